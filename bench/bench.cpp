@@ -0,0 +1,417 @@
+// SPDX-License-Identifier: MIT
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+#include "common/sampletype.hpp"
+#include "simd/cpu.hpp"
+#include "simd/sampleconv.hpp"
+#include "vsutils/audio.hpp"
+
+#include "vsapi_stub.hpp"
+
+VS_EXTERNAL_API(void) VapourSynthPluginInit2(VSPlugin* plugin, const VSPLUGINAPI* vspapi);
+
+
+namespace bench
+{
+    constexpr int SampleRate = 48000;
+
+    // number of distinct noise frames of a source clip
+    constexpr int FramePoolSize = 16;
+
+
+    struct Options
+    {
+        double seconds = 60;
+        int repeat = 3;
+        // empty: all filters
+        std::string filter;
+    };
+
+
+    struct BenchCase
+    {
+        const char* filter;
+
+        // fills the arguments for the filter, source2 is a second clip with the same format
+        std::function<void(VSMap* args, VSNode* source, VSNode* source2, const std::string& sampleType, const VSAPI* vsapi)> setArgs;
+    };
+
+
+    template <typename sample_t, size_t IntSampleBits>
+    static void fillNoiseFrame(VSFrame* frame, int numChannels, std::mt19937& rng, const VSAPI* vsapi)
+    {
+        std::uniform_real_distribution<double> dist(-0.5, 0.5);
+        std::vector<double> samples(static_cast<size_t>(vsapi->getFrameLength(frame)));
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            for (double& sample : samples)
+            {
+                sample = dist(rng);
+            }
+
+            sample_t* out = reinterpret_cast<sample_t*>(vsapi->getWritePtr(frame, ch));
+            simd::convSamplesFromDouble<sample_t, IntSampleBits>(samples.data(), out, static_cast<int>(samples.size()));
+        }
+    }
+
+
+    static VSFrame* newNoiseFrame(const VSAudioFormat& format, common::SampleType st, int numSamples, std::mt19937& rng, VSCore* core, const VSAPI* vsapi)
+    {
+        VSFrame* frame = vsapi->newAudioFrame(&format, numSamples, nullptr, core);
+
+        switch (st)
+        {
+            case common::SampleType::Int16:
+                fillNoiseFrame<int16_t, 16>(frame, format.numChannels, rng, vsapi);
+                break;
+            case common::SampleType::Int24:
+                fillNoiseFrame<int32_t, 24>(frame, format.numChannels, rng, vsapi);
+                break;
+            case common::SampleType::Int32:
+                fillNoiseFrame<int32_t, 32>(frame, format.numChannels, rng, vsapi);
+                break;
+            case common::SampleType::Float32:
+                fillNoiseFrame<float, 0>(frame, format.numChannels, rng, vsapi);
+                break;
+            default:
+                std::fprintf(stderr, "unsupported sample type\n");
+                std::exit(1);
+        }
+        return frame;
+    }
+
+
+    // creates a noise clip with uniformly distributed samples in [-0.5, 0.5)
+    static VSNode* newNoiseSource(common::SampleType st, int numChannels, int64_t numSamples, uint32_t seed, VSCore* core, const VSAPI* vsapi)
+    {
+        std::vector<int> channels;
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            channels.push_back(VSAudioChannels::acFrontLeft + ch);
+        }
+
+        VSAudioInfo audioInfo = VSAudioInfo();
+        audioInfo.format.numChannels = numChannels;
+        audioInfo.format.channelLayout = vsutils::toChannelLayout(channels);
+        common::applySampleTypeToAudioFormat(st, audioInfo.format);
+        audioInfo.sampleRate = SampleRate;
+        audioInfo.numSamples = numSamples;
+        audioInfo.numFrames = vsutils::samplesToFrames(numSamples);
+
+        std::mt19937 rng(seed);
+
+        std::vector<const VSFrame*> framePool;
+        for (int i = 0; i < FramePoolSize; ++i)
+        {
+            framePool.push_back(newNoiseFrame(audioInfo.format, st, VS_AUDIO_FRAME_SAMPLES, rng, core, vsapi));
+        }
+
+        int lastFrameLen = vsutils::getFrameSampleCount(audioInfo.numFrames - 1, numSamples);
+        const VSFrame* lastFrame = nullptr;
+        if (lastFrameLen < VS_AUDIO_FRAME_SAMPLES)
+        {
+            lastFrame = newNoiseFrame(audioInfo.format, st, lastFrameLen, rng, core, vsapi);
+        }
+
+        return newSourceNode(audioInfo, std::move(framePool), lastFrame);
+    }
+
+
+    static std::vector<BenchCase> getBenchCases()
+    {
+        return {
+            { "Chain", [](VSMap* args, VSNode* source, VSNode* source2, const std::string& sampleType, const VSAPI* vsapi)
+            {
+                int64_t numSamples = vsapi->getAudioInfo(source)->numSamples;
+                std::string fadein = "fadein samples=" + std::to_string(numSamples / 2);
+                std::string fadeout = "fadeout samples=" + std::to_string(numSamples / 2);
+
+                vsapi->mapSetNode(args, "clip", source, VSMapAppendMode::maReplace);
+                vsapi->mapSetData(args, "ops", "delay samples=1001", -1, VSDataTypeHint::dtUtf8, VSMapAppendMode::maAppend);
+                vsapi->mapSetData(args, "ops", fadein.c_str(), -1, VSDataTypeHint::dtUtf8, VSMapAppendMode::maAppend);
+                vsapi->mapSetData(args, "ops", fadeout.c_str(), -1, VSDataTypeHint::dtUtf8, VSMapAppendMode::maAppend);
+            } },
+            { "Convert", [](VSMap* args, VSNode* source, VSNode* source2, const std::string& sampleType, const VSAPI* vsapi)
+            {
+                vsapi->mapSetNode(args, "clip", source, VSMapAppendMode::maReplace);
+                vsapi->mapSetData(args, "sample_type", sampleType == "f32" ? "i16" : "f32", -1, VSDataTypeHint::dtUtf8, VSMapAppendMode::maReplace);
+            } },
+            { "Delay", [](VSMap* args, VSNode* source, VSNode* source2, const std::string& sampleType, const VSAPI* vsapi)
+            {
+                vsapi->mapSetNode(args, "clip", source, VSMapAppendMode::maReplace);
+                vsapi->mapSetInt(args, "samples", 1001, VSMapAppendMode::maReplace);
+            } },
+            { "FadeIn", [](VSMap* args, VSNode* source, VSNode* source2, const std::string& sampleType, const VSAPI* vsapi)
+            {
+                vsapi->mapSetNode(args, "clip", source, VSMapAppendMode::maReplace);
+                vsapi->mapSetInt(args, "samples", vsapi->getAudioInfo(source)->numSamples, VSMapAppendMode::maReplace);
+            } },
+            { "FadeOut", [](VSMap* args, VSNode* source, VSNode* source2, const std::string& sampleType, const VSAPI* vsapi)
+            {
+                vsapi->mapSetNode(args, "clip", source, VSMapAppendMode::maReplace);
+                vsapi->mapSetInt(args, "samples", vsapi->getAudioInfo(source)->numSamples, VSMapAppendMode::maReplace);
+            } },
+            { "CrossFade", [](VSMap* args, VSNode* source, VSNode* source2, const std::string& sampleType, const VSAPI* vsapi)
+            {
+                vsapi->mapSetNode(args, "clip1", source, VSMapAppendMode::maReplace);
+                vsapi->mapSetNode(args, "clip2", source2, VSMapAppendMode::maReplace);
+                vsapi->mapSetInt(args, "samples", vsapi->getAudioInfo(source)->numSamples / 2, VSMapAppendMode::maReplace);
+            } },
+            { "LoudNorm", [](VSMap* args, VSNode* source, VSNode* source2, const std::string& sampleType, const VSAPI* vsapi)
+            {
+                vsapi->mapSetNode(args, "clip", source, VSMapAppendMode::maReplace);
+                vsapi->mapSetFloat(args, "loudness", -23.0, VSMapAppendMode::maReplace);
+            } },
+            { "Mix", [](VSMap* args, VSNode* source, VSNode* source2, const std::string& sampleType, const VSAPI* vsapi)
+            {
+                int64_t numSamples = vsapi->getAudioInfo(source)->numSamples;
+
+                vsapi->mapSetNode(args, "clip1", source, VSMapAppendMode::maReplace);
+                vsapi->mapSetNode(args, "clip2", source2, VSMapAppendMode::maReplace);
+                vsapi->mapSetInt(args, "relative_gain", 1, VSMapAppendMode::maReplace);
+                vsapi->mapSetInt(args, "fadein_samples", numSamples / 4, VSMapAppendMode::maReplace);
+                vsapi->mapSetInt(args, "fadeout_samples", numSamples / 4, VSMapAppendMode::maReplace);
+            } },
+            { "MixN", [](VSMap* args, VSNode* source, VSNode* source2, const std::string& sampleType, const VSAPI* vsapi)
+            {
+                int64_t numSamples = vsapi->getAudioInfo(source)->numSamples;
+
+                // four overlapping inputs, the same mix as three chained Mix calls
+                for (int i = 0; i < 4; ++i)
+                {
+                    vsapi->mapSetNode(args, "clips", i % 2 == 0 ? source : source2, VSMapAppendMode::maAppend);
+                    vsapi->mapSetInt(args, "offsets_samples", i * 1001, VSMapAppendMode::maAppend);
+                }
+
+                vsapi->mapSetInt(args, "relative_gain", 1, VSMapAppendMode::maReplace);
+                vsapi->mapSetInt(args, "fadein_samples", numSamples / 4, VSMapAppendMode::maReplace);
+                vsapi->mapSetInt(args, "fadeout_samples", numSamples / 4, VSMapAppendMode::maReplace);
+            } },
+            { "Normalize", [](VSMap* args, VSNode* source, VSNode* source2, const std::string& sampleType, const VSAPI* vsapi)
+            {
+                vsapi->mapSetNode(args, "clip", source, VSMapAppendMode::maReplace);
+                vsapi->mapSetFloat(args, "peak", 0.9, VSMapAppendMode::maReplace);
+            } },
+            { "Resample", [](VSMap* args, VSNode* source, VSNode* source2, const std::string& sampleType, const VSAPI* vsapi)
+            {
+                // 48000 -> 44100: 147 phases, every output frame reads up to three input frames
+                vsapi->mapSetNode(args, "clip", source, VSMapAppendMode::maReplace);
+                vsapi->mapSetInt(args, "sample_rate", 44100, VSMapAppendMode::maReplace);
+                vsapi->mapSetData(args, "overflow", "clip", -1, VSDataTypeHint::dtUtf8, VSMapAppendMode::maReplace);
+            } },
+            { "SineTone", [](VSMap* args, VSNode* source, VSNode* source2, const std::string& sampleType, const VSAPI* vsapi)
+            {
+                const VSAudioInfo* ai = vsapi->getAudioInfo(source);
+                std::vector<int> channels = vsutils::getChannelsFromChannelLayout(ai->format.channelLayout);
+                std::vector<int64_t> channels64(channels.begin(), channels.end());
+
+                vsapi->mapSetNode(args, "clip", source, VSMapAppendMode::maReplace);
+                vsapi->mapSetInt(args, "samples", ai->numSamples, VSMapAppendMode::maReplace);
+                vsapi->mapSetData(args, "sample_type", sampleType.c_str(), -1, VSDataTypeHint::dtUtf8, VSMapAppendMode::maReplace);
+                vsapi->mapSetIntArray(args, "channels", channels64.data(), static_cast<int>(channels64.size()));
+                vsapi->mapSetFloat(args, "freq", 440.0, VSMapAppendMode::maReplace);
+                vsapi->mapSetFloat(args, "amp", 0.5, VSMapAppendMode::maReplace);
+            } },
+            { "Splice", [](VSMap* args, VSNode* source, VSNode* source2, const std::string& sampleType, const VSAPI* vsapi)
+            {
+                int64_t numSamples = vsapi->getAudioInfo(source)->numSamples;
+
+                // eight clips with a crossfade at every junction, the same as seven chained CrossFade calls
+                for (int i = 0; i < 8; ++i)
+                {
+                    vsapi->mapSetNode(args, "clips", i % 2 == 0 ? source : source2, VSMapAppendMode::maAppend);
+                }
+
+                vsapi->mapSetInt(args, "fade_samples", numSamples / 4, VSMapAppendMode::maReplace);
+            } },
+        };
+    }
+
+
+    // renders all frames, returns the elapsed seconds or a negative value on error
+    static double renderAll(VSNode* node, const VSAPI* vsapi)
+    {
+        int numFrames = vsapi->getAudioInfo(node)->numFrames;
+        char errorMsg[1024];
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (int n = 0; n < numFrames; ++n)
+        {
+            const VSFrame* frame = vsapi->getFrame(n, node, errorMsg, sizeof(errorMsg));
+            if (!frame)
+            {
+                std::fprintf(stderr, "frame %d: %s\n", n, errorMsg);
+                return -1;
+            }
+            vsapi->freeFrame(frame);
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+
+
+    static void printUsage()
+    {
+        std::fprintf(stderr,
+                     "usage: atools_bench [--seconds <audio seconds>] [--repeat <runs>] [--filter <name>]\n"
+                     "  renders every filter for every sample type and channel count\n"
+                     "  and prints the best run of each case as JSON to stdout\n");
+    }
+
+
+    static bool parseOptions(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+
+            if (arg == "--seconds" && hasValue)
+            {
+                options.seconds = std::atof(argv[++i]);
+            }
+            else if (arg == "--repeat" && hasValue)
+            {
+                options.repeat = std::atoi(argv[++i]);
+            }
+            else if (arg == "--filter" && hasValue)
+            {
+                options.filter = argv[++i];
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return 0 < options.seconds && 0 < options.repeat;
+    }
+
+
+    static int run(const Options& options)
+    {
+        const VSAPI* vsapi = getVSAPI();
+        VSCore* core = getCore();
+
+        VSPlugin* plugin = loadPlugin(VapourSynthPluginInit2);
+
+        int64_t numSamples = static_cast<int64_t>(options.seconds * SampleRate);
+
+        const std::vector<int> channelCounts = { 1, 2, 6 };
+
+        std::printf("{\n");
+        std::printf("  \"isa\": \"%s\",\n", simd::getIsaName(simd::getSampleConvIsa()));
+        std::printf("  \"sample_rate\": %d,\n", SampleRate);
+        std::printf("  \"results\": [");
+
+        bool firstResult = true;
+        int exitCode = 0;
+
+        for (const BenchCase& benchCase : getBenchCases())
+        {
+            if (!options.filter.empty() && options.filter != benchCase.filter)
+            {
+                continue;
+            }
+
+            for (const auto& [sampleTypeName, sampleType] : common::getStringVapourSynthSampleTypeMap())
+            {
+                for (int numChannels : channelCounts)
+                {
+                    VSNode* source = newNoiseSource(sampleType, numChannels, numSamples, 1, core, vsapi);
+                    VSNode* source2 = newNoiseSource(sampleType, numChannels, numSamples, 2, core, vsapi);
+
+                    VSMap* args = vsapi->createMap();
+                    VSMap* out = vsapi->createMap();
+
+                    benchCase.setArgs(args, source, source2, sampleTypeName, vsapi);
+                    invoke(plugin, benchCase.filter, args, out);
+
+                    vsapi->freeNode(source);
+                    vsapi->freeNode(source2);
+                    vsapi->freeMap(args);
+
+                    if (vsapi->mapGetError(out))
+                    {
+                        std::fprintf(stderr, "%s (%s, %d channels): %s\n", benchCase.filter, sampleTypeName.c_str(), numChannels, vsapi->mapGetError(out));
+                        vsapi->freeMap(out);
+                        exitCode = 1;
+                        continue;
+                    }
+
+                    VSNode* node = vsapi->mapGetNode(out, "clip", 0, nullptr);
+                    vsapi->freeMap(out);
+
+                    const VSAudioInfo* outInfo = vsapi->getAudioInfo(node);
+                    double totalSamples = static_cast<double>(outInfo->numSamples) * outInfo->format.numChannels;
+
+                    double bestSeconds = -1;
+                    for (int r = 0; r < options.repeat; ++r)
+                    {
+                        double seconds = renderAll(node, vsapi);
+                        if (seconds < 0)
+                        {
+                            bestSeconds = -1;
+                            break;
+                        }
+                        if (bestSeconds < 0 || seconds < bestSeconds)
+                        {
+                            bestSeconds = seconds;
+                        }
+                    }
+
+                    vsapi->freeNode(node);
+
+                    if (bestSeconds < 0)
+                    {
+                        exitCode = 1;
+                        continue;
+                    }
+
+                    std::printf("%s\n    {\"filter\": \"%s\", \"sample_type\": \"%s\", \"channels\": %d, \"samples\": %.0f, "
+                                "\"seconds\": %.6f, \"samples_per_second\": %.0f, \"ns_per_sample\": %.4f}",
+                                firstResult ? "" : ",", benchCase.filter, sampleTypeName.c_str(), numChannels, totalSamples,
+                                bestSeconds, totalSamples / bestSeconds, bestSeconds * 1e9 / totalSamples);
+                    std::fflush(stdout);
+
+                    firstResult = false;
+                }
+            }
+        }
+
+        std::printf("\n  ]\n}\n");
+
+        freePlugin(plugin);
+
+        return exitCode;
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    bench::Options options;
+
+    if (!bench::parseOptions(argc, argv, options))
+    {
+        bench::printUsage();
+        return 2;
+    }
+
+    return bench::run(options);
+}
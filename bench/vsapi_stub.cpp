@@ -0,0 +1,835 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <map>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+#include "vsapi_stub.hpp"
+
+struct VSMapValue
+{
+    VSPropertyType type = VSPropertyType::ptUnset;
+
+    std::vector<int64_t> ints;
+    std::vector<double> floats;
+    std::vector<std::string> data;
+    std::vector<VSNode*> nodes;
+};
+
+
+struct VSMap
+{
+    std::map<std::string, VSMapValue> values;
+
+    std::string error;
+};
+
+
+struct VSFrame
+{
+    VSAudioFormat format;
+    int numSamples;
+
+    // all channels in one buffer, VS_AUDIO_FRAME_SAMPLES samples per channel
+    uint8_t* data;
+    size_t channelStride;
+
+    // frame properties (numbers only)
+    VSMap props;
+
+    std::atomic<int> refCount;
+};
+
+
+struct VSNode
+{
+    std::string name;
+    VSAudioInfo audioInfo;
+
+    std::atomic<int> refCount;
+
+    // source node
+    std::vector<const VSFrame*> framePool;
+    const VSFrame* lastFrame = nullptr;
+
+    // filter node
+    VSFilterGetFrame getFrame = nullptr;
+    VSFilterFree free = nullptr;
+    void* instanceData = nullptr;
+};
+
+
+struct VSFrameContext
+{
+    std::vector<std::pair<VSNode*, int>> requests;
+
+    // frames of the requests, owned by the context
+    std::map<std::pair<VSNode*, int>, const VSFrame*> frames;
+
+    std::string error;
+};
+
+
+struct VSCore
+{
+};
+
+
+struct RegisteredFunction
+{
+    VSPublicFunction func;
+    void* functionData;
+};
+
+
+struct VSPlugin
+{
+    std::map<std::string, RegisteredFunction> functions;
+};
+
+
+namespace bench
+{
+    constexpr std::align_val_t FrameAlignment = std::align_val_t(64);
+
+    static VSCore core;
+
+    static const VSAPI* getApi();
+
+
+    // frames
+
+    static VSFrame* newFrame(const VSAudioFormat* format, int numSamples)
+    {
+        VSFrame* frame = new VSFrame();
+        frame->format = *format;
+        frame->numSamples = numSamples;
+        frame->channelStride = static_cast<size_t>(VS_AUDIO_FRAME_SAMPLES) * static_cast<size_t>(format->bytesPerSample);
+        frame->data = static_cast<uint8_t*>(::operator new(frame->channelStride * static_cast<size_t>(std::max(format->numChannels, 1)), FrameAlignment));
+        frame->refCount = 1;
+        return frame;
+    }
+
+
+    static const VSFrame* VS_CC addFrameRef(const VSFrame* f) noexcept
+    {
+        ++const_cast<VSFrame*>(f)->refCount;
+        return f;
+    }
+
+
+    static void VS_CC freeFrame(const VSFrame* f) noexcept
+    {
+        if (!f)
+        {
+            return;
+        }
+
+        VSFrame* frame = const_cast<VSFrame*>(f);
+        if (--frame->refCount == 0)
+        {
+            ::operator delete(frame->data, FrameAlignment);
+            delete frame;
+        }
+    }
+
+
+    static int VS_CC getFrameLength(const VSFrame* f) noexcept
+    {
+        return f->numSamples;
+    }
+
+
+    static const uint8_t* VS_CC getReadPtr(const VSFrame* f, int plane) noexcept
+    {
+        return f->data + static_cast<size_t>(plane) * f->channelStride;
+    }
+
+
+    static uint8_t* VS_CC getWritePtr(VSFrame* f, int plane) noexcept
+    {
+        return f->data + static_cast<size_t>(plane) * f->channelStride;
+    }
+
+
+    static const VSAudioFormat* VS_CC getAudioFrameFormat(const VSFrame* f) noexcept
+    {
+        return &f->format;
+    }
+
+
+    static VSFrame* VS_CC newAudioFrame(const VSAudioFormat* format, int numSamples, const VSFrame* propSrc, VSCore* core) noexcept
+    {
+        VSFrame* frame = newFrame(format, numSamples);
+        if (propSrc)
+        {
+            frame->props.values = propSrc->props.values;
+        }
+        return frame;
+    }
+
+
+    static VSFrame* VS_CC newAudioFrame2(const VSAudioFormat* format, int numSamples, const VSFrame** channelSrc, const int* channels, const VSFrame* propSrc, VSCore* core) noexcept
+    {
+        VSFrame* frame = newAudioFrame(format, numSamples, propSrc, core);
+
+        for (int ch = 0; ch < format->numChannels; ++ch)
+        {
+            if (channelSrc && channelSrc[ch])
+            {
+                std::memcpy(getWritePtr(frame, ch), getReadPtr(channelSrc[ch], channels[ch]), static_cast<size_t>(numSamples) * static_cast<size_t>(format->bytesPerSample));
+            }
+        }
+        return frame;
+    }
+
+
+    static VSFrame* VS_CC copyFrame(const VSFrame* f, VSCore* core) noexcept
+    {
+        VSFrame* frame = newAudioFrame(&f->format, f->numSamples, f, core);
+        std::memcpy(frame->data, f->data, f->channelStride * static_cast<size_t>(std::max(f->format.numChannels, 1)));
+        return frame;
+    }
+
+
+    static const VSMap* VS_CC getFramePropertiesRO(const VSFrame* f) noexcept
+    {
+        return &f->props;
+    }
+
+
+    static VSMap* VS_CC getFramePropertiesRW(VSFrame* f) noexcept
+    {
+        return &f->props;
+    }
+
+
+    // nodes
+
+    static VSNode* VS_CC addNodeRef(VSNode* node) noexcept
+    {
+        ++node->refCount;
+        return node;
+    }
+
+
+    static void VS_CC freeNode(VSNode* node) noexcept
+    {
+        if (!node || --node->refCount != 0)
+        {
+            return;
+        }
+
+        if (node->free)
+        {
+            node->free(node->instanceData, &core, getApi());
+        }
+
+        for (const VSFrame* frame : node->framePool)
+        {
+            freeFrame(frame);
+        }
+        freeFrame(node->lastFrame);
+
+        delete node;
+    }
+
+
+    static const VSAudioInfo* VS_CC getAudioInfo(VSNode* node) noexcept
+    {
+        return &node->audioInfo;
+    }
+
+
+    static int VS_CC getNodeType(VSNode* node) noexcept
+    {
+        return VSMediaType::mtAudio;
+    }
+
+
+    // frame requests
+
+    static int clampFrameNum(int n, VSNode* node)
+    {
+        return std::clamp(n, 0, std::max(node->audioInfo.numFrames - 1, 0));
+    }
+
+
+    // returns nullptr and sets errorMsg on error
+    static const VSFrame* evaluateFrame(int n, VSNode* node, std::string& errorMsg)
+    {
+        if (n < 0 || node->audioInfo.numFrames <= n)
+        {
+            errorMsg = "frame number out of range";
+            return nullptr;
+        }
+
+        if (!node->getFrame)
+        {
+            // source node
+            if (node->lastFrame && n == node->audioInfo.numFrames - 1)
+            {
+                return addFrameRef(node->lastFrame);
+            }
+            return addFrameRef(node->framePool[static_cast<size_t>(n) % node->framePool.size()]);
+        }
+
+        VSFrameContext frameCtx;
+        void* frameData = nullptr;
+
+        const VSFrame* frame = node->getFrame(n, VSActivationReason::arInitial, node->instanceData, &frameData, &frameCtx, &core, getApi());
+
+        if (!frame && frameCtx.error.empty() && !frameCtx.requests.empty())
+        {
+            bool requestFailed = false;
+
+            for (const auto& request : frameCtx.requests)
+            {
+                if (frameCtx.frames.contains(request))
+                {
+                    continue;
+                }
+
+                const VSFrame* requestFrame = evaluateFrame(request.second, request.first, frameCtx.error);
+                if (!requestFrame)
+                {
+                    requestFailed = true;
+                    break;
+                }
+
+                frameCtx.frames[request] = requestFrame;
+            }
+
+            int activationReason = requestFailed ? VSActivationReason::arError : VSActivationReason::arAllFramesReady;
+            frame = node->getFrame(n, activationReason, node->instanceData, &frameData, &frameCtx, &core, getApi());
+        }
+
+        for (const auto& [request, requestFrame] : frameCtx.frames)
+        {
+            freeFrame(requestFrame);
+        }
+
+        if (!frame)
+        {
+            errorMsg = frameCtx.error.empty() ? node->name + ": no frame returned" : frameCtx.error;
+        }
+
+        return frame;
+    }
+
+
+    static void VS_CC requestFrameFilter(int n, VSNode* node, VSFrameContext* frameCtx) noexcept
+    {
+        frameCtx->requests.push_back({ node, clampFrameNum(n, node) });
+    }
+
+
+    static const VSFrame* VS_CC getFrameFilter(int n, VSNode* node, VSFrameContext* frameCtx) noexcept
+    {
+        auto it = frameCtx->frames.find({ node, clampFrameNum(n, node) });
+        if (it == frameCtx->frames.end())
+        {
+            return nullptr;
+        }
+        return addFrameRef(it->second);
+    }
+
+
+    static void VS_CC setFilterError(const char* errorMessage, VSFrameContext* frameCtx) noexcept
+    {
+        if (frameCtx)
+        {
+            frameCtx->error = errorMessage;
+        }
+    }
+
+
+    static const VSFrame* VS_CC getFrame(int n, VSNode* node, char* errorMsg, int bufSize) noexcept
+    {
+        std::string error;
+        const VSFrame* frame = evaluateFrame(n, node, error);
+
+        if (!frame && errorMsg && 0 < bufSize)
+        {
+            std::snprintf(errorMsg, static_cast<size_t>(bufSize), "%s", error.c_str());
+        }
+        return frame;
+    }
+
+
+    struct AsyncRequest
+    {
+        int n;
+        VSNode* node;
+        VSFrameDoneCallback callback;
+        void* userData;
+    };
+
+    // requests made by a frame done callback are queued instead of evaluated recursively
+    static thread_local std::deque<AsyncRequest>* asyncQueue = nullptr;
+
+
+    static void VS_CC getFrameAsync(int n, VSNode* node, VSFrameDoneCallback callback, void* userData) noexcept
+    {
+        if (asyncQueue)
+        {
+            asyncQueue->push_back({ n, node, callback, userData });
+            return;
+        }
+
+        std::deque<AsyncRequest> queue = { { n, node, callback, userData } };
+        asyncQueue = &queue;
+
+        while (!queue.empty())
+        {
+            AsyncRequest request = queue.front();
+            queue.pop_front();
+
+            std::string error;
+            const VSFrame* frame = evaluateFrame(request.n, request.node, error);
+
+            request.callback(request.userData, frame, request.n, request.node, frame ? nullptr : error.c_str());
+        }
+
+        asyncQueue = nullptr;
+    }
+
+
+    static void VS_CC createAudioFilter(VSMap* out, const char* name, const VSAudioInfo* ai, VSFilterGetFrame getFrame, VSFilterFree free,
+                                        int filterMode, const VSFilterDependency* dependencies, int numDeps, void* instanceData, VSCore* core) noexcept
+    {
+        VSNode* node = new VSNode();
+        node->name = name;
+        node->audioInfo = *ai;
+        node->audioInfo.numFrames = static_cast<int>((ai->numSamples + VS_AUDIO_FRAME_SAMPLES - 1) / VS_AUDIO_FRAME_SAMPLES);
+        node->refCount = 1;
+        node->getFrame = getFrame;
+        node->free = free;
+        node->instanceData = instanceData;
+
+        // the out map owns the only reference
+        VSMapValue& value = out->values["clip"];
+        value.type = VSPropertyType::ptAudioNode;
+        value.nodes.push_back(node);
+    }
+
+
+    // maps
+
+    static VSMap* VS_CC createMap() noexcept
+    {
+        return new VSMap();
+    }
+
+
+    static void VS_CC clearMap(VSMap* map) noexcept
+    {
+        for (auto& [key, value] : map->values)
+        {
+            for (VSNode* node : value.nodes)
+            {
+                freeNode(node);
+            }
+        }
+        map->values.clear();
+        map->error.clear();
+    }
+
+
+    static void VS_CC freeMap(VSMap* map) noexcept
+    {
+        clearMap(map);
+        delete map;
+    }
+
+
+    static void VS_CC mapSetError(VSMap* map, const char* errorMessage) noexcept
+    {
+        clearMap(map);
+        map->error = errorMessage ? errorMessage : "";
+    }
+
+
+    static const char* VS_CC mapGetError(const VSMap* map) noexcept
+    {
+        return map->error.empty() ? nullptr : map->error.c_str();
+    }
+
+
+    static int VS_CC mapNumElements(const VSMap* map, const char* key) noexcept
+    {
+        auto it = map->values.find(key);
+        if (it == map->values.end())
+        {
+            return -1;
+        }
+
+        const VSMapValue& value = it->second;
+        return static_cast<int>(value.ints.size() + value.floats.size() + value.data.size() + value.nodes.size());
+    }
+
+
+    static int VS_CC mapDeleteKey(VSMap* map, const char* key) noexcept
+    {
+        return map->values.erase(key) != 0 ? 1 : 0;
+    }
+
+
+    static int VS_CC mapGetType(const VSMap* map, const char* key) noexcept
+    {
+        auto it = map->values.find(key);
+        return it == map->values.end() ? VSPropertyType::ptUnset : it->second.type;
+    }
+
+
+    // returns nullptr and sets error if the key does not exist or the type does not match
+    static const VSMapValue* getMapValue(const VSMap* map, const char* key, VSPropertyType type, int* error)
+    {
+        auto it = map->values.find(key);
+
+        int err = VSMapPropertyError::peSuccess;
+        if (!map->error.empty())
+        {
+            err = VSMapPropertyError::peError;
+        }
+        else if (it == map->values.end())
+        {
+            err = VSMapPropertyError::peUnset;
+        }
+        else if (it->second.type != type)
+        {
+            err = VSMapPropertyError::peType;
+        }
+
+        if (error)
+        {
+            *error = err;
+        }
+        return err == VSMapPropertyError::peSuccess ? &it->second : nullptr;
+    }
+
+
+    // returns nullptr and sets error if the key does not exist, the type does not match or the index is out of range
+    template <typename T>
+    static const T* getMapElement(const VSMap* map, const char* key, int index, VSPropertyType type, std::vector<T> VSMapValue::* member, int* error)
+    {
+        const VSMapValue* value = getMapValue(map, key, type, error);
+        if (!value)
+        {
+            return nullptr;
+        }
+
+        const std::vector<T>& elements = value->*member;
+        if (index < 0 || static_cast<int>(elements.size()) <= index)
+        {
+            if (error)
+            {
+                *error = VSMapPropertyError::peIndex;
+            }
+            return nullptr;
+        }
+        return &elements[static_cast<size_t>(index)];
+    }
+
+
+    static VSMapValue& setMapValue(VSMap* map, const char* key, VSPropertyType type, int append)
+    {
+        VSMapValue& value = map->values[key];
+        if (append == VSMapAppendMode::maReplace || value.type != type)
+        {
+            for (VSNode* node : value.nodes)
+            {
+                freeNode(node);
+            }
+            value = VSMapValue();
+            value.type = type;
+        }
+        return value;
+    }
+
+
+    static int64_t VS_CC mapGetInt(const VSMap* map, const char* key, int index, int* error) noexcept
+    {
+        const int64_t* element = getMapElement(map, key, index, VSPropertyType::ptInt, &VSMapValue::ints, error);
+        return element ? *element : 0;
+    }
+
+
+    static int VS_CC mapGetIntSaturated(const VSMap* map, const char* key, int index, int* error) noexcept
+    {
+        int64_t result = mapGetInt(map, key, index, error);
+        return static_cast<int>(std::clamp<int64_t>(result, std::numeric_limits<int>::min(), std::numeric_limits<int>::max()));
+    }
+
+
+    static const int64_t* VS_CC mapGetIntArray(const VSMap* map, const char* key, int* error) noexcept
+    {
+        const VSMapValue* value = getMapValue(map, key, VSPropertyType::ptInt, error);
+        return value ? value->ints.data() : nullptr;
+    }
+
+
+    static int VS_CC mapSetInt(VSMap* map, const char* key, int64_t i, int append) noexcept
+    {
+        setMapValue(map, key, VSPropertyType::ptInt, append).ints.push_back(i);
+        return 0;
+    }
+
+
+    static int VS_CC mapSetIntArray(VSMap* map, const char* key, const int64_t* i, int size) noexcept
+    {
+        VSMapValue& value = setMapValue(map, key, VSPropertyType::ptInt, VSMapAppendMode::maReplace);
+        value.ints.assign(i, i + size);
+        return 0;
+    }
+
+
+    static double VS_CC mapGetFloat(const VSMap* map, const char* key, int index, int* error) noexcept
+    {
+        const double* element = getMapElement(map, key, index, VSPropertyType::ptFloat, &VSMapValue::floats, error);
+        return element ? *element : 0;
+    }
+
+
+    static float VS_CC mapGetFloatSaturated(const VSMap* map, const char* key, int index, int* error) noexcept
+    {
+        return static_cast<float>(mapGetFloat(map, key, index, error));
+    }
+
+
+    static const double* VS_CC mapGetFloatArray(const VSMap* map, const char* key, int* error) noexcept
+    {
+        const VSMapValue* value = getMapValue(map, key, VSPropertyType::ptFloat, error);
+        return value ? value->floats.data() : nullptr;
+    }
+
+
+    static int VS_CC mapSetFloat(VSMap* map, const char* key, double d, int append) noexcept
+    {
+        setMapValue(map, key, VSPropertyType::ptFloat, append).floats.push_back(d);
+        return 0;
+    }
+
+
+    static int VS_CC mapSetFloatArray(VSMap* map, const char* key, const double* d, int size) noexcept
+    {
+        VSMapValue& value = setMapValue(map, key, VSPropertyType::ptFloat, VSMapAppendMode::maReplace);
+        value.floats.assign(d, d + size);
+        return 0;
+    }
+
+
+    static const char* VS_CC mapGetData(const VSMap* map, const char* key, int index, int* error) noexcept
+    {
+        const std::string* element = getMapElement(map, key, index, VSPropertyType::ptData, &VSMapValue::data, error);
+        return element ? element->c_str() : nullptr;
+    }
+
+
+    static int VS_CC mapGetDataSize(const VSMap* map, const char* key, int index, int* error) noexcept
+    {
+        const std::string* element = getMapElement(map, key, index, VSPropertyType::ptData, &VSMapValue::data, error);
+        return element ? static_cast<int>(element->size()) : -1;
+    }
+
+
+    static int VS_CC mapSetData(VSMap* map, const char* key, const char* data, int size, int type, int append) noexcept
+    {
+        size_t dataSize = size < 0 ? std::strlen(data) : static_cast<size_t>(size);
+        setMapValue(map, key, VSPropertyType::ptData, append).data.emplace_back(data, dataSize);
+        return 0;
+    }
+
+
+    static VSNode* VS_CC mapGetNode(const VSMap* map, const char* key, int index, int* error) noexcept
+    {
+        VSNode* const* element = getMapElement(map, key, index, VSPropertyType::ptAudioNode, &VSMapValue::nodes, error);
+        return element ? addNodeRef(*element) : nullptr;
+    }
+
+
+    static int VS_CC mapSetNode(VSMap* map, const char* key, VSNode* node, int append) noexcept
+    {
+        setMapValue(map, key, VSPropertyType::ptAudioNode, append).nodes.push_back(addNodeRef(node));
+        return 0;
+    }
+
+
+    static int VS_CC mapConsumeNode(VSMap* map, const char* key, VSNode* node, int append) noexcept
+    {
+        setMapValue(map, key, VSPropertyType::ptAudioNode, append).nodes.push_back(node);
+        return 0;
+    }
+
+
+    // core
+
+    static void VS_CC getCoreInfo(VSCore* core, VSCoreInfo* info) noexcept
+    {
+        *info = VSCoreInfo();
+        info->versionString = "atools_bench VSAPI stub";
+        info->api = VAPOURSYNTH_API_VERSION;
+        info->numThreads = 1;
+    }
+
+
+    static int VS_CC getAPIVersion() noexcept
+    {
+        return VAPOURSYNTH_API_VERSION;
+    }
+
+
+    static void VS_CC logMessage(int msgType, const char* msg, VSCore* core) noexcept
+    {
+        constexpr const char* msgTypeNames[] = { "Debug", "Information", "Warning", "Critical", "Fatal" };
+
+        const char* msgTypeName = 0 <= msgType && msgType < 5 ? msgTypeNames[msgType] : "Unknown";
+        std::fprintf(stderr, "%s: %s\n", msgTypeName, msg);
+    }
+
+
+    // plugins
+
+    static int VS_CC configPlugin(const char* identifier, const char* pluginNamespace, const char* name, int pluginVersion, int apiVersion, int flags, VSPlugin* plugin) noexcept
+    {
+        return 1;
+    }
+
+
+    static int VS_CC registerFunction(const char* name, const char* args, const char* returnType, VSPublicFunction argsFunc, void* functionData, VSPlugin* plugin) noexcept
+    {
+        plugin->functions[name] = { .func = argsFunc, .functionData = functionData };
+        return 1;
+    }
+
+
+    static const VSAPI* getApi()
+    {
+        static const VSAPI api = []
+        {
+            VSAPI a = VSAPI();
+
+            a.createAudioFilter = createAudioFilter;
+            a.addNodeRef = addNodeRef;
+            a.freeNode = freeNode;
+            a.getNodeType = getNodeType;
+            a.getAudioInfo = getAudioInfo;
+
+            a.newAudioFrame = newAudioFrame;
+            a.newAudioFrame2 = newAudioFrame2;
+            a.addFrameRef = addFrameRef;
+            a.freeFrame = freeFrame;
+            a.getFrameLength = getFrameLength;
+            a.getReadPtr = getReadPtr;
+            a.getWritePtr = getWritePtr;
+            a.getAudioFrameFormat = getAudioFrameFormat;
+            a.copyFrame = copyFrame;
+            a.getFramePropertiesRO = getFramePropertiesRO;
+            a.getFramePropertiesRW = getFramePropertiesRW;
+
+            a.getFrame = getFrame;
+            a.getFrameAsync = getFrameAsync;
+            a.getFrameFilter = getFrameFilter;
+            a.requestFrameFilter = requestFrameFilter;
+            a.setFilterError = setFilterError;
+
+            a.createMap = createMap;
+            a.freeMap = freeMap;
+            a.clearMap = clearMap;
+            a.mapSetError = mapSetError;
+            a.mapGetError = mapGetError;
+            a.mapNumElements = mapNumElements;
+            a.mapDeleteKey = mapDeleteKey;
+            a.mapGetType = mapGetType;
+            a.mapGetInt = mapGetInt;
+            a.mapGetIntSaturated = mapGetIntSaturated;
+            a.mapGetIntArray = mapGetIntArray;
+            a.mapSetInt = mapSetInt;
+            a.mapSetIntArray = mapSetIntArray;
+            a.mapGetFloat = mapGetFloat;
+            a.mapGetFloatSaturated = mapGetFloatSaturated;
+            a.mapGetFloatArray = mapGetFloatArray;
+            a.mapSetFloat = mapSetFloat;
+            a.mapSetFloatArray = mapSetFloatArray;
+            a.mapGetData = mapGetData;
+            a.mapGetDataSize = mapGetDataSize;
+            a.mapSetData = mapSetData;
+            a.mapGetNode = mapGetNode;
+            a.mapSetNode = mapSetNode;
+            a.mapConsumeNode = mapConsumeNode;
+
+            a.getCoreInfo = getCoreInfo;
+            a.getAPIVersion = getAPIVersion;
+            a.logMessage = logMessage;
+
+            return a;
+        }();
+
+        return &api;
+    }
+
+
+    const VSAPI* getVSAPI()
+    {
+        return getApi();
+    }
+
+
+    VSCore* getCore()
+    {
+        return &core;
+    }
+
+
+    VSPlugin* loadPlugin(VSInitPlugin pluginInit)
+    {
+        static const VSPLUGINAPI pluginApi = { .getAPIVersion = getAPIVersion, .configPlugin = configPlugin, .registerFunction = registerFunction };
+
+        VSPlugin* plugin = new VSPlugin();
+        pluginInit(plugin, &pluginApi);
+        return plugin;
+    }
+
+
+    void freePlugin(VSPlugin* plugin)
+    {
+        delete plugin;
+    }
+
+
+    bool invoke(VSPlugin* plugin, const char* funcName, const VSMap* in, VSMap* out)
+    {
+        auto it = plugin->functions.find(funcName);
+        if (it == plugin->functions.end())
+        {
+            return false;
+        }
+
+        it->second.func(in, out, it->second.functionData, &core, getApi());
+        return true;
+    }
+
+
+    VSNode* newSourceNode(const VSAudioInfo& audioInfo, std::vector<const VSFrame*> framePool, const VSFrame* lastFrame)
+    {
+        VSNode* node = new VSNode();
+        node->name = "Source";
+        node->audioInfo = audioInfo;
+        node->refCount = 1;
+        node->framePool = std::move(framePool);
+        node->lastFrame = lastFrame;
+        return node;
+    }
+}
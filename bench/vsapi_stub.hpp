@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+namespace bench
+{
+    /**
+     * minimal in-process implementation of the VSAPI functions used by the plugin
+     * frames are evaluated synchronously on the calling thread, there is no frame cache
+     */
+    const VSAPI* getVSAPI();
+
+    VSCore* getCore();
+
+    // loads a plugin by calling its VapourSynthPluginInit2 function
+    VSPlugin* loadPlugin(VSInitPlugin pluginInit);
+
+    void freePlugin(VSPlugin* plugin);
+
+    // calls a registered plugin function, returns false if the function does not exist
+    bool invoke(VSPlugin* plugin, const char* funcName, const VSMap* in, VSMap* out);
+
+    /**
+     * creates a source clip from prepared frames (references are taken over)
+     * frame n is framePool[n % framePool.size()], the last frame is lastFrame if it is shorter than VS_AUDIO_FRAME_SAMPLES
+     */
+    VSNode* newSourceNode(const VSAudioInfo& audioInfo, std::vector<const VSFrame*> framePool, const VSFrame* lastFrame);
+}
@@ -0,0 +1,956 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <span>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+#include "chain.hpp"
+#include "fade.hpp"
+#include "common/offset.hpp"
+#include "common/overflow.hpp"
+#include "common/sampletype.hpp"
+#include "common/stats.hpp"
+#include "common/transition.hpp"
+#include "simd/sampleconv.hpp"
+#include "utils/string.hpp"
+#include "vsmap/vsmap.hpp"
+#include "vsmap/vsmap_common.hpp"
+#include "vsutils/audio.hpp"
+
+constexpr const char* FuncName = "Chain";
+
+constexpr bool DefaultStrict = false;
+constexpr common::TransitionType DefaultFadeType = common::TransitionType::Cubic;
+constexpr common::OverflowMode DefaultOverflowMode = common::OverflowMode::Error;
+constexpr common::OverflowLog DefaultOverflowLog = common::OverflowLog::Once;
+constexpr bool DefaultStats = false;
+
+
+Chain::Chain(VSNode* _audio, const VSAudioInfo* _audioInfo, std::vector<ChainOp> _ops, bool _strict,
+             common::OverflowMode _overflowMode, common::OverflowLog _overflowLog, bool _stats) :
+    audio(_audio), inInfo(*_audioInfo), ops(std::move(_ops)), strict(_strict),
+    overflowMode(_overflowMode), overflowLog(_overflowLog), stats(_stats)
+{
+    inSampleType = common::getSampleTypeFromAudioFormat(inInfo.format).value();
+
+    common::SampleType sampleType = inSampleType;
+    for (const ChainOp& op : ops)
+    {
+        if (op.type == ChainOpType::Convert)
+        {
+            sampleType = op.sampleType;
+        }
+        opSampleTypes.push_back(sampleType);
+    }
+    outSampleType = sampleType;
+
+    outInfo = inInfo;
+    common::applySampleTypeToAudioFormat(outSampleType, outInfo.format);
+
+    initChannelPlans();
+
+    initOverflowPossible();
+
+    overflowTracker.init(FuncName, overflowMode, overflowLog, common::isFloatSampleType(outSampleType), outInfo.numFrames);
+
+    silenceFrames.init(outInfo.format, stats);
+}
+
+
+void Chain::initChannelPlans()
+{
+    int64_t numSamples = inInfo.numSamples;
+
+    for (int ch = 0; ch < inInfo.format.numChannels; ++ch)
+    {
+        ChannelPlan plan;
+        plan.opOutPosOffsets.assign(ops.size(), 0);
+        plan.outPosValidStart = 0;
+        plan.outPosValidEnd = numSamples;
+        plan.passthrough = true;
+        plan.lastOpIndex = 0;
+
+        // sum of the delays of all following operations
+        int64_t delay = 0;
+
+        for (size_t i = ops.size(); 0 < i--; )
+        {
+            const ChainOp& op = ops[i];
+
+            plan.opOutPosOffsets[i] = delay;
+
+            if (!op.channels[ch])
+            {
+                continue;
+            }
+
+            if (plan.passthrough)
+            {
+                plan.passthrough = false;
+                plan.lastOpIndex = i;
+            }
+
+            if (op.type == ChainOpType::Delay)
+            {
+                // output of the delay operation: [delay, delay + numSamples)
+                plan.outPosValidStart = std::max(plan.outPosValidStart, delay);
+                plan.outPosValidEnd = std::min(plan.outPosValidEnd, delay + numSamples);
+
+                delay += op.delaySamples;
+            }
+        }
+
+        // input audio
+        plan.outPosValidStart = std::max(plan.outPosValidStart, delay);
+        plan.outPosValidEnd = std::min(plan.outPosValidEnd, delay + numSamples);
+
+        auto it = std::find(sourceDelays.begin(), sourceDelays.end(), delay);
+        plan.sourceDelayIndex = static_cast<size_t>(it - sourceDelays.begin());
+
+        if (it == sourceDelays.end())
+        {
+            sourceDelays.push_back(delay);
+            sourceFrameSampleOffsets.push_back(common::getFrameSampleOffsets(delay));
+        }
+
+        channelPlans.push_back(std::move(plan));
+    }
+}
+
+
+void Chain::initOverflowPossible()
+{
+    // upper bound of the absolute samples after each operation over all channels
+    double maxAbsSample = common::getMaxAbsSample(inSampleType);
+
+    overflowPossible = false;
+
+    for (size_t i = 0; i < ops.size(); ++i)
+    {
+        const ChainOp& op = ops[i];
+
+        bool allChannels = std::all_of(op.channels.begin(), op.channels.end(), [](bool ch) { return ch; });
+
+        switch (op.type)
+        {
+            case ChainOpType::Gain:
+                // channels without the operation keep their bound
+                maxAbsSample *= allChannels ? op.gain : std::max(op.gain, 1.0);
+                break;
+            case ChainOpType::Clip:
+                if (allChannels)
+                {
+                    // also replaces a NaN bound
+                    maxAbsSample = maxAbsSample <= 1.0 ? maxAbsSample : 1.0;
+                }
+                break;
+            case ChainOpType::Delay:
+            case ChainOpType::FadeIn:
+            case ChainOpType::FadeOut:
+            case ChainOpType::Convert:
+                // the fade scales are inside [0, 1]
+                break;
+        }
+
+        // every operation is checked in strict mode
+        if (strict && common::isOverflowPossible(maxAbsSample, opSampleTypes[i]))
+        {
+            overflowPossible = true;
+        }
+    }
+
+    if (common::isOverflowPossible(maxAbsSample, outSampleType))
+    {
+        overflowPossible = true;
+    }
+}
+
+
+VSNode* Chain::getAudio()
+{
+    return audio;
+}
+
+
+const VSAudioInfo& Chain::getOutInfo()
+{
+    return outInfo;
+}
+
+
+bool Chain::isOverflowPossible()
+{
+    return overflowPossible;
+}
+
+
+bool Chain::isStatsEnabled()
+{
+    return stats;
+}
+
+
+const std::vector<int64_t>& Chain::getSourceDelays()
+{
+    return sourceDelays;
+}
+
+
+common::OffsetFramePos Chain::outFrameToSourceFrames(int outFrmNum, size_t sourceDelayIndex)
+{
+    return common::baseFrameToOffsetFrames(outFrmNum, sourceDelays[sourceDelayIndex], inInfo.numSamples, outInfo.numSamples);
+}
+
+
+bool Chain::isSilentOutFrame(int outFrmNum)
+{
+    for (size_t i = 0; i < sourceDelays.size(); ++i)
+    {
+        common::OffsetFramePos srcFrmNums = outFrameToSourceFrames(outFrmNum, i);
+
+        if (0 <= srcFrmNums.left || 0 <= srcFrmNums.right)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+const VSFrame* Chain::getSilenceFrame(int outFrmLen, VSCore* core, const VSAPI* vsapi)
+{
+    return silenceFrames.get(outFrmLen, core, vsapi);
+}
+
+
+std::vector<const VSFrame*> Chain::getOutChannelSources(int outFrmLen, const std::vector<ChainSourceFrames>& sourceFrames, const VSAPI* vsapi)
+{
+    std::vector<const VSFrame*> outChannelSources(static_cast<size_t>(outInfo.format.numChannels), nullptr);
+
+    for (int ch = 0; ch < outInfo.format.numChannels; ++ch)
+    {
+        const ChannelPlan& plan = channelPlans[ch];
+
+        // channels without any operation are not delayed and have the input sample type
+        const VSFrame* srcFrm = sourceFrames[plan.sourceDelayIndex].left;
+
+        if (plan.passthrough && srcFrm && vsapi->getFrameLength(srcFrm) == outFrmLen)
+        {
+            outChannelSources[ch] = srcFrm;
+        }
+    }
+
+    return outChannelSources;
+}
+
+
+void Chain::submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi)
+{
+    overflowTracker.submitFrame(outFrmNum, std::move(frameOverflowStats), core, vsapi);
+}
+
+
+void Chain::flushOverflowStats(VSCore* core, const VSAPI* vsapi)
+{
+    overflowTracker.flush(core, vsapi);
+}
+
+
+void Chain::free(const VSAPI* vsapi)
+{
+    for (ChainOp& op : ops)
+    {
+        delete op.fadeTrans;
+        op.fadeTrans = nullptr;
+    }
+    silenceFrames.clear(vsapi);
+    vsapi->freeNode(audio);
+}
+
+
+// rounds the samples to the given sample type like an unfused filter writing them to a frame
+template <typename sample_t, size_t IntSampleBits, bool CheckOverflow>
+static bool quantizeSamplesImpl(std::span<double> samples, int64_t totalPosStart, int ch, const common::OverflowContext& ofCtx)
+{
+    std::array<sample_t, VS_AUDIO_FRAME_SAMPLES> quantized;
+
+    if (!common::safeWriteSamples<sample_t, IntSampleBits, CheckOverflow>(samples, quantized.data(), totalPosStart, ch, ofCtx))
+    {
+        return false;
+    }
+
+    simd::convSamplesToDouble<sample_t, IntSampleBits>(quantized.data(), samples.data(), static_cast<int>(samples.size()));
+    return true;
+}
+
+
+template <bool CheckOverflow>
+static bool quantizeSamples(common::SampleType st, std::span<double> samples, int64_t totalPosStart, int ch, const common::OverflowContext& ofCtx)
+{
+    switch (st)
+    {
+        case common::SampleType::Int8:
+            return quantizeSamplesImpl<int8_t, 8, CheckOverflow>(samples, totalPosStart, ch, ofCtx);
+        case common::SampleType::Int16:
+            return quantizeSamplesImpl<int16_t, 16, CheckOverflow>(samples, totalPosStart, ch, ofCtx);
+        case common::SampleType::Int24:
+            return quantizeSamplesImpl<int32_t, 24, CheckOverflow>(samples, totalPosStart, ch, ofCtx);
+        case common::SampleType::Int32:
+            return quantizeSamplesImpl<int32_t, 32, CheckOverflow>(samples, totalPosStart, ch, ofCtx);
+        case common::SampleType::Float32:
+            return quantizeSamplesImpl<float, 0, CheckOverflow>(samples, totalPosStart, ch, ofCtx);
+        case common::SampleType::Float64:
+            return quantizeSamplesImpl<double, 0, CheckOverflow>(samples, totalPosStart, ch, ofCtx);
+        default:
+            return false;
+    }
+}
+
+
+template <bool CheckOverflow>
+bool Chain::processFrameChannel(int ch, int64_t outPosFrmStart, std::span<double> samples,
+                                const std::vector<ChainSourceFrames>& sourceFrames, const common::OverflowContext& ofCtx)
+{
+    const ChannelPlan& plan = channelPlans[ch];
+
+    int outFrmLen = static_cast<int>(samples.size());
+
+    // frame samples that are not silenced by a delay: [validBegin, validEnd), zeros otherwise
+    int validBegin = static_cast<int>(std::clamp<int64_t>(plan.outPosValidStart - outPosFrmStart, 0, outFrmLen));
+    int validEnd = static_cast<int>(std::clamp<int64_t>(plan.outPosValidEnd - outPosFrmStart, 0, outFrmLen));
+
+    std::fill(samples.begin(), samples.end(), 0.0);
+
+    if (validEnd <= validBegin)
+    {
+        // all operations keep silence silent
+        return true;
+    }
+
+    const ChainSourceFrames& srcFrms = sourceFrames[plan.sourceDelayIndex];
+
+    const uint8_t* srcFrmLPtr = srcFrms.left ? ofCtx.vsapi->getReadPtr(srcFrms.left, ch) : nullptr;
+    const uint8_t* srcFrmRPtr = srcFrms.right ? ofCtx.vsapi->getReadPtr(srcFrms.right, ch) : nullptr;
+
+    common::convOffsetSamplesToDouble(inSampleType, inInfo.format.bytesPerSample, validBegin, validEnd,
+                                      sourceFrameSampleOffsets[plan.sourceDelayIndex], srcFrmLPtr, srcFrmRPtr, samples.data());
+
+    std::span<double> validSamples = samples.subspan(validBegin, validEnd - validBegin);
+
+    for (size_t i = 0; i < ops.size(); ++i)
+    {
+        const ChainOp& op = ops[i];
+
+        if (!op.channels[ch])
+        {
+            continue;
+        }
+
+        // sample position of validSamples[0] at the output of this operation
+        int64_t opPosStart = outPosFrmStart + validBegin - plan.opOutPosOffsets[i];
+
+        switch (op.type)
+        {
+            case ChainOpType::Gain:
+                for (double& sample : validSamples)
+                {
+                    sample *= op.gain;
+                }
+                break;
+            case ChainOpType::FadeIn:
+            case ChainOpType::FadeOut:
+                applyFade(op.fadeTrans, op.fadeStart, op.fadeEnd, opPosStart, validSamples);
+                break;
+            case ChainOpType::Clip:
+                for (double& sample : validSamples)
+                {
+                    sample = std::clamp(sample, -1.0, 1.0);
+                }
+                break;
+            case ChainOpType::Delay:
+            case ChainOpType::Convert:
+                // the samples are not changed, handled by the channel plan and the final write
+                break;
+        }
+
+        // the last operation is quantized by the final write
+        if (strict && i != plan.lastOpIndex)
+        {
+            if (!quantizeSamples<CheckOverflow>(opSampleTypes[i], validSamples, opPosStart, ch, ofCtx))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+template <typename sample_t, size_t IntSampleBits, bool CheckOverflow>
+bool Chain::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
+                           const std::vector<ChainSourceFrames>& sourceFrames, const common::OverflowContext& ofCtx)
+{
+    // unchanged channels are already set by newAudioFrame2
+
+    int64_t outPosFrmStart = vsutils::frameToFirstSample(outFrmNum);
+    int outFrmLen = ofCtx.vsapi->getFrameLength(outFrm);
+
+    std::array<double, VS_AUDIO_FRAME_SAMPLES> samples;
+
+    for (int ch = 0; ch < outInfo.format.numChannels; ++ch)
+    {
+        if (outChannelSources[ch])
+        {
+            continue;
+        }
+
+        if (!processFrameChannel<CheckOverflow>(ch, outPosFrmStart, std::span(samples.data(), outFrmLen), sourceFrames, ofCtx))
+        {
+            return false;
+        }
+
+        sample_t* outFrmPtr = reinterpret_cast<sample_t*>(ofCtx.vsapi->getWritePtr(outFrm, ch));
+
+        // single overflow check of the whole chain
+        if (!common::safeWriteSamples<sample_t, IntSampleBits, CheckOverflow>(std::span(samples.data(), outFrmLen), outFrmPtr, outPosFrmStart, ch, ofCtx))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool Chain::writeFrame(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
+                       const std::vector<ChainSourceFrames>& sourceFrames,
+                       common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+{
+    common::OverflowContext ofCtx =
+        { .mode = overflowMode, .log = overflowLog, .funcName = FuncName,
+          .frameCtx = frameCtx, .core = core, .vsapi = vsapi,
+          .stats = overflowStats };
+
+    switch (outSampleType)
+    {
+        case common::SampleType::Int8:
+            return overflowPossible ? writeFrameImpl<int8_t, 8, true>(outFrm, outFrmNum, outChannelSources, sourceFrames, ofCtx)
+                                    : writeFrameImpl<int8_t, 8, false>(outFrm, outFrmNum, outChannelSources, sourceFrames, ofCtx);
+        case common::SampleType::Int16:
+            return overflowPossible ? writeFrameImpl<int16_t, 16, true>(outFrm, outFrmNum, outChannelSources, sourceFrames, ofCtx)
+                                    : writeFrameImpl<int16_t, 16, false>(outFrm, outFrmNum, outChannelSources, sourceFrames, ofCtx);
+        case common::SampleType::Int24:
+            return overflowPossible ? writeFrameImpl<int32_t, 24, true>(outFrm, outFrmNum, outChannelSources, sourceFrames, ofCtx)
+                                    : writeFrameImpl<int32_t, 24, false>(outFrm, outFrmNum, outChannelSources, sourceFrames, ofCtx);
+        case common::SampleType::Int32:
+            return overflowPossible ? writeFrameImpl<int32_t, 32, true>(outFrm, outFrmNum, outChannelSources, sourceFrames, ofCtx)
+                                    : writeFrameImpl<int32_t, 32, false>(outFrm, outFrmNum, outChannelSources, sourceFrames, ofCtx);
+        case common::SampleType::Float32:
+            return overflowPossible ? writeFrameImpl<float, 0, true>(outFrm, outFrmNum, outChannelSources, sourceFrames, ofCtx)
+                                    : writeFrameImpl<float, 0, false>(outFrm, outFrmNum, outChannelSources, sourceFrames, ofCtx);
+        case common::SampleType::Float64:
+            return overflowPossible ? writeFrameImpl<double, 0, true>(outFrm, outFrmNum, outChannelSources, sourceFrames, ofCtx)
+                                    : writeFrameImpl<double, 0, false>(outFrm, outFrmNum, outChannelSources, sourceFrames, ofCtx);
+        default:
+            return false;
+    }
+}
+
+
+static void VS_CC chainFree(void* instanceData, VSCore* core, const VSAPI* vsapi)
+{
+    Chain* data = static_cast<Chain*>(instanceData);
+    data->flushOverflowStats(core, vsapi);
+    data->free(vsapi);
+    delete data;
+}
+
+
+static const VSFrame* VS_CC chainGetFrame(int outFrmNum, int activationReason, void* instanceData, void** frameData, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+{
+    Chain* data = static_cast<Chain*>(instanceData);
+
+    size_t numSourceDelays = data->getSourceDelays().size();
+
+    if (activationReason == VSActivationReason::arInitial && data->isSilentOutFrame(outFrmNum))
+    {
+        // fully silent output frame (all operations keep silence silent): shared frame without any upstream request
+        data->submitOverflowStats(outFrmNum, common::OverflowStats(), core, vsapi);
+        return data->getSilenceFrame(vsutils::getFrameSampleCount(outFrmNum, data->getOutInfo().numSamples), core, vsapi);
+    }
+
+    if (activationReason == VSActivationReason::arInitial)
+    {
+        // at least one source frame is requested, see isSilentOutFrame
+        for (size_t i = 0; i < numSourceDelays; ++i)
+        {
+            common::OffsetFramePos srcFrmNums = data->outFrameToSourceFrames(outFrmNum, i);
+
+            if (0 <= srcFrmNums.left)
+            {
+                vsapi->requestFrameFilter(srcFrmNums.left, data->getAudio(), frameCtx);
+            }
+
+            if (0 <= srcFrmNums.right)
+            {
+                vsapi->requestFrameFilter(srcFrmNums.right, data->getAudio(), frameCtx);
+            }
+        }
+
+        return nullptr;
+    }
+
+    if (activationReason == VSActivationReason::arAllFramesReady)
+    {
+        std::vector<ChainSourceFrames> sourceFrames(numSourceDelays);
+
+        for (size_t i = 0; i < numSourceDelays; ++i)
+        {
+            common::OffsetFramePos srcFrmNums = data->outFrameToSourceFrames(outFrmNum, i);
+
+            if (0 <= srcFrmNums.left)
+            {
+                sourceFrames[i].left = vsapi->getFrameFilter(srcFrmNums.left, data->getAudio(), frameCtx);
+            }
+
+            if (0 <= srcFrmNums.right)
+            {
+                sourceFrames[i].right = vsapi->getFrameFilter(srcFrmNums.right, data->getAudio(), frameCtx);
+            }
+        }
+
+        int outFrmLen = vsutils::getFrameSampleCount(outFrmNum, data->getOutInfo().numSamples);
+
+        // channels without any operation are taken over from the input frames
+        std::vector<const VSFrame*> outChannelSources = data->getOutChannelSources(outFrmLen, sourceFrames, vsapi);
+
+        VSFrame* outFrm = vsutils::newAudioFrameFromChannelSources(&data->getOutInfo().format, outFrmLen, outChannelSources, nullptr, core, vsapi);
+
+        common::OverflowStats overflowStats;
+
+        bool success = data->writeFrame(outFrm, outFrmNum, outChannelSources, sourceFrames, overflowStats, frameCtx, core, vsapi);
+
+        for (const ChainSourceFrames& srcFrms : sourceFrames)
+        {
+            if (srcFrms.left)
+            {
+                vsapi->freeFrame(srcFrms.left);
+            }
+
+            if (srcFrms.right)
+            {
+                vsapi->freeFrame(srcFrms.right);
+            }
+        }
+
+        if (success)
+        {
+            common::updateFrameStatsProps(outFrm, data->isStatsEnabled(), overflowStats, vsapi);
+        }
+
+        data->submitOverflowStats(outFrmNum, std::move(overflowStats), core, vsapi);
+
+        if (success)
+        {
+            return outFrm;
+        }
+
+        vsapi->freeFrame(outFrm);
+    }
+
+    return nullptr;
+}
+
+
+enum class ChainArgType
+{
+    Int,
+    IntArray,
+    Float,
+    Data,
+};
+
+
+struct ChainArgSpec
+{
+    const char* name;
+    ChainArgType type;
+};
+
+
+struct ChainOpSpec
+{
+    const char* name;
+    ChainOpType type;
+    std::vector<ChainArgSpec> args;
+};
+
+
+static const std::vector<ChainOpSpec>& getChainOpSpecs()
+{
+    static const std::vector<ChainOpSpec> opSpecs =
+    {
+        { "gain", ChainOpType::Gain,
+          {{ "factor", ChainArgType::Float }, { "channels", ChainArgType::IntArray }} },
+        { "delay", ChainOpType::Delay,
+          {{ "samples", ChainArgType::Int }, { "seconds", ChainArgType::Float }, { "channels", ChainArgType::IntArray }} },
+        { "fadein", ChainOpType::FadeIn,
+          {{ "samples", ChainArgType::Int }, { "seconds", ChainArgType::Float },
+           { "start_sample", ChainArgType::Int }, { "start_second", ChainArgType::Float },
+           { "channels", ChainArgType::IntArray }, { "type", ChainArgType::Data }} },
+        { "fadeout", ChainOpType::FadeOut,
+          {{ "samples", ChainArgType::Int }, { "seconds", ChainArgType::Float },
+           { "end_sample", ChainArgType::Int }, { "end_second", ChainArgType::Float },
+           { "channels", ChainArgType::IntArray }, { "type", ChainArgType::Data }} },
+        { "convert", ChainOpType::Convert,
+          {{ "sample_type", ChainArgType::Data }} },
+        { "clip", ChainOpType::Clip,
+          {{ "channels", ChainArgType::IntArray }} },
+    };
+    return opSpecs;
+}
+
+
+// returns true if the whole string is a valid number
+template <typename T>
+static bool parseNumber(const std::string& str, T& value)
+{
+    const char* strEnd = str.data() + str.size();
+    auto [ptr, ec] = std::from_chars(str.data(), strEnd, value);
+    return ec == std::errc() && ptr == strEnd;
+}
+
+
+/**
+ * parses an operation string "<name> <key>=<value> ...", int[] values are separated by commas
+ * the arguments are stored in args, returns nullptr on error (message is set in out)
+ */
+static const ChainOpSpec* parseChainOpString(const std::string& opStr, const std::string& logFuncName, VSMap* args, VSMap* out, const VSAPI* vsapi)
+{
+    std::vector<std::string> tokens = utils::stringSplit(opStr, ' ');
+    if (tokens.empty())
+    {
+        vsapi->mapSetError(out, std::format("{}: empty operation", logFuncName).c_str());
+        return nullptr;
+    }
+
+    const std::vector<ChainOpSpec>& opSpecs = getChainOpSpecs();
+    auto specIt = std::find_if(opSpecs.begin(), opSpecs.end(), [&](const ChainOpSpec& spec) { return tokens[0] == spec.name; });
+    if (specIt == opSpecs.end())
+    {
+        std::vector<std::string> opNames;
+        for (const ChainOpSpec& spec : opSpecs)
+        {
+            opNames.push_back(spec.name);
+        }
+
+        std::string errMsg = std::format("{}: unknown operation: {}, must be one of: {}", logFuncName, tokens[0], utils::stringJoin(opNames, ", "));
+        vsapi->mapSetError(out, errMsg.c_str());
+        return nullptr;
+    }
+
+    for (size_t t = 1; t < tokens.size(); ++t)
+    {
+        size_t eqPos = tokens[t].find('=');
+        std::string key = tokens[t].substr(0, eqPos);
+        std::string value = eqPos == std::string::npos ? std::string() : tokens[t].substr(eqPos + 1);
+
+        auto argIt = std::find_if(specIt->args.begin(), specIt->args.end(), [&](const ChainArgSpec& arg) { return key == arg.name; });
+        if (argIt == specIt->args.end())
+        {
+            std::string errMsg = std::format("{}: unknown argument: {}", logFuncName, key);
+            vsapi->mapSetError(out, errMsg.c_str());
+            return nullptr;
+        }
+
+        if (eqPos == std::string::npos || value.empty() || 0 < vsapi->mapNumElements(args, key.c_str()))
+        {
+            std::string errMsg = std::format("{}: invalid or repeated argument: {}", logFuncName, tokens[t]);
+            vsapi->mapSetError(out, errMsg.c_str());
+            return nullptr;
+        }
+
+        bool valid = true;
+
+        switch (argIt->type)
+        {
+            case ChainArgType::Int:
+            {
+                int64_t intValue = 0;
+                valid = parseNumber(value, intValue);
+                vsapi->mapSetInt(args, key.c_str(), intValue, VSMapAppendMode::maAppend);
+                break;
+            }
+            case ChainArgType::IntArray:
+            {
+                std::vector<std::string> items = utils::stringSplit(value, ',');
+                valid = !items.empty();
+                for (const std::string& item : items)
+                {
+                    int64_t intValue = 0;
+                    valid = valid && parseNumber(item, intValue);
+                    vsapi->mapSetInt(args, key.c_str(), intValue, VSMapAppendMode::maAppend);
+                }
+                break;
+            }
+            case ChainArgType::Float:
+            {
+                double floatValue = 0;
+                valid = parseNumber(value, floatValue);
+                vsapi->mapSetFloat(args, key.c_str(), floatValue, VSMapAppendMode::maAppend);
+                break;
+            }
+            case ChainArgType::Data:
+                vsapi->mapSetData(args, key.c_str(), value.c_str(), -1, VSDataTypeHint::dtUtf8, VSMapAppendMode::maAppend);
+                break;
+        }
+
+        if (!valid)
+        {
+            std::string errMsg = std::format("{}: invalid value of argument {}: {}", logFuncName, key, value);
+            vsapi->mapSetError(out, errMsg.c_str());
+            return nullptr;
+        }
+    }
+
+    return &*specIt;
+}
+
+
+// creates an operation from its parsed arguments like the corresponding filter, returns std::nullopt on error (message is set in out)
+static std::optional<ChainOp> createChainOp(const ChainOpSpec& spec, const char* logFuncName, const VSMap* args, VSMap* out, const VSAPI* vsapi,
+                                            const VSAudioInfo* audioInfo)
+{
+    ChainOp op;
+    op.type = spec.type;
+
+    // channels:int[]:opt
+    std::vector<int> defaultChannels;
+    std::optional<std::vector<int>> optChannels = vsmap::getOptChannels("channels", logFuncName, args, out, vsapi, defaultChannels, audioInfo->format.numChannels);
+    if (!optChannels.has_value())
+    {
+        return std::nullopt;
+    }
+
+    op.channels.assign(static_cast<size_t>(audioInfo->format.numChannels), false);
+    for (const int& ch : optChannels.value())
+    {
+        op.channels[ch] = true;
+    }
+
+    switch (spec.type)
+    {
+        case ChainOpType::Gain:
+        {
+            if (vsapi->mapNumElements(args, "factor") <= 0)
+            {
+                vsapi->mapSetError(out, std::format("{}: factor not specified", logFuncName).c_str());
+                return std::nullopt;
+            }
+
+            op.gain = vsmap::getOptDouble("factor", args, vsapi, 1);
+            if (op.gain < 0)
+            {
+                vsapi->mapSetError(out, std::format("{}: negative factor", logFuncName).c_str());
+                return std::nullopt;
+            }
+            break;
+        }
+        case ChainOpType::Delay:
+        {
+            op.delaySamples = vsmap::getOptSamples("samples", "seconds", args, out, vsapi, 0, audioInfo->sampleRate);
+            break;
+        }
+        case ChainOpType::FadeIn:
+        case ChainOpType::FadeOut:
+        {
+            int64_t fadeSamples = vsmap::getOptSamples("samples", "seconds", args, out, vsapi, 0, audioInfo->sampleRate);
+            if (fadeSamples < 0)
+            {
+                vsapi->mapSetError(out, std::format("{}: negative fade length", logFuncName).c_str());
+                return std::nullopt;
+            }
+
+            std::optional<common::TransitionType> optFadeType = vsmap::getOptTransitionTypeFromString("type", logFuncName, args, out, vsapi, DefaultFadeType);
+            if (!optFadeType.has_value())
+            {
+                return std::nullopt;
+            }
+
+            if (spec.type == ChainOpType::FadeIn)
+            {
+                op.fadeStart = vsmap::getOptSamples("start_sample", "start_second", args, out, vsapi, 0, audioInfo->sampleRate);
+                op.fadeTrans = common::newTransition(optFadeType.value(), 0, 0, static_cast<double>(fadeSamples) - 1, 1);
+            }
+            else
+            {
+                int64_t endSample = vsmap::getOptSamples("end_sample", "end_second", args, out, vsapi, audioInfo->numSamples, audioInfo->sampleRate);
+                op.fadeStart = endSample - fadeSamples;
+                op.fadeTrans = common::newTransition(optFadeType.value(), 0, 1, static_cast<double>(fadeSamples) - 1, 0);
+            }
+            op.fadeEnd = op.fadeStart + fadeSamples;
+            break;
+        }
+        case ChainOpType::Convert:
+        {
+            std::optional<common::SampleType> optSampleType = vsmap::getVapourSynthSampleTypeFromString("sample_type", logFuncName, args, out, vsapi);
+            if (!optSampleType.has_value())
+            {
+                return std::nullopt;
+            }
+            op.sampleType = optSampleType.value();
+            break;
+        }
+        case ChainOpType::Clip:
+            break;
+    }
+
+    return op;
+}
+
+
+static void freeChainOps(std::vector<ChainOp>& ops)
+{
+    for (ChainOp& op : ops)
+    {
+        delete op.fadeTrans;
+        op.fadeTrans = nullptr;
+    }
+}
+
+
+static void VS_CC chainCreate(const VSMap* in, VSMap* out, void* userData, VSCore* core, const VSAPI* vsapi)
+{
+    // clip:anode
+    int err = 0;
+    VSNode* audio = vsapi->mapGetNode(in, "clip", 0, &err);
+    if (err)
+    {
+        return;
+    }
+
+    const VSAudioInfo* audioInfo = vsapi->getAudioInfo(audio);
+
+    // check for supported audio format
+    auto optSampleType = common::getSampleTypeFromAudioFormat(audioInfo->format);
+    if (!optSampleType.has_value())
+    {
+        std::string errMsg = std::format("{}: unsupported audio format", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // ops:data[]
+    std::vector<ChainOp> ops;
+    int numOps = std::max(0, vsapi->mapNumElements(in, "ops"));
+
+    // sample types after each operation
+    std::vector<common::SampleType> opSampleTypes;
+    common::SampleType sampleType = optSampleType.value();
+
+    for (int i = 0; i < numOps; ++i)
+    {
+        std::string opStr = vsapi->mapGetData(in, "ops", i, &err);
+        std::string logFuncName = std::format("{}: ops[{}]", FuncName, i);
+
+        VSMap* args = vsapi->createMap();
+
+        std::optional<ChainOp> optOp;
+        if (const ChainOpSpec* spec = parseChainOpString(opStr, logFuncName, args, out, vsapi))
+        {
+            logFuncName = std::format("{} {}", logFuncName, spec->name);
+            optOp = createChainOp(*spec, logFuncName.c_str(), args, out, vsapi, audioInfo);
+        }
+
+        vsapi->freeMap(args);
+
+        if (!optOp.has_value())
+        {
+            freeChainOps(ops);
+            vsapi->freeNode(audio);
+            return;
+        }
+
+        if (optOp.value().type == ChainOpType::Convert)
+        {
+            sampleType = optOp.value().sampleType;
+        }
+        opSampleTypes.push_back(sampleType);
+
+        ops.push_back(std::move(optOp.value()));
+    }
+
+    // strict:int:opt
+    bool strict = vsmap::getOptBool("strict", in, vsapi, DefaultStrict);
+
+    // overflow:data:opt
+    std::optional<common::OverflowMode> optOverflowMode = vsmap::getOptOverflowModeFromString("overflow", FuncName, in, out, vsapi, DefaultOverflowMode);
+    if (!optOverflowMode.has_value())
+    {
+        freeChainOps(ops);
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    if (optOverflowMode.value() == common::OverflowMode::KeepFloat)
+    {
+        // in strict mode every intermediate sample type is checked for overflows
+        bool intSampleType = !common::isFloatSampleType(sampleType) ||
+                             (strict && std::any_of(opSampleTypes.begin(), opSampleTypes.end(), [](common::SampleType st) { return !common::isFloatSampleType(st); }));
+
+        if (intSampleType)
+        {
+            std::string errMsg = std::format("{}: cannot use 'keep_float' overflow mode with an integer sample type", FuncName);
+            vsapi->mapSetError(out, errMsg.c_str());
+            freeChainOps(ops);
+            vsapi->freeNode(audio);
+            return;
+        }
+    }
+
+    // overflow_log:data:opt
+    std::optional<common::OverflowLog> optOverflowLog = vsmap::getOptOverflowLogFromString("overflow_log", FuncName, in, out, vsapi, DefaultOverflowLog);
+    if (!optOverflowLog.has_value())
+    {
+        freeChainOps(ops);
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // stats:int:opt
+    bool stats = vsmap::getOptBool("stats", in, vsapi, DefaultStats);
+
+    Chain* data = new Chain(audio, audioInfo, std::move(ops), strict, optOverflowMode.value(), optOverflowLog.value(), stats);
+
+    VSFilterDependency deps[] = {{ audio, rpGeneral }};
+
+    common::logOverflowCheck(FuncName, data->isOverflowPossible(), core, vsapi);
+
+    // fmParallel: overflows are collected per frame and logged in frame order by common::OverflowTracker
+    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), chainGetFrame, chainFree, VSFilterMode::fmParallel, deps, 1, data, core);
+}
+
+
+void chainInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi)
+{
+    vspapi->registerFunction(FuncName,
+                             "clip:anode;"
+                             "ops:data[];"
+                             "strict:int:opt;"
+                             "overflow:data:opt;"
+                             "overflow_log:data:opt;"
+                             "stats:int:opt;",
+                             "return:anode;",
+                             chainCreate, nullptr, plugin);
+}
@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+#include "common/offset.hpp"
+#include "common/overflow.hpp"
+#include "common/sampletype.hpp"
+#include "common/silenceframes.hpp"
+#include "common/transition.hpp"
+
+enum class ChainOpType
+{
+    Gain,
+    Delay,
+    FadeIn,
+    FadeOut,
+    Convert,
+    Clip,
+};
+
+
+// one operation of a chain, works like the corresponding filter
+struct ChainOp
+{
+    ChainOpType type;
+
+    // true for every channel the operation is applied to
+    std::vector<bool> channels;
+
+    // Gain
+    double gain = 1;
+
+    // Delay
+    int64_t delaySamples = 0;
+
+    // FadeIn, FadeOut: [fadeStart, fadeEnd)
+    int64_t fadeStart = 0;
+    int64_t fadeEnd = 0;
+    common::Transition* fadeTrans = nullptr;
+
+    // Convert
+    common::SampleType sampleType = common::SampleType::Float32;
+};
+
+
+// input frames of one source delay
+struct ChainSourceFrames
+{
+    const VSFrame* left = nullptr;
+    const VSFrame* right = nullptr;
+};
+
+
+class Chain
+{
+public:
+    Chain(VSNode* audio, const VSAudioInfo* audioInfo, std::vector<ChainOp> ops, bool strict,
+          common::OverflowMode overflowMode, common::OverflowLog overflowLog, bool stats);
+
+    VSNode* getAudio();
+
+    const VSAudioInfo& getOutInfo();
+
+    // false if no output or intermediate (strict) sample can overflow, see common::isOverflowPossible
+    bool isOverflowPossible();
+
+    // true if the stats props are written to every output frame, see common/stats.hpp
+    bool isStatsEnabled();
+
+    // distinct delays of the input audio over all channels (sum of all delay operations of a channel)
+    const std::vector<int64_t>& getSourceDelays();
+
+    common::OffsetFramePos outFrameToSourceFrames(int outFrmNum, size_t sourceDelayIndex);
+
+    // true if no source frame is read for this output frame: all channels are silenced by delay operations
+    bool isSilentOutFrame(int outFrmNum);
+
+    // returns a new reference of the shared silent output frame, see common::SilenceFrames
+    const VSFrame* getSilenceFrame(int outFrmLen, VSCore* core, const VSAPI* vsapi);
+
+    /**
+     * returns the source frame of each output channel that is taken over unchanged (for newAudioFrame2)
+     * only channels without any operation are taken over
+     * nullptr: the channel has to be written by writeFrame
+     */
+    std::vector<const VSFrame*> getOutChannelSources(int outFrmLen, const std::vector<ChainSourceFrames>& sourceFrames, const VSAPI* vsapi);
+
+    void submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi);
+
+    void flushOverflowStats(VSCore* core, const VSAPI* vsapi);
+
+    void free(const VSAPI* vsapi);
+
+    // writes all channels without an out channel source
+    bool writeFrame(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
+                    const std::vector<ChainSourceFrames>& sourceFrames,
+                    common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
+
+private:
+    // per channel plan of the operations
+    struct ChannelPlan
+    {
+        size_t sourceDelayIndex;
+
+        // output position - opOutPosOffsets[i] = sample position operation i is working on
+        // (sum of the delays of all following operations)
+        std::vector<int64_t> opOutPosOffsets;
+
+        // output samples that are not silenced by a delay: [outPosValidStart, outPosValidEnd)
+        int64_t outPosValidStart;
+        int64_t outPosValidEnd;
+
+        // no operation is applied to this channel
+        bool passthrough;
+
+        // last operation that is applied to this channel
+        size_t lastOpIndex;
+    };
+
+    VSNode* audio;
+    const VSAudioInfo inInfo;
+
+    VSAudioInfo outInfo;
+
+    common::SampleType inSampleType;
+    common::SampleType outSampleType;
+
+    std::vector<ChainOp> ops;
+
+    // sample type after each operation
+    std::vector<common::SampleType> opSampleTypes;
+
+    // quantize to the current sample type and handle overflows after every operation
+    bool strict;
+
+    std::vector<int64_t> sourceDelays;
+    std::vector<common::FrameSampleOffsets> sourceFrameSampleOffsets;
+
+    std::vector<ChannelPlan> channelPlans;
+
+    common::OverflowMode overflowMode;
+    common::OverflowLog overflowLog;
+
+    common::OverflowTracker overflowTracker;
+
+    // selects the writeFrameImpl specialization with or without overflow checks
+    bool overflowPossible;
+
+    bool stats;
+
+    common::SilenceFrames silenceFrames;
+
+    void initChannelPlans();
+
+    void initOverflowPossible();
+
+    // processes the samples of one output frame channel, returns false on an overflow error
+    template <bool CheckOverflow>
+    bool processFrameChannel(int ch, int64_t outPosFrmStart, std::span<double> samples,
+                             const std::vector<ChainSourceFrames>& sourceFrames, const common::OverflowContext& ofCtx);
+
+    template <typename sample_t, size_t IntSampleBits, bool CheckOverflow>
+    bool writeFrameImpl(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
+                        const std::vector<ChainSourceFrames>& sourceFrames, const common::OverflowContext& ofCtx);
+};
+
+
+void chainInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi);
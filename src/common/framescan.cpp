@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <format>
+#include <mutex>
+#include <string>
+
+#include "VapourSynth4.h"
+
+#include "common/framescan.hpp"
+
+namespace common
+{
+    // shared state of one scanFrames call, accessed by the frame done callbacks of the worker threads
+    struct FrameScan
+    {
+        FrameScan(VSNode* _audio, int _numFrames, const ScanControl& _control, const char* _scanName, const ScanFrameFunc& _frameFunc,
+                  VSCore* _core, const VSAPI* _vsapi) :
+            audio(_audio), numFrames(_numFrames), control(_control), scanName(_scanName), frameFunc(_frameFunc), core(_core), vsapi(_vsapi)
+        {
+        }
+
+        VSNode* audio;
+        int numFrames;
+        const ScanControl& control;
+        const char* scanName;
+        const ScanFrameFunc& frameFunc;
+        VSCore* core;
+        const VSAPI* vsapi;
+
+        std::mutex mutex;
+        std::condition_variable done;
+
+        // guarded by mutex
+        int nextFrame = 0;
+        int numInFlight = 0;
+        // frameFunc returned false -> skip remaining frames
+        bool stopped = false;
+
+        // progress: number of finished frames and the next percentage to log
+        int numDone = 0;
+        int nextProgressPercent = ProgressStepPercent;
+
+        static constexpr int ProgressStepPercent = 10;
+    };
+
+
+    static void VS_CC frameScanFrameDone(void* userData, const VSFrame* frame, int n, VSNode* node, const char* errorMsg)
+    {
+        FrameScan* scan = static_cast<FrameScan*>(userData);
+
+        bool skip;
+        {
+            std::lock_guard<std::mutex> lock(scan->mutex);
+            skip = scan->stopped;
+        }
+
+        if (scan->control.frameObserver)
+        {
+            (*scan->control.frameObserver)(n, frame);
+        }
+
+        bool keepScanning = skip || scan->frameFunc(n, frame, errorMsg);
+
+        if (frame)
+        {
+            scan->vsapi->freeFrame(frame);
+        }
+
+        // scan is destroyed by scanFrames once the last frame is done
+        const VSAPI* vsapi = scan->vsapi;
+        VSCore* core = scan->core;
+
+        int requestFrame = -1;
+        std::string progressMsg;
+        {
+            std::lock_guard<std::mutex> lock(scan->mutex);
+
+            ++scan->numDone;
+
+            int64_t percent = static_cast<int64_t>(scan->numDone) * 100 / scan->numFrames;
+            if (scan->control.progressFuncName && scan->nextProgressPercent <= percent)
+            {
+                progressMsg = std::format("{}: {} scan {}% ({} / {} frames)", scan->control.progressFuncName, scan->scanName, percent, scan->numDone, scan->numFrames);
+                scan->nextProgressPercent = static_cast<int>(percent / FrameScan::ProgressStepPercent + 1) * FrameScan::ProgressStepPercent;
+            }
+
+            scan->stopped |= !keepScanning;
+
+            if (!scan->stopped && !scan->control.isCancelled() && scan->nextFrame < scan->numFrames)
+            {
+                // keep the window full
+                requestFrame = scan->nextFrame++;
+            }
+            else
+            {
+                --scan->numInFlight;
+
+                if (scan->numInFlight == 0)
+                {
+                    scan->done.notify_all();
+                }
+            }
+        }
+
+        if (!progressMsg.empty())
+        {
+            vsapi->logMessage(VSMessageType::mtInformation, progressMsg.c_str(), core);
+        }
+
+        if (requestFrame != -1)
+        {
+            vsapi->getFrameAsync(requestFrame, scan->audio, frameScanFrameDone, scan);
+        }
+    }
+
+
+    void scanFrames(VSNode* audio, int numFrames, int maxRequests, const ScanControl& control, const char* scanName,
+                    const ScanFrameFunc& frameFunc, VSCore* core, const VSAPI* vsapi)
+    {
+        if (numFrames <= 0)
+        {
+            return;
+        }
+
+        if (maxRequests <= 0)
+        {
+            VSCoreInfo coreInfo;
+            vsapi->getCoreInfo(core, &coreInfo);
+            maxRequests = coreInfo.numThreads;
+        }
+
+        FrameScan scan(audio, numFrames, control, scanName, frameFunc, core, vsapi);
+
+        int numRequests;
+        {
+            std::lock_guard<std::mutex> lock(scan.mutex);
+            numRequests = std::min(std::max(maxRequests, 1), scan.numFrames);
+            scan.nextFrame = numRequests;
+            scan.numInFlight = numRequests;
+        }
+
+        // the callbacks may already run before all initial requests are sent
+        for (int n = 0; n < numRequests; ++n)
+        {
+            vsapi->getFrameAsync(n, audio, frameScanFrameDone, &scan);
+        }
+
+        std::unique_lock<std::mutex> lock(scan.mutex);
+        scan.done.wait(lock, [&scan] { return scan.numInFlight == 0; });
+    }
+}
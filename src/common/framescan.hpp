@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+
+#include "VapourSynth4.h"
+
+namespace common
+{
+    // sees every read frame of a scan, frame is nullptr if it could not be read, called from the worker threads in any frame order
+    using ScanFrameObserver = std::function<void(int n, const VSFrame* frame)>;
+
+
+    // optional progress logging, cancellation and frame observer of scanFrames
+    struct ScanControl
+    {
+        // logs the progress in 10% steps as information message with this function name, nullptr: no progress messages
+        const char* progressFuncName = nullptr;
+
+        // stops requesting frames once set to true, the result of the scan is incomplete then
+        const std::atomic<bool>* cancel = nullptr;
+
+        // called for every read frame before the scan function, also for frames that are skipped after the scan was stopped
+        // e.g. to checksum the frames in the same pass, nullptr: no observer
+        const ScanFrameObserver* frameObserver = nullptr;
+
+        bool isCancelled() const
+        {
+            return cancel && cancel->load();
+        }
+    };
+
+
+    /**
+     * called from the worker threads for every read frame, in any frame order
+     * frame is nullptr and errorMsg is set if the frame could not be read, the frame is freed by scanFrames afterwards
+     * returns false to skip the remaining frames (e.g. the result is already known)
+     */
+    using ScanFrameFunc = std::function<bool(int n, const VSFrame* frame, const char* errorMsg)>;
+
+
+    /**
+     * reads the frames [0, numFrames) of audio and passes them to frameFunc
+     * keeps up to maxRequests frame requests in flight (<= 0: number of VapourSynth threads)
+     * this is blocking until all requested frames are done
+     * scanName is part of the progress messages, e.g. "peak" -> "Normalize: peak scan 10% (...)"
+     * can be called from any thread, e.g. to scan in the background while the filter graph is built
+     */
+    void scanFrames(VSNode* audio, int numFrames, int maxRequests, const ScanControl& control, const char* scanName,
+                    const ScanFrameFunc& frameFunc, VSCore* core, const VSAPI* vsapi);
+}
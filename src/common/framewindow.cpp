@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+
+#include "VapourSynth4.h"
+
+#include "common/framewindow.hpp"
+#include "common/offset.hpp"
+
+namespace common
+{
+    void FrameWindow::init(size_t _capacity)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        capacity = _capacity;
+    }
+
+
+    const VSFrame* FrameWindow::get(int frmNum, const VSAPI* vsapi)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto it = std::find_if(frames.begin(), frames.end(), [frmNum](const std::pair<int, const VSFrame*>& f) { return f.first == frmNum; });
+        if (it == frames.end())
+        {
+            return nullptr;
+        }
+
+        return vsapi->addFrameRef(it->second);
+    }
+
+
+    void FrameWindow::put(int frmNum, const VSFrame* frm, const VSAPI* vsapi)
+    {
+        if (capacity == 0)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (std::any_of(frames.begin(), frames.end(), [frmNum](const std::pair<int, const VSFrame*>& f) { return f.first == frmNum; }))
+        {
+            // already added by another output frame
+            return;
+        }
+
+        if (frames.size() == capacity)
+        {
+            vsapi->freeFrame(frames.front().second);
+            frames.pop_front();
+        }
+
+        frames.emplace_back(frmNum, vsapi->addFrameRef(frm));
+    }
+
+
+    void FrameWindow::clear(const VSAPI* vsapi)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (const std::pair<int, const VSFrame*>& f : frames)
+        {
+            vsapi->freeFrame(f.second);
+        }
+
+        frames.clear();
+    }
+
+
+    static bool takeOrRequestFrame(int frmNum, VSNode* node, FrameWindow& window, const VSFrame*& windowFrm,
+                                   VSFrameContext* frameCtx, const VSAPI* vsapi)
+    {
+        windowFrm = nullptr;
+
+        if (frmNum < 0)
+        {
+            return false;
+        }
+
+        windowFrm = window.get(frmNum, vsapi);
+        if (windowFrm)
+        {
+            return false;
+        }
+
+        vsapi->requestFrameFilter(frmNum, node, frameCtx);
+        return true;
+    }
+
+
+    bool requestOffsetFrames(const OffsetFramePos& frmNums, VSNode* node, FrameWindow& window, OffsetFrames& windowFrms,
+                             VSFrameContext* frameCtx, const VSAPI* vsapi)
+    {
+        bool requestedL = takeOrRequestFrame(frmNums.left, node, window, windowFrms.left, frameCtx, vsapi);
+        bool requestedR = takeOrRequestFrame(frmNums.right, node, window, windowFrms.right, frameCtx, vsapi);
+
+        return requestedL || requestedR;
+    }
+
+
+    static const VSFrame* getWindowOrFetchedFrame(int frmNum, const VSFrame* windowFrm, VSNode* node, FrameWindow& window,
+                                                  VSFrameContext* frameCtx, const VSAPI* vsapi)
+    {
+        if (frmNum < 0)
+        {
+            return nullptr;
+        }
+
+        if (windowFrm)
+        {
+            return windowFrm;
+        }
+
+        const VSFrame* frm = vsapi->getFrameFilter(frmNum, node, frameCtx);
+        window.put(frmNum, frm, vsapi);
+        return frm;
+    }
+
+
+    OffsetFrames getOffsetFrames(const OffsetFramePos& frmNums, const OffsetFrames& windowFrms, VSNode* node, FrameWindow& window,
+                                 VSFrameContext* frameCtx, const VSAPI* vsapi)
+    {
+        return {
+            .left = getWindowOrFetchedFrame(frmNums.left, windowFrms.left, node, window, frameCtx, vsapi),
+            .right = getWindowOrFetchedFrame(frmNums.right, windowFrms.right, node, window, frameCtx, vsapi)
+        };
+    }
+
+
+    WindowFrames* releaseWindowFrames(void** frameData)
+    {
+        WindowFrames* windowFrms = static_cast<WindowFrames*>(*frameData);
+        *frameData = nullptr;
+        return windowFrms;
+    }
+
+
+    void freeWindowFrames(void** frameData, const VSAPI* vsapi)
+    {
+        WindowFrames* windowFrms = releaseWindowFrames(frameData);
+        if (!windowFrms)
+        {
+            return;
+        }
+
+        for (const OffsetFrames& frms : *windowFrms)
+        {
+            vsapi->freeFrame(frms.left);
+            vsapi->freeFrame(frms.right);
+        }
+
+        delete windowFrms;
+    }
+}
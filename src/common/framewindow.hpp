@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+#include "common/offset.hpp"
+
+namespace common
+{
+    /**
+     * keeps the most recently fetched frames of an input node
+     * if an input is not frame aligned every input frame is needed by two output frames (as right and as left offset frame),
+     * with the window it is only fetched once during linear rendering
+     * thread safe, the frames can be processed in any order and in parallel (fmParallel)
+     */
+    class FrameWindow
+    {
+    public:
+        static constexpr size_t DefaultCapacity = 4;
+
+        // capacity 0 disables the window
+        void init(size_t capacity);
+
+        // returns a new reference of the frame or nullptr if the frame is not in the window
+        const VSFrame* get(int frmNum, const VSAPI* vsapi);
+
+        // adds a reference of the frame to the window, the oldest frame is dropped if the window is full
+        void put(int frmNum, const VSFrame* frm, const VSAPI* vsapi);
+
+        // frees all frames, call before the input node is freed
+        void clear(const VSAPI* vsapi);
+
+    private:
+        std::mutex mutex;
+
+        size_t capacity = 0;
+
+        // oldest frame first
+        std::deque<std::pair<int, const VSFrame*>> frames;
+    };
+
+
+    // left and right offset frame of an output frame, nullptr if not needed (see OffsetFramePos)
+    struct OffsetFrames
+    {
+        const VSFrame* left;
+        const VSFrame* right;
+    };
+
+    // offset frames taken from the frame windows in arInitial (one entry per input), kept in frameData until arAllFramesReady or arError
+    using WindowFrames = std::vector<OffsetFrames>;
+
+    /**
+     * arInitial: takes the offset frames from the window, all other needed offset frames are requested from node
+     * the frames taken from the window are written to windowFrms and have to be passed to getOffsetFrames
+     * returns true if at least one frame was requested
+     */
+    bool requestOffsetFrames(const OffsetFramePos& frmNums, VSNode* node, FrameWindow& window, OffsetFrames& windowFrms,
+                             VSFrameContext* frameCtx, const VSAPI* vsapi);
+
+    /**
+     * arAllFramesReady: returns the offset frames (the caller owns the references)
+     * frames that are not in windowFrms are fetched from node and added to the window
+     */
+    OffsetFrames getOffsetFrames(const OffsetFramePos& frmNums, const OffsetFrames& windowFrms, VSNode* node, FrameWindow& window,
+                                 VSFrameContext* frameCtx, const VSAPI* vsapi);
+
+    // moves the window frames out of frameData (nullptr if there are none)
+    WindowFrames* releaseWindowFrames(void** frameData);
+
+    // arError: frees the window frames in frameData
+    void freeWindowFrames(void** frameData, const VSAPI* vsapi);
+}
@@ -0,0 +1,555 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <numbers>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+#include "common/framescan.hpp"
+#include "common/loudness.hpp"
+#include "common/sampletype.hpp"
+#include "simd/sampleconv.hpp"
+#include "vsutils/audio.hpp"
+
+namespace common
+{
+    // gating block hop: 100 ms, the 400 ms and 3 s blocks are made of consecutive hops
+    constexpr int MomentaryHops = 4;
+    constexpr int ShortTermHops = 30;
+
+    constexpr double AbsoluteGate = -70;
+    constexpr double IntegratedRelativeGate = -10;
+    constexpr double RangeRelativeGate = -20;
+
+    constexpr double RangeLowPercentile = 0.10;
+    constexpr double RangeHighPercentile = 0.95;
+
+    constexpr double SurroundChannelWeight = 1.41;
+
+
+    double getLoudnessChannelWeight(int vsChannel)
+    {
+        switch (vsChannel)
+        {
+            case VSAudioChannels::acLowFrequency:
+            case VSAudioChannels::acLowFrequency2:
+                return 0;
+            case VSAudioChannels::acBackLeft:
+            case VSAudioChannels::acBackRight:
+            case VSAudioChannels::acSideLeft:
+            case VSAudioChannels::acSideRight:
+                return SurroundChannelWeight;
+            default:
+                return 1;
+        }
+    }
+
+
+    static double powerToLoudness(double power)
+    {
+        return -0.691 + 10 * std::log10(power);
+    }
+
+
+    // transposed direct form II
+    struct Biquad
+    {
+        double b0;
+        double b1;
+        double b2;
+        double a1;
+        double a2;
+    };
+
+
+    // filter state of the K-weighting: two state values per biquad
+    using KWeightingState = std::array<double, 4>;
+
+    constexpr size_t KWeightingStateSize = std::tuple_size_v<KWeightingState>;
+
+    // number of distinct products of two state values
+    constexpr size_t KWeightingStatePairs = KWeightingStateSize * (KWeightingStateSize + 1) / 2;
+
+
+    // K-weighting of BS.1770: high shelf (head) followed by the RLB high pass, coefficients for any sample rate
+    class KWeighting
+    {
+    public:
+        explicit KWeighting(double sampleRate)
+        {
+            {
+                constexpr double f0 = 1681.974450955533;
+                constexpr double gainDb = 3.999843853973347;
+                constexpr double q = 0.7071752369554196;
+
+                double k = std::tan(std::numbers::pi * f0 / sampleRate);
+                double vh = std::pow(10.0, gainDb / 20);
+                double vb = std::pow(vh, 0.4996667741545416);
+                double a0 = 1 + k / q + k * k;
+
+                shelf = { .b0 = (vh + vb * k / q + k * k) / a0,
+                          .b1 = 2 * (k * k - vh) / a0,
+                          .b2 = (vh - vb * k / q + k * k) / a0,
+                          .a1 = 2 * (k * k - 1) / a0,
+                          .a2 = (1 - k / q + k * k) / a0 };
+            }
+            {
+                constexpr double f0 = 38.13547087602444;
+                constexpr double q = 0.5003270373238773;
+
+                double k = std::tan(std::numbers::pi * f0 / sampleRate);
+                double a0 = 1 + k / q + k * k;
+
+                highPass = { .b0 = 1,
+                             .b1 = -2,
+                             .b2 = 1,
+                             .a1 = 2 * (k * k - 1) / a0,
+                             .a2 = (1 - k / q + k * k) / a0 };
+            }
+        }
+
+        // in and out may be the same buffer
+        void process(const double* in, double* out, int numSamples, KWeightingState& state) const
+        {
+            double z0 = state[0];
+            double z1 = state[1];
+            double z2 = state[2];
+            double z3 = state[3];
+
+            for (int s = 0; s < numSamples; ++s)
+            {
+                double x = in[s];
+
+                double y1 = shelf.b0 * x + z0;
+                z0 = shelf.b1 * x - shelf.a1 * y1 + z1;
+                z1 = shelf.b2 * x - shelf.a2 * y1;
+
+                double y2 = highPass.b0 * y1 + z2;
+                z2 = highPass.b1 * y1 - highPass.a1 * y2 + z3;
+                z3 = highPass.b2 * y1 - highPass.a2 * y2;
+
+                out[s] = y2;
+            }
+
+            state = { z0, z1, z2, z3 };
+        }
+
+    private:
+        Biquad shelf;
+        Biquad highPass;
+    };
+
+
+    /**
+     * the K-weighting is linear in the input and the filter state:
+     * output of a frame = output with zero initial state + sum of initState[k] * zeroInputResponse[k]
+     * this allows to filter the frames independently and to add the filter state of the previous frames in frame order afterwards
+     */
+    class KWeightingZeroInput
+    {
+    public:
+        KWeightingZeroInput(const KWeighting& kWeighting, int lastFrameLength)
+        {
+            std::array<double, VS_AUDIO_FRAME_SAMPLES> zeros = {};
+
+            for (size_t k = 0; k < KWeightingStateSize; ++k)
+            {
+                KWeightingState state = {};
+                state[k] = 1;
+
+                response[k].resize(VS_AUDIO_FRAME_SAMPLES);
+
+                KWeightingState lastFrameState = state;
+                kWeighting.process(zeros.data(), response[k].data(), lastFrameLength, lastFrameState);
+                kWeighting.process(zeros.data(), response[k].data(), VS_AUDIO_FRAME_SAMPLES, state);
+
+                for (size_t i = 0; i < KWeightingStateSize; ++i)
+                {
+                    frameTransition[i][k] = state[i];
+                    lastFrameTransition[i][k] = lastFrameState[i];
+                }
+            }
+
+            size_t pair = 0;
+            for (size_t j = 0; j < KWeightingStateSize; ++j)
+            {
+                for (size_t k = j; k < KWeightingStateSize; ++k, ++pair)
+                {
+                    std::vector<double>& prefix = responseProductPrefix[pair];
+                    prefix.resize(VS_AUDIO_FRAME_SAMPLES + 1);
+                    prefix[0] = 0;
+
+                    for (int t = 0; t < VS_AUDIO_FRAME_SAMPLES; ++t)
+                    {
+                        prefix[t + 1] = prefix[t] + response[j][t] * response[k][t];
+                    }
+                }
+            }
+        }
+
+        // response[k][t]: zero input response at sample t of the frame for the initial state e_k
+        std::array<std::vector<double>, KWeightingStateSize> response;
+
+        // sums of response[j][t] * response[k][t] for j <= k over [0, t)
+        std::array<std::vector<double>, KWeightingStatePairs> responseProductPrefix;
+
+        // end state = zero state end state + transition * initial state, for full frames and for the last frame
+        std::array<KWeightingState, KWeightingStateSize> frameTransition;
+        std::array<KWeightingState, KWeightingStateSize> lastFrameTransition;
+    };
+
+
+    // part of a frame inside one hop: [begin, end) relative to the frame start
+    struct HopSegment
+    {
+        int64_t hop;
+        int begin;
+        int end;
+    };
+
+
+    // sums of one channel over a hop segment with zero initial filter state
+    struct HopSegmentSums
+    {
+        // sum of y0[t]^2
+        double zeroStateSquares;
+
+        // sums of y0[t] * response[k][t]
+        KWeightingState zeroStateResponse;
+    };
+
+
+    // result of the parallel part for one frame
+    struct LoudnessFrameSums
+    {
+        std::vector<HopSegment> segments;
+
+        // index: measured channel * number of segments + segment
+        std::vector<HopSegmentSums> sums;
+
+        // filter state at the frame end with zero initial state, per measured channel
+        std::vector<KWeightingState> zeroStateEnd;
+    };
+
+
+    struct LoudnessChannel
+    {
+        int channel;
+        double weight;
+    };
+
+
+    // shared state of one measureLoudness call, accessed by the scan callbacks of the worker threads
+    class LoudnessScan
+    {
+    public:
+        LoudnessScan(const VSAudioInfo* audioInfo, std::vector<LoudnessChannel> _channels) :
+            channels(std::move(_channels)),
+            sampleType(common::getSampleTypeFromAudioFormat(audioInfo->format).value()),
+            numFrames(audioInfo->numFrames),
+            hopLength(std::max<int64_t>(std::llround(audioInfo->sampleRate / 10.0), 1)),
+            kWeighting(audioInfo->sampleRate),
+            zeroInput(kWeighting, static_cast<int>(audioInfo->numSamples - vsutils::frameToFirstSample(audioInfo->numFrames - 1)))
+        {
+            // the incomplete last hop is not measured
+            hopSquares.resize(static_cast<size_t>(audioInfo->numSamples / hopLength), 0);
+
+            states.resize(channels.size(), KWeightingState());
+        }
+
+        // parallel part: K-weighting of the frame with zero initial state, summed up per hop segment
+        LoudnessFrameSums sumFrame(int n, const VSFrame* frame, const VSAPI* vsapi) const
+        {
+            LoudnessFrameSums frameSums;
+
+            int frmLen = vsapi->getFrameLength(frame);
+            int64_t posFrmStart = vsutils::frameToFirstSample(n);
+
+            for (int begin = 0; begin < frmLen;)
+            {
+                int64_t hop = (posFrmStart + begin) / hopLength;
+                if (static_cast<size_t>(hop) >= hopSquares.size())
+                {
+                    break;
+                }
+
+                int end = static_cast<int>(std::min<int64_t>((hop + 1) * hopLength - posFrmStart, frmLen));
+                frameSums.segments.push_back({ .hop = hop, .begin = begin, .end = end });
+                begin = end;
+            }
+
+            size_t numSegments = frameSums.segments.size();
+            frameSums.sums.resize(channels.size() * numSegments);
+            frameSums.zeroStateEnd.resize(channels.size(), KWeightingState());
+
+            std::array<double, VS_AUDIO_FRAME_SAMPLES> samples;
+
+            for (size_t c = 0; c < channels.size(); ++c)
+            {
+                simd::convSamplesToDouble(sampleType, vsapi->getReadPtr(frame, channels[c].channel), samples.data(), frmLen);
+
+                kWeighting.process(samples.data(), samples.data(), frmLen, frameSums.zeroStateEnd[c]);
+
+                for (size_t seg = 0; seg < numSegments; ++seg)
+                {
+                    const HopSegment& segment = frameSums.segments[seg];
+                    HopSegmentSums& sums = frameSums.sums[c * numSegments + seg];
+
+                    sums = HopSegmentSums();
+
+                    for (int t = segment.begin; t < segment.end; ++t)
+                    {
+                        double y0 = samples[t];
+                        sums.zeroStateSquares += y0 * y0;
+
+                        for (size_t k = 0; k < KWeightingStateSize; ++k)
+                        {
+                            sums.zeroStateResponse[k] += y0 * zeroInput.response[k][t];
+                        }
+                    }
+                }
+            }
+
+            return frameSums;
+        }
+
+        // sequential part, called with the frames in any order
+        void addFrame(int n, LoudnessFrameSums frameSums)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            pendingFrames.emplace(n, std::move(frameSums));
+
+            // the filter state of a frame is only known once all previous frames are added
+            for (auto it = pendingFrames.find(nextFrame); it != pendingFrames.end(); it = pendingFrames.find(nextFrame))
+            {
+                addFrameInOrder(it->second, nextFrame == numFrames - 1);
+                pendingFrames.erase(it);
+                ++nextFrame;
+            }
+        }
+
+        void setError(const char* errorMsg)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (error.empty())
+            {
+                error = errorMsg ? errorMsg : "unknown error";
+            }
+        }
+
+        std::optional<LoudnessResult> getResult(std::string& errMsg)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (!error.empty())
+            {
+                errMsg = error;
+                return std::nullopt;
+            }
+
+            if (nextFrame < numFrames)
+            {
+                errMsg = "loudness scan cancelled";
+                return std::nullopt;
+            }
+
+            std::vector<double> momentary = getBlockLoudness(MomentaryHops);
+            std::vector<double> shortTerm = getBlockLoudness(ShortTermHops);
+
+            return LoudnessResult{ .integrated = getGatedLoudness(momentary, IntegratedRelativeGate).first,
+                                   .range = getLoudnessRange(shortTerm),
+                                   .momentaryMax = getMaxLoudness(momentary),
+                                   .shortTermMax = getMaxLoudness(shortTerm) };
+        }
+
+    private:
+        const std::vector<LoudnessChannel> channels;
+        const common::SampleType sampleType;
+        const int numFrames;
+        const int64_t hopLength;
+
+        const KWeighting kWeighting;
+        const KWeightingZeroInput zeroInput;
+
+        std::mutex mutex;
+
+        // guarded by mutex
+        std::map<int, LoudnessFrameSums> pendingFrames;
+        int nextFrame = 0;
+        // filter state at the end of frame nextFrame - 1, per measured channel
+        std::vector<KWeightingState> states;
+        // channel weighted sums of the squared K-weighted samples per hop
+        std::vector<double> hopSquares;
+        std::string error;
+
+        void addFrameInOrder(const LoudnessFrameSums& frameSums, bool lastFrame)
+        {
+            const auto& transition = lastFrame ? zeroInput.lastFrameTransition : zeroInput.frameTransition;
+
+            size_t numSegments = frameSums.segments.size();
+
+            for (size_t c = 0; c < channels.size(); ++c)
+            {
+                const KWeightingState& state = states[c];
+
+                for (size_t seg = 0; seg < numSegments; ++seg)
+                {
+                    const HopSegment& segment = frameSums.segments[seg];
+                    const HopSegmentSums& sums = frameSums.sums[c * numSegments + seg];
+
+                    // sum of (y0 + sum_k state[k] * response[k])^2
+                    double squares = sums.zeroStateSquares;
+
+                    size_t pair = 0;
+                    for (size_t j = 0; j < KWeightingStateSize; ++j)
+                    {
+                        squares += 2 * state[j] * sums.zeroStateResponse[j];
+
+                        for (size_t k = j; k < KWeightingStateSize; ++k, ++pair)
+                        {
+                            const std::vector<double>& prefix = zeroInput.responseProductPrefix[pair];
+                            double product = state[j] * state[k] * (prefix[segment.end] - prefix[segment.begin]);
+                            squares += j == k ? product : 2 * product;
+                        }
+                    }
+
+                    // negative only by rounding errors
+                    hopSquares[segment.hop] += channels[c].weight * std::max(squares, 0.0);
+                }
+
+                KWeightingState endState = frameSums.zeroStateEnd[c];
+                for (size_t i = 0; i < KWeightingStateSize; ++i)
+                {
+                    for (size_t k = 0; k < KWeightingStateSize; ++k)
+                    {
+                        endState[i] += transition[i][k] * state[k];
+                    }
+                }
+                states[c] = endState;
+            }
+        }
+
+        // loudness of all blocks of numHops consecutive hops with a step of one hop
+        std::vector<double> getBlockLoudness(int numHops) const
+        {
+            std::vector<double> blocks;
+
+            for (size_t first = 0; first + numHops <= hopSquares.size(); ++first)
+            {
+                double squares = 0;
+                for (size_t hop = first; hop < first + numHops; ++hop)
+                {
+                    squares += hopSquares[hop];
+                }
+
+                blocks.push_back(powerToLoudness(squares / static_cast<double>(numHops * hopLength)));
+            }
+            return blocks;
+        }
+
+        /**
+         * returns a pair:
+         *     first:  loudness of the mean power of the blocks above the absolute and the relative gate, -inf if there is none
+         *     second: the blocks above both gates
+         */
+        static std::pair<double, std::vector<double>> getGatedLoudness(const std::vector<double>& blocks, double relativeGate)
+        {
+            std::vector<double> gated;
+            std::copy_if(blocks.begin(), blocks.end(), std::back_inserter(gated), [](double block) { return AbsoluteGate < block; });
+
+            double relativeGateLoudness = getMeanPowerLoudness(gated) + relativeGate;
+
+            std::erase_if(gated, [relativeGateLoudness](double block) { return block <= relativeGateLoudness; });
+
+            return { getMeanPowerLoudness(gated), gated };
+        }
+
+        static double getMeanPowerLoudness(const std::vector<double>& blocks)
+        {
+            if (blocks.empty())
+            {
+                return -std::numeric_limits<double>::infinity();
+            }
+
+            double power = 0;
+            for (double block : blocks)
+            {
+                power += std::pow(10.0, (block + 0.691) / 10);
+            }
+            return powerToLoudness(power / static_cast<double>(blocks.size()));
+        }
+
+        // EBU Tech 3342: difference of the 95th and the 10th percentile of the gated short-term loudness
+        static double getLoudnessRange(const std::vector<double>& shortTerm)
+        {
+            std::vector<double> gated = getGatedLoudness(shortTerm, RangeRelativeGate).second;
+            if (gated.size() < 2)
+            {
+                return 0;
+            }
+
+            std::sort(gated.begin(), gated.end());
+
+            double last = static_cast<double>(gated.size() - 1);
+            return gated[static_cast<size_t>(std::llround(last * RangeHighPercentile))] - gated[static_cast<size_t>(std::llround(last * RangeLowPercentile))];
+        }
+
+        static double getMaxLoudness(const std::vector<double>& blocks)
+        {
+            if (blocks.empty())
+            {
+                return -std::numeric_limits<double>::infinity();
+            }
+            return *std::max_element(blocks.begin(), blocks.end());
+        }
+    };
+
+
+    std::optional<LoudnessResult> measureLoudness(VSNode* audio, const VSAudioInfo* audioInfo, const std::vector<int>& channels,
+                                                  int maxRequests, const ScanControl& control, std::string& errMsg, VSCore* core, const VSAPI* vsapi)
+    {
+        std::vector<int> vsChannels = vsutils::getChannelsFromChannelLayout(audioInfo->format.channelLayout);
+
+        std::vector<LoudnessChannel> loudnessChannels;
+        for (int ch : channels)
+        {
+            double weight = getLoudnessChannelWeight(vsChannels[ch]);
+            if (weight != 0)
+            {
+                loudnessChannels.push_back({ .channel = ch, .weight = weight });
+            }
+        }
+
+        LoudnessScan scan(audioInfo, std::move(loudnessChannels));
+
+        auto scanFrame = [&scan, vsapi](int n, const VSFrame* frame, const char* errorMsg)
+        {
+            if (!frame)
+            {
+                scan.setError(errorMsg);
+                return false;
+            }
+
+            scan.addFrame(n, scan.sumFrame(n, frame, vsapi));
+            return true;
+        };
+
+        scanFrames(audio, audioInfo->numFrames, maxRequests, control, "loudness", scanFrame, core, vsapi);
+
+        return scan.getResult(errMsg);
+    }
+}
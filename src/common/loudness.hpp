@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+#include "common/framescan.hpp"
+
+namespace common
+{
+    // loudness of a clip according to ITU-R BS.1770-4 and EBU R128 / EBU Tech 3342
+    struct LoudnessResult
+    {
+        // gated integrated loudness in LUFS, -inf if no block passes the gates (silence or shorter than 400 ms)
+        double integrated;
+
+        // loudness range in LU, 0 if less than two short-term blocks pass the gates
+        double range;
+
+        // max. momentary loudness (400 ms blocks) in LUFS, -inf if there is no block
+        double momentaryMax;
+
+        // max. short-term loudness (3 s blocks) in LUFS, -inf if there is no block
+        double shortTermMax;
+    };
+
+
+    // BS.1770 weight of a VapourSynth channel (VSAudioChannels): 1.41 for surround channels, 0 for LFE channels (not measured), 1 otherwise
+    double getLoudnessChannelWeight(int vsChannel);
+
+
+    /**
+     * reads all frames to measure the loudness of channels
+     * the frames are K-weighted and summed up to 100 ms gating blocks in parallel with common::scanFrames,
+     * up to maxRequests frame requests in flight (<= 0: number of VapourSynth threads)
+     * this is blocking until all frames are read
+     * returns std::nullopt and sets errMsg if a frame could not be read or the scan was cancelled
+     */
+    std::optional<LoudnessResult> measureLoudness(VSNode* audio, const VSAudioInfo* audioInfo, const std::vector<int>& channels,
+                                                  int maxRequests, const ScanControl& control, std::string& errMsg, VSCore* core, const VSAPI* vsapi);
+}
@@ -1,10 +1,14 @@
 // SPDX-License-Identifier: MIT
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 
 #include "VapourSynth4.h"
 
 #include "common/offset.hpp"
+#include "common/sampletype.hpp"
+#include "simd/sampleconv.hpp"
 #include "vsutils/audio.hpp"
 
 namespace common
@@ -115,4 +119,24 @@ namespace common
 
         return offsetFrame;
     }
+
+
+    void convOffsetSamplesToDouble(SampleType st, int bytesPerSample, int begin, int end, const FrameSampleOffsets& offsets,
+                                   const uint8_t* offsetFrameLPtr, const uint8_t* offsetFrameRPtr, double* out)
+    {
+        // first base frame sample position that is read from the right frame
+        int splitPos = offsets.left == 0 ? end : std::clamp(-offsets.right, begin, end);
+
+        if (begin < splitPos)
+        {
+            const uint8_t* inPtr = offsetFrameLPtr + static_cast<ptrdiff_t>(begin + offsets.left) * bytesPerSample;
+            simd::convSamplesToDouble(st, inPtr, out + begin, splitPos - begin);
+        }
+
+        if (splitPos < end)
+        {
+            const uint8_t* inPtr = offsetFrameRPtr + static_cast<ptrdiff_t>(splitPos + offsets.right) * bytesPerSample;
+            simd::convSamplesToDouble(st, inPtr, out + splitPos, end - splitPos);
+        }
+    }
 }
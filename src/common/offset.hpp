@@ -2,7 +2,14 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+
+#include "common/precision.hpp"
+#include "common/sampletype.hpp"
+#include "simd/sampleconv.hpp"
 
 namespace common
 {
@@ -57,4 +64,79 @@ namespace common
         // left frame
         return offsetFrameLPtr[baseFrameSamplePos + offsets.left];
     }
+
+
+    /**
+     * converts the samples [begin, end) of a base frame to double
+     * reads from the left and right offset frame like getOffsetSample, but one contiguous run per frame
+     * the result is written to out[begin, end)
+     */
+    template <typename sample_t, size_t IntSampleBits>
+    void convOffsetSamplesToDouble(int begin, int end, const FrameSampleOffsets& offsets,
+                                   const sample_t* offsetFrameLPtr, const sample_t* offsetFrameRPtr, double* out)
+    {
+        // first base frame sample position that is read from the right frame
+        int splitPos = offsets.left == 0 ? end : std::clamp(-offsets.right, begin, end);
+
+        if (begin < splitPos)
+        {
+            simd::convSamplesToDouble<sample_t, IntSampleBits>(offsetFrameLPtr + begin + offsets.left, out + begin, splitPos - begin);
+        }
+
+        if (splitPos < end)
+        {
+            simd::convSamplesToDouble<sample_t, IntSampleBits>(offsetFrameRPtr + splitPos + offsets.right, out + splitPos, end - splitPos);
+        }
+    }
+
+
+    // same as convOffsetSamplesToDouble, but converts to the compute type (see common::convSamplesToCompute)
+    template <typename sample_t, size_t IntSampleBits, typename compute_t>
+    void convOffsetSamplesToCompute(int begin, int end, const FrameSampleOffsets& offsets,
+                                    const sample_t* offsetFrameLPtr, const sample_t* offsetFrameRPtr, compute_t* out)
+    {
+        // first base frame sample position that is read from the right frame
+        int splitPos = offsets.left == 0 ? end : std::clamp(-offsets.right, begin, end);
+
+        if (begin < splitPos)
+        {
+            convSamplesToCompute<sample_t, IntSampleBits, compute_t>(offsetFrameLPtr + begin + offsets.left, out + begin, splitPos - begin);
+        }
+
+        if (splitPos < end)
+        {
+            convSamplesToCompute<sample_t, IntSampleBits, compute_t>(offsetFrameRPtr + splitPos + offsets.right, out + splitPos, end - splitPos);
+        }
+    }
+
+
+    /**
+     * same as convOffsetSamplesToDouble, but the sample type is selected at runtime
+     * the frame pointers point to the first byte of the frame channels
+     */
+    void convOffsetSamplesToDouble(SampleType st, int bytesPerSample, int begin, int end, const FrameSampleOffsets& offsets,
+                                   const uint8_t* offsetFrameLPtr, const uint8_t* offsetFrameRPtr, double* out);
+
+
+    /**
+     * copies the samples [begin, end) of a base frame without any conversion
+     * reads from the left and right offset frame like getOffsetSample, the result is written to out[begin, end)
+     */
+    template <typename sample_t>
+    void copyOffsetSamples(int begin, int end, const FrameSampleOffsets& offsets,
+                           const sample_t* offsetFrameLPtr, const sample_t* offsetFrameRPtr, sample_t* out)
+    {
+        // first base frame sample position that is read from the right frame
+        int splitPos = offsets.left == 0 ? end : std::clamp(-offsets.right, begin, end);
+
+        if (begin < splitPos)
+        {
+            std::memcpy(out + begin, offsetFrameLPtr + begin + offsets.left, static_cast<size_t>(splitPos - begin) * sizeof(sample_t));
+        }
+
+        if (splitPos < end)
+        {
+            std::memcpy(out + splitPos, offsetFrameRPtr + splitPos + offsets.right, static_cast<size_t>(end - splitPos) * sizeof(sample_t));
+        }
+    }
 }
@@ -1,16 +1,26 @@
 // SPDX-License-Identifier: MIT
 
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <format>
+#include <limits>
 #include <map>
+#include <mutex>
+#include <span>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include "VapourSynth4.h"
 
 #include "common/overflow.hpp"
+#include "common/sampletype.hpp"
 #include "utils/array.hpp"
+#include "utils/sample.hpp"
+#include "vsutils/bitshift.hpp"
 
 namespace common
 {
@@ -43,22 +53,182 @@ namespace common
     }
 
 
-    void OverflowStats::addSample(double sample)
+    static std::string genOverflowHandlingMsg(const char* funcName, OverflowMode mode, bool floatSampleType)
+    {
+        switch (mode)
+        {
+            case OverflowMode::Error:
+                return std::format("{}: Exiting with an error.", funcName);
+
+            case OverflowMode::ClipInt:
+            case OverflowMode::KeepFloat:
+                if (floatSampleType)
+                {
+                    return std::format("{}: Overflowing samples will *not* be clipped.", funcName);
+                }
+                [[fallthrough]];
+
+            case OverflowMode::Clip:
+                return std::format("{}: Overflowing samples will be clipped.", funcName);
+
+            default:
+                return std::string();
+        }
+    }
+
+
+    void OverflowStats::addSample(double sample, int64_t totalPos, int channel, OverflowLog log)
     {
         ++count;
 
+        if (channelCounts.size() <= static_cast<size_t>(channel))
+        {
+            channelCounts.resize(static_cast<size_t>(channel) + 1, 0);
+        }
+        ++channelCounts[channel];
+
         double absSample = std::abs(sample);
         if (peak < absSample)
         {
             peak = absSample;
         }
+
+        if (log == OverflowLog::All || (log == OverflowLog::Once && events.empty()))
+        {
+            events.push_back({ .sample = sample, .totalPos = totalPos, .channel = channel });
+        }
+    }
+
+
+    void OverflowTracker::init(const char* _funcName, OverflowMode _mode, OverflowLog _log, bool _floatSampleType, int _numFrames)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        funcName = _funcName;
+        mode = _mode;
+        log = _log;
+        floatSampleType = _floatSampleType;
+        numFrames = _numFrames;
+
+        reset();
+    }
+
+
+    void OverflowTracker::submitFrame(int frameNum, OverflowStats frameStats, VSCore* core, const VSAPI* vsapi)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (frameNum < nextFrame || numFrames <= frameNum || submitted[frameNum])
+        {
+            // frame was already submitted (requested again)
+            return;
+        }
+
+        submitted[frameNum] = true;
+
+        if (0 < frameStats.count)
+        {
+            pendingStats[frameNum] = std::move(frameStats);
+        }
+
+        // log all frames in order up to the first missing frame
+        while (nextFrame < numFrames && submitted[nextFrame])
+        {
+            auto it = pendingStats.find(nextFrame);
+            if (it != pendingStats.end())
+            {
+                logFrame(it->second, core, vsapi);
+                pendingStats.erase(it);
+            }
+
+            submitted[nextFrame] = false;
+            ++nextFrame;
+        }
+
+        if (nextFrame == numFrames)
+        {
+            // all frames processed
+            logSummary(core, vsapi);
+            reset();
+        }
+    }
+
+
+    void OverflowTracker::flush(VSCore* core, const VSAPI* vsapi)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // skip missing frames
+        for (const auto& [frameNum, frameStats] : pendingStats)
+        {
+            logFrame(frameStats, core, vsapi);
+        }
+
+        logSummary(core, vsapi);
+        reset();
     }
 
-    void OverflowStats::logVS(const char* funcName, OverflowMode ofMode, bool floatSampleType, VSCore* core, const VSAPI* vsapi)
+
+    void OverflowTracker::logFrame(const OverflowStats& frameStats, VSCore* core, const VSAPI* vsapi)
     {
+        for (const OverflowEvent& event : frameStats.events)
+        {
+            switch (log)
+            {
+                case OverflowLog::All:
+                    // log all overflowing samples
+                    vsapi->logMessage(VSMessageType::mtWarning, genOverflowMsg(event.sample, event.totalPos, event.channel, funcName).c_str(), core);
+
+                    if (!firstLogged)
+                    {
+                        vsapi->logMessage(VSMessageType::mtInformation, genOverflowHandlingMsg(funcName, mode, floatSampleType).c_str(), core);
+                    }
+                    break;
+
+                case OverflowLog::Once:
+                    // log only the first overflowing sample
+                    if (!firstLogged)
+                    {
+                        bool errorMode = mode == OverflowMode::Error;
+
+                        vsapi->logMessage(errorMode ? VSMessageType::mtCritical : VSMessageType::mtWarning, genOverflowMsg(event.sample, event.totalPos, event.channel, funcName).c_str(), core);
+
+                        vsapi->logMessage(VSMessageType::mtInformation, genOverflowHandlingMsg(funcName, mode, floatSampleType).c_str(), core);
+
+                        if (!errorMode)
+                        {
+                            std::string firstHint = std::format("{}: Only the first overflow will be logged.", funcName);
+                            vsapi->logMessage(VSMessageType::mtInformation, firstHint.c_str(), core);
+                        }
+                    }
+                    break;
+
+                case OverflowLog::None:
+                    break;
+            }
+
+            firstLogged = true;
+        }
+
+        count += frameStats.count;
+
+        if (peak < frameStats.peak)
+        {
+            peak = frameStats.peak;
+        }
+    }
+
+
+    void OverflowTracker::logSummary(VSCore* core, const VSAPI* vsapi)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
         std::string logMsg;
 
-        switch (ofMode)
+        switch (mode)
         {
             case OverflowMode::ClipInt:
             case OverflowMode::KeepFloat:
@@ -80,4 +250,134 @@ namespace common
                 break;
         }
     }
+
+
+    void OverflowTracker::reset()
+    {
+        nextFrame = 0;
+        submitted.assign(static_cast<size_t>(numFrames), false);
+        pendingStats.clear();
+
+        count = 0;
+        peak = 0.0;
+        firstLogged = false;
+    }
+
+
+    bool isFrameChannelOverflowing(const VSFrame* frm, int ch, SampleType st, const VSAPI* vsapi)
+    {
+        const uint8_t* frmPtr = vsapi->getReadPtr(frm, ch);
+        size_t frmLen = static_cast<size_t>(vsapi->getFrameLength(frm));
+
+        switch (st)
+        {
+            case SampleType::Int8:
+                return utils::isAnySampleOverflowing<int8_t, 8>(std::span(reinterpret_cast<const int8_t*>(frmPtr), frmLen));
+            case SampleType::Int16:
+                return utils::isAnySampleOverflowing<int16_t, 16>(std::span(reinterpret_cast<const int16_t*>(frmPtr), frmLen));
+            case SampleType::Int24:
+                return utils::isAnySampleOverflowing<int32_t, 24>(std::span(reinterpret_cast<const int32_t*>(frmPtr), frmLen));
+            case SampleType::Int32:
+                return utils::isAnySampleOverflowing<int32_t, 32>(std::span(reinterpret_cast<const int32_t*>(frmPtr), frmLen));
+            case SampleType::Float32:
+                return utils::isAnySampleOverflowing<float, 0>(std::span(reinterpret_cast<const float*>(frmPtr), frmLen));
+            case SampleType::Float64:
+                return utils::isAnySampleOverflowing<double, 0>(std::span(reinterpret_cast<const double*>(frmPtr), frmLen));
+            default:
+                return true;
+        }
+    }
+
+
+    template <typename sample_t, size_t IntSampleBits>
+    static int64_t countOverflowingSamples(std::span<const sample_t> samples)
+    {
+        constexpr vsutils::BitShift bitShift = vsutils::getSampleBitShift<sample_t, IntSampleBits>();
+
+        int64_t count = 0;
+
+        for (sample_t sample : samples)
+        {
+            if constexpr (bitShift.required)
+            {
+                sample >>= bitShift.count;
+            }
+
+            if (utils::isSampleOverflowing<sample_t, IntSampleBits>(sample))
+            {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+
+    int64_t countFrameChannelOverflows(const VSFrame* frm, int ch, SampleType st, const VSAPI* vsapi)
+    {
+        const uint8_t* frmPtr = vsapi->getReadPtr(frm, ch);
+        size_t frmLen = static_cast<size_t>(vsapi->getFrameLength(frm));
+
+        switch (st)
+        {
+            case SampleType::Int8:
+                return countOverflowingSamples<int8_t, 8>(std::span(reinterpret_cast<const int8_t*>(frmPtr), frmLen));
+            case SampleType::Int16:
+                return countOverflowingSamples<int16_t, 16>(std::span(reinterpret_cast<const int16_t*>(frmPtr), frmLen));
+            case SampleType::Int24:
+                return countOverflowingSamples<int32_t, 24>(std::span(reinterpret_cast<const int32_t*>(frmPtr), frmLen));
+            case SampleType::Int32:
+                return countOverflowingSamples<int32_t, 32>(std::span(reinterpret_cast<const int32_t*>(frmPtr), frmLen));
+            case SampleType::Float32:
+                return countOverflowingSamples<float, 0>(std::span(reinterpret_cast<const float*>(frmPtr), frmLen));
+            case SampleType::Float64:
+                return countOverflowingSamples<double, 0>(std::span(reinterpret_cast<const double*>(frmPtr), frmLen));
+            default:
+                return 0;
+        }
+    }
+
+
+    double getMaxAbsSample(SampleType st)
+    {
+        if (isFloatSampleType(st))
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+        return 1.0;
+    }
+
+
+    bool isOverflowPossible(double maxAbsSample, SampleType outSampleType)
+    {
+        if (outSampleType == SampleType::Float64)
+        {
+            // rounding errors above 1.0 would be kept
+            return true;
+        }
+
+        // also true for NaN bounds (e.g. infinity * 0)
+        return !(maxAbsSample <= 1.0);
+    }
+
+
+    bool isOverflowPossible(double maxAbsSample, SampleType outSampleType, Precision precision)
+    {
+        if (isFloatCompute(precision, outSampleType))
+        {
+            // same as Float64
+            return true;
+        }
+
+        return isOverflowPossible(maxAbsSample, outSampleType);
+    }
+
+
+    void logOverflowCheck(const char* funcName, bool overflowPossible, VSCore* core, const VSAPI* vsapi)
+    {
+        std::string logMsg = overflowPossible ?
+            std::format("{}: sample overflows possible, using overflow checks", funcName) :
+            std::format("{}: sample overflows impossible, skipping overflow checks", funcName);
+
+        vsapi->logMessage(VSMessageType::mtDebug, logMsg.c_str(), core);
+    }
 }
@@ -5,14 +5,21 @@
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <format>
 #include <map>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 #include "VapourSynth4.h"
 
+#include "common/precision.hpp"
+#include "common/sampletype.hpp"
+#include "simd/sampleconv.hpp"
 #include "utils/sample.hpp"
 #include "vsutils/bitshift.hpp"
 
@@ -42,6 +49,30 @@ namespace common
     };
 
 
+    struct OverflowEvent
+    {
+        double sample;
+        int64_t totalPos;
+        int channel;
+    };
+
+
+    // overflows of a single frame
+    struct OverflowStats
+    {
+        int64_t count = 0;
+        double peak = 0.0;
+
+        // number of overflows per channel (only channels up to the last overflowing channel)
+        std::vector<int64_t> channelCounts;
+
+        // overflows to log: all overflows (OverflowLog::All), only the first overflow (OverflowLog::Once) or none (OverflowLog::None)
+        std::vector<OverflowEvent> events;
+
+        void addSample(double sample, int64_t totalPos, int channel, OverflowLog log);
+    };
+
+
     struct OverflowContext
     {
         OverflowMode mode;
@@ -50,17 +81,53 @@ namespace common
         VSFrameContext* frameCtx;
         VSCore* core;
         const VSAPI* vsapi;
+        // overflow stats of the current frame
+        OverflowStats& stats;
     };
 
 
-    struct OverflowStats
+    /**
+     * collects the overflow stats of all frames of a filter
+     * the frames can be processed in any order and in parallel (fmParallel),
+     * the overflows are logged in frame order as if all frames were processed one after another
+     * the summary is logged once all frames were submitted
+     */
+    class OverflowTracker
     {
+    public:
+        void init(const char* funcName, OverflowMode mode, OverflowLog log, bool floatSampleType, int numFrames);
+
+        // call once for every output frame, also for frames without any overflow check (e.g. passthrough frames)
+        void submitFrame(int frameNum, OverflowStats frameStats, VSCore* core, const VSAPI* vsapi);
+
+        // logs the submitted but not yet logged overflows and the summary (e.g. if not all frames were requested)
+        void flush(VSCore* core, const VSAPI* vsapi);
+
+    private:
+        const char* funcName = "";
+        OverflowMode mode = OverflowMode::Error;
+        OverflowLog log = OverflowLog::Once;
+        bool floatSampleType = false;
+        int numFrames = 0;
+
+        std::mutex mutex;
+
+        // all frames before nextFrame are logged
+        int nextFrame = 0;
+        // submitted frames that are waiting for previous frames
+        std::vector<bool> submitted;
+        std::map<int, OverflowStats> pendingStats;
+
+        // stats of the logged frames
         int64_t count = 0;
         double peak = 0.0;
+        bool firstLogged = false;
 
-        void addSample(double sample);
+        void logFrame(const OverflowStats& frameStats, VSCore* core, const VSAPI* vsapi);
 
-        void logVS(const char* funcName, OverflowMode ofMode, bool floatSampleType, VSCore* core, const VSAPI* vsapi);
+        void logSummary(VSCore* core, const VSAPI* vsapi);
+
+        void reset();
     };
 
 
@@ -70,85 +137,45 @@ namespace common
 
     void logNumOverflows(int64_t numOverflows, const char* funcName, VSCore* core, const VSAPI* vsapi);
 
-    static inline std::string genOverflowMsg(double sample, int64_t totalPos, int channel, const char* funcName)
-    {
-        return std::format("{}: Overflow detected. position: {}, channel: {}, sample: {:.6f}", funcName, totalPos, channel, sample);
-    }
+    // returns true if any sample of a frame channel would overflow if it was written unchanged
+    bool isFrameChannelOverflowing(const VSFrame* frm, int ch, SampleType st, const VSAPI* vsapi);
 
+    // returns the number of samples of a frame channel that would overflow if they were written unchanged
+    int64_t countFrameChannelOverflows(const VSFrame* frm, int ch, SampleType st, const VSAPI* vsapi);
 
-    template <typename sample_t>
-    requires std::integral<sample_t> || std::floating_point<sample_t>
-    static std::string genOverflowHandlingMsg(const OverflowContext& ofCtx)
-    {
-        switch (ofCtx.mode)
-        {
-            case OverflowMode::Error:
-                return std::format("{}: Exiting with an error.", ofCtx.funcName);
+    /**
+     * upper bound of the absolute samples of a sample type after the conversion to double
+     * integer samples are always inside [-1, 1] (the minimum integer is clamped), float samples are unbounded
+     */
+    double getMaxAbsSample(SampleType st);
 
-            case OverflowMode::ClipInt:
-            case OverflowMode::KeepFloat:
-                if constexpr (std::is_floating_point_v<sample_t>)
-                {
-                    return std::format("{}: Overflowing samples will *not* be clipped.", ofCtx.funcName);
-                }
-                [[fallthrough]];
+    /**
+     * returns true if processed samples with an absolute value up to maxAbsSample can overflow when written as outSampleType
+     * maxAbsSample is the bound of the exact calculation, rounding errors slightly above 1.0 are absorbed by the conversion
+     * to integer (clamped) and 32 bit float samples (rounded towards zero)
+     * filters use it at creation to select the writeFrameImpl specialization without overflow checks
+     */
+    bool isOverflowPossible(double maxAbsSample, SampleType outSampleType);
 
-            case OverflowMode::Clip:
-                return std::format("{}: Overflowing samples will be clipped.", ofCtx.funcName);
+    // same as isOverflowPossible, but float rounding errors above 1.0 are kept if the samples are processed as float
+    bool isOverflowPossible(double maxAbsSample, SampleType outSampleType, Precision precision);
 
-            default:
-                return std::string();
-        }
-    }
+    // logs which overflow check path was selected (debug message)
+    void logOverflowCheck(const char* funcName, bool overflowPossible, VSCore* core, const VSAPI* vsapi);
 
 
-    template <typename sample_t>
-    requires std::integral<sample_t> || std::floating_point<sample_t>
-    static void logOverflow(double sample, int64_t totalPos, int channel, const OverflowContext& ofCtx, const OverflowStats& ofStats)
+    static inline std::string genOverflowMsg(double sample, int64_t totalPos, int channel, const char* funcName)
     {
-        switch (ofCtx.log)
-        {
-            case OverflowLog::All:
-                // log all overflowing samples
-                ofCtx.vsapi->logMessage(VSMessageType::mtWarning, genOverflowMsg(sample, totalPos, channel, ofCtx.funcName).c_str(), ofCtx.core);
-
-                if (ofStats.count == 0)
-                {
-                    ofCtx.vsapi->logMessage(VSMessageType::mtInformation, genOverflowHandlingMsg<sample_t>(ofCtx).c_str(), ofCtx.core);
-                }
-                break;
-
-            case OverflowLog::Once:
-                // log only the first overflowing sample
-                if (ofStats.count == 0)
-                {
-                    bool errorMode = ofCtx.mode == OverflowMode::Error;
-
-                    ofCtx.vsapi->logMessage(errorMode ? VSMessageType::mtCritical : VSMessageType::mtWarning, genOverflowMsg(sample, totalPos, channel, ofCtx.funcName).c_str(), ofCtx.core);
-
-                    ofCtx.vsapi->logMessage(VSMessageType::mtInformation, genOverflowHandlingMsg<sample_t>(ofCtx).c_str(), ofCtx.core);
-
-                    if (!errorMode)
-                    {
-                        std::string firstHint = std::format("{}: Only the first overflow will be logged.", ofCtx.funcName);
-                        ofCtx.vsapi->logMessage(VSMessageType::mtInformation, firstHint.c_str(), ofCtx.core);
-                    }
-                }
-                break;
-
-            case OverflowLog::None:
-                break;
-        }
+        return std::format("{}: Overflow detected. position: {}, channel: {}, sample: {:.6f}", funcName, totalPos, channel, sample);
     }
 
 
     template <typename sample_t, size_t IntSampleBits>
     requires std::integral<sample_t> || std::floating_point<sample_t>
-    static std::optional<sample_t> handleOverflow(double sample, int64_t totalPos, int channel, const OverflowContext& ofCtx, OverflowStats& ofStats)
+    static std::optional<sample_t> handleOverflow(double sample, int64_t totalPos, int channel, const OverflowContext& ofCtx)
     {
-        logOverflow<sample_t>(sample, totalPos, channel, ofCtx, ofStats);
-
-        ofStats.addSample(sample);
+        // logged by OverflowTracker
+        ofCtx.stats.addSample(sample, totalPos, channel, ofCtx.log);
 
         switch (ofCtx.mode)
         {
@@ -179,15 +206,15 @@ namespace common
     }
 
 
-    // numOverflows will be incremented if an overflow happened
+    // ofCtx.stats will be updated if an overflow happened
     template <typename sample_t, size_t IntSampleBits>
     requires std::integral<sample_t> || std::floating_point<sample_t>
-    std::optional<sample_t> safeConvertSample(double sample, int64_t totalPos, int channel, const OverflowContext& ofCtx, OverflowStats& ofStats)
+    std::optional<sample_t> safeConvertSample(double sample, int64_t totalPos, int channel, const OverflowContext& ofCtx)
     {
         if (utils::isSampleOverflowing<double, 0>(sample))
         {
             // sample is overflowing
-            return handleOverflow<sample_t, IntSampleBits>(sample, totalPos, channel, ofCtx, ofStats);
+            return handleOverflow<sample_t, IntSampleBits>(sample, totalPos, channel, ofCtx);
         }
 
         // sample is not overflowing
@@ -197,9 +224,9 @@ namespace common
 
     template <typename sample_t, size_t IntSampleBits>
     requires std::integral<sample_t> || std::floating_point<sample_t>
-    bool safeWriteSample(double sample, sample_t* frmPtr, int frmPtrPos, int64_t totalPos, int channel, const OverflowContext& ofCtx, OverflowStats& ofStats)
+    bool safeWriteSample(double sample, sample_t* frmPtr, int frmPtrPos, int64_t totalPos, int channel, const OverflowContext& ofCtx)
     {
-        if (auto optSample = safeConvertSample<sample_t, IntSampleBits>(sample, totalPos, channel, ofCtx, ofStats))
+        if (auto optSample = safeConvertSample<sample_t, IntSampleBits>(sample, totalPos, channel, ofCtx))
         {
             sample_t outSample = optSample.value();
 
@@ -217,4 +244,77 @@ namespace common
         // overflow and error
         return false;
     }
+
+
+    /**
+     * block version of safeWriteSample
+     * writes samples[i] to frmPtr[i] for all samples
+     * checks the whole block for overflows first and only uses the per sample overflow handling if any sample is overflowing,
+     * so the output, the overflow stats and the logged overflow positions are the same as calling safeWriteSample for each sample
+     * totalPosStart: total sample position of samples[0]
+     * CheckOverflow: false only if isOverflowPossible proved that no sample can overflow, the samples are then converted unchecked
+     */
+    template <typename sample_t, size_t IntSampleBits, bool CheckOverflow = true>
+    requires std::integral<sample_t> || std::floating_point<sample_t>
+    bool safeWriteSamples(std::span<const double> samples, sample_t* frmPtr, int64_t totalPosStart, int channel, const OverflowContext& ofCtx)
+    {
+        int numSamples = static_cast<int>(samples.size());
+
+        if constexpr (CheckOverflow)
+        {
+            if (utils::isAnySampleOverflowing(samples))
+            {
+                // slow path: at least one sample is overflowing
+                for (int s = 0; s < numSamples; ++s)
+                {
+                    if (!safeWriteSample<sample_t, IntSampleBits>(samples[s], frmPtr, s, totalPosStart + s, channel, ofCtx))
+                    {
+                        // overflow and error
+                        return false;
+                    }
+                }
+                return true;
+            }
+        }
+
+        // fast path: no sample is overflowing
+        simd::convSamplesFromDouble<sample_t, IntSampleBits>(samples.data(), frmPtr, numSamples);
+
+        return true;
+    }
+
+
+    /**
+     * same as safeWriteSamples for samples processed as float (see common::Precision)
+     * only for float output, the samples are copied without conversion
+     */
+    template <typename sample_t, size_t IntSampleBits, bool CheckOverflow = true>
+    requires std::same_as<sample_t, float>
+    bool safeWriteSamples(std::span<const float> samples, sample_t* frmPtr, int64_t totalPosStart, int channel, const OverflowContext& ofCtx)
+    {
+        int numSamples = static_cast<int>(samples.size());
+
+        if constexpr (CheckOverflow)
+        {
+            if (utils::isAnySampleOverflowing<float, 0>(samples))
+            {
+                // slow path: at least one sample is overflowing
+                // float -> double is exact, non-overflowing samples are written unchanged
+                for (int s = 0; s < numSamples; ++s)
+                {
+                    if (!safeWriteSample<sample_t, IntSampleBits>(static_cast<double>(samples[s]), frmPtr, s, totalPosStart + s, channel, ofCtx))
+                    {
+                        // overflow and error
+                        return false;
+                    }
+                }
+                return true;
+            }
+        }
+
+        // fast path: no sample is overflowing
+        std::memcpy(frmPtr, samples.data(), static_cast<size_t>(numSamples) * sizeof(float));
+
+        return true;
+    }
 }
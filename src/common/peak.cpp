@@ -1,13 +1,17 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <mutex>
 #include <optional>
 #include <vector>
 
 #include "VapourSynth4.h"
 
+#include "common/framescan.hpp"
 #include "common/peak.hpp"
 #include "common/sampletype.hpp"
+#include "common/stats.hpp"
+#include "common/truepeak.hpp"
 #include "utils/number.hpp"
 
 namespace common
@@ -34,32 +38,89 @@ namespace common
     }
 
 
-    double findPeak(VSNode* audio, const VSAudioInfo* audioInfo, const std::vector<int>& channels, bool normalize, const VSAPI* vsapi)
+    // normalized peak from the stats props, std::nullopt if the frame has no stats props
+    static std::optional<PeakResult> findFrameStatsPeak(const VSFrame* frame, common::SampleType sampleType, const std::vector<int>& channels, const VSAPI* vsapi)
     {
+        double peak = 0;
+
+        for (int ch : channels)
+        {
+            std::optional<double> optChannelPeak = getFrameStatsPeak(frame, ch, vsapi);
+            if (!optChannelPeak.has_value())
+            {
+                return std::nullopt;
+            }
+
+            if (peak < optChannelPeak.value())
+            {
+                peak = optChannelPeak.value();
+            }
+        }
+
+        // normalized integer samples cannot exceed 1
+        return PeakResult{ .value = peak,
+                           .isMax = !common::isFloatSampleType(sampleType) && 1.0 <= peak };
+    }
+
+
+    double findPeak(VSNode* audio, const VSAudioInfo* audioInfo, const std::vector<int>& channels, bool normalize, bool truePeak, bool useStats,
+                    int maxRequests, const PeakScanControl& control, VSCore* core, const VSAPI* vsapi)
+    {
+        if (truePeak)
+        {
+            return findTruePeak(audio, audioInfo, channels, maxRequests, control, core, vsapi);
+        }
+
         common::SampleType sampleType = common::getSampleTypeFromAudioFormat(audioInfo->format).value();
 
+        // the stats props only contain the normalized peak
+        bool useStatsProps = useStats && normalize;
+
+        std::mutex mutex;
+
+        // guarded by mutex
         double peak = 0;
+        // frame number of peak -> the earliest frame wins if two frames have the same absolute peak
+        int peakFrame = -1;
         // found absolute maximum peak? -> skip remaining frames if true
         bool isMax = false;
 
-        for (int n = 0; n < audioInfo->numFrames && !isMax; ++n)
+        auto scanFrame = [&](int n, const VSFrame* frame, const char* errorMsg)
         {
-            const VSFrame* frame = vsapi->getFrame(n, audio, nullptr, 0);
-            if (frame)
+            std::optional<PeakResult> optPeakResult;
+
+            if (frame && useStatsProps)
             {
-                if (auto optPeakResult = findFramePeak(frame, sampleType, channels, normalize, vsapi))
-                {
-                    isMax |= optPeakResult.value().isMax;
+                optPeakResult = findFrameStatsPeak(frame, sampleType, channels, vsapi);
+            }
 
-                    if (std::abs(peak) < std::abs(optPeakResult.value().value))
-                    {
-                        peak = optPeakResult.value().value;
-                    }
-                }
+            if (frame && !optPeakResult.has_value())
+            {
+                optPeakResult = findFramePeak(frame, sampleType, channels, normalize, vsapi);
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
 
-                vsapi->freeFrame(frame);
+            if (optPeakResult.has_value())
+            {
+                const PeakResult& result = optPeakResult.value();
+
+                isMax |= result.isMax;
+
+                // same result as reading the frames in order
+                if (std::abs(peak) < std::abs(result.value) ||
+                    (std::abs(peak) == std::abs(result.value) && n < peakFrame))
+                {
+                    peak = result.value;
+                    peakFrame = n;
+                }
             }
-        }
+
+            return !isMax;
+        };
+
+        scanFrames(audio, audioInfo->numFrames, maxRequests, control, "peak", scanFrame, core, vsapi);
+
         return peak;
     }
 
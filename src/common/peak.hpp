@@ -10,10 +10,11 @@
 
 #include "VapourSynth4.h"
 
+#include "common/framescan.hpp"
 #include "common/sampletype.hpp"
+#include "simd/minmax.hpp"
 #include "utils/number.hpp"
 #include "utils/sample.hpp"
-#include "vsutils/bitshift.hpp"
 
 namespace common
 {
@@ -24,73 +25,51 @@ namespace common
     };
 
 
+    // samples per channel between two checks for the max. possible peak in findFramePeakImpl
+    constexpr int PeakChunkSamples = 512;
+
+
     /**
      * returns a pair:
      *     first:  peak value of this frame (actual sample value or normalized sample [0,1])
      *     second: absolute max. peak found? -> skip reading other frames if true
+     * the samples are reduced to their min and max with the SIMD kernels (see simd::findMinMax),
+     * all channels chunk by chunk with one max. peak check per chunk
      */
     template <typename sample_t, size_t IntSampleBits>
     requires std::integral<sample_t> || std::floating_point<sample_t>
     PeakResult findFramePeakImpl(const VSFrame* frame, const std::vector<int>& channels, bool normalize, const VSAPI* vsapi)
     {
+        int frmLen = vsapi->getFrameLength(frame);
+
+        simd::MinMax range = { .min = 0, .max = 0 };
+
         if constexpr (std::is_integral_v<sample_t>)
         {
             // Integer
-            constexpr vsutils::BitShift bitShift = vsutils::getSampleBitShift<sample_t, IntSampleBits>();
-
-            sample_t posPeak = 0;
-            sample_t negPeak = 0;
+            constexpr double maxInt = static_cast<double>(utils::maxInt<sample_t, IntSampleBits>);
+            constexpr double minInt = static_cast<double>(utils::minInt<sample_t, IntSampleBits>);
 
             bool foundMaxPeak = false;
 
-            int frmLen = vsapi->getFrameLength(frame);
-
-            for (const int& ch : channels)
+            for (int chunk = 0; chunk < frmLen && !foundMaxPeak; chunk += PeakChunkSamples)
             {
-                const sample_t* frmPtr_sample_t = reinterpret_cast<const sample_t*>(vsapi->getReadPtr(frame, ch));
+                int chunkLen = std::min(PeakChunkSamples, frmLen - chunk);
 
-                for (int s = 0; s < frmLen; ++s)
+                for (const int& ch : channels)
                 {
-                    sample_t sample = frmPtr_sample_t[s];
-
-                    if constexpr (bitShift.required)
-                    {
-                        sample >>= bitShift.count;
-                    }
+                    const sample_t* frmPtr_sample_t = reinterpret_cast<const sample_t*>(vsapi->getReadPtr(frame, ch));
 
-                    if (sample < negPeak)
-                    {
-                        negPeak = sample;
-
-                        if (negPeak <= -utils::maxInt<sample_t, IntSampleBits>)
-                        {
-                            if (negPeak == utils::minInt<sample_t, IntSampleBits> || normalize)
-                            {
-                                // max abs or max normalization value -> break both loops
-                                foundMaxPeak = true;
-                                break;
-                            }
-                        }
-                    }
-                    else if (posPeak < sample)
-                    {
-                        posPeak = sample;
-
-                        if (posPeak == utils::maxInt<sample_t, IntSampleBits> && normalize)
-                        {
-                            // max normalization value -> break both loops
-                            foundMaxPeak = true;
-                            break;
-                        }
-                    }
+                    simd::findMinMax<sample_t, IntSampleBits>(frmPtr_sample_t + chunk, chunkLen, range);
                 }
 
-                if (foundMaxPeak)
-                {
-                    break;
-                }
+                // max abs or max normalization value (minInt is clamped to -maxInt by the normalization)
+                foundMaxPeak = range.min == minInt || (normalize && (range.min <= -maxInt || range.max == maxInt));
             }
 
+            sample_t posPeak = static_cast<sample_t>(range.max);
+            sample_t negPeak = static_cast<sample_t>(range.min);
+
             if (normalize)
             {
                 // convSymSampleToDouble normalizes posPeak and negPeak to maxInt
@@ -110,43 +89,60 @@ namespace common
         if constexpr (std::is_floating_point_v<sample_t>)
         {
             // Float
-            double peak = 0;
-
-            int frmLen = vsapi->getFrameLength(frame);
-
             for (const int& ch : channels)
             {
                 const sample_t* frmPtr_sample_t = reinterpret_cast<const sample_t*>(vsapi->getReadPtr(frame, ch));
 
-                for (int s = 0; s < frmLen; ++s)
-                {
-                    sample_t sample = frmPtr_sample_t[s];
-
-                    if (std::abs(peak) < std::abs(sample))
-                    {
-                        peak = sample;
-                    }
-                }
+                simd::findMinMax<sample_t, IntSampleBits>(frmPtr_sample_t, frmLen, range);
             }
 
+            double peak = range.max < -range.min ? range.min : range.max;
+
             if (normalize)
             {
                 return { .value = std::abs(peak),
                          .isMax = false };
             }
 
+            if (0 < range.max && range.max == -range.min)
+            {
+                // positive and negative peak with the same absolute value: the first one in channel and sample order is the peak
+                for (const int& ch : channels)
+                {
+                    const sample_t* frmPtr_sample_t = reinterpret_cast<const sample_t*>(vsapi->getReadPtr(frame, ch));
+
+                    for (int s = 0; s < frmLen; ++s)
+                    {
+                        if (std::abs(static_cast<double>(frmPtr_sample_t[s])) == range.max)
+                        {
+                            return { .value = static_cast<double>(frmPtr_sample_t[s]),
+                                     .isMax = false };
+                        }
+                    }
+                }
+            }
+
             return { .value = peak,
                      .isMax = false };
         }
     }
 
 
+    // optional progress logging and cancellation of findPeak
+    using PeakScanControl = ScanControl;
+
+
     /**
      * reads all frames to determine the peak value
+     * the frames are read with common::scanFrames, up to maxRequests frame requests in flight (<= 0: number of VapourSynth threads)
      * this is blocking until all frames are read
      * skips the remaining frames if maximum possible peak was found
+     * truePeak: normalized true peak instead of the sample peak (normalize only, see common::findTruePeak), useStats is ignored then
+     * useStats: take the peak of frames with stats props (see common/stats.hpp) from the props instead of the samples (normalize only)
+     * can be called from any thread, e.g. to scan in the background while the filter graph is built
      */
-    double findPeak(VSNode* audio, const VSAudioInfo* audioInfo, const std::vector<int>& channels, bool normalize, const VSAPI* vsapi);
+    double findPeak(VSNode* audio, const VSAudioInfo* audioInfo, const std::vector<int>& channels, bool normalize, bool truePeak, bool useStats,
+                    int maxRequests, const PeakScanControl& control, VSCore* core, const VSAPI* vsapi);
 
 
     double adjustNormPeak(double normPeak, common::SampleType st);
@@ -0,0 +1,293 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+#include "common/peak.hpp"
+#include "common/peakcache.hpp"
+#include "common/stats.hpp"
+#include "utils/hash.hpp"
+
+namespace common
+{
+    // increase if the cache key or the file content changes
+    constexpr uint32_t PeakCacheVersion = 5;
+
+    // number of frames (first, last and equally spaced in between) that are part of the cache key
+    constexpr int NumFingerprintFrames = 16;
+
+
+    static std::filesystem::path getPeakCacheFilePath(const std::string& cacheDir, uint64_t key)
+    {
+        return std::filesystem::path(cacheDir) / std::format("{:016x}.peak", key);
+    }
+
+
+    // same condition as in findPeak: the stats props only contain the normalized sample peak
+    static bool isStatsPeakUsed(bool normalize, bool truePeak, bool useStats)
+    {
+        return useStats && normalize && !truePeak;
+    }
+
+
+    // the stats props peaks of a frame that has them (if statsPeakUsed, the peak scan does not read its samples) or the samples of the channels
+    static void hashFrameContent(utils::Fnv1aHash& hash, const VSFrame* frame, const std::vector<int>& channels, size_t bytesPerSample,
+                                 bool statsPeakUsed, const VSAPI* vsapi)
+    {
+        if (statsPeakUsed)
+        {
+            std::vector<double> statsPeaks;
+            for (const int& ch : channels)
+            {
+                std::optional<double> optChannelPeak = getFrameStatsPeak(frame, ch, vsapi);
+                if (!optChannelPeak.has_value())
+                {
+                    break;
+                }
+                statsPeaks.push_back(optChannelPeak.value());
+            }
+
+            if (statsPeaks.size() == channels.size())
+            {
+                hash.updateValue(true);
+                hash.update(statsPeaks.data(), statsPeaks.size() * sizeof(double));
+                return;
+            }
+        }
+
+        hash.updateValue(false);
+
+        size_t frmBytes = static_cast<size_t>(vsapi->getFrameLength(frame)) * bytesPerSample;
+
+        for (const int& ch : channels)
+        {
+            hash.update(vsapi->getReadPtr(frame, ch), frmBytes);
+        }
+    }
+
+
+    std::optional<uint64_t> getPeakCacheKey(VSNode* audio, const VSAudioInfo* audioInfo, const std::vector<int>& channels, bool normalize, bool truePeak,
+                                            bool useStats, const VSAPI* vsapi)
+    {
+        utils::Fnv1aHash hash;
+
+        hash.updateValue(PeakCacheVersion);
+
+        hash.updateValue(audioInfo->format.sampleType);
+        hash.updateValue(audioInfo->format.bitsPerSample);
+        hash.updateValue(audioInfo->format.numChannels);
+        hash.updateValue(audioInfo->format.channelLayout);
+        hash.updateValue(audioInfo->sampleRate);
+        hash.updateValue(audioInfo->numSamples);
+
+        hash.updateValue(normalize);
+        hash.updateValue(truePeak);
+
+        // the peak taken from stats props can differ from the peak of the samples
+        hash.updateValue(useStats);
+
+        hash.updateValue(channels.size());
+        for (const int& ch : channels)
+        {
+            hash.updateValue(ch);
+        }
+
+        bool statsPeakUsed = isStatsPeakUsed(normalize, truePeak, useStats);
+        size_t bytesPerSample = static_cast<size_t>(audioInfo->format.bytesPerSample);
+
+        // first and last frame and equally spaced frames in between
+        int numFrames = audioInfo->numFrames;
+        int numSampledFrames = std::min(numFrames, NumFingerprintFrames);
+
+        for (int i = 0; i < numSampledFrames; ++i)
+        {
+            int n = numSampledFrames == 1 ? 0 : static_cast<int>(static_cast<int64_t>(i) * (numFrames - 1) / (numSampledFrames - 1));
+
+            const VSFrame* frame = vsapi->getFrame(n, audio, nullptr, 0);
+            if (!frame)
+            {
+                // a key without this frame could match an edited clip
+                return std::nullopt;
+            }
+
+            hash.updateValue(n);
+            hashFrameContent(hash, frame, channels, bytesPerSample, statsPeakUsed, vsapi);
+
+            vsapi->freeFrame(frame);
+        }
+
+        return hash.digest();
+    }
+
+
+    std::optional<double> loadCachedPeak(const std::string& cacheDir, uint64_t key)
+    {
+        std::ifstream file(getPeakCacheFilePath(cacheDir, key));
+        if (!file)
+        {
+            return std::nullopt;
+        }
+
+        std::string content;
+        std::getline(file, content);
+
+        double peak;
+        auto [ptr, ec] = std::from_chars(content.data(), content.data() + content.size(), peak);
+        if (ec != std::errc() || ptr != content.data() + content.size())
+        {
+            return std::nullopt;
+        }
+
+        return peak;
+    }
+
+
+    bool storeCachedPeak(const std::string& cacheDir, uint64_t key, double peak, std::optional<uint64_t> contentChecksum)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(cacheDir, ec);
+        if (ec)
+        {
+            return false;
+        }
+
+        std::filesystem::path filePath = getPeakCacheFilePath(cacheDir, key);
+        std::filesystem::path tmpFilePath = filePath;
+        tmpFilePath += ".tmp";
+
+        {
+            std::ofstream file(tmpFilePath, std::ios::trunc);
+            if (!file)
+            {
+                return false;
+            }
+
+            // shortest representation that reads back to the same value
+            file << std::format("{}\n", peak);
+
+            if (contentChecksum.has_value())
+            {
+                file << std::format("{:016x}\n", contentChecksum.value());
+            }
+
+            if (!file)
+            {
+                return false;
+            }
+        }
+
+        // replace the cache file at once, a concurrent reader never sees a partial file
+        std::filesystem::rename(tmpFilePath, filePath, ec);
+        if (ec)
+        {
+            std::filesystem::remove(tmpFilePath, ec);
+            return false;
+        }
+
+        return true;
+    }
+
+
+    double findPeakCached(VSNode* audio, const VSAudioInfo* audioInfo, const std::vector<int>& channels, bool normalize, bool truePeak, bool useStats,
+                          int maxRequests, const PeakScanControl& control, const std::string& cacheDir, const char* logFuncName, VSCore* core, const VSAPI* vsapi)
+    {
+        if (cacheDir.empty())
+        {
+            return findPeak(audio, audioInfo, channels, normalize, truePeak, useStats, maxRequests, control, core, vsapi);
+        }
+
+        std::optional<uint64_t> optKey = getPeakCacheKey(audio, audioInfo, channels, normalize, truePeak, useStats, vsapi);
+        if (!optKey.has_value())
+        {
+            std::string warnMsg = std::format("{}: could not read the fingerprint frames, the peak cache is not used", logFuncName);
+            vsapi->logMessage(VSMessageType::mtWarning, warnMsg.c_str(), core);
+
+            return findPeak(audio, audioInfo, channels, normalize, truePeak, useStats, maxRequests, control, core, vsapi);
+        }
+
+        uint64_t key = optKey.value();
+
+        if (std::optional<double> optPeak = loadCachedPeak(cacheDir, key))
+        {
+            return optPeak.value();
+        }
+
+        // checksums of all frames in the same pass as the peak scan
+        bool statsPeakUsed = isStatsPeakUsed(normalize, truePeak, useStats);
+        size_t bytesPerSample = static_cast<size_t>(audioInfo->format.bytesPerSample);
+
+        std::vector<uint64_t> frameChecksums(static_cast<size_t>(audioInfo->numFrames));
+        std::atomic<int> numChecksums = 0;
+        std::atomic<bool> frameError = false;
+
+        ScanFrameObserver checksumFrame = [&](int n, const VSFrame* frame)
+        {
+            if (control.frameObserver)
+            {
+                (*control.frameObserver)(n, frame);
+            }
+
+            if (!frame)
+            {
+                frameError = true;
+                return;
+            }
+
+            utils::Fnv1aHash frameHash;
+            hashFrameContent(frameHash, frame, channels, bytesPerSample, statsPeakUsed, vsapi);
+
+            frameChecksums[n] = frameHash.digest();
+            ++numChecksums;
+        };
+
+        PeakScanControl checksumControl = control;
+        checksumControl.frameObserver = &checksumFrame;
+
+        double peak = findPeak(audio, audioInfo, channels, normalize, truePeak, useStats, maxRequests, checksumControl, core, vsapi);
+
+        if (control.isCancelled())
+        {
+            // incomplete peak
+            return peak;
+        }
+
+        if (frameError)
+        {
+            // the peak of the other frames would be stored as the peak of the clip
+            std::string warnMsg = std::format("{}: could not read all frames, the peak is not cached", logFuncName);
+            vsapi->logMessage(VSMessageType::mtWarning, warnMsg.c_str(), core);
+            return peak;
+        }
+
+        // the sample peak scan stops at the maximum possible peak, there is no checksum of the whole clip then
+        std::optional<uint64_t> contentChecksum;
+        if (numChecksums == audioInfo->numFrames)
+        {
+            utils::Fnv1aHash hash;
+            for (const uint64_t& frameChecksum : frameChecksums)
+            {
+                hash.updateValue(frameChecksum);
+            }
+            contentChecksum = hash.digest();
+        }
+
+        if (!storeCachedPeak(cacheDir, key, peak, contentChecksum))
+        {
+            std::string warnMsg = std::format("{}: could not write peak cache file to: {}", logFuncName, cacheDir);
+            vsapi->logMessage(VSMessageType::mtWarning, warnMsg.c_str(), core);
+        }
+
+        return peak;
+    }
+}
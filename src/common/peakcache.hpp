@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+#include "common/peak.hpp"
+
+namespace common
+{
+    /**
+     * returns a fingerprint of the audio clip and the peak search options:
+     * audio format, length, channel set, normalize, truePeak, useStats and checksums of 16 frames spread over the whole clip
+     * (the stats props peaks instead of the samples of frames with stats props if the peak search takes them, see common::findPeak)
+     * this is blocking until the sampled frames are read
+     * returns std::nullopt if a sampled frame could not be read
+     */
+    std::optional<uint64_t> getPeakCacheKey(VSNode* audio, const VSAudioInfo* audioInfo, const std::vector<int>& channels, bool normalize, bool truePeak,
+                                            bool useStats, const VSAPI* vsapi);
+
+    // returns std::nullopt if there is no valid cache entry
+    std::optional<double> loadCachedPeak(const std::string& cacheDir, uint64_t key);
+
+    /**
+     * returns false if the cache entry could not be written
+     * contentChecksum: checksum of all frames of the peak scan, stored with the peak to identify the measured content
+     */
+    bool storeCachedPeak(const std::string& cacheDir, uint64_t key, double peak, std::optional<uint64_t> contentChecksum);
+
+    /**
+     * same as common::findPeak, but looks up the peak in the cache directory first
+     * the cache is disabled if cacheDir is empty, it is bypassed if the cache key could not be computed
+     * on a cache hit only the frames of the key are read, on a miss the content checksum is computed in the same pass as the peak scan
+     * failing to read a frame or to write the cache entry is logged as warning, the peak of a cancelled scan or with frame errors is not stored
+     */
+    double findPeakCached(VSNode* audio, const VSAudioInfo* audioInfo, const std::vector<int>& channels, bool normalize, bool truePeak, bool useStats,
+                          int maxRequests, const PeakScanControl& control, const std::string& cacheDir, const char* logFuncName, VSCore* core, const VSAPI* vsapi);
+}
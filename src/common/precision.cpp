@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: MIT
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "common/precision.hpp"
+#include "common/sampletype.hpp"
+#include "utils/array.hpp"
+
+namespace common
+{
+    constexpr std::pair<std::string_view, Precision> strPrecisionPairs[] =
+    {
+        { "double", Precision::Double },
+        { "float",  Precision::Float },
+    };
+
+
+    std::map<std::string, Precision> getStringPrecisionMap()
+    {
+        return utils::constStringViewPairArrayToStringMap(strPrecisionPairs);
+    }
+
+
+    bool isFloatCompute(Precision precision, SampleType st)
+    {
+        return precision == Precision::Float && st == SampleType::Float32;
+    }
+}
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <string>
+#include <type_traits>
+
+#include "common/sampletype.hpp"
+#include "simd/sampleconv.hpp"
+#include "utils/sample.hpp"
+
+namespace common
+{
+    // floating point type the samples of a filter are processed in
+    enum class Precision
+    {
+        // every sample type is processed as double
+        Double,
+        // float samples are processed as float (no conversion to double and back), other sample types as double
+        Float,
+    };
+
+    std::map<std::string, Precision> getStringPrecisionMap();
+
+
+    // true if samples of the sample type are processed as float
+    bool isFloatCompute(Precision precision, SampleType st);
+
+
+    /**
+     * converts numSamples samples to the compute type
+     * compute_t double: same as simd::convSamplesToDouble, compute_t float: float samples only (copy)
+     */
+    template <typename sample_t, size_t IntSampleBits, typename compute_t>
+    requires std::same_as<compute_t, double> || (std::same_as<compute_t, float> && std::same_as<sample_t, float>)
+    void convSamplesToCompute(const sample_t* in, compute_t* out, int numSamples)
+    {
+        if constexpr (std::is_same_v<compute_t, double>)
+        {
+            simd::convSamplesToDouble<sample_t, IntSampleBits>(in, out, numSamples);
+        }
+        else
+        {
+            std::memcpy(out, in, static_cast<size_t>(numSamples) * sizeof(float));
+        }
+    }
+
+
+    // single sample version of convSamplesToCompute, the bit shift of the sample type has to be removed already
+    template <typename sample_t, size_t IntSampleBits, typename compute_t>
+    requires std::same_as<compute_t, double> || (std::same_as<compute_t, float> && std::same_as<sample_t, float>)
+    compute_t convSampleToCompute(sample_t sample)
+    {
+        if constexpr (std::is_same_v<compute_t, double>)
+        {
+            return utils::convSampleToDouble<sample_t, IntSampleBits>(sample);
+        }
+        else
+        {
+            return sample;
+        }
+    }
+}
@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numbers>
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+#include "common/resampler.hpp"
+#include "simd/resample.hpp"
+
+namespace common
+{
+    // Kaiser window design (stopband attenuation in dB)
+    constexpr double StopbandAttenuation = 100.0;
+
+
+    ResampleRatio getResampleRatio(int inRate, int outRate)
+    {
+        int gcd = std::gcd(inRate, outRate);
+
+        return { .up = outRate / gcd, .down = inRate / gcd };
+    }
+
+
+    int64_t getResampledLength(int64_t numSamples, const ResampleRatio& ratio)
+    {
+        // output sample j is inside the input if j * down < numSamples * up
+        return (numSamples * ratio.up + ratio.down - 1) / ratio.down;
+    }
+
+
+    // number of input samples on each side of the output position, the filter length 2 * half is a multiple of simd::ResampleTapAlign
+    static int64_t getHalfLength(const ResampleRatio& ratio, int taps)
+    {
+        // the cutoff is at the lower of both rates, the zero crossings are further apart when downsampling
+        int64_t half = ratio.up < ratio.down ? (static_cast<int64_t>(taps) * ratio.down + ratio.up - 1) / ratio.up : taps;
+
+        constexpr int64_t align = simd::ResampleTapAlign / 2;
+
+        return (half + align - 1) / align * align;
+    }
+
+
+    // modified Bessel function of the first kind of order 0 (power series)
+    static double besselI0(double x)
+    {
+        double sum = 1;
+        double term = 1;
+
+        for (int k = 1; k < 500; ++k)
+        {
+            double f = x / (2 * k);
+            term *= f * f;
+            sum += term;
+
+            if (term < sum * 1e-21)
+            {
+                break;
+            }
+        }
+        return sum;
+    }
+
+
+    /**
+     * coefficient table: phase p interpolates the input at the fractional position p / up
+     * tap k of phase p weights the input sample at distance k - (half - 1) - p / up from the output position
+     */
+    class PolyphaseFilter
+    {
+    public:
+        PolyphaseFilter(const ResampleRatio& ratio, int taps) :
+            numPhases(ratio.up)
+        {
+            half = static_cast<int>(getHalfLength(ratio, taps));
+            numTaps = 2 * half;
+
+            // lower rate / input rate
+            double scale = ratio.up < ratio.down ? static_cast<double>(ratio.up) / ratio.down : 1.0;
+
+            // the transition band ends at the lower Nyquist frequency
+            double beta = 0.1102 * (StopbandAttenuation - 8.7);
+            double transitionWidth = (StopbandAttenuation - 7.95) / (14.36 * numTaps * scale);
+            double cutoff = (0.5 - transitionWidth / 2) * scale;
+
+            double windowNorm = besselI0(beta);
+
+            coeffs.resize(static_cast<size_t>(numPhases) * numTaps);
+
+            for (int p = 0; p < numPhases; ++p)
+            {
+                double* c = coeffs.data() + static_cast<size_t>(p) * numTaps;
+                double sum = 0;
+
+                for (int k = 0; k < numTaps; ++k)
+                {
+                    double dist = k - (half - 1) - static_cast<double>(p) / numPhases;
+
+                    double x = 2 * cutoff * dist;
+                    double sinc = x == 0 ? 1.0 : std::sin(std::numbers::pi * x) / (std::numbers::pi * x);
+
+                    double t = dist / half;
+                    double window = besselI0(beta * std::sqrt(std::max(0.0, 1 - t * t))) / windowNorm;
+
+                    c[k] = sinc * window;
+                    sum += c[k];
+                }
+
+                // unity gain at 0 Hz for every phase
+                for (int k = 0; k < numTaps; ++k)
+                {
+                    c[k] /= sum;
+                }
+            }
+        }
+
+        const int numPhases;
+        int half;
+        int numTaps;
+
+        // [phase][tap]
+        std::vector<double> coeffs;
+    };
+
+
+    // filters of all resamplers, shared while at least one resampler uses them
+    static std::mutex filterCacheMutex;
+    static std::map<std::tuple<int, int, int>, std::weak_ptr<const PolyphaseFilter>> filterCache;
+
+
+    static std::shared_ptr<const PolyphaseFilter> getPolyphaseFilter(const ResampleRatio& ratio, int taps)
+    {
+        std::lock_guard<std::mutex> lock(filterCacheMutex);
+
+        std::weak_ptr<const PolyphaseFilter>& cached = filterCache[{ ratio.up, ratio.down, taps }];
+
+        std::shared_ptr<const PolyphaseFilter> filter = cached.lock();
+        if (!filter)
+        {
+            filter = std::make_shared<const PolyphaseFilter>(ratio, taps);
+            cached = filter;
+        }
+        return filter;
+    }
+
+
+    Resampler::Resampler(const ResampleRatio& _ratio, int taps) :
+        ratio(_ratio), filter(getPolyphaseFilter(_ratio, taps))
+    {
+    }
+
+
+    bool Resampler::isSupported(const ResampleRatio& ratio, int taps)
+    {
+        return 2 * getHalfLength(ratio, taps) * ratio.up <= MaxCoeffs;
+    }
+
+
+    SampleRange Resampler::getInputRange(int64_t outBegin, int64_t outEnd) const
+    {
+        // input sample left of (or at) the output position
+        int64_t first = outBegin * ratio.down / ratio.up;
+        int64_t last = (outEnd - 1) * ratio.down / ratio.up;
+
+        return { .begin = first - (filter->half - 1), .end = last + filter->half + 1 };
+    }
+
+
+    void Resampler::process(const double* in, int64_t outBegin, double* out, int numSamples) const
+    {
+        int phase = static_cast<int>(outBegin * ratio.down % ratio.up);
+
+        simd::resamplePolyphase(in, filter->coeffs.data(), filter->numTaps, ratio.up, ratio.down, phase, out, numSamples);
+    }
+}
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace common
+{
+    // output rate / input rate = up / down as reduced fraction
+    struct ResampleRatio
+    {
+        int up;
+        int down;
+    };
+
+    ResampleRatio getResampleRatio(int inRate, int outRate);
+
+    // number of output samples of numSamples input samples, the position of the last output sample is inside the input
+    int64_t getResampledLength(int64_t numSamples, const ResampleRatio& ratio);
+
+
+    // [begin, end) sample positions, can be outside of the clip
+    struct SampleRange
+    {
+        int64_t begin;
+        int64_t end;
+    };
+
+
+    class PolyphaseFilter;
+
+    /**
+     * windowed sinc (Kaiser) polyphase resampler of one rate ratio
+     * output sample j is located at input position j * down / up, the input is treated as surrounded by silence
+     * the filter has up phases, the coefficient table is shared by all resamplers with the same ratio and taps
+     */
+    class Resampler
+    {
+    public:
+        static constexpr int MinTaps = 8;
+        static constexpr int MaxTaps = 256;
+
+        // limit of the coefficient table size (number of phases * filter length)
+        static constexpr int64_t MaxCoeffs = 1 << 21;
+
+        /**
+         * taps: zero crossings of the sinc on each side of the filter at the lower of both rates
+         * the filter is longer at the input rate when downsampling
+         */
+        Resampler(const ResampleRatio& ratio, int taps);
+
+        // false if the coefficient table of the ratio would be larger than MaxCoeffs
+        static bool isSupported(const ResampleRatio& ratio, int taps);
+
+        // input samples read by the output samples [outBegin, outEnd), outBegin < outEnd
+        SampleRange getInputRange(int64_t outBegin, int64_t outEnd) const;
+
+        /**
+         * writes the output samples [outBegin, outBegin + numSamples)
+         * in: input samples of getInputRange(outBegin, outBegin + numSamples), in[0] is the input sample at range begin
+         */
+        void process(const double* in, int64_t outBegin, double* out, int numSamples) const;
+
+    private:
+        ResampleRatio ratio;
+
+        std::shared_ptr<const PolyphaseFilter> filter;
+    };
+}
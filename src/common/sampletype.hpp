@@ -2,9 +2,12 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <map>
 #include <optional>
 #include <string>
+#include <type_traits>
 
 #include "VapourSynth4.h"
 
@@ -26,6 +29,40 @@ namespace common
         Float64
     };
 
+    constexpr size_t NumSampleTypes = 6;
+
+
+    // returns the SampleType of a sample_t / IntSampleBits template pair
+    template <typename sample_t, size_t IntSampleBits>
+    constexpr SampleType toSampleType()
+    {
+        if constexpr (std::is_same_v<sample_t, int8_t> && IntSampleBits == 8)
+        {
+            return SampleType::Int8;
+        }
+        else if constexpr (std::is_same_v<sample_t, int16_t> && IntSampleBits == 16)
+        {
+            return SampleType::Int16;
+        }
+        else if constexpr (std::is_same_v<sample_t, int32_t> && IntSampleBits == 24)
+        {
+            return SampleType::Int24;
+        }
+        else if constexpr (std::is_same_v<sample_t, int32_t> && IntSampleBits == 32)
+        {
+            return SampleType::Int32;
+        }
+        else if constexpr (std::is_same_v<sample_t, float>)
+        {
+            return SampleType::Float32;
+        }
+        else
+        {
+            static_assert(std::is_same_v<sample_t, double>, "unsupported sample type");
+            return SampleType::Float64;
+        }
+    }
+
     std::map<std::string, SampleType> getStringSampleTypeMap();
 
     std::map<std::string, SampleType> getStringVapourSynthSampleTypeMap();
@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <utility>
+
+#include "VapourSynth4.h"
+
+#include "common/overflow.hpp"
+#include "common/silenceframes.hpp"
+#include "common/stats.hpp"
+
+namespace common
+{
+    void SilenceFrames::init(const VSAudioFormat& _format, bool _stats)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        format = _format;
+        stats = _stats;
+    }
+
+
+    const VSFrame* SilenceFrames::get(int frmLen, VSCore* core, const VSAPI* vsapi)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto it = std::find_if(frames.begin(), frames.end(), [frmLen](const std::pair<int, const VSFrame*>& f) { return f.first == frmLen; });
+        if (it != frames.end())
+        {
+            return vsapi->addFrameRef(it->second);
+        }
+
+        VSFrame* frm = vsapi->newAudioFrame(&format, frmLen, nullptr, core);
+
+        for (int ch = 0; ch < format.numChannels; ++ch)
+        {
+            // zero bytes are a zero sample for all sample types
+            std::memset(vsapi->getWritePtr(frm, ch), 0, static_cast<size_t>(frmLen) * static_cast<size_t>(format.bytesPerSample));
+        }
+
+        // no overflows in silence
+        updateFrameStatsProps(frm, stats, OverflowStats(), vsapi);
+
+        frames.emplace_back(frmLen, frm);
+
+        return vsapi->addFrameRef(frm);
+    }
+
+
+    void SilenceFrames::clear(const VSAPI* vsapi)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (const std::pair<int, const VSFrame*>& f : frames)
+        {
+            vsapi->freeFrame(f.second);
+        }
+
+        frames.clear();
+    }
+}
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+namespace common
+{
+    /**
+     * shared silent output frames of a filter, one per frame length (only the last frame can be shorter)
+     * a fully silent output frame is returned as a new reference of the shared frame instead of allocating and zeroing a frame
+     * thread safe
+     */
+    class SilenceFrames
+    {
+    public:
+        // stats: the shared frames get the stats props (see common/stats.hpp)
+        void init(const VSAudioFormat& format, bool stats);
+
+        // returns a new reference of the silent frame with frmLen samples, the frame is created on first use
+        const VSFrame* get(int frmLen, VSCore* core, const VSAPI* vsapi);
+
+        // frees all frames, call in the free function of the filter
+        void clear(const VSAPI* vsapi);
+
+    private:
+        std::mutex mutex;
+
+        VSAudioFormat format = {};
+        bool stats = false;
+
+        std::vector<std::pair<int, const VSFrame*>> frames;
+    };
+}
@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: MIT
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+#include "common/overflow.hpp"
+#include "common/sampletype.hpp"
+#include "common/stats.hpp"
+#include "simd/sampleconv.hpp"
+
+namespace common
+{
+    ChannelStats calcFrameChannelStats(const VSFrame* frm, int ch, SampleType st, const VSAPI* vsapi)
+    {
+        int frmLen = vsapi->getFrameLength(frm);
+        if (frmLen <= 0)
+        {
+            return {};
+        }
+
+        std::array<double, VS_AUDIO_FRAME_SAMPLES> samples;
+        simd::convSamplesToDouble(st, vsapi->getReadPtr(frm, ch), samples.data(), frmLen);
+
+        double peak = 0.0;
+        double sum = 0.0;
+        double sumSquares = 0.0;
+
+        for (int s = 0; s < frmLen; ++s)
+        {
+            double sample = samples[s];
+
+            double absSample = std::abs(sample);
+            if (peak < absSample)
+            {
+                peak = absSample;
+            }
+
+            sum += sample;
+            sumSquares += sample * sample;
+        }
+
+        return { .peak = peak,
+                 .rms = std::sqrt(sumSquares / frmLen),
+                 .dc = sum / frmLen };
+    }
+
+
+    void setFrameStatsProps(VSFrame* frm, const OverflowStats& overflowStats, const VSAPI* vsapi)
+    {
+        const VSAudioFormat* format = vsapi->getAudioFrameFormat(frm);
+        SampleType st = getSampleTypeFromAudioFormat(*format).value();
+
+        int numChannels = format->numChannels;
+
+        std::vector<double> peaks(numChannels);
+        std::vector<double> rms(numChannels);
+        std::vector<double> dc(numChannels);
+        std::vector<int64_t> overflows(numChannels, 0);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            ChannelStats stats = calcFrameChannelStats(frm, ch, st, vsapi);
+            peaks[ch] = stats.peak;
+            rms[ch] = stats.rms;
+            dc[ch] = stats.dc;
+
+            if (static_cast<size_t>(ch) < overflowStats.channelCounts.size())
+            {
+                overflows[ch] = overflowStats.channelCounts[ch];
+            }
+        }
+
+        VSMap* props = vsapi->getFramePropertiesRW(frm);
+        vsapi->mapSetFloatArray(props, StatsPeakProp, peaks.data(), numChannels);
+        vsapi->mapSetFloatArray(props, StatsRMSProp, rms.data(), numChannels);
+        vsapi->mapSetFloatArray(props, StatsDCProp, dc.data(), numChannels);
+        vsapi->mapSetIntArray(props, StatsOverflowsProp, overflows.data(), numChannels);
+    }
+
+
+    void deleteFrameStatsProps(VSFrame* frm, const VSAPI* vsapi)
+    {
+        VSMap* props = vsapi->getFramePropertiesRW(frm);
+        vsapi->mapDeleteKey(props, StatsPeakProp);
+        vsapi->mapDeleteKey(props, StatsRMSProp);
+        vsapi->mapDeleteKey(props, StatsDCProp);
+        vsapi->mapDeleteKey(props, StatsOverflowsProp);
+    }
+
+
+    void updateFrameStatsProps(VSFrame* frm, bool enabled, const OverflowStats& overflowStats, const VSAPI* vsapi)
+    {
+        if (enabled)
+        {
+            setFrameStatsProps(frm, overflowStats, vsapi);
+        }
+        else
+        {
+            deleteFrameStatsProps(frm, vsapi);
+        }
+    }
+
+
+    const VSFrame* passFrameStatsProps(const VSFrame* frm, bool enabled, VSCore* core, const VSAPI* vsapi)
+    {
+        if (!enabled)
+        {
+            // samples are unchanged -> props of frm are still valid
+            return frm;
+        }
+
+        VSFrame* outFrm = vsapi->copyFrame(frm, core);
+        vsapi->freeFrame(frm);
+
+        setFrameStatsProps(outFrm, OverflowStats(), vsapi);
+        return outFrm;
+    }
+
+
+    std::optional<double> getFrameStatsPeak(const VSFrame* frm, int ch, const VSAPI* vsapi)
+    {
+        const VSMap* props = vsapi->getFramePropertiesRO(frm);
+
+        if (vsapi->mapGetType(props, StatsPeakProp) != ptFloat ||
+            vsapi->mapNumElements(props, StatsPeakProp) != vsapi->getAudioFrameFormat(frm)->numChannels)
+        {
+            return std::nullopt;
+        }
+
+        int err = 0;
+        double peak = vsapi->mapGetFloat(props, StatsPeakProp, ch, &err);
+        if (err)
+        {
+            return std::nullopt;
+        }
+        return peak;
+    }
+}
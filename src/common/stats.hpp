@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <optional>
+
+#include "VapourSynth4.h"
+
+#include "common/overflow.hpp"
+#include "common/sampletype.hpp"
+
+namespace common
+{
+    // frame properties with one value per channel
+    // absolute peak of the normalized samples [0,1] (float samples can exceed 1)
+    constexpr const char* StatsPeakProp = "_AtoolsPeak";
+    // root mean square of the normalized samples
+    constexpr const char* StatsRMSProp = "_AtoolsRMS";
+    // mean of the normalized samples
+    constexpr const char* StatsDCProp = "_AtoolsDC";
+    // number of overflows handled by the filter that wrote the frame
+    constexpr const char* StatsOverflowsProp = "_AtoolsOverflows";
+
+
+    struct ChannelStats
+    {
+        double peak = 0.0;
+        double rms = 0.0;
+        double dc = 0.0;
+    };
+
+
+    /**
+     * calculates the stats of one frame channel
+     * samples are normalized like utils::convSampleToDouble, so peak matches the normalized result of findPeak
+     */
+    ChannelStats calcFrameChannelStats(const VSFrame* frm, int ch, SampleType st, const VSAPI* vsapi);
+
+    /**
+     * writes the stats props of all channels of frm
+     * overflowStats: overflows of this frame (per channel counts)
+     */
+    void setFrameStatsProps(VSFrame* frm, const OverflowStats& overflowStats, const VSAPI* vsapi);
+
+    // removes the stats props, e.g. props of the source frame that are stale after the samples were changed
+    void deleteFrameStatsProps(VSFrame* frm, const VSAPI* vsapi);
+
+    /**
+     * call for every new output frame of a filter with a stats option
+     * writes the stats props if enabled, otherwise removes stale stats props copied from the prop source frame
+     */
+    void updateFrameStatsProps(VSFrame* frm, bool enabled, const OverflowStats& overflowStats, const VSAPI* vsapi);
+
+    /**
+     * call for every output frame that is passed through unchanged by a filter with a stats option
+     * returns frm itself if stats are disabled, otherwise a copy of frm with the stats props (frm is freed)
+     */
+    const VSFrame* passFrameStatsProps(const VSFrame* frm, bool enabled, VSCore* core, const VSAPI* vsapi);
+
+    // returns the peak prop of channel ch or std::nullopt if the frame has no valid stats props
+    std::optional<double> getFrameStatsPeak(const VSFrame* frm, int ch, const VSAPI* vsapi);
+}
@@ -4,6 +4,7 @@
 #include <cmath>
 #include <map>
 #include <numbers>
+#include <span>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -21,12 +22,41 @@ namespace common
     };
 
 
+    // the recurrences in fill() are restarted from an exact value every AnchorInterval samples
+    // to keep the accumulated rounding error far below the resolution of 32 bit samples
+    // the last sample of every run and the transition endpoints are evaluated with calcY
+    constexpr size_t AnchorInterval = 256;
+
+
     std::map<std::string, TransitionType> getStringTransitionTypeMap()
     {
         return utils::constStringViewPairArrayToStringMap(strTransitionTypePairs);
     }
 
 
+    void Transition::fill(double x0, std::span<double> out)
+    {
+        for (size_t i = 0; i < out.size(); ++i)
+        {
+            out[i] = calcY(x0 + static_cast<double>(i));
+        }
+    }
+
+
+    void Transition::pinEndpoints(double x0, std::span<double> out, double x1, double x2)
+    {
+        for (double x : { x1, x2 })
+        {
+            double pos = x - x0;
+
+            if (0 <= pos && pos < static_cast<double>(out.size()) && pos == std::floor(pos))
+            {
+                out[static_cast<size_t>(pos)] = calcY(x);
+            }
+        }
+    }
+
+
     LinearTransition::LinearTransition(double _x1, double _y1, double _x2, double _y2) :
         x1(_x1), y1(_y1), x2(_x2), y2(_y2)
     {
@@ -47,6 +77,21 @@ namespace common
         return gradient * x + yOffset;
     }
 
+    void LinearTransition::fill(double x0, std::span<double> out)
+    {
+        if (x1 == x2)
+        {
+            std::fill(out.begin(), out.end(), y1);
+            return;
+        }
+
+        // a direct evaluation is as cheap as a forward difference and has no accumulated error
+        for (size_t i = 0; i < out.size(); ++i)
+        {
+            out[i] = gradient * (x0 + static_cast<double>(i)) + yOffset;
+        }
+    }
+
 
     CubicTransition::CubicTransition(double _x1, double _y1, double _x2, double _y2) :
         x1(_x1), y1(_y1), x2(_x2), y2(_y2)
@@ -77,6 +122,45 @@ namespace common
         return factor3 * x_x1DiffPow3 + factor2 * x_x1DiffPow2 + y1;
     }
 
+    void CubicTransition::fill(double x0, std::span<double> out)
+    {
+        if (x1 == x2)
+        {
+            std::fill(out.begin(), out.end(), y1);
+            return;
+        }
+
+        // forward differencing with step 1:
+        // y(t) = f3 * t^3 + f2 * t^2 + y1    with t = x - x1
+        // d1(t) = y(t + 1) - y(t) = f3 * (3t^2 + 3t + 1) + f2 * (2t + 1)
+        // d2(t) = d1(t + 1) - d1(t) = f3 * (6t + 6) + 2 * f2
+        // d3 = d2(t + 1) - d2(t) = 6 * f3
+        const double d3 = 6 * factor3;
+
+        for (size_t anchor = 0; anchor < out.size(); anchor += AnchorInterval)
+        {
+            size_t end = std::min(anchor + AnchorInterval, out.size());
+
+            double t = x0 + static_cast<double>(anchor) - x1;
+
+            double y = calcY(x0 + static_cast<double>(anchor));
+            double d1 = factor3 * (3 * t * t + 3 * t + 1) + factor2 * (2 * t + 1);
+            double d2 = factor3 * (6 * t + 6) + 2 * factor2;
+
+            for (size_t i = anchor; i < end; ++i)
+            {
+                out[i] = y;
+                y += d1;
+                d1 += d2;
+                d2 += d3;
+            }
+
+            out[end - 1] = calcY(x0 + static_cast<double>(end - 1));
+        }
+
+        pinEndpoints(x0, out, x1, x2);
+    }
+
 
     SineTransition::SineTransition(double _x1, double _y1, double _x2, double _y2) :
         x1(_x1), y1(_y1), x2(_x2), y2(_y2)
@@ -96,6 +180,43 @@ namespace common
         return std::cos((x - x1) * xScale) * yScale + yOffset;
     }
 
+    void SineTransition::fill(double x0, std::span<double> out)
+    {
+        if (x1 == x2)
+        {
+            std::fill(out.begin(), out.end(), y1);
+            return;
+        }
+
+        // rotate (cos(a), sin(a)) by xScale per sample:
+        // cos(a + d) = cos(a) * cos(d) - sin(a) * sin(d)
+        // sin(a + d) = sin(a) * cos(d) + cos(a) * sin(d)
+        const double cosStep = std::cos(xScale);
+        const double sinStep = std::sin(xScale);
+
+        for (size_t anchor = 0; anchor < out.size(); anchor += AnchorInterval)
+        {
+            size_t end = std::min(anchor + AnchorInterval, out.size());
+
+            double angle = (x0 + static_cast<double>(anchor) - x1) * xScale;
+            double cosAngle = std::cos(angle);
+            double sinAngle = std::sin(angle);
+
+            for (size_t i = anchor; i < end; ++i)
+            {
+                out[i] = cosAngle * yScale + yOffset;
+
+                double nextCos = cosAngle * cosStep - sinAngle * sinStep;
+                sinAngle = sinAngle * cosStep + cosAngle * sinStep;
+                cosAngle = nextCos;
+            }
+
+            out[end - 1] = calcY(x0 + static_cast<double>(end - 1));
+        }
+
+        pinEndpoints(x0, out, x1, x2);
+    }
+
 
     Transition* newTransition(TransitionType type, double x1, double y1, double x2, double y2)
     {
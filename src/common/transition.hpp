@@ -3,6 +3,7 @@
 #pragma once
 
 #include <map>
+#include <span>
 #include <string>
 
 namespace common
@@ -23,6 +24,13 @@ namespace common
         virtual ~Transition() = default;
 
         virtual double calcY(double x) = 0;
+
+        // batch version of calcY: out[i] = calcY(x0 + i)
+        virtual void fill(double x0, std::span<double> out);
+
+    protected:
+        // overwrites the samples at x1 and x2 (if inside out) with calcY, fill() reaches y1 and y2 exactly like calcY
+        void pinEndpoints(double x0, std::span<double> out, double x1, double x2);
     };
 
 
@@ -33,6 +41,8 @@ namespace common
 
         double calcY(double x) override;
 
+        void fill(double x0, std::span<double> out) override;
+
     private:
         double x1;
         double y1;
@@ -51,6 +61,8 @@ namespace common
 
         double calcY(double x) override;
 
+        void fill(double x0, std::span<double> out) override;
+
     private:
         double x1;
         double y1;
@@ -68,6 +80,8 @@ namespace common
 
         double calcY(double x) override;
 
+        void fill(double x0, std::span<double> out) override;
+
     private:
         double x1;
         double y1;
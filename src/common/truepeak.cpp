@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+#include "common/framescan.hpp"
+#include "common/sampletype.hpp"
+#include "common/truepeak.hpp"
+#include "simd/minmax.hpp"
+#include "simd/sampleconv.hpp"
+#include "simd/truepeak.hpp"
+
+namespace common
+{
+    constexpr int History = simd::TruePeakHistory;
+
+
+    // shared state of one findTruePeak call, accessed by the scan callbacks of the worker threads
+    class TruePeakScan
+    {
+    public:
+        TruePeakScan(const VSAudioInfo* audioInfo, const std::vector<int>& _channels) :
+            channels(_channels),
+            sampleType(common::getSampleTypeFromAudioFormat(audioInfo->format).value()),
+            numFrames(audioInfo->numFrames)
+        {
+        }
+
+        void scanFrame(int n, const VSFrame* frame, const VSAPI* vsapi)
+        {
+            int frmLen = vsapi->getFrameLength(frame);
+            bool lastFrame = n == numFrames - 1;
+
+            // the last frame is followed by silence: the filter runs History samples past its end
+            int numPositions = lastFrame ? frmLen + History : frmLen;
+
+            // first History samples (zero padded in a short last frame) and last History samples of every channel
+            std::vector<double> head(channels.size() * History);
+            std::vector<double> tail(lastFrame ? 0 : channels.size() * History);
+
+            std::array<double, VS_AUDIO_FRAME_SAMPLES + History> samples;
+
+            double framePeak = 0;
+
+            for (size_t c = 0; c < channels.size(); ++c)
+            {
+                simd::convSamplesToDouble(sampleType, vsapi->getReadPtr(frame, channels[c]), samples.data(), frmLen);
+                std::fill(samples.begin() + frmLen, samples.begin() + frmLen + History, 0.0);
+
+                // the oversampling filter does not pass the samples unchanged, the sample peak is the lower bound
+                simd::MinMax range = { .min = 0, .max = 0 };
+                simd::findMinMax<double, 0>(samples.data(), frmLen, range);
+                framePeak = std::max(framePeak, std::max(-range.min, range.max));
+
+                // positions with the whole filter history inside this frame
+                if (History < numPositions)
+                {
+                    framePeak = std::max(framePeak, simd::findTruePeak(samples.data() + History, numPositions - History));
+                }
+
+                std::copy(samples.begin(), samples.begin() + History, head.begin() + c * History);
+
+                if (!lastFrame)
+                {
+                    std::copy(samples.begin() + frmLen - History, samples.begin() + frmLen, tail.begin() + c * History);
+                }
+            }
+
+            // the first positions of a frame need the tail of the previous frame, whichever of both frames is read last oversamples them
+            std::optional<std::vector<double>> prevTail;
+            std::optional<std::vector<double>> nextHead;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                if (0 < n)
+                {
+                    if (auto it = tails.find(n - 1); it != tails.end())
+                    {
+                        prevTail = std::move(it->second);
+                        tails.erase(it);
+                    }
+                    else
+                    {
+                        heads.emplace(n, head);
+                    }
+                }
+
+                if (!lastFrame)
+                {
+                    if (auto it = heads.find(n + 1); it != heads.end())
+                    {
+                        nextHead = std::move(it->second);
+                        heads.erase(it);
+                    }
+                    else
+                    {
+                        tails.emplace(n, tail);
+                    }
+                }
+            }
+
+            if (n == 0)
+            {
+                // the clip is preceded by silence
+                framePeak = std::max(framePeak, findEdgePeak(std::vector<double>(channels.size() * History, 0.0), head));
+            }
+
+            if (prevTail.has_value())
+            {
+                framePeak = std::max(framePeak, findEdgePeak(prevTail.value(), head));
+            }
+
+            if (nextHead.has_value())
+            {
+                framePeak = std::max(framePeak, findEdgePeak(tail, nextHead.value()));
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            peak = std::max(peak, framePeak);
+        }
+
+        double getPeak()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return peak;
+        }
+
+    private:
+        const std::vector<int>& channels;
+        const common::SampleType sampleType;
+        const int numFrames;
+
+        std::mutex mutex;
+
+        // guarded by mutex
+        double peak = 0;
+        // heads of frames whose previous frame is not read yet and tails of frames whose next frame is not read yet
+        std::map<int, std::vector<double>> heads;
+        std::map<int, std::vector<double>> tails;
+
+        // true peak of the first History positions of a frame
+        double findEdgePeak(const std::vector<double>& prevTail, const std::vector<double>& head) const
+        {
+            double edgePeak = 0;
+
+            std::array<double, 2 * History> samples;
+
+            for (size_t c = 0; c < channels.size(); ++c)
+            {
+                std::copy(prevTail.begin() + c * History, prevTail.begin() + (c + 1) * History, samples.begin());
+                std::copy(head.begin() + c * History, head.begin() + (c + 1) * History, samples.begin() + History);
+
+                edgePeak = std::max(edgePeak, simd::findTruePeak(samples.data() + History, History));
+            }
+            return edgePeak;
+        }
+    };
+
+
+    double findTruePeak(VSNode* audio, const VSAudioInfo* audioInfo, const std::vector<int>& channels,
+                        int maxRequests, const ScanControl& control, VSCore* core, const VSAPI* vsapi)
+    {
+        TruePeakScan scan(audioInfo, channels);
+
+        auto scanFrame = [&scan, vsapi](int n, const VSFrame* frame, const char* errorMsg)
+        {
+            if (frame)
+            {
+                scan.scanFrame(n, frame, vsapi);
+            }
+            return true;
+        };
+
+        scanFrames(audio, audioInfo->numFrames, maxRequests, control, "true peak", scanFrame, core, vsapi);
+
+        return scan.getPeak();
+    }
+}
@@ -0,0 +1,22 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <vector>
+
+#include "VapourSynth4.h"
+
+#include "common/framescan.hpp"
+
+namespace common
+{
+    /**
+     * reads all frames to determine the normalized true peak of channels (ITU-R BS.1770-4 Annex 2, 4x oversampling, see simd::findTruePeak)
+     * the result is never below the normalized sample peak, the audio is treated as preceded and followed by silence
+     * the frames are read in parallel with common::scanFrames, the first samples of a frame are oversampled
+     * with the end of the previous frame as filter history once both frames are read
+     * this is blocking until all frames are read
+     */
+    double findTruePeak(VSNode* audio, const VSAudioInfo* audioInfo, const std::vector<int>& channels,
+                        int maxRequests, const ScanControl& control, VSCore* core, const VSAPI* vsapi);
+}
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: MIT
 
 #include <algorithm>
+#include <array>
 #include <climits>
 #include <cmath>
 #include <cstdint>
@@ -8,8 +9,10 @@
 #include <format>
 #include <limits>
 #include <optional>
+#include <span>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "VapourSynth4.h"
@@ -19,6 +22,8 @@
 #include "common/offset.hpp"
 #include "common/overflow.hpp"
 #include "common/sampletype.hpp"
+#include "common/stats.hpp"
+#include "simd/sampleconv.hpp"
 #include "utils/sample.hpp"
 #include "vsmap/vsmap.hpp"
 #include "vsmap/vsmap_common.hpp"
@@ -29,16 +34,23 @@ constexpr const char* FuncName = "Convert";
 
 constexpr common::OverflowMode DefaultOverflowMode = common::OverflowMode::Error;
 constexpr common::OverflowLog DefaultOverflowLog = common::OverflowLog::Once;
+constexpr bool DefaultStats = false;
 
 
 Convert::Convert(VSNode* _audio, const VSAudioInfo* inInfo, common::SampleType _outSampleType,
-                 common::OverflowMode _overflowMode, common::OverflowLog _overflowLog) :
-    audio(_audio), outSampleType(_outSampleType), overflowMode(_overflowMode), overflowLog(_overflowLog)
+                 common::OverflowMode _overflowMode, common::OverflowLog _overflowLog, bool _stats) :
+    audio(_audio), outSampleType(_outSampleType), overflowMode(_overflowMode), overflowLog(_overflowLog), stats(_stats)
 {
     inSampleType = common::getSampleTypeFromAudioFormat(inInfo->format).value();
 
     outInfo = *inInfo;
     common::applySampleTypeToAudioFormat(outSampleType, outInfo.format);
+
+    // the samples are not changed, integer input samples are exactly inside [-1, 1] and fit into every output sample type
+    // (selected at compile time by writeFrameChannel)
+    overflowPossible = common::isFloatSampleType(inSampleType);
+
+    overflowTracker.init(FuncName, overflowMode, overflowLog, common::isFloatSampleType(outSampleType), outInfo.numFrames);
 }
 
 
@@ -53,24 +65,33 @@ const VSAudioInfo& Convert::getOutInfo()
 }
 
 
+bool Convert::isOverflowPossible()
+{
+    return overflowPossible;
+}
+
+
+bool Convert::isStatsEnabled()
+{
+    return stats;
+}
+
+
 bool Convert::isPassthrough()
 {
     return inSampleType == outSampleType;
 }
 
 
-void Convert::resetOverflowStats()
+void Convert::submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi)
 {
-    overflowStats = { .count = 0, .peak = 0.0 };
+    overflowTracker.submitFrame(outFrmNum, std::move(frameOverflowStats), core, vsapi);
 }
 
 
-void Convert::logOverflowStats(VSCore* core, const VSAPI* vsapi)
+void Convert::flushOverflowStats(VSCore* core, const VSAPI* vsapi)
 {
-    if (0 < overflowStats.count)
-    {
-        overflowStats.logVS(FuncName, overflowMode, isFloatSampleType(outSampleType), core, vsapi);
-    }
+    overflowTracker.flush(core, vsapi);
 }
 
 
@@ -88,28 +109,14 @@ bool Convert::writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStart,
 
     const in_sample_t* inFrmPtr = reinterpret_cast<const in_sample_t*>(ofCtx.vsapi->getReadPtr(inFrm, ch));
 
-    constexpr vsutils::BitShift inBitShift = vsutils::getSampleBitShift<in_sample_t, InSampleIntBits>();
-
-    for (int s = 0; s < outFrmLen; ++s)
-    {
-        int64_t outPos = outPosFrmStart + s;
-
-        in_sample_t sample = inFrmPtr[s];
+    std::array<double, VS_AUDIO_FRAME_SAMPLES> samples;
 
-        if constexpr (inBitShift.required)
-        {
-            sample >>= inBitShift.count;
-        }
+    simd::convSamplesToDouble<in_sample_t, InSampleIntBits>(inFrmPtr, samples.data(), outFrmLen);
 
-        if (!common::safeWriteSample<out_sample_t, OutSampleIntBits>(
-                utils::convSampleToDouble<in_sample_t, InSampleIntBits>(sample), outFrmPtr, s, outPos, ch, ofCtx, overflowStats))
-        {
-            // overflow and error
-            return false;
-        }
-    }
+    // see overflowPossible
+    constexpr bool checkOverflow = std::is_floating_point_v<in_sample_t>;
 
-    return true;
+    return common::safeWriteSamples<out_sample_t, OutSampleIntBits, checkOverflow>(std::span(samples.data(), outFrmLen), outFrmPtr, outPosFrmStart, ch, ofCtx);
 }
 
 
@@ -130,11 +137,12 @@ bool Convert::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* inFr
 }
 
 
-bool Convert::writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+bool Convert::writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
 {
     common::OverflowContext ofCtx =
         { .mode = overflowMode, .log = overflowLog, .funcName = FuncName,
-          .frameCtx = frameCtx, .core = core, .vsapi = vsapi };
+          .frameCtx = frameCtx, .core = core, .vsapi = vsapi,
+          .stats = overflowStats };
 
     switch (inSampleType)
     {
@@ -261,8 +269,7 @@ bool Convert::writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, V
 static void VS_CC convertFree(void* instanceData, VSCore* core, const VSAPI* vsapi)
 {
     Convert* data = static_cast<Convert*>(instanceData);
-    // skip logging since the total number of overflows is unreliable
-    // data->logNumOverflows(core, vsapi);
+    data->flushOverflowStats(core, vsapi);
     data->free(vsapi);
     delete data;
 }
@@ -280,33 +287,31 @@ static const VSFrame* VS_CC convertGetFrame(int outFrmNum, int activationReason,
 
     if (activationReason == VSActivationReason::arAllFramesReady)
     {
-        if (outFrmNum == 0)
-        {
-            data->resetOverflowStats();
-        }
-
         const VSFrame* inFrm = vsapi->getFrameFilter(outFrmNum, data->getAudio(), frameCtx);
 
         if (data->isPassthrough())
         {
             // pass through if input sample type equals output sample type
-            return inFrm;
+            return common::passFrameStatsProps(inFrm, data->isStatsEnabled(), core, vsapi);
         }
 
         int inFrmLen = vsapi->getFrameLength(inFrm);
 
         VSFrame* outFrm = vsapi->newAudioFrame(&data->getOutInfo().format, inFrmLen, inFrm, core);
 
-        bool success = data->writeFrame(outFrm, outFrmNum, inFrm, frameCtx, core, vsapi);
+        common::OverflowStats overflowStats;
+
+        bool success = data->writeFrame(outFrm, outFrmNum, inFrm, overflowStats, frameCtx, core, vsapi);
 
         vsapi->freeFrame(inFrm);
 
-        if (outFrmNum == data->getOutInfo().numFrames - 1)
+        if (success)
         {
-            // last frame
-            data->logOverflowStats(core, vsapi);
+            common::updateFrameStatsProps(outFrm, data->isStatsEnabled(), overflowStats, vsapi);
         }
 
+        data->submitOverflowStats(outFrmNum, std::move(overflowStats), core, vsapi);
+
         if (success)
         {
             return outFrm;
@@ -373,12 +378,17 @@ static void VS_CC convertCreate(const VSMap* in, VSMap* out, void* userData, VSC
         return;
     }
 
-    Convert* data = new Convert(audio, audioInfo, optOutSampleType.value(), optOverflowMode.value(), optOverflowLog.value());
+    // stats:int:opt
+    bool stats = vsmap::getOptBool("stats", in, vsapi, DefaultStats);
+
+    Convert* data = new Convert(audio, audioInfo, optOutSampleType.value(), optOverflowMode.value(), optOverflowLog.value(), stats);
 
     VSFilterDependency deps[] = {{ audio, rpStrictSpatial }};
 
-    // fmParallelRequests: strict sequential frame requests for overflow logging
-    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), convertGetFrame, convertFree, VSFilterMode::fmParallelRequests, deps, 1, data, core);
+    common::logOverflowCheck(FuncName, data->isOverflowPossible(), core, vsapi);
+
+    // fmParallel: overflows are collected per frame and logged in frame order by common::OverflowTracker
+    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), convertGetFrame, convertFree, VSFilterMode::fmParallel, deps, 1, data, core);
 }
 
 
@@ -388,7 +398,8 @@ void convertInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi)
                              "clip:anode;"
                              "sample_type:data;"
                              "overflow:data:opt;"
-                             "overflow_log:data:opt;",
+                             "overflow_log:data:opt;"
+                             "stats:int:opt;",
                              "return:anode;",
                              convertCreate, nullptr, plugin);
 }
@@ -12,21 +12,28 @@
 class Convert
 {
 public:
-    Convert(VSNode* audio, const VSAudioInfo* audioInfo, common::SampleType outSampleType, common::OverflowMode overflowMode, common::OverflowLog overflowLog);
+    Convert(VSNode* audio, const VSAudioInfo* audioInfo, common::SampleType outSampleType, common::OverflowMode overflowMode, common::OverflowLog overflowLog,
+            bool stats);
 
     VSNode* getAudio();
 
     const VSAudioInfo& getOutInfo();
 
+    // false if no output sample can overflow, see common::isOverflowPossible
+    bool isOverflowPossible();
+
+    // true if the stats props are written to every output frame, see common/stats.hpp
+    bool isStatsEnabled();
+
     bool isPassthrough();
 
-    void resetOverflowStats();
+    void submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi);
 
-    void logOverflowStats(VSCore* core, const VSAPI* vsapi);
+    void flushOverflowStats(VSCore* core, const VSAPI* vsapi);
 
     void free(const VSAPI* vsapi);
 
-    bool writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
+    bool writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
 
 private:
     VSNode* audio;
@@ -38,7 +45,12 @@ private:
     common::OverflowMode overflowMode;
     common::OverflowLog overflowLog;
 
-    common::OverflowStats overflowStats = { .count = 0, .peak = 0.0 };
+    common::OverflowTracker overflowTracker;
+
+    // only used for logging, the overflow checks are selected at compile time by the input sample type
+    bool overflowPossible;
+
+    bool stats;
 
     template <typename in_sample_t, size_t InSampleIntBits, typename out_sample_t, size_t OutSampleIntBits>
     bool writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStart, int outFrmLen, const VSFrame* inFrm,
@@ -1,23 +1,30 @@
 // SPDX-License-Identifier: MIT
 
 #include <algorithm>
+#include <array>
 #include <climits>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <format>
 #include <limits>
+#include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <type_traits>
+#include <utility>
 
 #include "VapourSynth4.h"
 #include "VSHelper4.h"
 
 #include "crossfade.hpp"
+#include "common/framewindow.hpp"
 #include "common/offset.hpp"
 #include "common/overflow.hpp"
+#include "common/precision.hpp"
 #include "common/sampletype.hpp"
+#include "common/stats.hpp"
 #include "common/transition.hpp"
 #include "utils/debug.hpp"
 #include "utils/sample.hpp"
@@ -32,15 +39,17 @@ constexpr int64_t DefaultFadeSamples = 0;
 constexpr common::TransitionType DefaultFadeType = common::TransitionType::Cubic;
 constexpr common::OverflowMode DefaultOverflowMode = common::OverflowMode::Error;
 constexpr common::OverflowLog DefaultOverflowLog = common::OverflowLog::Once;
+constexpr bool DefaultStats = false;
+constexpr common::Precision DefaultPrecision = common::Precision::Double;
 
 
 CrossFade::CrossFade(VSNode* _audio1, const VSAudioInfo* _audio1Info, VSNode* _audio2, const VSAudioInfo* _audio2Info,
                      int64_t fadeSamples, common::TransitionType fadeType,
-                     common::OverflowMode _overflowMode, common::OverflowLog _overflowLog) :
+                     common::OverflowMode _overflowMode, common::OverflowLog _overflowLog, bool _stats, common::Precision _precision) :
     audio1(_audio1), audio1Info(*_audio1Info), audio2(_audio2), audio2Info(*_audio2Info),
-    overflowMode(_overflowMode), overflowLog(_overflowLog)
+    overflowMode(_overflowMode), overflowLog(_overflowLog), stats(_stats), precision(_precision)
 {
-    fadeSamples = std::max(fadeSamples, 0LL);
+    fadeSamples = std::max<int64_t>(fadeSamples, 0);
 
     // create destination audio information
     outInfo = audio1Info;
@@ -54,10 +63,18 @@ CrossFade::CrossFade(VSNode* _audio1, const VSAudioInfo* _audio1Info, VSNode* _a
 
     audio2FrameSampleOffsets = common::getFrameSampleOffsets(outPosFadeStart);
 
+    // only needed if every audio2 frame is used by two output frames (audio1 frames are used once)
+    audio2Window.init(audio2FrameSampleOffsets.left == 0 ? 0 : common::FrameWindow::DefaultCapacity);
+
     if (0 < fadeSamples)
     {
         fadeoutTrans = common::newTransition(fadeType, 0, 1, static_cast<double>(fadeSamples - 1), 0);
     }
+
+    // the audio1 and audio2 scales are inside [0, 1] and add up to 1
+    overflowPossible = common::isOverflowPossible(common::getMaxAbsSample(outSampleType), outSampleType, precision);
+
+    overflowTracker.init(FuncName, overflowMode, overflowLog, common::isFloatSampleType(outSampleType), outInfo.numFrames);
 }
 
 
@@ -73,24 +90,39 @@ VSNode* CrossFade::getAudio2()
 }
 
 
+common::FrameWindow& CrossFade::getAudio2Window()
+{
+    return audio2Window;
+}
+
+
 const VSAudioInfo& CrossFade::getOutInfo()
 {
     return outInfo;
 }
 
 
-void CrossFade::resetOverflowStats()
+bool CrossFade::isOverflowPossible()
 {
-    overflowStats = { .count = 0, .peak = 0.0 };
+    return overflowPossible;
 }
 
 
-void CrossFade::logOverflowStats(VSCore* core, const VSAPI* vsapi)
+bool CrossFade::isStatsEnabled()
 {
-    if (0 < overflowStats.count)
-    {
-        overflowStats.logVS(FuncName, overflowMode, isFloatSampleType(outSampleType), core, vsapi);
-    }
+    return stats;
+}
+
+
+void CrossFade::submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi)
+{
+    overflowTracker.submitFrame(outFrmNum, std::move(frameOverflowStats), core, vsapi);
+}
+
+
+void CrossFade::flushOverflowStats(VSCore* core, const VSAPI* vsapi)
+{
+    overflowTracker.flush(core, vsapi);
 }
 
 
@@ -98,6 +130,8 @@ void CrossFade::free(const VSAPI* vsapi)
 {
     delete fadeoutTrans;
 
+    audio2Window.clear(vsapi);
+
     vsapi->freeNode(audio1);
     vsapi->freeNode(audio2);
 }
@@ -115,7 +149,7 @@ common::OffsetFramePos CrossFade::outFrameToAudio2Frames(int outFrmNum)
 }
 
 
-template <typename sample_t, size_t IntSampleBits>
+template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t>
 bool CrossFade::writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStart, int outFrmLen,
                                   const VSFrame* a1Frm, const VSFrame* a2FrmL, const VSFrame* a2FrmR,
                                   const common::OverflowContext& ofCtx)
@@ -128,6 +162,20 @@ bool CrossFade::writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStar
 
     constexpr vsutils::BitShift bitShift = vsutils::getSampleBitShift<sample_t, IntSampleBits>();
 
+    std::array<compute_t, VS_AUDIO_FRAME_SAMPLES> samples;
+
+    // audio1 scales of the frame samples inside the crossfade: [fadeBegin, fadeEnd)
+    std::array<double, VS_AUDIO_FRAME_SAMPLES> audio1Scales;
+
+    int fadeBegin = static_cast<int>(std::clamp<int64_t>(outPosFadeStart - outPosFrmStart, 0, outFrmLen));
+    int fadeEnd = static_cast<int>(std::clamp<int64_t>(outPosFadeEnd - outPosFrmStart, 0, outFrmLen));
+
+    if (fadeBegin < fadeEnd && fadeoutTrans)
+    {
+        int64_t fadePosBegin = outPosFrmStart + fadeBegin - outPosFadeStart;
+        fadeoutTrans->fill(static_cast<double>(fadePosBegin), std::span(audio1Scales.data(), fadeEnd - fadeBegin));
+    }
+
     for (int s = 0; s < outFrmLen; ++s)
     {
         int64_t outPos = outPosFrmStart + s;
@@ -144,12 +192,7 @@ bool CrossFade::writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStar
                 a1Sample >>= bitShift.count;
             }
 
-            if (!common::safeWriteSample<sample_t, IntSampleBits>(utils::convSampleToDouble<sample_t, IntSampleBits>(a1Sample),
-                                                                  outFrmPtr, s, outPos, ch, ofCtx, overflowStats))
-            {
-                // overflow and error
-                return false;
-            }
+            samples[s] = common::convSampleToCompute<sample_t, IntSampleBits, compute_t>(a1Sample);
         }
         else if (outPosFadeEnd <= outPos)
         {
@@ -171,12 +214,7 @@ bool CrossFade::writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStar
                 a2Sample >>= bitShift.count;
             }
 
-            if (!common::safeWriteSample<sample_t, IntSampleBits>(utils::convSampleToDouble<sample_t, IntSampleBits>(a2Sample),
-                                                                  outFrmPtr, s, outPos, ch, ofCtx, overflowStats))
-            {
-                // overflow and error
-                return false;
-            }
+            samples[s] = common::convSampleToCompute<sample_t, IntSampleBits, compute_t>(a2Sample);
         }
         else
         {
@@ -202,31 +240,24 @@ bool CrossFade::writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStar
                 a2Sample >>= bitShift.count;
             }
 
-            int64_t fadePos = outPos - outPosFadeStart;
-            double audio1Scale = 1;
-            double audio2Scale = 0;
+            compute_t audio1Scale = 1;
+            compute_t audio2Scale = 0;
 
             if (fadeoutTrans)
             {
-                audio1Scale = fadeoutTrans->calcY(static_cast<double>(fadePos));
+                audio1Scale = static_cast<compute_t>(audio1Scales[s - fadeBegin]);
                 audio2Scale = 1 - audio1Scale;
             }
 
-            double mixedSample = audio1Scale * utils::convSampleToDouble<sample_t, IntSampleBits>(a1Sample) +
-                                 audio2Scale * utils::convSampleToDouble<sample_t, IntSampleBits>(a2Sample);
-
-            if (!common::safeWriteSample<sample_t, IntSampleBits>(mixedSample, outFrmPtr, s, outPos, ch, ofCtx, overflowStats))
-            {
-                // overflow and error
-                return false;
-            }
+            samples[s] = audio1Scale * common::convSampleToCompute<sample_t, IntSampleBits, compute_t>(a1Sample) +
+                         audio2Scale * common::convSampleToCompute<sample_t, IntSampleBits, compute_t>(a2Sample);
         }
     }
-    return true;
+    return common::safeWriteSamples<sample_t, IntSampleBits, CheckOverflow>(std::span(samples.data(), outFrmLen), outFrmPtr, outPosFrmStart, ch, ofCtx);
 }
 
 
-template <typename sample_t, size_t IntSampleBits>
+template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t>
 bool CrossFade::writeFrameImpl(VSFrame* outFrm, int outFrmNum,
                                const VSFrame* a1Frm, const VSFrame* a2FrmL, const VSFrame* a2FrmR,
                                const common::OverflowContext& ofCtx)
@@ -236,7 +267,7 @@ bool CrossFade::writeFrameImpl(VSFrame* outFrm, int outFrmNum,
 
     for (int ch = 0; ch < outInfo.format.numChannels; ++ch)
     {
-        if (!writeFrameChannel<sample_t, IntSampleBits>(ch, outFrm, outPosFrmStart, outFrmLen, a1Frm, a2FrmL, a2FrmR, ofCtx))
+        if (!writeFrameChannel<sample_t, IntSampleBits, CheckOverflow, compute_t>(ch, outFrm, outPosFrmStart, outFrmLen, a1Frm, a2FrmL, a2FrmR, ofCtx))
         {
             return false;
         }
@@ -247,26 +278,38 @@ bool CrossFade::writeFrameImpl(VSFrame* outFrm, int outFrmNum,
 
 bool CrossFade::writeFrame(VSFrame* outFrm, int outFrmNum,
                            const VSFrame* a1Frm, const VSFrame* a2FrmL, const VSFrame* a2FrmR,
-                           VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+                           common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
 {
     common::OverflowContext ofCtx =
         { .mode = overflowMode, .log = overflowLog, .funcName = FuncName,
-          .frameCtx = frameCtx, .core = core, .vsapi = vsapi };
+          .frameCtx = frameCtx, .core = core, .vsapi = vsapi,
+          .stats = overflowStats };
 
     switch (outSampleType)
     {
         case common::SampleType::Int8:
-            return writeFrameImpl<int8_t, 8>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx);
+            return overflowPossible ? writeFrameImpl<int8_t, 8, true>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx)
+                                    : writeFrameImpl<int8_t, 8, false>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx);
         case common::SampleType::Int16:
-            return writeFrameImpl<int16_t, 16>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx);
+            return overflowPossible ? writeFrameImpl<int16_t, 16, true>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx)
+                                    : writeFrameImpl<int16_t, 16, false>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx);
         case common::SampleType::Int24:
-            return writeFrameImpl<int32_t, 24>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx);
+            return overflowPossible ? writeFrameImpl<int32_t, 24, true>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx)
+                                    : writeFrameImpl<int32_t, 24, false>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx);
         case common::SampleType::Int32:
-            return writeFrameImpl<int32_t, 32>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx);
+            return overflowPossible ? writeFrameImpl<int32_t, 32, true>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx)
+                                    : writeFrameImpl<int32_t, 32, false>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx);
         case common::SampleType::Float32:
-            return writeFrameImpl<float, 0>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx);
+            if (common::isFloatCompute(precision, outSampleType))
+            {
+                // float rounding errors can overflow, see common::isOverflowPossible
+                return writeFrameImpl<float, 0, true, float>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx);
+            }
+            return overflowPossible ? writeFrameImpl<float, 0, true>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx)
+                                    : writeFrameImpl<float, 0, false>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx);
         case common::SampleType::Float64:
-            return writeFrameImpl<double, 0>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx);
+            return overflowPossible ? writeFrameImpl<double, 0, true>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx)
+                                    : writeFrameImpl<double, 0, false>(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, ofCtx);
         default:
             return false;
     }
@@ -276,8 +319,7 @@ bool CrossFade::writeFrame(VSFrame* outFrm, int outFrmNum,
 static void VS_CC crossfadeFree(void* instanceData, VSCore* core, const VSAPI* vsapi)
 {
     CrossFade* data = static_cast<CrossFade*>(instanceData);
-    // skip logging since the total number of overflows is unreliable
-    // data->logNumOverflows(core, vsapi);
+    data->flushOverflowStats(core, vsapi);
     data->free(vsapi);
     delete data;
 }
@@ -292,70 +334,64 @@ static const VSFrame* VS_CC crossfadeGetFrame(int outFrmNum, int activationReaso
 
     common::OffsetFramePos a2FrmNums = data->outFrameToAudio2Frames(outFrmNum);
 
+    if (activationReason == VSActivationReason::arError)
+    {
+        common::freeWindowFrames(frameData, vsapi);
+        return nullptr;
+    }
+
     if (activationReason == VSActivationReason::arInitial)
     {
+        bool frmRequested = false;
+
         if (0 <= a1FrmNum)
         {
             vsapi->requestFrameFilter(a1FrmNum, data->getAudio1(), frameCtx);
+            frmRequested = true;
         }
 
-        if (0 <= a2FrmNums.left)
+        // audio2 frames that are still in the frame window are not requested again
+        auto windowFrms = std::make_unique<common::WindowFrames>(1);
+
+        if (common::requestOffsetFrames(a2FrmNums, data->getAudio2(), data->getAudio2Window(), windowFrms->at(0), frameCtx, vsapi))
         {
-            vsapi->requestFrameFilter(a2FrmNums.left, data->getAudio2(), frameCtx);
+            frmRequested = true;
         }
 
-        if (0 <= a2FrmNums.right)
+        *frameData = windowFrms.release();
+
+        if (frmRequested)
         {
-            vsapi->requestFrameFilter(a2FrmNums.right, data->getAudio2(), frameCtx);
+            return nullptr;
         }
 
-        return nullptr;
+        // all frames are in the frame window: the frame is returned right away
     }
 
-    if (activationReason == VSActivationReason::arAllFramesReady)
+    if (activationReason == VSActivationReason::arInitial || activationReason == VSActivationReason::arAllFramesReady)
     {
-        if (outFrmNum == 0)
-        {
-            data->resetOverflowStats();
-        }
+        std::unique_ptr<common::WindowFrames> windowFrms(common::releaseWindowFrames(frameData));
 
         const VSFrame* a1Frm = nullptr;
-        const VSFrame* a2FrmL = nullptr;
-        const VSFrame* a2FrmR = nullptr;
-        const VSFrame* propFrm = nullptr;
 
         if (0 <= a1FrmNum)
         {
             a1Frm = vsapi->getFrameFilter(a1FrmNum, data->getAudio1(), frameCtx);
-            if (!propFrm)
-            {
-                propFrm = a1Frm;
-            }
         }
 
-        if (0 <= a2FrmNums.left)
-        {
-            a2FrmL = vsapi->getFrameFilter(a2FrmNums.left, data->getAudio2(), frameCtx);
-            if (!propFrm)
-            {
-                propFrm = a2FrmL;
-            }
-        }
+        common::OffsetFrames a2Frms = common::getOffsetFrames(a2FrmNums, windowFrms->at(0), data->getAudio2(), data->getAudio2Window(), frameCtx, vsapi);
 
-        if (0 <= a2FrmNums.right)
-        {
-            a2FrmR = vsapi->getFrameFilter(a2FrmNums.right, data->getAudio2(), frameCtx);
-            if (!propFrm)
-            {
-                propFrm = a2FrmR;
-            }
-        }
+        const VSFrame* a2FrmL = a2Frms.left;
+        const VSFrame* a2FrmR = a2Frms.right;
+        const VSFrame* propFrm = a1Frm ? a1Frm : (a2FrmL ? a2FrmL : a2FrmR);
 
         int outFrmLen = vsutils::getFrameSampleCount(outFrmNum, data->getOutInfo().numSamples);
 
         VSFrame* outFrm = vsapi->newAudioFrame(&data->getOutInfo().format, outFrmLen, propFrm, core);
 
-        bool success = data->writeFrame(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, frameCtx, core, vsapi);
+        common::OverflowStats overflowStats;
+
+        bool success = data->writeFrame(outFrm, outFrmNum, a1Frm, a2FrmL, a2FrmR, overflowStats, frameCtx, core, vsapi);
 
         if (a1Frm)
         {
@@ -372,12 +408,13 @@ static const VSFrame* VS_CC crossfadeGetFrame(int outFrmNum, int activationReaso
             vsapi->freeFrame(a2FrmR);
         }
 
-        if (outFrmNum == data->getOutInfo().numFrames - 1)
+        if (success)
         {
-            // last frame
-            data->logOverflowStats(core, vsapi);
+            common::updateFrameStatsProps(outFrm, data->isStatsEnabled(), overflowStats, vsapi);
         }
 
+        data->submitOverflowStats(outFrmNum, std::move(overflowStats), core, vsapi);
+
         if (success)
         {
             return outFrm;
@@ -498,12 +535,27 @@ static void VS_CC crossfadeCreate(const VSMap* in, VSMap* out, void* userData, V
         return;
     }
 
-    CrossFade* data = new CrossFade(audio1, audio1Info, audio2, audio2Info, samples, optFadeType.value(), optOverflowMode.value(), optOverflowLog.value());
+    // stats:int:opt
+    bool stats = vsmap::getOptBool("stats", in, vsapi, DefaultStats);
+
+    // precision:data:opt
+    std::optional<common::Precision> optPrecision = vsmap::getOptPrecisionFromString("precision", FuncName, in, out, vsapi, DefaultPrecision);
+    if (!optPrecision.has_value())
+    {
+        vsapi->freeNode(audio1);
+        vsapi->freeNode(audio2);
+        return;
+    }
+
+    CrossFade* data = new CrossFade(audio1, audio1Info, audio2, audio2Info, samples, optFadeType.value(), optOverflowMode.value(), optOverflowLog.value(), stats,
+                                    optPrecision.value());
 
     VSFilterDependency deps[] = {{ audio1, VSRequestPattern::rpStrictSpatial }, { audio2, VSRequestPattern::rpGeneral }};
 
-    // fmParallelRequests: strict sequential frame requests for overflow logging
-    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), crossfadeGetFrame, crossfadeFree, VSFilterMode::fmParallelRequests, deps, 2, data, core);
+    common::logOverflowCheck(FuncName, data->isOverflowPossible(), core, vsapi);
+
+    // fmParallel: overflows are collected per frame and logged in frame order by common::OverflowTracker
+    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), crossfadeGetFrame, crossfadeFree, VSFilterMode::fmParallel, deps, 2, data, core);
 }
 
 
@@ -516,7 +568,9 @@ void crossfadeInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi)
                              "seconds:float:opt;"
                              "type:data:opt;"
                              "overflow:data:opt;"
-                             "overflow_log:data:opt;",
+                             "overflow_log:data:opt;"
+                             "stats:int:opt;"
+                             "precision:data:opt;",
                              "return:anode;",
                              crossfadeCreate, nullptr, plugin);
 }
@@ -6,8 +6,10 @@
 
 #include "VapourSynth4.h"
 
+#include "common/framewindow.hpp"
 #include "common/offset.hpp"
 #include "common/overflow.hpp"
+#include "common/precision.hpp"
 #include "common/sampletype.hpp"
 #include "common/transition.hpp"
 
@@ -16,17 +18,26 @@ class CrossFade
 public:
     CrossFade(VSNode* audio1, const VSAudioInfo* audio1Info, VSNode* audio2, const VSAudioInfo* audio2Info,
               int64_t fadeSamples, common::TransitionType transType,
-              common::OverflowMode overflowMode, common::OverflowLog overflowLog);
+              common::OverflowMode overflowMode, common::OverflowLog overflowLog, bool stats, common::Precision precision);
 
     VSNode* getAudio1();
 
     VSNode* getAudio2();
 
+    // recently fetched audio2 frames, see common::FrameWindow
+    common::FrameWindow& getAudio2Window();
+
     const VSAudioInfo& getOutInfo();
 
-    void resetOverflowStats();
+    // false if no output sample can overflow, see common::isOverflowPossible
+    bool isOverflowPossible();
+
+    // true if the stats props are written to every output frame, see common/stats.hpp
+    bool isStatsEnabled();
 
-    void logOverflowStats(VSCore* core, const VSAPI* vsapi);
+    void submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi);
+
+    void flushOverflowStats(VSCore* core, const VSAPI* vsapi);
 
     void free(const VSAPI* vsapi);
 
@@ -36,7 +47,7 @@ public:
 
     bool writeFrame(VSFrame* outFrm, int outFrmNum,
                     const VSFrame* a1Frm, const VSFrame* a2FrmL, const VSFrame* a2FrmR,
-                    VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
+                    common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
 
 private:
     VSNode* audio1;
@@ -53,7 +64,15 @@ private:
     common::OverflowMode overflowMode;
     common::OverflowLog overflowLog;
 
-    common::OverflowStats overflowStats = { .count = 0, .peak = 0.0 };
+    common::OverflowTracker overflowTracker;
+
+    // selects the writeFrameImpl specialization with or without overflow checks
+    bool overflowPossible;
+
+    bool stats;
+
+    // compute type of float samples, see common::Precision
+    common::Precision precision;
 
     // transition is expected to go from (0, 1) to (samples - 1, 0)
     common::Transition* fadeoutTrans = nullptr;
@@ -65,12 +84,14 @@ private:
 
     common::FrameSampleOffsets audio2FrameSampleOffsets;
 
-    template <typename sample_t, size_t IntSampleBits>
+    common::FrameWindow audio2Window;
+
+    template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t = double>
     bool writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStart, int outFrmLen,
                            const VSFrame* a1Frm, const VSFrame* a2FrmL, const VSFrame* a2FrmR,
                            const common::OverflowContext& ofCtx);
 
-    template <typename sample_t, size_t IntSampleBits>
+    template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t = double>
     bool writeFrameImpl(VSFrame* outFrm, int outFrmNum,
                         const VSFrame* a1Frm, const VSFrame* a2FrmL, const VSFrame* a2FrmR,
                         const common::OverflowContext& ofCtx);
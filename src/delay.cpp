@@ -1,24 +1,31 @@
 // SPDX-License-Identifier: MIT
 
 #include <algorithm>
+#include <array>
 #include <climits>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <format>
 #include <limits>
+#include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "VapourSynth4.h"
 #include "VSHelper4.h"
 
 #include "delay.hpp"
+#include "common/framewindow.hpp"
 #include "common/offset.hpp"
 #include "common/overflow.hpp"
 #include "common/sampletype.hpp"
+#include "common/silenceframes.hpp"
+#include "common/stats.hpp"
 #include "utils/debug.hpp"
 #include "utils/sample.hpp"
 #include "utils/vector.hpp"
@@ -32,12 +39,13 @@ constexpr const char* FuncName = "Delay";
 constexpr int64_t DefaultDelaySamples = 0;
 constexpr common::OverflowMode DefaultOverflowMode = common::OverflowMode::Error;
 constexpr common::OverflowLog DefaultOverflowLog = common::OverflowLog::Once;
+constexpr bool DefaultStats = false;
 
 
 Delay::Delay(VSNode* _audio, const VSAudioInfo* _audioInfo, int64_t _offsetSamples, std::vector<int> _editChannels,
-             common::OverflowMode _overflowMode, common::OverflowLog _overflowLog) :
+             common::OverflowMode _overflowMode, common::OverflowLog _overflowLog, bool _stats) :
     audio(_audio), audioInfo(*_audioInfo), editChannels(_editChannels),
-    overflowMode(_overflowMode), overflowLog(_overflowLog)
+    overflowMode(_overflowMode), overflowLog(_overflowLog), stats(_stats)
 {
     outSampleType = common::getSampleTypeFromAudioFormat(audioInfo.format).value();
 
@@ -46,7 +54,16 @@ Delay::Delay(VSNode* _audio, const VSAudioInfo* _audioInfo, int64_t _offsetSampl
 
     audioFrameSampleOffsets = common::getFrameSampleOffsets(outPosOffsetStart);
 
+    frameAligned = audioFrameSampleOffsets.left == 0;
+
+    // only needed if every input frame is used by two output frames
+    audioWindow.init(frameAligned ? 0 : common::FrameWindow::DefaultCapacity);
+
     copyChannels = utils::vectorInvert(editChannels, 0, audioInfo.format.numChannels);
+
+    overflowTracker.init(FuncName, overflowMode, overflowLog, common::isFloatSampleType(outSampleType), audioInfo.numFrames);
+
+    silenceFrames.init(audioInfo.format, stats);
 }
 
 
@@ -56,12 +73,30 @@ VSNode* Delay::getAudio()
 }
 
 
+common::FrameWindow& Delay::getAudioWindow()
+{
+    return audioWindow;
+}
+
+
+const VSFrame* Delay::getSilenceFrame(int outFrmLen, VSCore* core, const VSAPI* vsapi)
+{
+    return silenceFrames.get(outFrmLen, core, vsapi);
+}
+
+
 const VSAudioInfo& Delay::getOutInfo()
 {
     return audioInfo;
 }
 
 
+bool Delay::isStatsEnabled()
+{
+    return stats;
+}
+
+
 common::OffsetFramePos Delay::outFrameToOffsetInFrames(int outFrmNum)
 {
     return common::baseFrameToOffsetFrames(outFrmNum, outPosOffsetStart, audioInfo.numSamples, audioInfo.numSamples);
@@ -80,23 +115,55 @@ size_t Delay::getNumEditChannels()
 }
 
 
-void Delay::resetOverflowStats()
+std::vector<const VSFrame*> Delay::getOutChannelSources(int outFrmNum, int outFrmLen, const VSFrame* inFrm, const VSFrame* offsetInFrmL, const VSAPI* vsapi)
 {
-    overflowStats = { .count = 0, .peak = 0.0 };
-}
+    std::vector<const VSFrame*> outChannelSources(static_cast<size_t>(audioInfo.format.numChannels), nullptr);
+
+    for (const int& ch : copyChannels)
+    {
+        outChannelSources[ch] = inFrm;
+    }
 
+    int64_t outPosFrmStart = vsutils::frameToFirstSample(outFrmNum);
 
-void Delay::logOverflowStats(VSCore* core, const VSAPI* vsapi)
-{
-    if (0 < overflowStats.count)
+    // the whole output frame has to be inside the delayed audio and the input frame must have the same length
+    if (!frameAligned || !offsetInFrmL ||
+        outPosFrmStart < outPosOffsetStart || outPosOffsetEnd < outPosFrmStart + outFrmLen ||
+        vsapi->getFrameLength(offsetInFrmL) != outFrmLen)
+    {
+        return outChannelSources;
+    }
+
+    for (const int& ch : editChannels)
     {
-        overflowStats.logVS(FuncName, overflowMode, isFloatSampleType(outSampleType), core, vsapi);
+        // overflowing input samples are handled by writeFrame
+        if (!common::isFrameChannelOverflowing(offsetInFrmL, ch, outSampleType, vsapi))
+        {
+            outChannelSources[ch] = offsetInFrmL;
+        }
     }
+
+    return outChannelSources;
+}
+
+
+void Delay::submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi)
+{
+    overflowTracker.submitFrame(outFrmNum, std::move(frameOverflowStats), core, vsapi);
+}
+
+
+void Delay::flushOverflowStats(VSCore* core, const VSAPI* vsapi)
+{
+    overflowTracker.flush(core, vsapi);
 }
 
 
 void Delay::free(const VSAPI* vsapi)
 {
+    audioWindow.clear(vsapi);
+    silenceFrames.clear(vsapi);
+
     vsapi->freeNode(audio);
 }
 
@@ -111,61 +178,48 @@ bool Delay::writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStart, i
     const sample_t* offsetInFrmLPtr = reinterpret_cast<const sample_t*>(offsetInFrmL ? ofCtx.vsapi->getReadPtr(offsetInFrmL, ch) : nullptr);
     const sample_t* offsetInFrmRPtr = reinterpret_cast<const sample_t*>(offsetInFrmR ? ofCtx.vsapi->getReadPtr(offsetInFrmR, ch) : nullptr);
 
-    constexpr vsutils::BitShift bitShift = vsutils::getSampleBitShift<sample_t, IntSampleBits>();
+    // frame samples inside the delayed audio: [copyBegin, copyEnd), zeros otherwise
+    int copyBegin = static_cast<int>(std::clamp<int64_t>(outPosOffsetStart - outPosFrmStart, 0, outFrmLen));
+    int copyEnd = static_cast<int>(std::clamp<int64_t>(outPosOffsetEnd - outPosFrmStart, 0, outFrmLen));
+
+    // zero bytes are a zero sample for all sample types
+    std::memset(outFrmPtr, 0, static_cast<size_t>(copyBegin) * sizeof(sample_t));
+    std::memset(outFrmPtr + copyEnd, 0, static_cast<size_t>(outFrmLen - copyEnd) * sizeof(sample_t));
 
-    for (int s = 0; s < outFrmLen; ++s)
+    if (copyEnd <= copyBegin)
     {
-        int64_t outPos = outPosFrmStart + s;
+        return true;
+    }
 
-        if (outPos < outPosOffsetStart || outPosOffsetEnd <= outPos)
-        {
-            // fill with zeros
-            if (!common::safeWriteSample<sample_t, IntSampleBits>(0, outFrmPtr, s, outPos, ch, ofCtx, overflowStats))
-            {
-                // overflow and error
-                return false;
-            }
-        }
-        else
-        {
 #ifndef NDEBUG
-            // only for debug builds
-            assertm(offsetInFrmLPtr, "offsetInFrmLPtr null");
-
-            if (audioFrameSampleOffsets.right != 0)
-            {
-                assertm(offsetInFrmRPtr, "offsetInFrmRPtr null");
-            }
+    // only for debug builds
+    assertm(offsetInFrmLPtr || offsetInFrmRPtr, "offsetInFrmLPtr and offsetInFrmRPtr null");
 #endif
 
-            sample_t inSample = common::getOffsetSample(s, audioFrameSampleOffsets, offsetInFrmLPtr, offsetInFrmRPtr);
-
-            if constexpr (bitShift.required)
-            {
-                inSample >>= bitShift.count;
-            }
+    // fast path: the samples are not changed, so only overflowing input samples can overflow
+    common::copyOffsetSamples<sample_t>(copyBegin, copyEnd, audioFrameSampleOffsets, offsetInFrmLPtr, offsetInFrmRPtr, outFrmPtr);
 
-            if (!common::safeWriteSample<sample_t, IntSampleBits>(utils::convSampleToDouble<sample_t, IntSampleBits>(inSample), outFrmPtr, s, outPos, ch, ofCtx, overflowStats))
-            {
-                // overflow and error
-                return false;
-            }
-        }
+    if (!utils::isAnySampleOverflowing<sample_t, IntSampleBits>(std::span<const sample_t>(outFrmPtr + copyBegin, copyEnd - copyBegin)))
+    {
+        return true;
     }
-    return true;
+
+    // slow path: handle overflowing input samples
+    std::array<double, VS_AUDIO_FRAME_SAMPLES> samples;
+
+    common::convOffsetSamplesToDouble<sample_t, IntSampleBits>(copyBegin, copyEnd, audioFrameSampleOffsets, offsetInFrmLPtr, offsetInFrmRPtr, samples.data());
+
+    return common::safeWriteSamples<sample_t, IntSampleBits>(std::span(samples.data() + copyBegin, copyEnd - copyBegin), outFrmPtr + copyBegin,
+                                                             outPosFrmStart + copyBegin, ch, ofCtx);
 }
 
 
 template <typename sample_t, size_t IntSampleBits>
-bool Delay::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm,
+bool Delay::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
                            const VSFrame* offsetInFrmL, const VSFrame* offsetInFrmR,
                            const common::OverflowContext& ofCtx)
 {
-    // copy channels
-    for (const int& ch : copyChannels)
-    {
-        vsutils::copyFrameChannel(outFrm, ch, inFrm, ch, getOutInfo().format.bytesPerSample, ofCtx.vsapi);
-    }
+    // copy channels and unchanged edit channels are already set by newAudioFrame2
 
     // edit channels
     int64_t outPosFrmStart = vsutils::frameToFirstSample(outFrmNum);
@@ -173,6 +227,11 @@ bool Delay::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm,
 
     for (const int& ch : editChannels)
     {
+        if (outChannelSources[ch])
+        {
+            continue;
+        }
+
         if (!writeFrameChannel<sample_t, IntSampleBits>(ch, outFrm, outPosFrmStart, outFrmLen, offsetInFrmL, offsetInFrmR, ofCtx))
         {
             return false;
@@ -182,28 +241,29 @@ bool Delay::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm,
 }
 
 
-bool Delay::writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm,
+bool Delay::writeFrame(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
                        const VSFrame* offsetInFrmL, const VSFrame* offsetInFrmR,
-                       VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+                       common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
 {
     common::OverflowContext ofCtx =
         { .mode = overflowMode, .log = overflowLog, .funcName = FuncName,
-          .frameCtx = frameCtx, .core = core, .vsapi = vsapi };
+          .frameCtx = frameCtx, .core = core, .vsapi = vsapi,
+          .stats = overflowStats };
 
     switch (outSampleType)
     {
         case common::SampleType::Int8:
-            return writeFrameImpl<int8_t, 8>(outFrm, outFrmNum, inFrm, offsetInFrmL, offsetInFrmR, ofCtx);
+            return writeFrameImpl<int8_t, 8>(outFrm, outFrmNum, outChannelSources, offsetInFrmL, offsetInFrmR, ofCtx);
         case common::SampleType::Int16:
-            return writeFrameImpl<int16_t, 16>(outFrm, outFrmNum, inFrm, offsetInFrmL, offsetInFrmR, ofCtx);
+            return writeFrameImpl<int16_t, 16>(outFrm, outFrmNum, outChannelSources, offsetInFrmL, offsetInFrmR, ofCtx);
         case common::SampleType::Int24:
-            return writeFrameImpl<int32_t, 24>(outFrm, outFrmNum, inFrm, offsetInFrmL, offsetInFrmR, ofCtx);
+            return writeFrameImpl<int32_t, 24>(outFrm, outFrmNum, outChannelSources, offsetInFrmL, offsetInFrmR, ofCtx);
         case common::SampleType::Int32:
-            return writeFrameImpl<int32_t, 32>(outFrm, outFrmNum, inFrm, offsetInFrmL, offsetInFrmR, ofCtx);
+            return writeFrameImpl<int32_t, 32>(outFrm, outFrmNum, outChannelSources, offsetInFrmL, offsetInFrmR, ofCtx);
         case common::SampleType::Float32:
-            return writeFrameImpl<float, 0>(outFrm, outFrmNum, inFrm, offsetInFrmL, offsetInFrmR, ofCtx);
+            return writeFrameImpl<float, 0>(outFrm, outFrmNum, outChannelSources, offsetInFrmL, offsetInFrmR, ofCtx);
         case common::SampleType::Float64:
-            return writeFrameImpl<double, 0>(outFrm, outFrmNum, inFrm, offsetInFrmL, offsetInFrmR, ofCtx);
+            return writeFrameImpl<double, 0>(outFrm, outFrmNum, outChannelSources, offsetInFrmL, offsetInFrmR, ofCtx);
         default:
             return false;
     }
@@ -213,8 +273,7 @@ bool Delay::writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm,
 static void VS_CC delayFree(void* instanceData, VSCore* core, const VSAPI* vsapi)
 {
     Delay* data = static_cast<Delay*>(instanceData);
-    // skip logging since the total number of overflows is unreliable
-    // data->logNumOverflows(core, vsapi);
+    data->flushOverflowStats(core, vsapi);
     data->free(vsapi);
     delete data;
 }
@@ -226,23 +285,29 @@ static const VSFrame* VS_CC delayGetFrame(int outFrmNum, int activationReason, v
 
     common::OffsetFramePos offsetInFrmNums = data->outFrameToOffsetInFrames(outFrmNum);
 
+    if (activationReason == VSActivationReason::arError)
+    {
+        common::freeWindowFrames(frameData, vsapi);
+        return nullptr;
+    }
+
+    if (activationReason == VSActivationReason::arInitial && 0 == data->getNumCopyChannels() && offsetInFrmNums.left < 0 && offsetInFrmNums.right < 0)
+    {
+        // fully silent output frame: shared frame without any upstream request
+        data->submitOverflowStats(outFrmNum, common::OverflowStats(), core, vsapi);
+        return data->getSilenceFrame(vsutils::getFrameSampleCount(outFrmNum, data->getOutInfo().numSamples), core, vsapi);
+    }
+
     if (activationReason == VSActivationReason::arInitial)
     {
         bool frmRequested = false;
 
+        // offset frames that are still in the frame window are not requested again
+        auto windowFrms = std::make_unique<common::WindowFrames>(1);
+
         if (0 < data->getNumEditChannels())
         {
-            if (0 <= offsetInFrmNums.left)
-            {
-                vsapi->requestFrameFilter(offsetInFrmNums.left, data->getAudio(), frameCtx);
-                frmRequested = true;
-            }
-
-            if (0 <= offsetInFrmNums.right)
-            {
-                vsapi->requestFrameFilter(offsetInFrmNums.right, data->getAudio(), frameCtx);
-                frmRequested = true;
-            }
+            frmRequested = common::requestOffsetFrames(offsetInFrmNums, data->getAudio(), data->getAudioWindow(), windowFrms->at(0), frameCtx, vsapi);
         }
 
         if (0 < data->getNumCopyChannels())
@@ -251,23 +316,19 @@ static const VSFrame* VS_CC delayGetFrame(int outFrmNum, int activationReason, v
             frmRequested = true;
         }
 
-        if (!frmRequested)
+        *frameData = windowFrms.release();
+
+        if (frmRequested)
         {
-            // request a dummy frame (0) if no frame was requested before
-            // apparently you always need to request a frame even if you don't need one
-            // otherwise you get a fatal error: No frame returned at the end of processing by Delay
-            vsapi->requestFrameFilter(0, data->getAudio(), frameCtx);
+            return nullptr;
         }
 
-        return nullptr;
+        // all offset frames are in the frame window: the frame is returned right away
     }
 
-    if (activationReason == VSActivationReason::arAllFramesReady)
+    if (activationReason == VSActivationReason::arInitial || activationReason == VSActivationReason::arAllFramesReady)
     {
-        if (outFrmNum == 0)
-        {
-            data->resetOverflowStats();
-        }
+        std::unique_ptr<common::WindowFrames> windowFrms(common::releaseWindowFrames(frameData));
 
         const VSFrame* inFrm = nullptr;
         const VSFrame* offsetInFrmL = nullptr;
@@ -280,22 +341,21 @@ static const VSFrame* VS_CC delayGetFrame(int outFrmNum, int activationReason, v
 
         if (0 < data->getNumEditChannels())
         {
-            if (0 <= offsetInFrmNums.left)
-            {
-                offsetInFrmL = vsapi->getFrameFilter(offsetInFrmNums.left, data->getAudio(), frameCtx);
-            }
-
-            if (0 <= offsetInFrmNums.right)
-            {
-                offsetInFrmR = vsapi->getFrameFilter(offsetInFrmNums.right, data->getAudio(), frameCtx);
-            }
+            common::OffsetFrames offsetInFrms = common::getOffsetFrames(offsetInFrmNums, windowFrms->at(0), data->getAudio(), data->getAudioWindow(), frameCtx, vsapi);
+            offsetInFrmL = offsetInFrms.left;
+            offsetInFrmR = offsetInFrms.right;
         }
 
         int outFrmLen = vsutils::getFrameSampleCount(outFrmNum, data->getOutInfo().numSamples);
 
-        VSFrame* outFrm = vsapi->newAudioFrame(&data->getOutInfo().format, outFrmLen, nullptr, core);
+        // channels that are not changed are taken over from the input frames
+        std::vector<const VSFrame*> outChannelSources = data->getOutChannelSources(outFrmNum, outFrmLen, inFrm, offsetInFrmL, vsapi);
+
+        VSFrame* outFrm = vsutils::newAudioFrameFromChannelSources(&data->getOutInfo().format, outFrmLen, outChannelSources, nullptr, core, vsapi);
 
-        bool success = data->writeFrame(outFrm, outFrmNum, inFrm, offsetInFrmL, offsetInFrmR, frameCtx, core, vsapi);
+        common::OverflowStats overflowStats;
+
+        bool success = data->writeFrame(outFrm, outFrmNum, outChannelSources, offsetInFrmL, offsetInFrmR, overflowStats, frameCtx, core, vsapi);
 
         if (inFrm)
         {
@@ -312,12 +372,13 @@ static const VSFrame* VS_CC delayGetFrame(int outFrmNum, int activationReason, v
             vsapi->freeFrame(offsetInFrmR);
         }
 
-        if (outFrmNum == data->getOutInfo().numFrames - 1)
+        if (success)
         {
-            // last frame
-            data->logOverflowStats(core, vsapi);
+            common::updateFrameStatsProps(outFrm, data->isStatsEnabled(), overflowStats, vsapi);
         }
 
+        data->submitOverflowStats(outFrmNum, std::move(overflowStats), core, vsapi);
+
         if (success)
         {
             return outFrm;
@@ -391,12 +452,15 @@ static void VS_CC delayCreate(const VSMap* in, VSMap* out, void* userData, VSCor
         return;
     }
 
-    Delay* data = new Delay(audio, audioInfo, samples, optChannels.value(), optOverflowMode.value(), optOverflowLog.value());
+    // stats:int:opt
+    bool stats = vsmap::getOptBool("stats", in, vsapi, DefaultStats);
+
+    Delay* data = new Delay(audio, audioInfo, samples, optChannels.value(), optOverflowMode.value(), optOverflowLog.value(), stats);
 
     VSFilterDependency deps[] = {{ audio, rpGeneral }};
 
-    // fmParallelRequests: strict sequential frame requests for overflow logging
-    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), delayGetFrame, delayFree, VSFilterMode::fmParallelRequests, deps, 1, data, core);
+    // fmParallel: overflows are collected per frame and logged in frame order by common::OverflowTracker
+    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), delayGetFrame, delayFree, VSFilterMode::fmParallel, deps, 1, data, core);
 }
 
 
@@ -408,7 +472,8 @@ void delayInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi)
                              "seconds:float:opt;"
                              "channels:int[]:opt;"
                              "overflow:data:opt;"
-                             "overflow_log:data:opt;",
+                             "overflow_log:data:opt;"
+                             "stats:int:opt;",
                              "return:anode;",
                              delayCreate, nullptr, plugin);
 }
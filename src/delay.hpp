@@ -7,9 +7,11 @@
 
 #include "VapourSynth4.h"
 
+#include "common/framewindow.hpp"
 #include "common/offset.hpp"
 #include "common/overflow.hpp"
 #include "common/sampletype.hpp"
+#include "common/silenceframes.hpp"
 
 class Delay
 {
@@ -17,27 +19,44 @@ public:
     // positive samples shift the audio stream to the 'right'
     // negative samples shift the audio stream to the 'left'
     Delay(VSNode* audio, const VSAudioInfo* audioInfo, int64_t samples, std::vector<int> editChannels,
-          common::OverflowMode overflowMode, common::OverflowLog overflowLog);
+          common::OverflowMode overflowMode, common::OverflowLog overflowLog, bool stats);
 
     VSNode* getAudio();
 
+    // recently fetched input frames, see common::FrameWindow
+    common::FrameWindow& getAudioWindow();
+
+    // returns a new reference of the shared silent output frame, see common::SilenceFrames
+    const VSFrame* getSilenceFrame(int outFrmLen, VSCore* core, const VSAPI* vsapi);
+
     const VSAudioInfo& getOutInfo();
 
+    // true if the stats props are written to every output frame, see common/stats.hpp
+    bool isStatsEnabled();
+
     common::OffsetFramePos outFrameToOffsetInFrames(int outFrmNum);
 
     size_t getNumCopyChannels();
 
     size_t getNumEditChannels();
 
-    void resetOverflowStats();
+    /**
+     * returns the source frame of each output channel that is taken over unchanged (for newAudioFrame2)
+     * copy channels are taken from inFrm, edit channels from offsetInFrmL if the delay is a multiple of the frame size
+     * nullptr: the channel has to be written by writeFrame
+     */
+    std::vector<const VSFrame*> getOutChannelSources(int outFrmNum, int outFrmLen, const VSFrame* inFrm, const VSFrame* offsetInFrmL, const VSAPI* vsapi);
+
+    void submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi);
 
-    void logOverflowStats(VSCore* core, const VSAPI* vsapi);
+    void flushOverflowStats(VSCore* core, const VSAPI* vsapi);
 
     void free(const VSAPI* vsapi);
 
-    bool writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm,
+    // writes all channels without an out channel source
+    bool writeFrame(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
                     const VSFrame* offsetInFrmL, const VSFrame* offsetInFrmR,
-                    VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
+                    common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
 
 private:
     VSNode* audio;
@@ -51,7 +70,9 @@ private:
     common::OverflowMode overflowMode;
     common::OverflowLog overflowLog;
 
-    common::OverflowStats overflowStats = { .count = 0, .peak = 0.0 };
+    common::OverflowTracker overflowTracker;
+
+    bool stats;
 
     // inclusive
     int64_t outPosOffsetStart;
@@ -60,13 +81,20 @@ private:
 
     common::FrameSampleOffsets audioFrameSampleOffsets;
 
+    // true if an output frame covers exactly one input frame
+    bool frameAligned;
+
+    common::FrameWindow audioWindow;
+
+    common::SilenceFrames silenceFrames;
+
     template <typename sample_t, size_t IntSampleBits>
     bool writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStart, int outFrmLen,
                            const VSFrame* offsetInFrmL, const VSFrame* offsetInFrmR,
                            const common::OverflowContext& ofCtx);
 
     template <typename sample_t, size_t IntSampleBits>
-    bool writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm,
+    bool writeFrameImpl(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
                         const VSFrame* offsetInFrmL, const VSFrame* offsetInFrmR,
                         const common::OverflowContext& ofCtx);
 };
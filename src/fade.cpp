@@ -1,25 +1,31 @@
 // SPDX-License-Identifier: MIT
 
 #include <algorithm>
+#include <array>
 #include <climits>
 #include <cstdint>
 #include <cstring>
+#include <span>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "fade.hpp"
 #include "common/overflow.hpp"
+#include "common/precision.hpp"
 #include "common/sampletype.hpp"
+#include "common/stats.hpp"
 #include "common/transition.hpp"
+#include "simd/sampleconv.hpp"
 #include "utils/sample.hpp"
 #include "utils/vector.hpp"
 #include "vsutils/audio.hpp"
 #include "vsutils/bitshift.hpp"
 
 Fade::Fade(VSNode* _audio, const VSAudioInfo* _audioInfo, int64_t _outPosFadeStart, int64_t _fadeSamples, std::vector<int> channels,
-           common::Transition* _fadeTrans, common::OverflowMode _overflowMode, common::OverflowLog _overflowLog, const char* _funcName) :
+           common::Transition* _fadeTrans, common::OverflowMode _overflowMode, common::OverflowLog _overflowLog, bool _stats, common::Precision _precision, const char* _funcName) :
     audio(_audio), audioInfo(*_audioInfo), outPosFadeStart(_outPosFadeStart), fadeSamples(_fadeSamples), editChannels(channels),
-    fadeTrans(_fadeTrans), overflowMode(_overflowMode), overflowLog(_overflowLog), funcName(_funcName)
+    fadeTrans(_fadeTrans), overflowMode(_overflowMode), overflowLog(_overflowLog), stats(_stats), precision(_precision), funcName(_funcName)
 {
     outPosFadeEnd = outPosFadeStart + fadeSamples;
 
@@ -30,6 +36,11 @@ Fade::Fade(VSNode* _audio, const VSAudioInfo* _audioInfo, int64_t _outPosFadeSta
     outFrameFadeEnd = vsutils::sampleToFrame(outPosFadeEnd - 1) + 1;
 
     copyChannels = utils::vectorInvert(editChannels, 0, audioInfo.format.numChannels);
+
+    // the fade scales are inside [0, 1], so only overflowing input samples can overflow
+    overflowPossible = common::isOverflowPossible(common::getMaxAbsSample(outSampleType), outSampleType, precision);
+
+    overflowTracker.init(funcName, overflowMode, overflowLog, common::isFloatSampleType(outSampleType), audioInfo.numFrames);
 }
 
 
@@ -45,6 +56,18 @@ const VSAudioInfo& Fade::getOutInfo()
 }
 
 
+bool Fade::isOverflowPossible()
+{
+    return overflowPossible;
+}
+
+
+bool Fade::isStatsEnabled()
+{
+    return stats;
+}
+
+
 int Fade::getFadeStartFrame()
 {
     return outFrameFadeStart;
@@ -57,18 +80,28 @@ int Fade::getFadeEndFrame()
 }
 
 
-void Fade::resetOverflowStats()
+std::vector<const VSFrame*> Fade::getOutChannelSources(const VSFrame* inFrm)
 {
-    overflowStats = { .count = 0, .peak = 0.0 };
+    std::vector<const VSFrame*> outChannelSources(static_cast<size_t>(audioInfo.format.numChannels), nullptr);
+
+    for (const int& ch : copyChannels)
+    {
+        outChannelSources[ch] = inFrm;
+    }
+
+    return outChannelSources;
 }
 
 
-void Fade::logOverflowStats(VSCore* core, const VSAPI* vsapi)
+void Fade::submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi)
 {
-    if (0 < overflowStats.count)
-    {
-        overflowStats.logVS(funcName, overflowMode, isFloatSampleType(outSampleType), core, vsapi);
-    }
+    overflowTracker.submitFrame(outFrmNum, std::move(frameOverflowStats), core, vsapi);
+}
+
+
+void Fade::flushOverflowStats(VSCore* core, const VSAPI* vsapi)
+{
+    overflowTracker.flush(core, vsapi);
 }
 
 
@@ -79,71 +112,28 @@ void Fade::free(const VSAPI* vsapi)
 }
 
 
-template <typename sample_t, size_t IntSampleBits>
+template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t>
 bool Fade::writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStart, int outFrmLen, const VSFrame* inFrm,
                              const common::OverflowContext& ofCtx)
 {
     sample_t* outFrmPtr = reinterpret_cast<sample_t*>(ofCtx.vsapi->getWritePtr(outFrm, ch));
     const sample_t* inFrmPtr = reinterpret_cast<const sample_t*>(ofCtx.vsapi->getReadPtr(inFrm, ch));
 
-    constexpr vsutils::BitShift bitShift = vsutils::getSampleBitShift<sample_t, IntSampleBits>();
-
-    for (int s = 0; s < outFrmLen; ++s)
-    {
-        int64_t outPos = outPosFrmStart + s;
-        if (outPosFadeStart <= outPos && outPos < outPosFadeEnd && fadeTrans)
-        {
-            // sample inside fade transition
-            int64_t fadePos = outPos - outPosFadeStart;
-
-            double fadeScale = fadeTrans->calcY(static_cast<double>(fadePos));
-
-            sample_t inSample = inFrmPtr[s];
-
-            if constexpr (bitShift.required)
-            {
-                inSample >>= bitShift.count;
-            }
-
-            double scaledSample = fadeScale * utils::convSampleToDouble<sample_t, IntSampleBits>(inSample);
+    std::array<compute_t, VS_AUDIO_FRAME_SAMPLES> samples;
 
-            if (!common::safeWriteSample<sample_t, IntSampleBits>(scaledSample, outFrmPtr, s, outPos, ch, ofCtx, overflowStats))
-            {
-                // overflow and error
-                return false;
-            }
-        }
-        else
-        {
-            // sample outside transition -> copy sample
-            sample_t inSample = inFrmPtr[s];
+    common::convSamplesToCompute<sample_t, IntSampleBits, compute_t>(inFrmPtr, samples.data(), outFrmLen);
 
-            if constexpr (bitShift.required)
-            {
-                inSample >>= bitShift.count;
-            }
+    // samples outside the transition are copied
+    applyFade(fadeTrans, outPosFadeStart, outPosFadeEnd, outPosFrmStart, std::span(samples.data(), outFrmLen));
 
-            if (!common::safeWriteSample<sample_t, IntSampleBits>(utils::convSampleToDouble<sample_t, IntSampleBits>(inSample), outFrmPtr, s, outPos, ch, ofCtx, overflowStats))
-            {
-                // overflow and error
-                return false;
-            }
-        }
-    }
-    return true;
+    return common::safeWriteSamples<sample_t, IntSampleBits, CheckOverflow>(std::span(samples.data(), outFrmLen), outFrmPtr, outPosFrmStart, ch, ofCtx);
 }
 
 
-template <typename sample_t, size_t IntSampleBits>
+template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t>
 bool Fade::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, const common::OverflowContext& ofCtx)
 {
-    int bytesPerSample = audioInfo.format.bytesPerSample;
-
-    // copy channels
-    for (const int& ch : copyChannels)
-    {
-        vsutils::copyFrameChannel(outFrm, ch, inFrm, ch, bytesPerSample, ofCtx.vsapi);
-    }
+    // copy channels are already set by newAudioFrame2
 
     // edit channels
     int64_t outPosFrmStart = vsutils::frameToFirstSample(outFrmNum);
@@ -151,7 +141,7 @@ bool Fade::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm,
 
     for (const int& ch : editChannels)
     {
-        if (!writeFrameChannel<sample_t, IntSampleBits>(ch, outFrm, outPosFrmStart, outFrmLen, inFrm, ofCtx))
+        if (!writeFrameChannel<sample_t, IntSampleBits, CheckOverflow, compute_t>(ch, outFrm, outPosFrmStart, outFrmLen, inFrm, ofCtx))
         {
             return false;
         }
@@ -160,37 +150,84 @@ bool Fade::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm,
 }
 
 
-bool Fade::writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+bool Fade::writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
 {
     common::OverflowContext ofCtx =
         { .mode = overflowMode, .log = overflowLog, .funcName = funcName,
-          .frameCtx = frameCtx, .core = core, .vsapi = vsapi };
+          .frameCtx = frameCtx, .core = core, .vsapi = vsapi,
+          .stats = overflowStats };
 
     switch (outSampleType)
     {
         case common::SampleType::Int8:
-            return writeFrameImpl<int8_t, 8>(outFrm, outFrmNum, inFrm, ofCtx);
+            return overflowPossible ? writeFrameImpl<int8_t, 8, true>(outFrm, outFrmNum, inFrm, ofCtx)
+                                    : writeFrameImpl<int8_t, 8, false>(outFrm, outFrmNum, inFrm, ofCtx);
         case common::SampleType::Int16:
-            return writeFrameImpl<int16_t, 16>(outFrm, outFrmNum, inFrm, ofCtx);
+            return overflowPossible ? writeFrameImpl<int16_t, 16, true>(outFrm, outFrmNum, inFrm, ofCtx)
+                                    : writeFrameImpl<int16_t, 16, false>(outFrm, outFrmNum, inFrm, ofCtx);
         case common::SampleType::Int24:
-            return writeFrameImpl<int32_t, 24>(outFrm, outFrmNum, inFrm, ofCtx);
+            return overflowPossible ? writeFrameImpl<int32_t, 24, true>(outFrm, outFrmNum, inFrm, ofCtx)
+                                    : writeFrameImpl<int32_t, 24, false>(outFrm, outFrmNum, inFrm, ofCtx);
         case common::SampleType::Int32:
-            return writeFrameImpl<int32_t, 32>(outFrm, outFrmNum, inFrm, ofCtx);
+            return overflowPossible ? writeFrameImpl<int32_t, 32, true>(outFrm, outFrmNum, inFrm, ofCtx)
+                                    : writeFrameImpl<int32_t, 32, false>(outFrm, outFrmNum, inFrm, ofCtx);
         case common::SampleType::Float32:
-            return writeFrameImpl<float, 0>(outFrm, outFrmNum, inFrm, ofCtx);
+            if (common::isFloatCompute(precision, outSampleType))
+            {
+                // float rounding errors can overflow, see common::isOverflowPossible
+                return writeFrameImpl<float, 0, true, float>(outFrm, outFrmNum, inFrm, ofCtx);
+            }
+            return overflowPossible ? writeFrameImpl<float, 0, true>(outFrm, outFrmNum, inFrm, ofCtx)
+                                    : writeFrameImpl<float, 0, false>(outFrm, outFrmNum, inFrm, ofCtx);
         case common::SampleType::Float64:
-            return writeFrameImpl<double, 0>(outFrm, outFrmNum, inFrm, ofCtx);
+            return overflowPossible ? writeFrameImpl<double, 0, true>(outFrm, outFrmNum, inFrm, ofCtx)
+                                    : writeFrameImpl<double, 0, false>(outFrm, outFrmNum, inFrm, ofCtx);
         default:
             return false;
     }
 }
 
 
+template <typename compute_t>
+static void applyFadeImpl(common::Transition* fadeTrans, int64_t posFadeStart, int64_t posFadeEnd, int64_t posStart, std::span<compute_t> samples)
+{
+    int numSamples = static_cast<int>(samples.size());
+
+    // samples inside the fade transition: [fadeBegin, fadeEnd)
+    int fadeBegin = static_cast<int>(std::clamp<int64_t>(posFadeStart - posStart, 0, numSamples));
+    int fadeEnd = static_cast<int>(std::clamp<int64_t>(posFadeEnd - posStart, 0, numSamples));
+
+    if (fadeBegin < fadeEnd && fadeTrans)
+    {
+        std::array<double, VS_AUDIO_FRAME_SAMPLES> fadeScales;
+
+        int64_t fadePosBegin = posStart + fadeBegin - posFadeStart;
+        fadeTrans->fill(static_cast<double>(fadePosBegin), std::span(fadeScales.data(), fadeEnd - fadeBegin));
+
+        for (int s = fadeBegin; s < fadeEnd; ++s)
+        {
+            samples[s] *= static_cast<compute_t>(fadeScales[s - fadeBegin]);
+        }
+    }
+}
+
+
+void applyFade(common::Transition* fadeTrans, int64_t posFadeStart, int64_t posFadeEnd, int64_t posStart, std::span<double> samples)
+{
+    applyFadeImpl(fadeTrans, posFadeStart, posFadeEnd, posStart, samples);
+}
+
+
+void applyFade(common::Transition* fadeTrans, int64_t posFadeStart, int64_t posFadeEnd, int64_t posStart, std::span<float> samples)
+{
+    applyFadeImpl(fadeTrans, posFadeStart, posFadeEnd, posStart, samples);
+}
+
+
 void VS_CC fadeFree(void* instanceData, VSCore* core, const VSAPI* vsapi)
 {
     Fade* data = static_cast<Fade*>(instanceData);
-    // skip logging since the total number of overflows is unreliable
-    // data->logNumOverflows(core, vsapi);
+    data->flushOverflowStats(core, vsapi);
     data->free(vsapi);
     delete data;
 }
@@ -208,32 +245,34 @@ const VSFrame* VS_CC fadeGetFrame(int outFrmNum, int activationReason, void* ins
 
     if (activationReason == VSActivationReason::arAllFramesReady)
     {
-        if (outFrmNum == 0)
-        {
-            data->resetOverflowStats();
-        }
-
         const VSFrame* inFrm = vsapi->getFrameFilter(outFrmNum, data->getAudio(), frameCtx);
 
         if (outFrmNum < data->getFadeStartFrame() || data->getFadeEndFrame() <= outFrmNum)
         {
-            return inFrm;
+            // no overflows possible outside the fade
+            data->submitOverflowStats(outFrmNum, common::OverflowStats(), core, vsapi);
+            return common::passFrameStatsProps(inFrm, data->isStatsEnabled(), core, vsapi);
         }
 
         int inFrmLen = vsapi->getFrameLength(inFrm);
 
-        VSFrame *outFrm = vsapi->newAudioFrame(&data->getOutInfo().format, inFrmLen, inFrm, core);
+        std::vector<const VSFrame*> outChannelSources = data->getOutChannelSources(inFrm);
 
-        bool success = data->writeFrame(outFrm, outFrmNum, inFrm, frameCtx, core, vsapi);
+        VSFrame* outFrm = vsutils::newAudioFrameFromChannelSources(&data->getOutInfo().format, inFrmLen, outChannelSources, inFrm, core, vsapi);
+
+        common::OverflowStats overflowStats;
+
+        bool success = data->writeFrame(outFrm, outFrmNum, inFrm, overflowStats, frameCtx, core, vsapi);
 
         vsapi->freeFrame(inFrm);
 
-        if (outFrmNum == data->getOutInfo().numFrames - 1)
+        if (success)
         {
-            // last frame
-            data->logOverflowStats(core, vsapi);
+            common::updateFrameStatsProps(outFrm, data->isStatsEnabled(), overflowStats, vsapi);
         }
 
+        data->submitOverflowStats(outFrmNum, std::move(overflowStats), core, vsapi);
+
         if (success)
         {
             return outFrm;
@@ -3,11 +3,13 @@
 #pragma once
 
 #include <cstdint>
+#include <span>
 #include <vector>
 
 #include "VapourSynth4.h"
 
 #include "common/overflow.hpp"
+#include "common/precision.hpp"
 #include "common/sampletype.hpp"
 #include "common/transition.hpp"
 
@@ -16,23 +18,36 @@ class Fade
 public:
     Fade(VSNode* audio, const VSAudioInfo* audioInfo, int64_t outPosStart, int64_t fadeSamples,
          std::vector<int> channels, common::Transition* fadeTrans,
-         common::OverflowMode overflowMode, common::OverflowLog overflowLog, const char* funcName);
+         common::OverflowMode overflowMode, common::OverflowLog overflowLog, bool stats, common::Precision precision, const char* funcName);
 
     VSNode* getAudio();
 
     const VSAudioInfo& getOutInfo();
 
+    // false if no output sample can overflow, see common::isOverflowPossible
+    bool isOverflowPossible();
+
+    // true if the stats props are written to every output frame, see common/stats.hpp
+    bool isStatsEnabled();
+
     int getFadeStartFrame();
 
     int getFadeEndFrame();
 
-    void resetOverflowStats();
+    /**
+     * returns the source frame of each output channel that is taken over unchanged (for newAudioFrame2)
+     * copy channels are taken from inFrm, edit channels are nullptr and written by writeFrame
+     */
+    std::vector<const VSFrame*> getOutChannelSources(const VSFrame* inFrm);
 
-    void logOverflowStats(VSCore* core, const VSAPI* vsapi);
+    void submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi);
+
+    void flushOverflowStats(VSCore* core, const VSAPI* vsapi);
 
     void free(const VSAPI* vsapi);
 
-    bool writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
+    // writes the edit channels
+    bool writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
 
 private:
     VSNode* audio;
@@ -63,18 +78,35 @@ private:
     common::OverflowMode overflowMode;
     common::OverflowLog overflowLog;
 
-    common::OverflowStats overflowStats = { .count = 0, .peak = 0.0 };
+    common::OverflowTracker overflowTracker;
+
+    // selects the writeFrameImpl specialization with or without overflow checks
+    bool overflowPossible;
+
+    bool stats;
+
+    // compute type of float samples, see common::Precision
+    common::Precision precision;
 
     const char* funcName = nullptr;
 
-    template <typename sample_t, size_t IntSampleBits>
+    template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t = double>
     bool writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStart, int outFrmLen, const VSFrame* inFrm,
                            const common::OverflowContext& ofCtx);
 
-    template <typename sample_t, size_t IntSampleBits>
+    template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t = double>
     bool writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, const common::OverflowContext& ofCtx);
 };
 
+/**
+ * multiplies up to VS_AUDIO_FRAME_SAMPLES samples with the fade transition, samples[0] is at the (total) sample position posStart
+ * the fade is going from posFadeStart (inclusive) to posFadeEnd (exclusive), samples outside of it are not changed
+ */
+void applyFade(common::Transition* fadeTrans, int64_t posFadeStart, int64_t posFadeEnd, int64_t posStart, std::span<double> samples);
+
+// float version of applyFade, the fade scales are calculated as double
+void applyFade(common::Transition* fadeTrans, int64_t posFadeStart, int64_t posFadeEnd, int64_t posStart, std::span<float> samples);
+
 void VS_CC fadeFree(void* instanceData, VSCore* core, const VSAPI* vsapi);
 
 const VSFrame* VS_CC fadeGetFrame(int n, int activationReason, void* instanceData, void** frameData, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
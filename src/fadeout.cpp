@@ -11,6 +11,7 @@
 
 #include "fade.hpp"
 #include "common/overflow.hpp"
+#include "common/precision.hpp"
 #include "common/sampletype.hpp"
 #include "common/transition.hpp"
 #include "vsmap/vsmap.hpp"
@@ -22,6 +23,8 @@ constexpr int64_t DefaultFadeSamples = 0;
 constexpr common::TransitionType DefaultFadeType = common::TransitionType::Cubic;
 constexpr common::OverflowMode DefaultOverflowMode = common::OverflowMode::Error;
 constexpr common::OverflowLog DefaultOverflowLog = common::OverflowLog::Once;
+constexpr bool DefaultStats = false;
+constexpr common::Precision DefaultPrecision = common::Precision::Double;
 
 
 static void VS_CC fadeoutCreate(const VSMap* in, VSMap* out, void* userData, VSCore* core, const VSAPI* vsapi)
@@ -106,12 +109,26 @@ static void VS_CC fadeoutCreate(const VSMap* in, VSMap* out, void* userData, VSC
         return;
     }
 
-    Fade* data = new Fade(audio, audioInfo, endSample - fadeSamples, fadeSamples, optChannels.value(), trans, optOverflowMode.value(), optOverflowLog.value(), FuncName);
+    // stats:int:opt
+    bool stats = vsmap::getOptBool("stats", in, vsapi, DefaultStats);
+
+    // precision:data:opt
+    std::optional<common::Precision> optPrecision = vsmap::getOptPrecisionFromString("precision", FuncName, in, out, vsapi, DefaultPrecision);
+    if (!optPrecision.has_value())
+    {
+        delete trans;
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    Fade* data = new Fade(audio, audioInfo, endSample - fadeSamples, fadeSamples, optChannels.value(), trans, optOverflowMode.value(), optOverflowLog.value(), stats, optPrecision.value(), FuncName);
 
     VSFilterDependency deps[] = {{ audio, VSRequestPattern::rpStrictSpatial }};
 
-    // fmParallelRequests: strict sequential frame requests for overflow logging
-    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), fadeGetFrame, fadeFree, VSFilterMode::fmParallelRequests, deps, 1, data, core);
+    common::logOverflowCheck(FuncName, data->isOverflowPossible(), core, vsapi);
+
+    // fmParallel: overflows are collected per frame and logged in frame order by common::OverflowTracker
+    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), fadeGetFrame, fadeFree, VSFilterMode::fmParallel, deps, 1, data, core);
 }
 
 
@@ -126,7 +143,9 @@ void fadeoutInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi)
                              "channels:int[]:opt;"
                              "type:data:opt;"
                              "overflow:data:opt;"
-                             "overflow_log:data:opt;",
+                             "overflow_log:data:opt;"
+                             "stats:int:opt;"
+                             "precision:data:opt;",
                              "return:anode;",
                              fadeoutCreate, nullptr, plugin);
 }
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: MIT
+
+#include <format>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+#include "findloudness.hpp"
+#include "common/loudness.hpp"
+#include "common/sampletype.hpp"
+#include "vsmap/vsmap.hpp"
+#include "vsmap/vsmap_common.hpp"
+
+constexpr const char* FuncName = "FindLoudness";
+
+constexpr int DefaultRequests = 0;
+
+
+static void VS_CC findloudnessCreate(const VSMap* in, VSMap* out, void* userData, VSCore* core, const VSAPI* vsapi)
+{
+    // clip:anode
+    int err = 0;
+    VSNode* audio = vsapi->mapGetNode(in, "clip", 0, &err);
+    if (err)
+    {
+        return;
+    }
+
+    const VSAudioInfo* audioInfo = vsapi->getAudioInfo(audio);
+
+    // check for supported audio format
+    std::optional<common::SampleType> optSampleType = common::getSampleTypeFromAudioFormat(audioInfo->format);
+    if (!optSampleType.has_value())
+    {
+        std::string errMsg = std::format("{}: unsupported audio format", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // channels:int[]:opt
+    std::vector<int> defaultChannels;
+    std::optional<std::vector<int>> optChannels = vsmap::getOptChannels("channels", FuncName, in, out, vsapi, defaultChannels, audioInfo->format.numChannels);
+    if (!optChannels.has_value())
+    {
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // requests:int:opt
+    int requests = vsmap::getOptInt("requests", in, vsapi, DefaultRequests);
+    if (requests < 0)
+    {
+        std::string errMsg = std::format("{}: negative requests", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // blocking operation
+    std::string scanErrMsg;
+    std::optional<common::LoudnessResult> optLoudness = common::measureLoudness(audio, audioInfo, optChannels.value(), requests, common::ScanControl(), scanErrMsg, core, vsapi);
+    vsapi->freeNode(audio);
+
+    if (!optLoudness.has_value())
+    {
+        std::string errMsg = std::format("{}: {}", FuncName, scanErrMsg);
+        vsapi->mapSetError(out, errMsg.c_str());
+        return;
+    }
+
+    const common::LoudnessResult& loudness = optLoudness.value();
+
+    vsapi->mapSetFloat(out, "integrated", loudness.integrated, VSMapAppendMode::maReplace);
+    vsapi->mapSetFloat(out, "range", loudness.range, VSMapAppendMode::maReplace);
+    vsapi->mapSetFloat(out, "momentary_max", loudness.momentaryMax, VSMapAppendMode::maReplace);
+    vsapi->mapSetFloat(out, "short_term_max", loudness.shortTermMax, VSMapAppendMode::maReplace);
+}
+
+
+void findloudnessInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi)
+{
+    vspapi->registerFunction(FuncName,
+                             "clip:anode;"
+                             "channels:int[]:opt;"
+                             "requests:int:opt;",
+                             "integrated:float;"
+                             "range:float;"
+                             "momentary_max:float;"
+                             "short_term_max:float;",
+                             findloudnessCreate, nullptr, plugin);
+}
@@ -0,0 +1,7 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "VapourSynth4.h"
+
+void findloudnessInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi);
@@ -8,6 +8,7 @@
 #include "VapourSynth4.h"
 
 #include "common/peak.hpp"
+#include "common/peakcache.hpp"
 #include "common/sampletype.hpp"
 #include "vsmap/vsmap.hpp"
 #include "vsmap/vsmap_common.hpp"
@@ -15,6 +16,9 @@
 constexpr const char* FuncName = "FindPeak";
 
 constexpr bool DefaultNormalize = true;
+constexpr bool DefaultTruePeak = false;
+constexpr int DefaultRequests = 0;
+constexpr bool DefaultUseStats = false;
 
 
 static void VS_CC findpeakCreate(const VSMap* in, VSMap* out, void* userData, VSCore* core, const VSAPI* vsapi)
@@ -42,6 +46,16 @@ static void VS_CC findpeakCreate(const VSMap* in, VSMap* out, void* userData, VS
     // normalize:int:opt
     bool normalize = vsmap::getOptBool("normalize", in, vsapi, DefaultNormalize);
 
+    // true_peak:int:opt
+    bool truePeak = vsmap::getOptBool("true_peak", in, vsapi, DefaultTruePeak);
+    if (truePeak && !normalize)
+    {
+        std::string errMsg = std::format("{}: true_peak requires normalize", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        vsapi->freeNode(audio);
+        return;
+    }
+
     // channels:int[]:opt
     std::vector<int> defaultChannels;
     std::optional<std::vector<int>> optChannels = vsmap::getOptChannels("channels", FuncName, in, out, vsapi, defaultChannels, audioInfo->format.numChannels);
@@ -51,8 +65,24 @@ static void VS_CC findpeakCreate(const VSMap* in, VSMap* out, void* userData, VS
         return;
     }
 
+    // requests:int:opt
+    int requests = vsmap::getOptInt("requests", in, vsapi, DefaultRequests);
+    if (requests < 0)
+    {
+        std::string errMsg = std::format("{}: negative requests", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // cache_path:data:opt
+    std::string cacheDir = vsmap::getOptString("cache_path", in, vsapi, "");
+
+    // use_stats:int:opt
+    bool useStats = vsmap::getOptBool("use_stats", in, vsapi, DefaultUseStats);
+
     // blocking operation
-    double peak = common::findPeak(audio, audioInfo, optChannels.value(), normalize, vsapi);
+    double peak = common::findPeakCached(audio, audioInfo, optChannels.value(), normalize, truePeak, useStats, requests, common::PeakScanControl(), cacheDir, FuncName, core, vsapi);
     vsapi->freeNode(audio);
 
     vsapi->mapSetFloat(out, "return", peak, VSMapAppendMode::maReplace);
@@ -64,7 +94,11 @@ void findpeakInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi)
     vspapi->registerFunction(FuncName,
                              "clip:anode;"
                              "normalize:int:opt;"
-                             "channels:int[]:opt;",
+                             "true_peak:int:opt;"
+                             "channels:int[]:opt;"
+                             "requests:int:opt;"
+                             "cache_path:data:opt;"
+                             "use_stats:int:opt;",
                              "return:float;",
                              findpeakCreate, nullptr, plugin);
 }
@@ -0,0 +1,410 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "VapourSynth4.h"
+#include "VSHelper4.h"
+
+#include "loudnorm.hpp"
+#include "common/loudness.hpp"
+#include "common/overflow.hpp"
+#include "common/precision.hpp"
+#include "common/sampletype.hpp"
+#include "common/stats.hpp"
+#include "utils/vector.hpp"
+#include "vsmap/vsmap.hpp"
+#include "vsmap/vsmap_common.hpp"
+#include "vsutils/audio.hpp"
+
+constexpr const char* FuncName = "LoudNorm";
+
+// EBU R128 target level
+constexpr double DefaultLoudness = -23;
+constexpr int DefaultRequests = 0;
+constexpr common::OverflowMode DefaultOverflowMode = common::OverflowMode::Error;
+constexpr common::OverflowLog DefaultOverflowLog = common::OverflowLog::Once;
+constexpr bool DefaultStats = false;
+constexpr common::Precision DefaultPrecision = common::Precision::Double;
+
+
+LoudNorm::LoudNorm(VSNode* _audio, const VSAudioInfo* _audioInfo, double outLoudness, const common::LoudnessResult& inLoudness, std::vector<int> _editChannels,
+                   common::OverflowMode _overflowMode, common::OverflowLog _overflowLog, bool _stats, common::Precision _precision) :
+    audio(_audio), audioInfo(*_audioInfo), editChannels(_editChannels), overflowMode(_overflowMode), overflowLog(_overflowLog), stats(_stats), precision(_precision)
+{
+    outSampleType = common::getSampleTypeFromAudioFormat(audioInfo.format).value();
+
+    // silence (no block above the absolute gate) is left unchanged
+    gain = std::isfinite(inLoudness.integrated) ? std::pow(10.0, (outLoudness - inLoudness.integrated) / 20) : 1.0;
+
+    copyChannels = utils::vectorInvert(editChannels, 0, audioInfo.format.numChannels);
+
+    overflowPossible = common::isOverflowPossible(gain * common::getMaxAbsSample(outSampleType), outSampleType, precision);
+
+    overflowTracker.init(FuncName, overflowMode, overflowLog, common::isFloatSampleType(outSampleType), audioInfo.numFrames);
+}
+
+
+VSNode* LoudNorm::getAudio()
+{
+    return audio;
+}
+
+const VSAudioInfo& LoudNorm::getOutInfo()
+{
+    return audioInfo;
+}
+
+
+double LoudNorm::getGain()
+{
+    return gain;
+}
+
+
+bool LoudNorm::isOverflowPossible()
+{
+    return overflowPossible;
+}
+
+
+bool LoudNorm::isStatsEnabled()
+{
+    return stats;
+}
+
+
+std::vector<const VSFrame*> LoudNorm::getOutChannelSources(const VSFrame* inFrm, const VSAPI* vsapi)
+{
+    std::vector<const VSFrame*> outChannelSources(static_cast<size_t>(audioInfo.format.numChannels), nullptr);
+
+    for (const int& ch : copyChannels)
+    {
+        outChannelSources[ch] = inFrm;
+    }
+
+    if (gain != 1.0)
+    {
+        return outChannelSources;
+    }
+
+    for (const int& ch : editChannels)
+    {
+        // overflowing samples (integer minimum or float outside [-1, 1]) are handled by writeFrame
+        if (!common::isFrameChannelOverflowing(inFrm, ch, outSampleType, vsapi))
+        {
+            outChannelSources[ch] = inFrm;
+        }
+    }
+
+    return outChannelSources;
+}
+
+
+void LoudNorm::submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi)
+{
+    overflowTracker.submitFrame(outFrmNum, std::move(frameOverflowStats), core, vsapi);
+}
+
+
+void LoudNorm::flushOverflowStats(VSCore* core, const VSAPI* vsapi)
+{
+    overflowTracker.flush(core, vsapi);
+}
+
+
+void LoudNorm::free(const VSAPI* vsapi)
+{
+    vsapi->freeNode(audio);
+}
+
+
+
+template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t>
+bool LoudNorm::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, const std::vector<const VSFrame*>& outChannelSources,
+                              const common::OverflowContext& ofCtx)
+{
+    // copy channels and unchanged edit channels are already set by newAudioFrame2
+
+    // edit channels
+    int64_t outPosFrmStart = vsutils::frameToFirstSample(outFrmNum);
+    int outFrmLen = ofCtx.vsapi->getFrameLength(outFrm);
+
+    const compute_t computeGain = static_cast<compute_t>(gain);
+
+    std::array<compute_t, VS_AUDIO_FRAME_SAMPLES> samples;
+
+    for (const int& ch : editChannels)
+    {
+        if (outChannelSources[ch])
+        {
+            continue;
+        }
+
+        sample_t* outFrmPtr = reinterpret_cast<sample_t*>(ofCtx.vsapi->getWritePtr(outFrm, ch));
+
+        const sample_t* inFrmPtr = reinterpret_cast<const sample_t*>(ofCtx.vsapi->getReadPtr(inFrm, ch));
+
+        common::convSamplesToCompute<sample_t, IntSampleBits, compute_t>(inFrmPtr, samples.data(), outFrmLen);
+
+        for (int s = 0; s < outFrmLen; ++s)
+        {
+            samples[s] *= computeGain;
+        }
+
+        if (!common::safeWriteSamples<sample_t, IntSampleBits, CheckOverflow>(std::span(samples.data(), outFrmLen), outFrmPtr, outPosFrmStart, ch, ofCtx))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+bool LoudNorm::writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, const std::vector<const VSFrame*>& outChannelSources,
+                          common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+{
+    common::OverflowContext ofCtx =
+        { .mode = overflowMode, .log = overflowLog, .funcName = FuncName,
+          .frameCtx = frameCtx, .core = core, .vsapi = vsapi,
+          .stats = overflowStats };
+
+    switch (outSampleType)
+    {
+        case common::SampleType::Int8:
+            return overflowPossible ? writeFrameImpl<int8_t, 8, true>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx)
+                                    : writeFrameImpl<int8_t, 8, false>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx);
+        case common::SampleType::Int16:
+            return overflowPossible ? writeFrameImpl<int16_t, 16, true>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx)
+                                    : writeFrameImpl<int16_t, 16, false>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx);
+        case common::SampleType::Int24:
+            return overflowPossible ? writeFrameImpl<int32_t, 24, true>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx)
+                                    : writeFrameImpl<int32_t, 24, false>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx);
+        case common::SampleType::Int32:
+            return overflowPossible ? writeFrameImpl<int32_t, 32, true>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx)
+                                    : writeFrameImpl<int32_t, 32, false>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx);
+        case common::SampleType::Float32:
+            if (common::isFloatCompute(precision, outSampleType))
+            {
+                return overflowPossible ? writeFrameImpl<float, 0, true, float>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx)
+                                        : writeFrameImpl<float, 0, false, float>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx);
+            }
+            return overflowPossible ? writeFrameImpl<float, 0, true>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx)
+                                    : writeFrameImpl<float, 0, false>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx);
+        case common::SampleType::Float64:
+            return overflowPossible ? writeFrameImpl<double, 0, true>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx)
+                                    : writeFrameImpl<double, 0, false>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx);
+        default:
+            return false;
+    }
+}
+
+
+static void VS_CC loudnormFree(void* instanceData, VSCore* core, const VSAPI* vsapi)
+{
+    LoudNorm* data = static_cast<LoudNorm*>(instanceData);
+    data->flushOverflowStats(core, vsapi);
+    data->free(vsapi);
+    delete data;
+}
+
+
+static const VSFrame* VS_CC loudnormGetFrame(int outFrmNum, int activationReason, void* instanceData, void** frameData, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+{
+    LoudNorm* data = static_cast<LoudNorm*>(instanceData);
+
+    if (activationReason == VSActivationReason::arInitial)
+    {
+        vsapi->requestFrameFilter(outFrmNum, data->getAudio(), frameCtx);
+
+        return nullptr;
+    }
+
+    if (activationReason == VSActivationReason::arAllFramesReady)
+    {
+        const VSFrame* inFrm = vsapi->getFrameFilter(outFrmNum, data->getAudio(), frameCtx);
+
+        std::vector<const VSFrame*> outChannelSources = data->getOutChannelSources(inFrm, vsapi);
+
+        if (std::all_of(outChannelSources.begin(), outChannelSources.end(), [](const VSFrame* src) { return src; }))
+        {
+            // all channels unchanged
+            data->submitOverflowStats(outFrmNum, common::OverflowStats(), core, vsapi);
+            return common::passFrameStatsProps(inFrm, data->isStatsEnabled(), core, vsapi);
+        }
+
+        int inFrmLen = vsapi->getFrameLength(inFrm);
+
+        VSFrame* outFrm = vsutils::newAudioFrameFromChannelSources(&data->getOutInfo().format, inFrmLen, outChannelSources, inFrm, core, vsapi);
+
+        common::OverflowStats overflowStats;
+
+        bool success = data->writeFrame(outFrm, outFrmNum, inFrm, outChannelSources, overflowStats, frameCtx, core, vsapi);
+
+        vsapi->freeFrame(inFrm);
+
+        if (success)
+        {
+            common::updateFrameStatsProps(outFrm, data->isStatsEnabled(), overflowStats, vsapi);
+        }
+
+        data->submitOverflowStats(outFrmNum, std::move(overflowStats), core, vsapi);
+
+        if (success)
+        {
+            return outFrm;
+        }
+
+        vsapi->freeFrame(outFrm);
+    }
+
+    return nullptr;
+}
+
+
+static void VS_CC loudnormCreate(const VSMap* in, VSMap* out, void* userData, VSCore* core, const VSAPI* vsapi)
+{
+    // clip:anode
+    int err = 0;
+    VSNode* audio = vsapi->mapGetNode(in, "clip", 0, &err);
+    if (err)
+    {
+        return;
+    }
+
+    const VSAudioInfo* audioInfo = vsapi->getAudioInfo(audio);
+
+    // check for supported audio format
+    std::optional<common::SampleType> optSampleType = common::getSampleTypeFromAudioFormat(audioInfo->format);
+    if (!optSampleType.has_value())
+    {
+        std::string errMsg = std::format("{}: unsupported audio format", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // loudness:float:opt
+    double outLoudness = vsmap::getOptDouble("loudness", in, vsapi, DefaultLoudness);
+    if (!std::isfinite(outLoudness))
+    {
+        std::string errMsg = std::format("{}: invalid loudness", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // channels:int[]:opt
+    std::vector<int> defaultChannels;
+    std::optional<std::vector<int>> optChannels = vsmap::getOptChannels("channels", FuncName, in, out, vsapi, defaultChannels, audioInfo->format.numChannels);
+    if (!optChannels.has_value())
+    {
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // overflow:data:opt
+    std::optional<common::OverflowMode> optOverflowMode = vsmap::getOptOverflowModeFromString("overflow", FuncName, in, out, vsapi, DefaultOverflowMode);
+    if (!optOverflowMode.has_value())
+    {
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    if (optOverflowMode.value() == common::OverflowMode::KeepFloat && !common::isFloatSampleType(optSampleType.value()))
+    {
+        std::string errMsg = std::format("{}: cannot use 'keep_float' overflow mode with an integer sample type", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // overflow_log:data:opt
+    std::optional<common::OverflowLog> optOverflowLog = vsmap::getOptOverflowLogFromString("overflow_log", FuncName, in, out, vsapi, DefaultOverflowLog);
+    if (!optOverflowLog.has_value())
+    {
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // requests:int:opt
+    int requests = vsmap::getOptInt("requests", in, vsapi, DefaultRequests);
+    if (requests < 0)
+    {
+        std::string errMsg = std::format("{}: negative requests", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // stats:int:opt
+    bool stats = vsmap::getOptBool("stats", in, vsapi, DefaultStats);
+
+    // precision:data:opt
+    std::optional<common::Precision> optPrecision = vsmap::getOptPrecisionFromString("precision", FuncName, in, out, vsapi, DefaultPrecision);
+    if (!optPrecision.has_value())
+    {
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // blocking operation
+    std::string scanErrMsg;
+    std::optional<common::LoudnessResult> optInLoudness = common::measureLoudness(audio, audioInfo, optChannels.value(), requests, common::ScanControl(), scanErrMsg, core, vsapi);
+    if (!optInLoudness.has_value())
+    {
+        std::string errMsg = std::format("{}: {}", FuncName, scanErrMsg);
+        vsapi->mapSetError(out, errMsg.c_str());
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    const common::LoudnessResult& inLoudness = optInLoudness.value();
+
+    LoudNorm* data = new LoudNorm(audio, audioInfo, outLoudness, inLoudness, optChannels.value(), optOverflowMode.value(), optOverflowLog.value(), stats, optPrecision.value());
+
+    if (std::isfinite(inLoudness.integrated))
+    {
+        std::string infoMsg = std::format("{}: integrated loudness {:.2f} LUFS, loudness range {:.2f} LU, gain {:+.2f} dB",
+                                          FuncName, inLoudness.integrated, inLoudness.range, 20 * std::log10(data->getGain()));
+        vsapi->logMessage(VSMessageType::mtInformation, infoMsg.c_str(), core);
+    }
+    else
+    {
+        std::string warnMsg = std::format("{}: no audible blocks (silence or shorter than 400 ms), the audio is not changed", FuncName);
+        vsapi->logMessage(VSMessageType::mtWarning, warnMsg.c_str(), core);
+    }
+
+    VSFilterDependency deps[] = {{ audio, rpStrictSpatial }};
+
+    common::logOverflowCheck(FuncName, data->isOverflowPossible(), core, vsapi);
+
+    // fmParallel: overflows are collected per frame and logged in frame order by common::OverflowTracker
+    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), loudnormGetFrame, loudnormFree, VSFilterMode::fmParallel, deps, 1, data, core);
+}
+
+
+void loudnormInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi)
+{
+    vspapi->registerFunction(FuncName,
+                             "clip:anode;"
+                             "loudness:float:opt;"
+                             "channels:int[]:opt;"
+                             "overflow:data:opt;"
+                             "overflow_log:data:opt;"
+                             "requests:int:opt;"
+                             "stats:int:opt;"
+                             "precision:data:opt;",
+                             "return:anode;",
+                             loudnormCreate, nullptr, plugin);
+}
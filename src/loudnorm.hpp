@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+#include "common/loudness.hpp"
+#include "common/overflow.hpp"
+#include "common/precision.hpp"
+#include "common/sampletype.hpp"
+
+
+class LoudNorm
+{
+public:
+    // the gain is set from the measured integrated loudness of editChannels (see common::measureLoudness)
+    LoudNorm(VSNode* audio, const VSAudioInfo* audioInfo, double outLoudness, const common::LoudnessResult& inLoudness, std::vector<int> editChannels,
+             common::OverflowMode overflowMode, common::OverflowLog overflowLog, bool stats, common::Precision precision);
+
+    VSNode* getAudio();
+
+    const VSAudioInfo& getOutInfo();
+
+    double getGain();
+
+    // false if no output sample can overflow, see common::isOverflowPossible
+    bool isOverflowPossible();
+
+    // true if the stats props are written to every output frame, see common/stats.hpp
+    bool isStatsEnabled();
+
+    /**
+     * returns the source frame of each output channel that is taken over unchanged (for newAudioFrame2)
+     * copy channels are taken from inFrm, edit channels too if the gain is 1 and no sample would change
+     * nullptr: the channel has to be written by writeFrame
+     */
+    std::vector<const VSFrame*> getOutChannelSources(const VSFrame* inFrm, const VSAPI* vsapi);
+
+    void submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi);
+
+    void flushOverflowStats(VSCore* core, const VSAPI* vsapi);
+
+    void free(const VSAPI* vsapi);
+
+    // writes all channels without an out channel source
+    bool writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, const std::vector<const VSFrame*>& outChannelSources,
+                    common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
+
+private:
+    VSNode* audio;
+    const VSAudioInfo audioInfo;
+
+    common::SampleType outSampleType;
+
+    double gain;
+
+    std::vector<int> editChannels;
+    std::vector<int> copyChannels;
+
+    common::OverflowMode overflowMode;
+    common::OverflowLog overflowLog;
+
+    common::OverflowTracker overflowTracker;
+
+    // selects the writeFrameImpl specialization with or without overflow checks
+    bool overflowPossible;
+
+    bool stats;
+
+    // compute type of float samples, see common::Precision
+    common::Precision precision;
+
+    template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t = double>
+    bool writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, const std::vector<const VSFrame*>& outChannelSources,
+                        const common::OverflowContext& ofCtx);
+};
+
+
+void loudnormInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi);
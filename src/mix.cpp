@@ -1,24 +1,32 @@
 // SPDX-License-Identifier: MIT
 
 #include <algorithm>
+#include <array>
 #include <climits>
 #include <cassert>
 #include <cstdint>
 #include <cstring>
 #include <format>
+#include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "VapourSynth4.h"
 #include "VSHelper4.h"
 
 #include "mix.hpp"
+#include "common/framewindow.hpp"
 #include "common/offset.hpp"
 #include "common/overflow.hpp"
+#include "common/precision.hpp"
 #include "common/sampletype.hpp"
+#include "common/silenceframes.hpp"
+#include "common/stats.hpp"
 #include "common/transition.hpp"
 #include "utils/debug.hpp"
 #include "utils/sample.hpp"
@@ -41,6 +49,8 @@ constexpr bool DefaultExtendStart = false;
 constexpr bool DefaultExtendEnd = false;
 constexpr common::OverflowMode DefaultOverflowMode = common::OverflowMode::Error;
 constexpr common::OverflowLog DefaultOverflowLog = common::OverflowLog::Once;
+constexpr bool DefaultStats = false;
+constexpr common::Precision DefaultPrecision = common::Precision::Double;
 
 
 Mix::Mix(VSNode* _audio1, const VSAudioInfo* _audio1Info, double _audio1Gain,
@@ -48,12 +58,17 @@ Mix::Mix(VSNode* _audio1, const VSAudioInfo* _audio1Info, double _audio1Gain,
          int64_t audio2OffsetSamples, bool _relativeGain,
          int64_t fadeinSamples, int64_t fadeoutSamples, common::TransitionType fadeType,
          bool extendAudio1Start, bool extendAudio1End, std::vector<int> _editChannels,
-         common::OverflowMode _overflowMode, common::OverflowLog _overflowLog) :
+         common::OverflowMode _overflowMode, common::OverflowLog _overflowLog, bool _stats, common::Precision _precision) :
     audio1(_audio1), audio1Info(*_audio1Info), audio1Gain(_audio1Gain),
     audio2(_audio2), audio2Info(*_audio2Info), audio2Gain(_audio2Gain),
-    relativeGain(_relativeGain), editChannels(_editChannels.begin(), _editChannels.end()),
-    overflowMode(_overflowMode), overflowLog(_overflowLog)
+    relativeGain(_relativeGain), editChannels(static_cast<size_t>(_audio1Info->format.numChannels), false),
+    overflowMode(_overflowMode), overflowLog(_overflowLog), stats(_stats), precision(_precision)
 {
+    for (int ch : _editChannels)
+    {
+        editChannels[ch] = true;
+    }
+
     fadeinAudio2 = true;
     fadeoutAudio2 = true;
 
@@ -118,6 +133,12 @@ Mix::Mix(VSNode* _audio1, const VSAudioInfo* _audio1Info, double _audio1Gain,
     audio1FrameSampleOffsets = common::getFrameSampleOffsets(outPosAudio1Start);
     audio2FrameSampleOffsets = common::getFrameSampleOffsets(outPosAudio2Start);
 
+    audio1FrameAligned = audio1FrameSampleOffsets.left == 0;
+
+    // only needed if every input frame is used by two output frames
+    audio1Window.init(audio1FrameAligned ? 0 : common::FrameWindow::DefaultCapacity);
+    audio2Window.init(audio2FrameSampleOffsets.left == 0 ? 0 : common::FrameWindow::DefaultCapacity);
+
     // overlapping range of audio1 and audio2
     int64_t outPosMixStart = std::max(outPosAudio1TrimStart, outPosAudio2TrimStart);
     int64_t outPosMixEnd = std::min(outPosAudio1TrimEnd, outPosAudio2TrimEnd);
@@ -170,6 +191,16 @@ Mix::Mix(VSNode* _audio1, const VSAudioInfo* _audio1Info, double _audio1Gain,
     {
         fadeoutTrans = common::newTransition(fadeType, 0, 1, static_cast<double>(fadeoutSamples - 1), 0);
     }
+
+    initFrameSegments();
+
+    // the fade scales are inside [0, 1], so the sum of both scaled clips is the upper bound
+    double maxAbsSample = common::getMaxAbsSample(outSampleType);
+    overflowPossible = common::isOverflowPossible(audio1Scale * maxAbsSample + audio2Scale * maxAbsSample, outSampleType, precision);
+
+    overflowTracker.init(FuncName, overflowMode, overflowLog, common::isFloatSampleType(outSampleType), outInfo.numFrames);
+
+    silenceFrames.init(outInfo.format, stats);
 }
 
 VSNode* Mix::getAudio1()
@@ -184,12 +215,42 @@ VSNode* Mix::getAudio2()
 }
 
 
+common::FrameWindow& Mix::getAudio1Window()
+{
+    return audio1Window;
+}
+
+
+common::FrameWindow& Mix::getAudio2Window()
+{
+    return audio2Window;
+}
+
+
+const VSFrame* Mix::getSilenceFrame(int outFrmLen, VSCore* core, const VSAPI* vsapi)
+{
+    return silenceFrames.get(outFrmLen, core, vsapi);
+}
+
+
 const VSAudioInfo& Mix::getOutInfo()
 {
     return outInfo;
 }
 
 
+bool Mix::isOverflowPossible()
+{
+    return overflowPossible;
+}
+
+
+bool Mix::isStatsEnabled()
+{
+    return stats;
+}
+
+
 void Mix::printDebugInfo(VSCore* core, const VSAPI* vsapi)
 {
     std::string msg = std::format("{}: audio1.length: {}", FuncName, audio1Info.numSamples);
@@ -218,9 +279,112 @@ void Mix::printDebugInfo(VSCore* core, const VSAPI* vsapi)
 }
 
 
+// returns the segment type of an output sample of an edit channel
+MixSegmentType Mix::getSegmentType(int64_t outPos)
+{
+    bool inAudio1 = outPosAudio1TrimStart <= outPos && outPos < outPosAudio1TrimEnd;
+    bool inAudio2 = outPosAudio2TrimStart <= outPos && outPos < outPosAudio2TrimEnd;
+
+    if (inAudio1 && inAudio2)
+    {
+        bool inFadein = outPosFadeinStart <= outPos && outPos < outPosFadeinEnd && fadeinTrans;
+        bool inFadeout = outPosFadeoutStart <= outPos && outPos < outPosFadeoutEnd && fadeoutTrans;
+
+        if (inFadein && inFadeout)
+        {
+            return MixSegmentType::MixFadeinFadeout;
+        }
+
+        if (inFadein)
+        {
+            return MixSegmentType::MixFadein;
+        }
+
+        if (inFadeout)
+        {
+            return MixSegmentType::MixFadeout;
+        }
+
+        return MixSegmentType::Mix;
+    }
+
+    if (inAudio1)
+    {
+        return MixSegmentType::Audio1;
+    }
+
+    if (inAudio2)
+    {
+        return MixSegmentType::Audio2;
+    }
+
+    // no audio, not supposed to happen
+    return MixSegmentType::Silence;
+}
+
+
+void Mix::initFrameSegments()
+{
+    // all positions where the segment type can change
+    std::vector<int64_t> outPosBounds = { 0, outInfo.numSamples,
+                                          outPosAudio1TrimStart, outPosAudio1TrimEnd,
+                                          outPosAudio2TrimStart, outPosAudio2TrimEnd,
+                                          outPosFadeinStart, outPosFadeinEnd,
+                                          outPosFadeoutStart, outPosFadeoutEnd };
+
+    for (int64_t& outPos : outPosBounds)
+    {
+        outPos = std::clamp<int64_t>(outPos, 0, outInfo.numSamples);
+    }
+
+    std::sort(outPosBounds.begin(), outPosBounds.end());
+    outPosBounds.erase(std::unique(outPosBounds.begin(), outPosBounds.end()), outPosBounds.end());
+
+    frameSegments.clear();
+
+    // count the segments of each frame first, then turn the counts into begin indices
+    frameSegmentsBegin.assign(static_cast<size_t>(outInfo.numFrames) + 1, 0);
+
+    int lastFrm = -1;
+
+    for (size_t i = 0; i + 1 < outPosBounds.size(); ++i)
+    {
+        int64_t outPosStart = outPosBounds[i];
+        int64_t outPosEnd = outPosBounds[i + 1];
+
+        MixSegmentType type = getSegmentType(outPosStart);
+
+        for (int frm = vsutils::sampleToFrame(outPosStart); frm <= vsutils::sampleToFrame(outPosEnd - 1); ++frm)
+        {
+            int64_t outPosFrmStart = vsutils::frameToFirstSample(frm);
+
+            int begin = static_cast<int>(std::max(outPosStart, outPosFrmStart) - outPosFrmStart);
+            int end = static_cast<int>(std::min(outPosEnd, outPosFrmStart + VS_AUDIO_FRAME_SAMPLES) - outPosFrmStart);
+
+            // merge with the previous segment of the same frame and type
+            if (lastFrm == frm && frameSegments.back().type == type)
+            {
+                frameSegments.back().end = end;
+                continue;
+            }
+
+            // segments are created in frame order
+            frameSegments.push_back({ .type = type, .begin = begin, .end = end });
+            ++frameSegmentsBegin[frm + 1];
+            lastFrm = frm;
+        }
+    }
+
+    for (size_t frm = 1; frm < frameSegmentsBegin.size(); ++frm)
+    {
+        frameSegmentsBegin[frm] += frameSegmentsBegin[frm - 1];
+    }
+}
+
+
 bool Mix::isEditChannel(int ch)
 {
-    return editChannels.contains(ch);
+    return editChannels[ch];
 }
 
 
@@ -236,18 +400,15 @@ common::OffsetFramePos Mix::outFrameToAudio2Frames(int outFrmNum)
 }
 
 
-void Mix::resetOverflowStats()
+void Mix::submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi)
 {
-    overflowStats = { .count = 0, .peak = 0.0 };
+    overflowTracker.submitFrame(outFrmNum, std::move(frameOverflowStats), core, vsapi);
 }
 
 
-void Mix::logOverflowStats(VSCore* core, const VSAPI* vsapi)
+void Mix::flushOverflowStats(VSCore* core, const VSAPI* vsapi)
 {
-    if (0 < overflowStats.count)
-    {
-        overflowStats.logVS(FuncName, overflowMode, isFloatSampleType(outSampleType), core, vsapi);
-    }
+    overflowTracker.flush(core, vsapi);
 }
 
 
@@ -256,15 +417,90 @@ void Mix::free(const VSAPI* vsapi)
     delete fadeinTrans;
     delete fadeoutTrans;
 
+    audio1Window.clear(vsapi);
+    audio2Window.clear(vsapi);
+    silenceFrames.clear(vsapi);
+
     vsapi->freeNode(audio1);
     vsapi->freeNode(audio2);
 }
 
 
-template <typename sample_t, size_t IntSampleBits>
-bool Mix::writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStart, int outFrmLen,
+// returns the segment type of a channel that is not mixed with audio2
+static MixSegmentType toAudio1OnlySegmentType(MixSegmentType type)
+{
+    switch (type)
+    {
+        case MixSegmentType::Audio1:
+        case MixSegmentType::Mix:
+        case MixSegmentType::MixFadein:
+        case MixSegmentType::MixFadeout:
+        case MixSegmentType::MixFadeinFadeout:
+            return MixSegmentType::Audio1;
+
+        case MixSegmentType::Audio2:
+        case MixSegmentType::Silence:
+        default:
+            return MixSegmentType::Silence;
+    }
+}
+
+
+std::vector<const VSFrame*> Mix::getOutChannelSources(int outFrmNum, int outFrmLen, const VSFrame* a1FrmL, const VSAPI* vsapi)
+{
+    std::vector<const VSFrame*> outChannelSources(static_cast<size_t>(outInfo.format.numChannels), nullptr);
+
+    if (!audio1FrameAligned || audio1Scale != 1.0 || !a1FrmL || vsapi->getFrameLength(a1FrmL) != outFrmLen)
+    {
+        return outChannelSources;
+    }
+
+    // audio1 has to be the only audio in the whole frame, segments always cover the whole frame
+    bool audio1Only = true;
+    bool audio1OnlyCopyChannels = true;
+
+    for (size_t i = frameSegmentsBegin[outFrmNum]; i < frameSegmentsBegin[outFrmNum + 1]; ++i)
+    {
+        MixSegmentType type = frameSegments[i].type;
+
+        audio1Only &= type == MixSegmentType::Audio1;
+        audio1OnlyCopyChannels &= toAudio1OnlySegmentType(type) == MixSegmentType::Audio1;
+    }
+
+    for (int ch = 0; ch < outInfo.format.numChannels; ++ch)
+    {
+        if (!(isEditChannel(ch) ? audio1Only : audio1OnlyCopyChannels))
+        {
+            continue;
+        }
+
+        // overflowing input samples are handled by writeFrame
+        if (!common::isFrameChannelOverflowing(a1FrmL, ch, outSampleType, vsapi))
+        {
+            outChannelSources[ch] = a1FrmL;
+        }
+    }
+
+    return outChannelSources;
+}
+
+
+// samples[begin, end) = scale * samples[begin, end)
+template <typename compute_t>
+static void scaleSamples(compute_t* samples, int begin, int end, compute_t scale)
+{
+    for (int s = begin; s < end; ++s)
+    {
+        samples[s] = scale * samples[s];
+    }
+}
+
+
+template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t>
+bool Mix::writeFrameChannel(int ch, VSFrame* outFrm, int outFrmNum, int64_t outPosFrmStart, int outFrmLen,
                             const VSFrame* a1FrmL, const VSFrame* a1FrmR,
                             const VSFrame* a2FrmL, const VSFrame* a2FrmR,
+                            const FrameScales& fadeinScales, const FrameScales& fadeoutScales,
                             const common::OverflowContext& ofCtx)
 {
     bool audio2Enabled = isEditChannel(ch);
@@ -276,168 +512,152 @@ bool Mix::writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStart, int
     const sample_t* a2FrmLPtr = reinterpret_cast<const sample_t*>(a2FrmL ? ofCtx.vsapi->getReadPtr(a2FrmL, ch) : nullptr);
     const sample_t* a2FrmRPtr = reinterpret_cast<const sample_t*>(a2FrmR ? ofCtx.vsapi->getReadPtr(a2FrmR, ch) : nullptr);
 
-    constexpr vsutils::BitShift bitShift = vsutils::getSampleBitShift<sample_t, IntSampleBits>();
+    // audio1 samples, scaled or mixed in place
+    std::array<compute_t, VS_AUDIO_FRAME_SAMPLES> samples;
+
+    std::array<compute_t, VS_AUDIO_FRAME_SAMPLES> audio2Samples;
+
+    // per sample gains of the fade segments
+    std::array<compute_t, VS_AUDIO_FRAME_SAMPLES> audio1Gains;
+    std::array<compute_t, VS_AUDIO_FRAME_SAMPLES> audio2Gains;
+
+    const compute_t scale1 = static_cast<compute_t>(audio1Scale);
+    const compute_t scale2 = static_cast<compute_t>(audio2Scale);
 
-    for (int s = 0; s < outFrmLen; ++s)
+    auto readAudio1 = [&](int begin, int end)
     {
-        int64_t outPos = outPosFrmStart + s;
+        // only for debug builds
+        assertm(a1FrmLPtr || a1FrmRPtr, "a1FrmLPtr and a1FrmRPtr null");
 
-        if (outPosAudio1TrimStart <= outPos && outPos < outPosAudio1TrimEnd)
-        {
-            // audio1
-#ifndef NDEBUG
-            // only for debug builds
-            assertm(a1FrmLPtr, "a1FrmLPtr null");
+        common::convOffsetSamplesToCompute<sample_t, IntSampleBits, compute_t>(begin, end, audio1FrameSampleOffsets, a1FrmLPtr, a1FrmRPtr, samples.data());
+    };
 
-            if (audio1FrameSampleOffsets.right != 0)
-            {
-                assertm(a1FrmRPtr, "a1FrmRPtr null");
-            }
-#endif
+    auto readAudio2 = [&](int begin, int end, compute_t* out)
+    {
+        // only for debug builds
+        assertm(a2FrmLPtr || a2FrmRPtr, "a2FrmLPtr and a2FrmRPtr null");
 
-            sample_t audio1Sample = common::getOffsetSample(s, audio1FrameSampleOffsets, a1FrmLPtr, a1FrmRPtr);
-            if constexpr (bitShift.required)
-            {
-                audio1Sample >>= bitShift.count;
-            }
+        common::convOffsetSamplesToCompute<sample_t, IntSampleBits, compute_t>(begin, end, audio2FrameSampleOffsets, a2FrmLPtr, a2FrmRPtr, out);
+    };
 
-            if (audio2Enabled && outPosAudio2TrimStart <= outPos && outPos < outPosAudio2TrimEnd)
-            {
-                // mix audio1 and audio2
-#ifndef NDEBUG
-                // only for debug builds
-                assertm(a2FrmLPtr, "a2FrmLPtr null");
+    for (size_t i = frameSegmentsBegin[outFrmNum]; i < frameSegmentsBegin[outFrmNum + 1]; ++i)
+    {
+        const MixSegment& segment = frameSegments[i];
 
-                if (audio2FrameSampleOffsets.right != 0)
-                {
-                    assertm(a2FrmRPtr, "a2FrmRPtr null");
-                }
-#endif
+        int begin = segment.begin;
+        int end = segment.end;
 
-                sample_t audio2Sample = common::getOffsetSample(s, audio2FrameSampleOffsets, a2FrmLPtr, a2FrmRPtr);
-                if constexpr (bitShift.required)
-                {
-                    audio2Sample >>= bitShift.count;
-                }
+        MixSegmentType type = audio2Enabled ? segment.type : toAudio1OnlySegmentType(segment.type);
 
-                int64_t fadeinPos = outPos - outPosFadeinStart;
-                int64_t fadeoutPos = outPos - outPosFadeoutStart;
-                double audio1FadeinScale = 1;
-                double audio2FadeinScale = 1;
-                double audio1FadeoutScale = 1;
-                double audio2FadeoutScale = 1;
+        switch (type)
+        {
+            case MixSegmentType::Silence:
+                std::fill(samples.begin() + begin, samples.begin() + end, compute_t(0));
+                break;
 
-                if (outPosFadeinStart <= outPos && outPos < outPosFadeinEnd && fadeinTrans)
-                {
-                    if (fadeinAudio2)
-                    {
-                        audio2FadeinScale = fadeinTrans->calcY(static_cast<double>(fadeinPos));
-                    }
-                    else
-                    {
-                        audio1FadeinScale = fadeinTrans->calcY(static_cast<double>(fadeinPos));
-                    }
-                }
+            case MixSegmentType::Audio1:
+                readAudio1(begin, end);
+                scaleSamples(samples.data(), begin, end, scale1);
+                break;
 
-                if (outPosFadeoutStart <= outPos && outPos < outPosFadeoutEnd && fadeoutTrans)
-                {
-                    if (fadeoutAudio2)
-                    {
-                        audio2FadeoutScale = fadeoutTrans->calcY(static_cast<double>(fadeoutPos));
-                    }
-                    else
-                    {
-                        audio1FadeoutScale = fadeoutTrans->calcY(static_cast<double>(fadeoutPos));
-                    }
-                }
+            case MixSegmentType::Audio2:
+                readAudio2(begin, end, samples.data());
+                scaleSamples(samples.data(), begin, end, scale2);
+                break;
 
-                // mix audio1Sample and audio2Sample
-                double mixedSample = audio1Scale * audio1FadeinScale * audio1FadeoutScale * utils::convSampleToDouble<sample_t, IntSampleBits>(audio1Sample) +
-                                     audio2Scale * audio2FadeinScale * audio2FadeoutScale * utils::convSampleToDouble<sample_t, IntSampleBits>(audio2Sample);
+            case MixSegmentType::Mix:
+                readAudio1(begin, end);
+                readAudio2(begin, end, audio2Samples.data());
 
-                if (!common::safeWriteSample<sample_t, IntSampleBits>(mixedSample, outFrmPtr, s, outPos, ch, ofCtx, overflowStats))
+                for (int s = begin; s < end; ++s)
                 {
-                    // overflow and error
-                    return false;
+                    samples[s] = scale1 * samples[s] + scale2 * audio2Samples[s];
                 }
-            }
-            else
-            {
-                // only audio1
-                double scaledSample = audio1Scale * utils::convSampleToDouble<sample_t, IntSampleBits>(audio1Sample);
+                break;
 
-                if (!common::safeWriteSample<sample_t, IntSampleBits>(scaledSample, outFrmPtr, s, outPos, ch, ofCtx, overflowStats))
-                {
-                    // overflow and error
-                    return false;
-                }
-            }
-        }
-        else
-        {
-            if (audio2Enabled)
+            case MixSegmentType::MixFadein:
+            case MixSegmentType::MixFadeout:
+            case MixSegmentType::MixFadeinFadeout:
             {
-                if (outPosAudio2TrimStart <= outPos && outPos < outPosAudio2TrimEnd)
-                {
-                    // only audio2
-#ifndef NDEBUG
-                    // only for debug builds
-                    assertm(a2FrmLPtr, "a2FrmLPtr null");
+                readAudio1(begin, end);
+                readAudio2(begin, end, audio2Samples.data());
 
-                    if (audio2FrameSampleOffsets.right != 0)
-                    {
-                        assertm(a2FrmRPtr, "a2FrmRPtr null");
-                    }
-#endif
+                std::fill(audio1Gains.begin() + begin, audio1Gains.begin() + end, scale1);
+                std::fill(audio2Gains.begin() + begin, audio2Gains.begin() + end, scale2);
 
-                    sample_t audio2Sample = common::getOffsetSample(s, audio2FrameSampleOffsets, a2FrmLPtr, a2FrmRPtr);
-                    if constexpr (bitShift.required)
+                if (type != MixSegmentType::MixFadeout)
+                {
+                    compute_t* gains = fadeinAudio2 ? audio2Gains.data() : audio1Gains.data();
+                    for (int s = begin; s < end; ++s)
                     {
-                        audio2Sample >>= bitShift.count;
+                        gains[s] *= static_cast<compute_t>(fadeinScales[s]);
                     }
+                }
 
-                    double scaledSample = audio2Scale * utils::convSampleToDouble<sample_t, IntSampleBits>(audio2Sample);
-
-                    if (!common::safeWriteSample<sample_t, IntSampleBits>(scaledSample, outFrmPtr, s, outPos, ch, ofCtx, overflowStats))
+                if (type != MixSegmentType::MixFadein)
+                {
+                    compute_t* gains = fadeoutAudio2 ? audio2Gains.data() : audio1Gains.data();
+                    for (int s = begin; s < end; ++s)
                     {
-                        // overflow and error
-                        return false;
+                        gains[s] *= static_cast<compute_t>(fadeoutScales[s]);
                     }
                 }
-                else
-                {
-                    // no audio, not supposed to happen
-                    assertm(false, "sample is neither in the left nor in the right frame");
-                }
-            }
-            else
-            {
-                // fill with zeros
-                if (!common::safeWriteSample<sample_t, IntSampleBits>(0, outFrmPtr, s, outPos, ch, ofCtx, overflowStats))
+
+                for (int s = begin; s < end; ++s)
                 {
-                    // overflow and error
-                    return false;
+                    samples[s] = audio1Gains[s] * samples[s] + audio2Gains[s] * audio2Samples[s];
                 }
+                break;
             }
         }
     }
 
-    return true;
+    return common::safeWriteSamples<sample_t, IntSampleBits, CheckOverflow>(std::span(samples.data(), outFrmLen), outFrmPtr, outPosFrmStart, ch, ofCtx);
 }
 
 
-template <typename sample_t, size_t IntSampleBits>
-bool Mix::writeFrameImpl(VSFrame* outFrm, int outFrmNum,
-                     const VSFrame* a1FrmL, const VSFrame* a1FrmR,
-                     const VSFrame* a2FrmL, const VSFrame* a2FrmR,
-                     const common::OverflowContext& ofCtx)
+template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t>
+bool Mix::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
+                         const VSFrame* a1FrmL, const VSFrame* a1FrmR,
+                         const VSFrame* a2FrmL, const VSFrame* a2FrmR,
+                         const common::OverflowContext& ofCtx)
 {
     int64_t outPosFrmStart = vsutils::frameToFirstSample(outFrmNum);
     int outFrmLen = ofCtx.vsapi->getFrameLength(outFrm);
 
+    // fade scales are the same for all channels
+    // only the frame samples inside the fade in/out are set: [fadeinBegin, fadeinEnd), [fadeoutBegin, fadeoutEnd)
+    FrameScales fadeinScales;
+    FrameScales fadeoutScales;
+
+    int fadeinBegin = static_cast<int>(std::clamp<int64_t>(outPosFadeinStart - outPosFrmStart, 0, outFrmLen));
+    int fadeinEnd = static_cast<int>(std::clamp<int64_t>(outPosFadeinEnd - outPosFrmStart, 0, outFrmLen));
+
+    if (fadeinBegin < fadeinEnd && fadeinTrans)
+    {
+        int64_t fadeinPosBegin = outPosFrmStart + fadeinBegin - outPosFadeinStart;
+        fadeinTrans->fill(static_cast<double>(fadeinPosBegin), std::span(fadeinScales.data() + fadeinBegin, fadeinEnd - fadeinBegin));
+    }
+
+    int fadeoutBegin = static_cast<int>(std::clamp<int64_t>(outPosFadeoutStart - outPosFrmStart, 0, outFrmLen));
+    int fadeoutEnd = static_cast<int>(std::clamp<int64_t>(outPosFadeoutEnd - outPosFrmStart, 0, outFrmLen));
+
+    if (fadeoutBegin < fadeoutEnd && fadeoutTrans)
+    {
+        int64_t fadeoutPosBegin = outPosFrmStart + fadeoutBegin - outPosFadeoutStart;
+        fadeoutTrans->fill(static_cast<double>(fadeoutPosBegin), std::span(fadeoutScales.data() + fadeoutBegin, fadeoutEnd - fadeoutBegin));
+    }
+
+    // unchanged channels are already set by newAudioFrame2
     for (int ch = 0; ch < audio1Info.format.numChannels; ++ch)
     {
-        if (!writeFrameChannel<sample_t, IntSampleBits>(ch, outFrm, outPosFrmStart, outFrmLen, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx))
+        if (outChannelSources[ch])
+        {
+            continue;
+        }
+
+        if (!writeFrameChannel<sample_t, IntSampleBits, CheckOverflow, compute_t>(ch, outFrm, outFrmNum, outPosFrmStart, outFrmLen, a1FrmL, a1FrmR, a2FrmL, a2FrmR,
+                                                                   fadeinScales, fadeoutScales, ofCtx))
         {
             return false;
         }
@@ -446,29 +666,41 @@ bool Mix::writeFrameImpl(VSFrame* outFrm, int outFrmNum,
 }
 
 
-bool Mix::writeFrame(VSFrame* outFrm, int outFrmNum,
+bool Mix::writeFrame(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
                      const VSFrame* a1FrmL, const VSFrame* a1FrmR,
                      const VSFrame* a2FrmL, const VSFrame* a2FrmR,
-                     VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+                     common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
 {
     common::OverflowContext ofCtx =
         { .mode = overflowMode, .log = overflowLog, .funcName = FuncName,
-          .frameCtx = frameCtx, .core = core, .vsapi = vsapi };
+          .frameCtx = frameCtx, .core = core, .vsapi = vsapi,
+          .stats = overflowStats };
 
     switch (outSampleType)
     {
         case common::SampleType::Int8:
-            return writeFrameImpl<int8_t, 8>(outFrm, outFrmNum, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx);
+            return overflowPossible ? writeFrameImpl<int8_t, 8, true>(outFrm, outFrmNum, outChannelSources, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx)
+                                    : writeFrameImpl<int8_t, 8, false>(outFrm, outFrmNum, outChannelSources, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx);
         case common::SampleType::Int16:
-            return writeFrameImpl<int16_t, 16>(outFrm, outFrmNum, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx);
+            return overflowPossible ? writeFrameImpl<int16_t, 16, true>(outFrm, outFrmNum, outChannelSources, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx)
+                                    : writeFrameImpl<int16_t, 16, false>(outFrm, outFrmNum, outChannelSources, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx);
         case common::SampleType::Int24:
-            return writeFrameImpl<int32_t, 24>(outFrm, outFrmNum, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx);
+            return overflowPossible ? writeFrameImpl<int32_t, 24, true>(outFrm, outFrmNum, outChannelSources, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx)
+                                    : writeFrameImpl<int32_t, 24, false>(outFrm, outFrmNum, outChannelSources, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx);
         case common::SampleType::Int32:
-            return writeFrameImpl<int32_t, 32>(outFrm, outFrmNum, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx);
+            return overflowPossible ? writeFrameImpl<int32_t, 32, true>(outFrm, outFrmNum, outChannelSources, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx)
+                                    : writeFrameImpl<int32_t, 32, false>(outFrm, outFrmNum, outChannelSources, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx);
         case common::SampleType::Float32:
-            return writeFrameImpl<float, 0>(outFrm, outFrmNum, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx);
+            if (common::isFloatCompute(precision, outSampleType))
+            {
+                // float rounding errors can overflow, see common::isOverflowPossible
+                return writeFrameImpl<float, 0, true, float>(outFrm, outFrmNum, outChannelSources, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx);
+            }
+            return overflowPossible ? writeFrameImpl<float, 0, true>(outFrm, outFrmNum, outChannelSources, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx)
+                                    : writeFrameImpl<float, 0, false>(outFrm, outFrmNum, outChannelSources, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx);
         case common::SampleType::Float64:
-            return writeFrameImpl<double, 0>(outFrm, outFrmNum, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx);
+            return overflowPossible ? writeFrameImpl<double, 0, true>(outFrm, outFrmNum, outChannelSources, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx)
+                                    : writeFrameImpl<double, 0, false>(outFrm, outFrmNum, outChannelSources, a1FrmL, a1FrmR, a2FrmL, a2FrmR, ofCtx);
         default:
             return false;
     }
@@ -478,8 +710,7 @@ bool Mix::writeFrame(VSFrame* outFrm, int outFrmNum,
 static void VS_CC mixFree(void* instanceData, VSCore* core, const VSAPI* vsapi)
 {
     Mix* data = static_cast<Mix*>(instanceData);
-    // skip logging since the total number of overflows is unreliable
-    // data->logNumOverflows(core, vsapi);
+    data->flushOverflowStats(core, vsapi);
     data->free(vsapi);
     delete data;
 }
@@ -492,77 +723,59 @@ static const VSFrame* VS_CC mixGetFrame(int outFrmNum, int activationReason, voi
     common::OffsetFramePos a1FrmNums = data->outFrameToAudio1Frames(outFrmNum);
     common::OffsetFramePos a2FrmNums = data->outFrameToAudio2Frames(outFrmNum);
 
+    if (activationReason == VSActivationReason::arError)
+    {
+        common::freeWindowFrames(frameData, vsapi);
+        return nullptr;
+    }
+
+    if (activationReason == VSActivationReason::arInitial && a1FrmNums.left < 0 && a1FrmNums.right < 0 && a2FrmNums.left < 0 && a2FrmNums.right < 0)
+    {
+        // fully silent output frame: shared frame without any upstream request
+        data->submitOverflowStats(outFrmNum, common::OverflowStats(), core, vsapi);
+        return data->getSilenceFrame(vsutils::getFrameSampleCount(outFrmNum, data->getOutInfo().numSamples), core, vsapi);
+    }
+
     if (activationReason == VSActivationReason::arInitial)
     {
-        if (0 <= a1FrmNums.left)
-        {
-            vsapi->requestFrameFilter(a1FrmNums.left, data->getAudio1(), frameCtx);
-        }
+        // offset frames that are still in the frame windows are not requested again
+        auto windowFrms = std::make_unique<common::WindowFrames>(2);
 
-        if (0 <= a1FrmNums.right)
-        {
-            vsapi->requestFrameFilter(a1FrmNums.right, data->getAudio1(), frameCtx);
-        }
+        bool a1Requested = common::requestOffsetFrames(a1FrmNums, data->getAudio1(), data->getAudio1Window(), windowFrms->at(0), frameCtx, vsapi);
+        bool a2Requested = common::requestOffsetFrames(a2FrmNums, data->getAudio2(), data->getAudio2Window(), windowFrms->at(1), frameCtx, vsapi);
 
-        if (0 <= a2FrmNums.left)
-        {
-            vsapi->requestFrameFilter(a2FrmNums.left, data->getAudio2(), frameCtx);
-        }
+        *frameData = windowFrms.release();
 
-        if (0 <= a2FrmNums.right)
+        if (a1Requested || a2Requested)
         {
-            vsapi->requestFrameFilter(a2FrmNums.right, data->getAudio2(), frameCtx);
+            return nullptr;
         }
 
-        return nullptr;
+        // all frames are in the frame windows: the frame is returned right away
     }
 
-    if (activationReason == VSActivationReason::arAllFramesReady)
+    if (activationReason == VSActivationReason::arInitial || activationReason == VSActivationReason::arAllFramesReady)
     {
-        if (outFrmNum == 0)
-        {
-            data->resetOverflowStats();
-        }
+        std::unique_ptr<common::WindowFrames> windowFrms(common::releaseWindowFrames(frameData));
 
-        const VSFrame* a1FrmL = nullptr;
-        const VSFrame* a1FrmR = nullptr;
-        const VSFrame* a2FrmL = nullptr;
-        const VSFrame* a2FrmR = nullptr;
-        const VSFrame* propFrm = nullptr;
+        common::OffsetFrames a1Frms = common::getOffsetFrames(a1FrmNums, windowFrms->at(0), data->getAudio1(), data->getAudio1Window(), frameCtx, vsapi);
+        common::OffsetFrames a2Frms = common::getOffsetFrames(a2FrmNums, windowFrms->at(1), data->getAudio2(), data->getAudio2Window(), frameCtx, vsapi);
 
-        if (0 <= a1FrmNums.left)
-        {
-            a1FrmL = vsapi->getFrameFilter(a1FrmNums.left, data->getAudio1(), frameCtx);
-            if (!propFrm)
-            {
-                propFrm = a1FrmL;
-            }
-        }
+        const VSFrame* a1FrmL = a1Frms.left;
+        const VSFrame* a1FrmR = a1Frms.right;
+        const VSFrame* a2FrmL = a2Frms.left;
+        const VSFrame* a2FrmR = a2Frms.right;
+        const VSFrame* propFrm = a1FrmL ? a1FrmL : a1FrmR;
 
-        if (0 <= a1FrmNums.right)
-        {
-            a1FrmR = vsapi->getFrameFilter(a1FrmNums.right, data->getAudio1(), frameCtx);
-            if (!propFrm)
-            {
-                propFrm = a1FrmR;
-            }
-        }
+        int outFrmLen = vsutils::getFrameSampleCount(outFrmNum, data->getOutInfo().numSamples);
 
-        if (0 <= a2FrmNums.left)
-        {
-            a2FrmL = vsapi->getFrameFilter(a2FrmNums.left, data->getAudio2(), frameCtx);
-        }
+        std::vector<const VSFrame*> outChannelSources = data->getOutChannelSources(outFrmNum, outFrmLen, a1FrmL, vsapi);
 
-        if (0 <= a2FrmNums.right)
-        {
-            a2FrmR = vsapi->getFrameFilter(a2FrmNums.right, data->getAudio2(), frameCtx);
-        }
-
-        int outFrmLen = vsutils::getFrameSampleCount(outFrmNum, data->getOutInfo().numSamples);
+        VSFrame* outFrm = vsutils::newAudioFrameFromChannelSources(&data->getOutInfo().format, outFrmLen, outChannelSources, propFrm, core, vsapi);
 
-        VSFrame* outFrm = vsapi->newAudioFrame(&data->getOutInfo().format, outFrmLen, propFrm, core);
+        common::OverflowStats overflowStats;
 
-        bool success = data->writeFrame(outFrm, outFrmNum, a1FrmL, a1FrmR, a2FrmL, a2FrmR, frameCtx, core, vsapi);
+        bool success = data->writeFrame(outFrm, outFrmNum, outChannelSources, a1FrmL, a1FrmR, a2FrmL, a2FrmR, overflowStats, frameCtx, core, vsapi);
 
         if (a1FrmL)
         {
@@ -584,12 +797,13 @@ static const VSFrame* VS_CC mixGetFrame(int outFrmNum, int activationReason, voi
             vsapi->freeFrame(a2FrmR);
         }
 
-        if (outFrmNum == data->getOutInfo().numFrames - 1)
+        if (success)
         {
-            // last frame
-            data->logOverflowStats(core, vsapi);
+            common::updateFrameStatsProps(outFrm, data->isStatsEnabled(), overflowStats, vsapi);
         }
 
+        data->submitOverflowStats(outFrmNum, std::move(overflowStats), core, vsapi);
+
         if (success)
         {
             return outFrm;
@@ -765,16 +979,30 @@ static void VS_CC mixCreate(const VSMap* in, VSMap* out, void* userData, VSCore*
         return;
     }
 
+    // stats:int:opt
+    bool stats = vsmap::getOptBool("stats", in, vsapi, DefaultStats);
+
+    // precision:data:opt
+    std::optional<common::Precision> optPrecision = vsmap::getOptPrecisionFromString("precision", FuncName, in, out, vsapi, DefaultPrecision);
+    if (!optPrecision.has_value())
+    {
+        vsapi->freeNode(audio1);
+        vsapi->freeNode(audio2);
+        return;
+    }
+
     Mix* data = new Mix(audio1, audio1Info, audio1Gain, audio2, audio2Info, audio2Gain, audio2OffsetSamples, relativeGain,
                         fadeinSamples, fadeoutSamples, optFadeType.value(), extendStart, extendEnd, optChannels.value(),
-                        optOverflowMode.value(), optOverflowLog.value());
+                        optOverflowMode.value(), optOverflowLog.value(), stats, optPrecision.value());
 
     //data->printDebugInfo(core, vsapi);
 
     VSFilterDependency deps[] = {{ audio1, VSRequestPattern::rpGeneral }, { audio2, VSRequestPattern::rpGeneral }};
 
-    // fmParallelRequests: strict sequential frame requests for overflow logging
-    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), mixGetFrame, mixFree, VSFilterMode::fmParallelRequests, deps, 2, data, core);
+    common::logOverflowCheck(FuncName, data->isOverflowPossible(), core, vsapi);
+
+    // fmParallel: overflows are collected per frame and logged in frame order by common::OverflowTracker
+    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), mixGetFrame, mixFree, VSFilterMode::fmParallel, deps, 2, data, core);
 }
 
 
@@ -797,7 +1025,9 @@ void mixInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi)
                              "extend_end:int:opt;"
                              "channels:int[]:opt;"
                              "overflow:data:opt;"
-                             "overflow_log:data:opt;",
+                             "overflow_log:data:opt;"
+                             "stats:int:opt;"
+                             "precision:data:opt;",
                              "return:anode;",
                              mixCreate, nullptr, plugin);
 }
@@ -2,17 +2,44 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <set>
 #include <vector>
 
 #include "VapourSynth4.h"
 
+#include "common/framewindow.hpp"
 #include "common/offset.hpp"
 #include "common/overflow.hpp"
+#include "common/precision.hpp"
 #include "common/sampletype.hpp"
+#include "common/silenceframes.hpp"
 #include "common/transition.hpp"
 
+enum class MixSegmentType
+{
+    Silence,
+    Audio1,
+    Audio2,
+    Mix,
+    MixFadein,
+    MixFadeout,
+    MixFadeinFadeout,
+};
+
+
+// homogeneous run of output samples
+struct MixSegment
+{
+    MixSegmentType type;
+
+    // frame sample positions [begin, end)
+    int begin;
+    int end;
+};
+
+
 class Mix
 {
 public:
@@ -21,28 +48,49 @@ public:
         int64_t audio2OffsetSamples, bool relativeGain,
         int64_t fadeinSamples, int64_t fadeoutSamples, common::TransitionType fadeType,
         bool extendAudio1Start, bool extendAudio1End, std::vector<int> editChannels,
-        common::OverflowMode overflowMode, common::OverflowLog overflowLog);
+        common::OverflowMode overflowMode, common::OverflowLog overflowLog, bool stats, common::Precision precision);
 
     VSNode* getAudio1();
     VSNode* getAudio2();
 
+    // recently fetched input frames, see common::FrameWindow
+    common::FrameWindow& getAudio1Window();
+    common::FrameWindow& getAudio2Window();
+
+    // returns a new reference of the shared silent output frame, see common::SilenceFrames
+    const VSFrame* getSilenceFrame(int outFrmLen, VSCore* core, const VSAPI* vsapi);
+
     const VSAudioInfo& getOutInfo();
 
+    // false if no output sample can overflow, see common::isOverflowPossible
+    bool isOverflowPossible();
+
+    // true if the stats props are written to every output frame, see common/stats.hpp
+    bool isStatsEnabled();
+
     common::OffsetFramePos outFrameToAudio1Frames(int outFrmNum);
     common::OffsetFramePos outFrameToAudio2Frames(int outFrmNum);
 
-    void resetOverflowStats();
+    /**
+     * returns the source frame of each output channel that is taken over unchanged (for newAudioFrame2)
+     * a channel is taken from a1FrmL if audio1 is frame aligned, not scaled and the only audio of that channel in the whole frame
+     * nullptr: the channel has to be written by writeFrame
+     */
+    std::vector<const VSFrame*> getOutChannelSources(int outFrmNum, int outFrmLen, const VSFrame* a1FrmL, const VSAPI* vsapi);
+
+    void submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi);
 
-    void logOverflowStats(VSCore* core, const VSAPI* vsapi);
+    void flushOverflowStats(VSCore* core, const VSAPI* vsapi);
 
     void free(const VSAPI* vsapi);
 
     void printDebugInfo(VSCore* core, const VSAPI* vsapi);
 
-    bool writeFrame(VSFrame* outFrm, int outFrmNum,
+    // writes all channels without an out channel source
+    bool writeFrame(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
                     const VSFrame* a1FrmL, const VSFrame* a1FrmR,
                     const VSFrame* a2FrmL, const VSFrame* a2FrmR,
-                    VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
+                    common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
 
 private:
     VSNode* audio1;
@@ -61,13 +109,21 @@ private:
     // relative or absolute gain
     bool relativeGain;
 
-    //std::vector<int> editChannels;
-    std::set<int> editChannels;
+    // true for every channel that is mixed with audio2
+    std::vector<bool> editChannels;
 
     common::OverflowMode overflowMode;
     common::OverflowLog overflowLog;
 
-    common::OverflowStats overflowStats = { .count = 0, .peak = 0.0 };
+    common::OverflowTracker overflowTracker;
+
+    // selects the writeFrameImpl specialization with or without overflow checks
+    bool overflowPossible;
+
+    bool stats;
+
+    // compute type of float samples, see common::Precision
+    common::Precision precision;
 
     // fade in/out audio2 or audio1, depending on which clip starts later or ends first
     // which depends on extendAudio1Start and extendAudio1End
@@ -88,6 +144,14 @@ private:
     common::FrameSampleOffsets audio1FrameSampleOffsets;
     common::FrameSampleOffsets audio2FrameSampleOffsets;
 
+    // true if an output frame covers exactly one audio1 frame
+    bool audio1FrameAligned;
+
+    common::FrameWindow audio1Window;
+    common::FrameWindow audio2Window;
+
+    common::SilenceFrames silenceFrames;
+
     int64_t outPosFadeinStart;
     int64_t outPosFadeinEnd;
 
@@ -100,16 +164,27 @@ private:
     // fade out transition is going from (0, 1) to (fadeoutSamples - 1, 0)
     common::Transition* fadeoutTrans = nullptr;
 
+    using FrameScales = std::array<double, VS_AUDIO_FRAME_SAMPLES>;
+
+    // segments of the output frame n (of an edit channel): frameSegments[frameSegmentsBegin[n], frameSegmentsBegin[n + 1])
+    std::vector<MixSegment> frameSegments;
+    std::vector<size_t> frameSegmentsBegin;
+
+    void initFrameSegments();
+
+    MixSegmentType getSegmentType(int64_t outPos);
+
     bool isEditChannel(int ch);
 
-    template <typename sample_t, size_t IntSampleBits>
-    bool writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStart, int outFrmLen,
+    template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t = double>
+    bool writeFrameChannel(int ch, VSFrame* outFrm, int outFrmNum, int64_t outPosFrmStart, int outFrmLen,
                            const VSFrame* a1FrmL, const VSFrame* a1FrmR,
                            const VSFrame* a2FrmL, const VSFrame* a2FrmR,
+                           const FrameScales& fadeinScales, const FrameScales& fadeoutScales,
                            const common::OverflowContext& ofCtx);
 
-    template <typename sample_t, size_t IntSampleBits>
-    bool writeFrameImpl(VSFrame* outFrm, int outFrmNum,
+    template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t = double>
+    bool writeFrameImpl(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
                         const VSFrame* a1FrmL, const VSFrame* a1FrmR,
                         const VSFrame* a2FrmL, const VSFrame* a2FrmR,
                         const common::OverflowContext& ofCtx);
@@ -0,0 +1,820 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "VapourSynth4.h"
+#include "VSHelper4.h"
+
+#include "mixn.hpp"
+#include "common/framewindow.hpp"
+#include "common/offset.hpp"
+#include "common/overflow.hpp"
+#include "common/precision.hpp"
+#include "common/sampletype.hpp"
+#include "common/silenceframes.hpp"
+#include "common/stats.hpp"
+#include "common/transition.hpp"
+#include "vsmap/vsmap.hpp"
+#include "vsmap/vsmap_common.hpp"
+#include "vsutils/audio.hpp"
+
+constexpr const char* FuncName = "MixN";
+
+constexpr int64_t DefaultOffset = 0;
+constexpr double DefaultGain = 1;
+constexpr bool DefaultRelativeGain = false;
+constexpr int64_t DefaultFadeInSamples = 0;
+constexpr int64_t DefaultFadeOutSamples = 0;
+constexpr common::TransitionType DefaultFadeType = common::TransitionType::Cubic;
+constexpr common::OverflowMode DefaultOverflowMode = common::OverflowMode::Error;
+constexpr common::OverflowLog DefaultOverflowLog = common::OverflowLog::Once;
+constexpr bool DefaultStats = false;
+constexpr common::Precision DefaultPrecision = common::Precision::Double;
+
+
+MixN::MixN(std::vector<VSNode*> audios, std::vector<int64_t> offsets, std::vector<double> gains, bool relativeGain,
+           std::vector<int64_t> fadeinSamples, std::vector<int64_t> fadeoutSamples, common::TransitionType fadeType,
+           common::OverflowMode _overflowMode, common::OverflowLog _overflowLog, bool _stats, common::Precision _precision,
+           const VSAPI* vsapi) :
+    overflowMode(_overflowMode), overflowLog(_overflowLog), stats(_stats), precision(_precision)
+{
+    outInfo = *vsapi->getAudioInfo(audios[0]);
+
+    double totalGain = 0;
+    for (const double& gain : gains)
+    {
+        totalGain += gain;
+    }
+
+    int64_t outLen = 0;
+    double totalScale = 0;
+
+    for (size_t i = 0; i < audios.size(); ++i)
+    {
+        MixNInput input = {};
+
+        input.audio = audios[i];
+        input.info = *vsapi->getAudioInfo(audios[i]);
+
+        if (relativeGain)
+        {
+            // scale the gains so they add up to 1
+            input.scale = totalGain == 0 ? 0 : gains[i] / totalGain;
+        }
+        else
+        {
+            input.scale = gains[i];
+        }
+
+        input.outPosStart = offsets[i];
+
+        // trim the input samples before the output start
+        input.outPosTrimStart = std::max<int64_t>(input.outPosStart, 0);
+        input.outPosTrimEnd = input.outPosStart + input.info.numSamples;
+
+        input.frameSampleOffsets = common::getFrameSampleOffsets(input.outPosStart);
+
+        int64_t trimLen = input.outPosTrimEnd - input.outPosTrimStart;
+
+        int64_t fadein = std::min(fadeinSamples[i], trimLen);
+        int64_t fadeout = std::min(fadeoutSamples[i], trimLen);
+
+        input.outPosFadeinEnd = input.outPosTrimStart + fadein;
+        input.outPosFadeoutStart = input.outPosTrimEnd - fadeout;
+
+        input.fadeinTrans = 0 < fadein ? common::newTransition(fadeType, 0, 0, static_cast<double>(fadein - 1), 1) : nullptr;
+        input.fadeoutTrans = 0 < fadeout ? common::newTransition(fadeType, 0, 1, static_cast<double>(fadeout - 1), 0) : nullptr;
+
+        outLen = std::max(outLen, input.outPosTrimEnd);
+        totalScale += input.scale;
+
+        inputs.push_back(input);
+    }
+
+    // create destination audio information
+    outInfo.numSamples = outLen;
+    outInfo.numFrames = vsutils::samplesToFrames(outInfo.numSamples);
+
+    outSampleType = common::getSampleTypeFromAudioFormat(outInfo.format).value();
+
+    initActiveInputs();
+
+    // only needed if every input frame is used by two output frames
+    inputWindows = std::vector<common::FrameWindow>(inputs.size());
+
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        inputWindows[i].init(inputs[i].frameSampleOffsets.left == 0 ? 0 : common::FrameWindow::DefaultCapacity);
+    }
+
+    // the fade scales are inside [0, 1], so the sum of all scaled inputs is the upper bound
+    overflowPossible = common::isOverflowPossible(totalScale * common::getMaxAbsSample(outSampleType), outSampleType, precision);
+
+    overflowTracker.init(FuncName, overflowMode, overflowLog, common::isFloatSampleType(outSampleType), outInfo.numFrames);
+
+    silenceFrames.init(outInfo.format, stats);
+}
+
+
+const VSAudioInfo& MixN::getOutInfo()
+{
+    return outInfo;
+}
+
+
+bool MixN::isOverflowPossible()
+{
+    return overflowPossible;
+}
+
+
+bool MixN::isStatsEnabled()
+{
+    return stats;
+}
+
+
+size_t MixN::getNumInputs()
+{
+    return inputs.size();
+}
+
+
+VSNode* MixN::getAudio(size_t input)
+{
+    return inputs[input].audio;
+}
+
+
+common::FrameWindow& MixN::getInputWindow(size_t input)
+{
+    return inputWindows[input];
+}
+
+
+const VSFrame* MixN::getSilenceFrame(int outFrmLen, VSCore* core, const VSAPI* vsapi)
+{
+    return silenceFrames.get(outFrmLen, core, vsapi);
+}
+
+
+void MixN::initActiveInputs()
+{
+    // count the active inputs of each frame first, then turn the counts into begin indices
+    activeInputsBegin.assign(static_cast<size_t>(outInfo.numFrames) + 1, 0);
+
+    for (const MixNInput& input : inputs)
+    {
+        for (int frm = vsutils::sampleToFrame(input.outPosTrimStart); frm <= vsutils::sampleToFrame(input.outPosTrimEnd - 1); ++frm)
+        {
+            ++activeInputsBegin[frm + 1];
+        }
+    }
+
+    for (size_t frm = 1; frm < activeInputsBegin.size(); ++frm)
+    {
+        activeInputsBegin[frm] += activeInputsBegin[frm - 1];
+    }
+
+    activeInputs.resize(activeInputsBegin.back());
+
+    // next free index of each frame
+    std::vector<size_t> activeInputsEnd(activeInputsBegin.begin(), activeInputsBegin.end() - 1);
+
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        for (int frm = vsutils::sampleToFrame(inputs[i].outPosTrimStart); frm <= vsutils::sampleToFrame(inputs[i].outPosTrimEnd - 1); ++frm)
+        {
+            activeInputs[activeInputsEnd[frm]++] = i;
+        }
+    }
+}
+
+
+std::span<const size_t> MixN::getActiveInputs(int outFrmNum)
+{
+    size_t begin = activeInputsBegin[outFrmNum];
+    size_t end = activeInputsBegin[outFrmNum + 1];
+
+    return std::span<const size_t>(activeInputs.data() + begin, end - begin);
+}
+
+
+common::OffsetFramePos MixN::outFrameToInputFrames(int outFrmNum, size_t input)
+{
+    const MixNInput& in = inputs[input];
+
+    return common::baseFrameToOffsetFramesTrim(outFrmNum, in.outPosStart, in.info.numSamples, in.outPosTrimStart, in.outPosTrimEnd, outInfo.numSamples);
+}
+
+
+bool MixN::isFading(const MixNInput& input, int64_t outPosFrmStart, int64_t outPosFrmEnd)
+{
+    bool inFadein = input.fadeinTrans && input.outPosTrimStart < outPosFrmEnd && outPosFrmStart < input.outPosFadeinEnd;
+    bool inFadeout = input.fadeoutTrans && input.outPosFadeoutStart < outPosFrmEnd && outPosFrmStart < input.outPosTrimEnd;
+
+    return inFadein || inFadeout;
+}
+
+
+std::vector<const VSFrame*> MixN::getOutChannelSources(int outFrmNum, int outFrmLen, const std::vector<MixNInputFrames>& inputFrames, const VSAPI* vsapi)
+{
+    std::vector<const VSFrame*> outChannelSources(static_cast<size_t>(outInfo.format.numChannels), nullptr);
+
+    if (inputFrames.size() != 1)
+    {
+        return outChannelSources;
+    }
+
+    const MixNInputFrames& frames = inputFrames[0];
+    const MixNInput& input = inputs[frames.input];
+
+    int64_t outPosFrmStart = vsutils::frameToFirstSample(outFrmNum);
+    int64_t outPosFrmEnd = outPosFrmStart + outFrmLen;
+
+    // the input has to cover the whole frame unchanged
+    if (input.frameSampleOffsets.left != 0 || input.scale != 1.0 || !frames.frmL || vsapi->getFrameLength(frames.frmL) != outFrmLen ||
+        outPosFrmStart < input.outPosTrimStart || input.outPosTrimEnd < outPosFrmEnd || isFading(input, outPosFrmStart, outPosFrmEnd))
+    {
+        return outChannelSources;
+    }
+
+    for (int ch = 0; ch < outInfo.format.numChannels; ++ch)
+    {
+        // overflowing input samples are handled by writeFrame
+        if (!common::isFrameChannelOverflowing(frames.frmL, ch, outSampleType, vsapi))
+        {
+            outChannelSources[ch] = frames.frmL;
+        }
+    }
+
+    return outChannelSources;
+}
+
+
+void MixN::submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi)
+{
+    overflowTracker.submitFrame(outFrmNum, std::move(frameOverflowStats), core, vsapi);
+}
+
+
+void MixN::flushOverflowStats(VSCore* core, const VSAPI* vsapi)
+{
+    overflowTracker.flush(core, vsapi);
+}
+
+
+void MixN::free(const VSAPI* vsapi)
+{
+    for (common::FrameWindow& window : inputWindows)
+    {
+        window.clear(vsapi);
+    }
+
+    silenceFrames.clear(vsapi);
+
+    for (MixNInput& input : inputs)
+    {
+        delete input.fadeinTrans;
+        delete input.fadeoutTrans;
+
+        vsapi->freeNode(input.audio);
+    }
+}
+
+
+template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t>
+bool MixN::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
+                          const std::vector<MixNInputFrames>& inputFrames, const common::OverflowContext& ofCtx)
+{
+    int64_t outPosFrmStart = vsutils::frameToFirstSample(outFrmNum);
+    int outFrmLen = ofCtx.vsapi->getFrameLength(outFrm);
+
+    int numChannels = outInfo.format.numChannels;
+
+    // sum of all scaled inputs, one frame per channel
+    std::vector<compute_t> mixSamples(static_cast<size_t>(numChannels) * VS_AUDIO_FRAME_SAMPLES, compute_t(0));
+
+    std::array<compute_t, VS_AUDIO_FRAME_SAMPLES> samples;
+
+    // per sample gains of a fading input, the same for all channels
+    std::array<compute_t, VS_AUDIO_FRAME_SAMPLES> gains;
+    FrameScales fadeScales;
+
+    for (const MixNInputFrames& frames : inputFrames)
+    {
+        const MixNInput& input = inputs[frames.input];
+
+        int begin = static_cast<int>(std::clamp<int64_t>(input.outPosTrimStart - outPosFrmStart, 0, outFrmLen));
+        int end = static_cast<int>(std::clamp<int64_t>(input.outPosTrimEnd - outPosFrmStart, 0, outFrmLen));
+
+        if (end <= begin)
+        {
+            continue;
+        }
+
+        const compute_t scale = static_cast<compute_t>(input.scale);
+
+        bool fading = isFading(input, outPosFrmStart + begin, outPosFrmStart + end);
+
+        if (fading)
+        {
+            std::fill(gains.begin() + begin, gains.begin() + end, scale);
+
+            int fadeinEnd = static_cast<int>(std::clamp<int64_t>(input.outPosFadeinEnd - outPosFrmStart, begin, end));
+
+            if (input.fadeinTrans && begin < fadeinEnd)
+            {
+                int64_t fadeinPosBegin = outPosFrmStart + begin - input.outPosTrimStart;
+                input.fadeinTrans->fill(static_cast<double>(fadeinPosBegin), std::span(fadeScales.data() + begin, fadeinEnd - begin));
+
+                for (int s = begin; s < fadeinEnd; ++s)
+                {
+                    gains[s] *= static_cast<compute_t>(fadeScales[s]);
+                }
+            }
+
+            int fadeoutBegin = static_cast<int>(std::clamp<int64_t>(input.outPosFadeoutStart - outPosFrmStart, begin, end));
+
+            if (input.fadeoutTrans && fadeoutBegin < end)
+            {
+                int64_t fadeoutPosBegin = outPosFrmStart + fadeoutBegin - input.outPosFadeoutStart;
+                input.fadeoutTrans->fill(static_cast<double>(fadeoutPosBegin), std::span(fadeScales.data() + fadeoutBegin, end - fadeoutBegin));
+
+                for (int s = fadeoutBegin; s < end; ++s)
+                {
+                    gains[s] *= static_cast<compute_t>(fadeScales[s]);
+                }
+            }
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            if (outChannelSources[ch])
+            {
+                continue;
+            }
+
+            const sample_t* frmLPtr = reinterpret_cast<const sample_t*>(frames.frmL ? ofCtx.vsapi->getReadPtr(frames.frmL, ch) : nullptr);
+            const sample_t* frmRPtr = reinterpret_cast<const sample_t*>(frames.frmR ? ofCtx.vsapi->getReadPtr(frames.frmR, ch) : nullptr);
+
+            common::convOffsetSamplesToCompute<sample_t, IntSampleBits, compute_t>(begin, end, input.frameSampleOffsets, frmLPtr, frmRPtr, samples.data());
+
+            compute_t* mixPtr = mixSamples.data() + static_cast<size_t>(ch) * VS_AUDIO_FRAME_SAMPLES;
+
+            if (fading)
+            {
+                for (int s = begin; s < end; ++s)
+                {
+                    mixPtr[s] += gains[s] * samples[s];
+                }
+            }
+            else
+            {
+                for (int s = begin; s < end; ++s)
+                {
+                    mixPtr[s] += scale * samples[s];
+                }
+            }
+        }
+    }
+
+    // one overflow check and conversion per channel for all inputs
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        if (outChannelSources[ch])
+        {
+            continue;
+        }
+
+        sample_t* outFrmPtr = reinterpret_cast<sample_t*>(ofCtx.vsapi->getWritePtr(outFrm, ch));
+
+        compute_t* mixPtr = mixSamples.data() + static_cast<size_t>(ch) * VS_AUDIO_FRAME_SAMPLES;
+
+        if (!common::safeWriteSamples<sample_t, IntSampleBits, CheckOverflow>(std::span(mixPtr, outFrmLen), outFrmPtr, outPosFrmStart, ch, ofCtx))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool MixN::writeFrame(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
+                      const std::vector<MixNInputFrames>& inputFrames,
+                      common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+{
+    common::OverflowContext ofCtx =
+        { .mode = overflowMode, .log = overflowLog, .funcName = FuncName,
+          .frameCtx = frameCtx, .core = core, .vsapi = vsapi,
+          .stats = overflowStats };
+
+    switch (outSampleType)
+    {
+        case common::SampleType::Int8:
+            return overflowPossible ? writeFrameImpl<int8_t, 8, true>(outFrm, outFrmNum, outChannelSources, inputFrames, ofCtx)
+                                    : writeFrameImpl<int8_t, 8, false>(outFrm, outFrmNum, outChannelSources, inputFrames, ofCtx);
+        case common::SampleType::Int16:
+            return overflowPossible ? writeFrameImpl<int16_t, 16, true>(outFrm, outFrmNum, outChannelSources, inputFrames, ofCtx)
+                                    : writeFrameImpl<int16_t, 16, false>(outFrm, outFrmNum, outChannelSources, inputFrames, ofCtx);
+        case common::SampleType::Int24:
+            return overflowPossible ? writeFrameImpl<int32_t, 24, true>(outFrm, outFrmNum, outChannelSources, inputFrames, ofCtx)
+                                    : writeFrameImpl<int32_t, 24, false>(outFrm, outFrmNum, outChannelSources, inputFrames, ofCtx);
+        case common::SampleType::Int32:
+            return overflowPossible ? writeFrameImpl<int32_t, 32, true>(outFrm, outFrmNum, outChannelSources, inputFrames, ofCtx)
+                                    : writeFrameImpl<int32_t, 32, false>(outFrm, outFrmNum, outChannelSources, inputFrames, ofCtx);
+        case common::SampleType::Float32:
+            if (common::isFloatCompute(precision, outSampleType))
+            {
+                // float rounding errors can overflow, see common::isOverflowPossible
+                return writeFrameImpl<float, 0, true, float>(outFrm, outFrmNum, outChannelSources, inputFrames, ofCtx);
+            }
+            return overflowPossible ? writeFrameImpl<float, 0, true>(outFrm, outFrmNum, outChannelSources, inputFrames, ofCtx)
+                                    : writeFrameImpl<float, 0, false>(outFrm, outFrmNum, outChannelSources, inputFrames, ofCtx);
+        case common::SampleType::Float64:
+            return overflowPossible ? writeFrameImpl<double, 0, true>(outFrm, outFrmNum, outChannelSources, inputFrames, ofCtx)
+                                    : writeFrameImpl<double, 0, false>(outFrm, outFrmNum, outChannelSources, inputFrames, ofCtx);
+        default:
+            return false;
+    }
+}
+
+
+static void VS_CC mixnFree(void* instanceData, VSCore* core, const VSAPI* vsapi)
+{
+    MixN* data = static_cast<MixN*>(instanceData);
+    data->flushOverflowStats(core, vsapi);
+    data->free(vsapi);
+    delete data;
+}
+
+
+static const VSFrame* VS_CC mixnGetFrame(int outFrmNum, int activationReason, void* instanceData, void** frameData, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+{
+    MixN* data = static_cast<MixN*>(instanceData);
+
+    // only the inputs that overlap the output frame are requested
+    std::span<const size_t> activeInputs = data->getActiveInputs(outFrmNum);
+
+    if (activationReason == VSActivationReason::arError)
+    {
+        common::freeWindowFrames(frameData, vsapi);
+        return nullptr;
+    }
+
+    if (activationReason == VSActivationReason::arInitial && activeInputs.empty())
+    {
+        // fully silent output frame: shared frame without any upstream request
+        data->submitOverflowStats(outFrmNum, common::OverflowStats(), core, vsapi);
+        return data->getSilenceFrame(vsutils::getFrameSampleCount(outFrmNum, data->getOutInfo().numSamples), core, vsapi);
+    }
+
+    if (activationReason == VSActivationReason::arInitial)
+    {
+        bool frmRequested = false;
+
+        // input frames that are still in the frame windows are not requested again
+        auto windowFrms = std::make_unique<common::WindowFrames>(activeInputs.size());
+
+        for (size_t i = 0; i < activeInputs.size(); ++i)
+        {
+            size_t input = activeInputs[i];
+            common::OffsetFramePos frmNums = data->outFrameToInputFrames(outFrmNum, input);
+
+            if (common::requestOffsetFrames(frmNums, data->getAudio(input), data->getInputWindow(input), windowFrms->at(i), frameCtx, vsapi))
+            {
+                frmRequested = true;
+            }
+        }
+
+        *frameData = windowFrms.release();
+
+        if (frmRequested)
+        {
+            return nullptr;
+        }
+
+        // all frames are in the frame windows: the frame is returned right away
+    }
+
+    if (activationReason == VSActivationReason::arInitial || activationReason == VSActivationReason::arAllFramesReady)
+    {
+        std::unique_ptr<common::WindowFrames> windowFrms(common::releaseWindowFrames(frameData));
+
+        std::vector<MixNInputFrames> inputFrames;
+        inputFrames.reserve(activeInputs.size());
+
+        const VSFrame* propFrm = nullptr;
+
+        for (size_t i = 0; i < activeInputs.size(); ++i)
+        {
+            size_t input = activeInputs[i];
+            common::OffsetFramePos frmNums = data->outFrameToInputFrames(outFrmNum, input);
+
+            common::OffsetFrames frms = common::getOffsetFrames(frmNums, windowFrms->at(i), data->getAudio(input), data->getInputWindow(input), frameCtx, vsapi);
+
+            MixNInputFrames frames = { .input = input, .frmL = frms.left, .frmR = frms.right };
+
+            if (!propFrm)
+            {
+                propFrm = frames.frmL ? frames.frmL : frames.frmR;
+            }
+
+            inputFrames.push_back(frames);
+        }
+
+        int outFrmLen = vsutils::getFrameSampleCount(outFrmNum, data->getOutInfo().numSamples);
+
+        std::vector<const VSFrame*> outChannelSources = data->getOutChannelSources(outFrmNum, outFrmLen, inputFrames, vsapi);
+
+        VSFrame* outFrm = vsutils::newAudioFrameFromChannelSources(&data->getOutInfo().format, outFrmLen, outChannelSources, propFrm, core, vsapi);
+
+        common::OverflowStats overflowStats;
+
+        bool success = data->writeFrame(outFrm, outFrmNum, outChannelSources, inputFrames, overflowStats, frameCtx, core, vsapi);
+
+        for (const MixNInputFrames& frames : inputFrames)
+        {
+            if (frames.frmL)
+            {
+                vsapi->freeFrame(frames.frmL);
+            }
+
+            if (frames.frmR)
+            {
+                vsapi->freeFrame(frames.frmR);
+            }
+        }
+
+        if (success)
+        {
+            common::updateFrameStatsProps(outFrm, data->isStatsEnabled(), overflowStats, vsapi);
+        }
+
+        data->submitOverflowStats(outFrmNum, std::move(overflowStats), core, vsapi);
+
+        if (success)
+        {
+            return outFrm;
+        }
+
+        vsapi->freeFrame(outFrm);
+    }
+
+    return nullptr;
+}
+
+
+static void freeNodes(const std::vector<VSNode*>& nodes, const VSAPI* vsapi)
+{
+    for (VSNode* node : nodes)
+    {
+        vsapi->freeNode(node);
+    }
+}
+
+
+/**
+ * returns one value per clip
+ * values can be empty (defaultValue for all clips), have one value (for all clips) or one value per clip
+ */
+template <typename T>
+static std::optional<std::vector<T>> toPerClipValues(const char* varName, const std::vector<T>& values, size_t numClips, T defaultValue, VSMap* out, const VSAPI* vsapi)
+{
+    if (values.empty())
+    {
+        return std::vector<T>(numClips, defaultValue);
+    }
+
+    if (values.size() == 1)
+    {
+        return std::vector<T>(numClips, values[0]);
+    }
+
+    if (values.size() != numClips)
+    {
+        std::string errMsg = std::format("{}: {} must have one value or one value per clip ({})", FuncName, varName, numClips);
+        vsapi->mapSetError(out, errMsg.c_str());
+        return std::nullopt;
+    }
+
+    return values;
+}
+
+
+static void VS_CC mixnCreate(const VSMap* in, VSMap* out, void* userData, VSCore* core, const VSAPI* vsapi)
+{
+    // clips:anode[]
+    int numClips = vsapi->mapNumElements(in, "clips");
+    if (numClips < 1)
+    {
+        std::string errMsg = std::format("{}: no clips", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        return;
+    }
+
+    std::vector<VSNode*> audios;
+    audios.reserve(static_cast<size_t>(numClips));
+
+    for (int i = 0; i < numClips; ++i)
+    {
+        audios.push_back(vsapi->mapGetNode(in, "clips", i, nullptr));
+    }
+
+    const VSAudioInfo* audioInfo = vsapi->getAudioInfo(audios[0]);
+
+    for (int i = 1; i < numClips; ++i)
+    {
+        if (!vsh::isSameAudioInfo(audioInfo, vsapi->getAudioInfo(audios[i])))
+        {
+            std::string errMsg = std::format("{}: clips have different audio format", FuncName);
+            vsapi->mapSetError(out, errMsg.c_str());
+            freeNodes(audios, vsapi);
+            return;
+        }
+    }
+
+    // check for supported audio format
+    auto optSampleType = common::getSampleTypeFromAudioFormat(audioInfo->format);
+    if (!optSampleType.has_value())
+    {
+        std::string errMsg = std::format("{}: unsupported audio format", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    size_t clips = audios.size();
+
+    // offsets_samples:int[]:opt
+    // offsets_seconds:float[]:opt
+    // offsets_samples has a higher priority than offsets_seconds
+    std::optional<std::vector<int64_t>> optOffsets = toPerClipValues("offsets",
+        vsmap::getOptSamplesArray("offsets_samples", "offsets_seconds", in, vsapi, {}, audioInfo->sampleRate), clips, DefaultOffset, out, vsapi);
+    if (!optOffsets.has_value())
+    {
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    for (size_t i = 0; i < clips; ++i)
+    {
+        if (optOffsets.value()[i] + vsapi->getAudioInfo(audios[i])->numSamples <= 0)
+        {
+            std::string errMsg = std::format("{}: invalid offset of clip {}: the clip ends before the output start", FuncName, i);
+            vsapi->mapSetError(out, errMsg.c_str());
+            freeNodes(audios, vsapi);
+            return;
+        }
+    }
+
+    // gains:float[]:opt
+    std::optional<std::vector<double>> optGains = toPerClipValues("gains", vsmap::getOptDoubleArray("gains", in, vsapi, {}), clips, DefaultGain, out, vsapi);
+    if (!optGains.has_value())
+    {
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    if (std::any_of(optGains.value().begin(), optGains.value().end(), [](double gain) { return gain < 0; }))
+    {
+        std::string errMsg = std::format("{}: negative gain", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    // relative_gain:int:opt
+    bool relativeGain = vsmap::getOptBool("relative_gain", in, vsapi, DefaultRelativeGain);
+
+    // fadein_samples:int[]:opt
+    // fadein_seconds:float[]:opt
+    // fadein_samples has a higher priority than fadein_seconds
+    std::optional<std::vector<int64_t>> optFadeinSamples = toPerClipValues("fadein",
+        vsmap::getOptSamplesArray("fadein_samples", "fadein_seconds", in, vsapi, {}, audioInfo->sampleRate), clips, DefaultFadeInSamples, out, vsapi);
+    if (!optFadeinSamples.has_value())
+    {
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    if (std::any_of(optFadeinSamples.value().begin(), optFadeinSamples.value().end(), [](int64_t samples) { return samples < 0; }))
+    {
+        std::string errMsg = std::format("{}: negative fadein length", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    // fadeout_samples:int[]:opt
+    // fadeout_seconds:float[]:opt
+    // fadeout_samples has a higher priority than fadeout_seconds
+    std::optional<std::vector<int64_t>> optFadeoutSamples = toPerClipValues("fadeout",
+        vsmap::getOptSamplesArray("fadeout_samples", "fadeout_seconds", in, vsapi, {}, audioInfo->sampleRate), clips, DefaultFadeOutSamples, out, vsapi);
+    if (!optFadeoutSamples.has_value())
+    {
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    if (std::any_of(optFadeoutSamples.value().begin(), optFadeoutSamples.value().end(), [](int64_t samples) { return samples < 0; }))
+    {
+        std::string errMsg = std::format("{}: negative fadeout length", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    // fade_type:data:opt
+    std::optional<common::TransitionType> optFadeType = vsmap::getOptTransitionTypeFromString("fade_type", FuncName, in, out, vsapi, DefaultFadeType);
+    if (!optFadeType.has_value())
+    {
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    // overflow:data:opt
+    std::optional<common::OverflowMode> optOverflowMode = vsmap::getOptOverflowModeFromString("overflow", FuncName, in, out, vsapi, DefaultOverflowMode);
+    if (!optOverflowMode.has_value())
+    {
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    if (optOverflowMode.value() == common::OverflowMode::KeepFloat && !common::isFloatSampleType(optSampleType.value()))
+    {
+        std::string errMsg = std::format("{}: cannot use 'keep_float' overflow mode with an integer sample type", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    // overflow_log:data:opt
+    std::optional<common::OverflowLog> optOverflowLog = vsmap::getOptOverflowLogFromString("overflow_log", FuncName, in, out, vsapi, DefaultOverflowLog);
+    if (!optOverflowLog.has_value())
+    {
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    // stats:int:opt
+    bool stats = vsmap::getOptBool("stats", in, vsapi, DefaultStats);
+
+    // precision:data:opt
+    std::optional<common::Precision> optPrecision = vsmap::getOptPrecisionFromString("precision", FuncName, in, out, vsapi, DefaultPrecision);
+    if (!optPrecision.has_value())
+    {
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    std::vector<VSFilterDependency> deps;
+    deps.reserve(clips);
+
+    for (VSNode* audio : audios)
+    {
+        deps.push_back({ audio, VSRequestPattern::rpGeneral });
+    }
+
+    MixN* data = new MixN(audios, optOffsets.value(), optGains.value(), relativeGain,
+                          optFadeinSamples.value(), optFadeoutSamples.value(), optFadeType.value(),
+                          optOverflowMode.value(), optOverflowLog.value(), stats, optPrecision.value(), vsapi);
+
+    common::logOverflowCheck(FuncName, data->isOverflowPossible(), core, vsapi);
+
+    // fmParallel: overflows are collected per frame and logged in frame order by common::OverflowTracker
+    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), mixnGetFrame, mixnFree, VSFilterMode::fmParallel, deps.data(), static_cast<int>(deps.size()), data, core);
+}
+
+
+void mixnInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi)
+{
+    vspapi->registerFunction(FuncName,
+                             "clips:anode[];"
+                             "offsets_samples:int[]:opt;"
+                             "offsets_seconds:float[]:opt;"
+                             "gains:float[]:opt;"
+                             "relative_gain:int:opt;"
+                             "fadein_samples:int[]:opt;"
+                             "fadein_seconds:float[]:opt;"
+                             "fadeout_samples:int[]:opt;"
+                             "fadeout_seconds:float[]:opt;"
+                             "fade_type:data:opt;"
+                             "overflow:data:opt;"
+                             "overflow_log:data:opt;"
+                             "stats:int:opt;"
+                             "precision:data:opt;",
+                             "return:anode;",
+                             mixnCreate, nullptr, plugin);
+}
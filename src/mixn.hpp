@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+#include "common/framewindow.hpp"
+#include "common/offset.hpp"
+#include "common/overflow.hpp"
+#include "common/precision.hpp"
+#include "common/sampletype.hpp"
+#include "common/silenceframes.hpp"
+#include "common/transition.hpp"
+
+// input clip of MixN
+struct MixNInput
+{
+    VSNode* audio;
+    VSAudioInfo info;
+
+    double scale;
+
+    // output position of the first input sample, can be negative
+    int64_t outPosStart;
+
+    // trimmed to the output: [outPosTrimStart, outPosTrimEnd)
+    int64_t outPosTrimStart;
+    int64_t outPosTrimEnd;
+
+    common::FrameSampleOffsets frameSampleOffsets;
+
+    // fade in at the start and fade out at the end of the trimmed input
+    int64_t outPosFadeinEnd;
+    int64_t outPosFadeoutStart;
+
+    // fade in transition is going from (0, 0) to (fadeinSamples - 1, 1)
+    common::Transition* fadeinTrans;
+
+    // fade out transition is going from (0, 1) to (fadeoutSamples - 1, 0)
+    common::Transition* fadeoutTrans;
+};
+
+
+// frames of an input that overlap an output frame, nullptr if not needed
+struct MixNInputFrames
+{
+    size_t input;
+
+    const VSFrame* frmL;
+    const VSFrame* frmR;
+};
+
+
+class MixN
+{
+public:
+    /**
+     * all parameters except fadeType and relativeGain have one value per input
+     * the output starts at output position 0 and ends with the last input
+     */
+    MixN(std::vector<VSNode*> audios, std::vector<int64_t> offsets, std::vector<double> gains, bool relativeGain,
+         std::vector<int64_t> fadeinSamples, std::vector<int64_t> fadeoutSamples, common::TransitionType fadeType,
+         common::OverflowMode overflowMode, common::OverflowLog overflowLog, bool stats, common::Precision precision,
+         const VSAPI* vsapi);
+
+    const VSAudioInfo& getOutInfo();
+
+    // false if no output sample can overflow, see common::isOverflowPossible
+    bool isOverflowPossible();
+
+    // true if the stats props are written to every output frame, see common/stats.hpp
+    bool isStatsEnabled();
+
+    size_t getNumInputs();
+
+    VSNode* getAudio(size_t input);
+
+    // recently fetched frames of an input, see common::FrameWindow
+    common::FrameWindow& getInputWindow(size_t input);
+
+    // returns a new reference of the shared silent output frame, see common::SilenceFrames
+    const VSFrame* getSilenceFrame(int outFrmLen, VSCore* core, const VSAPI* vsapi);
+
+    // indices of the inputs that overlap the output frame, in input order
+    std::span<const size_t> getActiveInputs(int outFrmNum);
+
+    common::OffsetFramePos outFrameToInputFrames(int outFrmNum, size_t input);
+
+    /**
+     * returns the source frame of each output channel that is taken over unchanged (for newAudioFrame2)
+     * a channel is taken from an input frame if that input is the only active input of the frame,
+     * frame aligned, not scaled and not faded
+     * nullptr: the channel has to be written by writeFrame
+     */
+    std::vector<const VSFrame*> getOutChannelSources(int outFrmNum, int outFrmLen, const std::vector<MixNInputFrames>& inputFrames, const VSAPI* vsapi);
+
+    void submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi);
+
+    void flushOverflowStats(VSCore* core, const VSAPI* vsapi);
+
+    void free(const VSAPI* vsapi);
+
+    // writes all channels without an out channel source
+    bool writeFrame(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
+                    const std::vector<MixNInputFrames>& inputFrames,
+                    common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
+
+private:
+    std::vector<MixNInput> inputs;
+
+    // one frame window per input
+    std::vector<common::FrameWindow> inputWindows;
+
+    common::SilenceFrames silenceFrames;
+
+    VSAudioInfo outInfo;
+    common::SampleType outSampleType;
+
+    common::OverflowMode overflowMode;
+    common::OverflowLog overflowLog;
+
+    common::OverflowTracker overflowTracker;
+
+    // selects the writeFrameImpl specialization with or without overflow checks
+    bool overflowPossible;
+
+    bool stats;
+
+    // compute type of float samples, see common::Precision
+    common::Precision precision;
+
+    // inputs that overlap the output frame n: activeInputs[activeInputsBegin[n], activeInputsBegin[n + 1])
+    std::vector<size_t> activeInputs;
+    std::vector<size_t> activeInputsBegin;
+
+    using FrameScales = std::array<double, VS_AUDIO_FRAME_SAMPLES>;
+
+    void initActiveInputs();
+
+    // true if the input has a fade in or fade out inside the output frame range [outPosFrmStart, outPosFrmEnd)
+    bool isFading(const MixNInput& input, int64_t outPosFrmStart, int64_t outPosFrmEnd);
+
+    template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t = double>
+    bool writeFrameImpl(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
+                        const std::vector<MixNInputFrames>& inputFrames, const common::OverflowContext& ofCtx);
+};
+
+void mixnInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi);
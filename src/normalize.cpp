@@ -1,15 +1,20 @@
 // SPDX-License-Identifier: MIT
 
 #include <algorithm>
+#include <array>
 #include <climits>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <format>
 #include <limits>
+#include <map>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "VapourSynth4.h"
@@ -18,45 +23,103 @@
 #include "normalize.hpp"
 #include "common/overflow.hpp"
 #include "common/peak.hpp"
+#include "common/peakcache.hpp"
+#include "common/precision.hpp"
 #include "common/sampletype.hpp"
+#include "common/stats.hpp"
+#include "simd/fixedgain.hpp"
 #include "utils/sample.hpp"
 #include "utils/vector.hpp"
 #include "vsmap/vsmap.hpp"
 #include "vsmap/vsmap_common.hpp"
 #include "vsutils/audio.hpp"
-#include "vsutils/bitshift.hpp"
 
 constexpr const char* FuncName = "Normalize";
 
 constexpr double DefaultNormPeak = 1;
+constexpr int DefaultRequests = 0;
 constexpr common::OverflowMode DefaultOverflowMode = common::OverflowMode::Error;
 constexpr common::OverflowLog DefaultOverflowLog = common::OverflowLog::Once;
+constexpr bool DefaultStats = false;
+constexpr bool DefaultTruePeak = false;
+constexpr bool DefaultUseStats = false;
+constexpr bool DefaultBackgroundScan = false;
+constexpr NormalizeFixedPoint DefaultFixedPoint = NormalizeFixedPoint::Off;
+constexpr common::Precision DefaultPrecision = common::Precision::Double;
+
+
+// unfinished background scans of all Normalize filters per core
+// each one can block a thread in normalizeGetFrame (fmParallelRequests: one thread per filter)
+static std::mutex backgroundScanMutex;
+static std::map<VSCore*, int> backgroundScanCount;
+
+
+// false if numThreads - 1 scans are already running: at least one thread stays free to read the frames of the scans
+static bool tryAcquireBackgroundScan(VSCore* core, int numThreads)
+{
+    std::lock_guard<std::mutex> lock(backgroundScanMutex);
+
+    auto it = backgroundScanCount.find(core);
+    int count = it != backgroundScanCount.end() ? it->second : 0;
+
+    if (numThreads - 1 <= count)
+    {
+        return false;
+    }
+
+    backgroundScanCount[core] = count + 1;
+    return true;
+}
+
+
+static void releaseBackgroundScan(VSCore* core)
+{
+    std::lock_guard<std::mutex> lock(backgroundScanMutex);
+
+    if (--backgroundScanCount[core] == 0)
+    {
+        backgroundScanCount.erase(core);
+    }
+}
 
 
 Normalize::Normalize(VSNode* _audio, const VSAudioInfo* _audioInfo, double _outNormPeak,
-                     bool lowerOnly, std::vector<int> _editChannels,
-                     common::OverflowMode _overflowMode, common::OverflowLog _overflowLog,
-                     const VSAPI* vsapi) :
-    audio(_audio), audioInfo(*_audioInfo), editChannels(_editChannels), overflowMode(_overflowMode), overflowLog(_overflowLog)
+                     bool _lowerOnly, std::vector<int> _editChannels, NormalizeFixedPoint _fixedPoint,
+                     common::OverflowMode _overflowMode, common::OverflowLog _overflowLog, bool _stats, common::Precision _precision,
+                     int requests, bool truePeak, bool useStats, bool backgroundScan, const std::string& cacheDir, VSCore* core, const VSAPI* vsapi) :
+    audio(_audio), audioInfo(*_audioInfo), lowerOnly(_lowerOnly), fixedPoint(_fixedPoint), editChannels(_editChannels), overflowMode(_overflowMode), overflowLog(_overflowLog), stats(_stats), precision(_precision)
 {
     outSampleType = common::getSampleTypeFromAudioFormat(audioInfo.format).value();
 
     outNormPeak = common::adjustNormPeak(_outNormPeak, outSampleType);
 
-    // blocking operation
-    double inNormPeak = common::findPeak(audio, &audioInfo, editChannels, true, vsapi);
-
-    if (lowerOnly && inNormPeak <= outNormPeak)
+    if (backgroundScan)
     {
-        gain = 1.0;
+        // the gain is set by waitForGain once the first frame is requested
+        inNormPeakScan = std::async(std::launch::async, [this, requests, truePeak, useStats, cacheDir, core, vsapi]
+        {
+            common::PeakScanControl control = { .progressFuncName = FuncName, .cancel = &cancelPeakScan };
+            double inNormPeak = common::findPeakCached(audio, &audioInfo, editChannels, true, truePeak, useStats, requests, control, cacheDir, FuncName, core, vsapi);
+
+            // a thread waiting for this scan is not blocked anymore
+            releaseBackgroundScan(core);
+
+            return inNormPeak;
+        });
     }
     else
     {
-        // !lowerOnly || outNormPeak < inNormPeak
-        gain = outNormPeak / inNormPeak;
+        // blocking operation
+        initGain(common::findPeakCached(audio, &audioInfo, editChannels, true, truePeak, useStats, requests, common::PeakScanControl(), cacheDir, FuncName, core, vsapi));
     }
 
     copyChannels = utils::vectorInvert(editChannels, 0, audioInfo.format.numChannels);
+
+    // all edit channel samples are clamped to outNormPeak
+    // also with float compute: outNormPeak <= 1 is exact as float
+    overflowPossible = common::isOverflowPossible(outNormPeak, outSampleType);
+
+    overflowTracker.init(FuncName, overflowMode, overflowLog, common::isFloatSampleType(outSampleType), audioInfo.numFrames);
 }
 
 
@@ -71,69 +134,149 @@ const VSAudioInfo& Normalize::getOutInfo()
 }
 
 
-void Normalize::resetOverflowStats()
+bool Normalize::isOverflowPossible()
+{
+    return overflowPossible;
+}
+
+
+bool Normalize::isStatsEnabled()
+{
+    return stats;
+}
+
+
+bool Normalize::hasBackgroundScan()
 {
-    overflowStats = { .count = 0, .peak = 0.0 };
+    return inNormPeakScan.valid();
+}
+
+
+void Normalize::waitForGain()
+{
+    std::call_once(gainInitFlag, [this]
+    {
+        if (inNormPeakScan.valid())
+        {
+            initGain(inNormPeakScan.get());
+        }
+    });
 }
 
 
-void Normalize::logOverflowStats(VSCore* core, const VSAPI* vsapi)
+void Normalize::initGain(double inNormPeak)
 {
-    if (0 < overflowStats.count)
+    if (lowerOnly && inNormPeak <= outNormPeak)
+    {
+        gain = 1.0;
+    }
+    else
+    {
+        // !lowerOnly || outNormPeak < inNormPeak
+        gain = outNormPeak / inNormPeak;
+    }
+
+    unityGain = gain == 1.0 && inNormPeak <= outNormPeak;
+
+    if (fixedPoint != NormalizeFixedPoint::Off)
+    {
+        fixedGain = simd::makeFixedGain(outSampleType, gain, outNormPeak, fixedPoint == NormalizeFixedPoint::Exact);
+    }
+}
+
+
+std::vector<const VSFrame*> Normalize::getOutChannelSources(const VSFrame* inFrm, const VSAPI* vsapi)
+{
+    std::vector<const VSFrame*> outChannelSources(static_cast<size_t>(audioInfo.format.numChannels), nullptr);
+
+    for (const int& ch : copyChannels)
+    {
+        outChannelSources[ch] = inFrm;
+    }
+
+    if (!unityGain)
+    {
+        return outChannelSources;
+    }
+
+    for (const int& ch : editChannels)
     {
-        overflowStats.logVS(FuncName, overflowMode, isFloatSampleType(outSampleType), core, vsapi);
+        // all samples are inside [-outNormPeak, outNormPeak] and convert back to the same value,
+        // except overflowing samples (integer minimum or float outside [-1, 1]) which are handled by writeFrame
+        if (!common::isFrameChannelOverflowing(inFrm, ch, outSampleType, vsapi))
+        {
+            outChannelSources[ch] = inFrm;
+        }
     }
+
+    return outChannelSources;
+}
+
+
+void Normalize::submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi)
+{
+    overflowTracker.submitFrame(outFrmNum, std::move(frameOverflowStats), core, vsapi);
+}
+
+
+void Normalize::flushOverflowStats(VSCore* core, const VSAPI* vsapi)
+{
+    overflowTracker.flush(core, vsapi);
 }
 
 
 void Normalize::free(const VSAPI* vsapi)
 {
+    if (inNormPeakScan.valid())
+    {
+        // no frame was requested, the scan may still be running
+        cancelPeakScan = true;
+        inNormPeakScan.wait();
+    }
+
     vsapi->freeNode(audio);
 }
 
 
 
-template <typename sample_t, size_t IntSampleBits>
+template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t>
 bool Normalize::writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStart, int outFrmLen, const VSFrame* inFrm, const common::OverflowContext& ofCtx)
 {
     sample_t* outFrmPtr = reinterpret_cast<sample_t*>(ofCtx.vsapi->getWritePtr(outFrm, ch));
 
     const sample_t* inFrmPtr = reinterpret_cast<const sample_t*>(ofCtx.vsapi->getReadPtr(inFrm, ch));
 
-    constexpr vsutils::BitShift bitShift = vsutils::getSampleBitShift<sample_t, IntSampleBits>();
-
-    for (int s = 0; s < outFrmLen; ++s)
+    if constexpr (std::is_integral_v<sample_t>)
     {
-        int64_t outPos = outPosFrmStart + s;
-
-        sample_t inSample = inFrmPtr[s];
-
-        if constexpr (bitShift.required)
+        if (fixedGain.has_value())
         {
-            inSample >>= bitShift.count;
+            // no overflow possible (outNormPeak <= 1, see simd::makeFixedGain)
+            simd::applyFixedGain<sample_t, IntSampleBits>(inFrmPtr, outFrmPtr, outFrmLen, fixedGain.value());
+            return true;
         }
+    }
 
-        double scaledSample = std::clamp(gain * utils::convSampleToDouble<sample_t, IntSampleBits>(inSample), -outNormPeak, outNormPeak);
+    std::array<compute_t, VS_AUDIO_FRAME_SAMPLES> samples;
 
-        if (!common::safeWriteSample<sample_t, IntSampleBits>(scaledSample, outFrmPtr, s, outPos, ch, ofCtx, overflowStats))
-        {
-            // overflow and error
-            return false;
-        }
+    common::convSamplesToCompute<sample_t, IntSampleBits, compute_t>(inFrmPtr, samples.data(), outFrmLen);
+
+    const compute_t computeGain = static_cast<compute_t>(gain);
+    const compute_t peak = static_cast<compute_t>(outNormPeak);
+
+    for (int s = 0; s < outFrmLen; ++s)
+    {
+        samples[s] = std::clamp(computeGain * samples[s], -peak, peak);
     }
 
-    return true;
+    return common::safeWriteSamples<sample_t, IntSampleBits, CheckOverflow>(std::span(samples.data(), outFrmLen), outFrmPtr, outPosFrmStart, ch, ofCtx);
 }
 
 
-template <typename sample_t, size_t IntSampleBits>
-bool Normalize::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, const common::OverflowContext& ofCtx)
+template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t>
+bool Normalize::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, const std::vector<const VSFrame*>& outChannelSources,
+                               const common::OverflowContext& ofCtx)
 {
-    // copy channels
-    for (const int& ch : copyChannels)
-    {
-        vsutils::copyFrameChannel(outFrm, ch, inFrm, ch, getOutInfo().format.bytesPerSample, ofCtx.vsapi);
-    }
+    // copy channels and unchanged edit channels are already set by newAudioFrame2
 
     // edit channels
     int64_t outPosFrmStart = vsutils::frameToFirstSample(outFrmNum);
@@ -141,7 +284,12 @@ bool Normalize::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* in
 
     for (const int& ch : editChannels)
     {
-        if (!writeFrameChannel<sample_t, IntSampleBits>(ch, outFrm, outPosFrmStart, outFrmLen, inFrm, ofCtx))
+        if (outChannelSources[ch])
+        {
+            continue;
+        }
+
+        if (!writeFrameChannel<sample_t, IntSampleBits, CheckOverflow, compute_t>(ch, outFrm, outPosFrmStart, outFrmLen, inFrm, ofCtx))
         {
             return false;
         }
@@ -151,27 +299,39 @@ bool Normalize::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* in
 
 
 
-bool Normalize::writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm,
-                           VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+bool Normalize::writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, const std::vector<const VSFrame*>& outChannelSources,
+                           common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
 {
     common::OverflowContext ofCtx =
         { .mode = overflowMode, .log = overflowLog, .funcName = FuncName,
-          .frameCtx = frameCtx, .core = core, .vsapi = vsapi };
+          .frameCtx = frameCtx, .core = core, .vsapi = vsapi,
+          .stats = overflowStats };
 
     switch (outSampleType)
     {
         case common::SampleType::Int8:
-            return writeFrameImpl<int8_t, 8>(outFrm, outFrmNum, inFrm, ofCtx);
+            return overflowPossible ? writeFrameImpl<int8_t, 8, true>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx)
+                                    : writeFrameImpl<int8_t, 8, false>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx);
         case common::SampleType::Int16:
-            return writeFrameImpl<int16_t, 16>(outFrm, outFrmNum, inFrm, ofCtx);
+            return overflowPossible ? writeFrameImpl<int16_t, 16, true>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx)
+                                    : writeFrameImpl<int16_t, 16, false>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx);
         case common::SampleType::Int24:
-            return writeFrameImpl<int32_t, 24>(outFrm, outFrmNum, inFrm, ofCtx);
+            return overflowPossible ? writeFrameImpl<int32_t, 24, true>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx)
+                                    : writeFrameImpl<int32_t, 24, false>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx);
         case common::SampleType::Int32:
-            return writeFrameImpl<int32_t, 32>(outFrm, outFrmNum, inFrm, ofCtx);
+            return overflowPossible ? writeFrameImpl<int32_t, 32, true>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx)
+                                    : writeFrameImpl<int32_t, 32, false>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx);
         case common::SampleType::Float32:
-            return writeFrameImpl<float, 0>(outFrm, outFrmNum, inFrm, ofCtx);
+            if (common::isFloatCompute(precision, outSampleType))
+            {
+                return overflowPossible ? writeFrameImpl<float, 0, true, float>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx)
+                                        : writeFrameImpl<float, 0, false, float>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx);
+            }
+            return overflowPossible ? writeFrameImpl<float, 0, true>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx)
+                                    : writeFrameImpl<float, 0, false>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx);
         case common::SampleType::Float64:
-            return writeFrameImpl<double, 0>(outFrm, outFrmNum, inFrm, ofCtx);
+            return overflowPossible ? writeFrameImpl<double, 0, true>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx)
+                                    : writeFrameImpl<double, 0, false>(outFrm, outFrmNum, inFrm, outChannelSources, ofCtx);
         default:
             return false;
     }
@@ -181,8 +341,7 @@ bool Normalize::writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm,
 static void VS_CC normalizeFree(void* instanceData, VSCore* core, const VSAPI* vsapi)
 {
     Normalize* data = static_cast<Normalize*>(instanceData);
-    // skip logging since the total number of overflows is unreliable
-    // data->logNumOverflows(core, vsapi);
+    data->flushOverflowStats(core, vsapi);
     data->free(vsapi);
     delete data;
 }
@@ -201,27 +360,37 @@ static const VSFrame* VS_CC normalizeGetFrame(int outFrmNum, int activationReaso
 
     if (activationReason == VSActivationReason::arAllFramesReady)
     {
-        if (outFrmNum == 0)
-        {
-            data->resetOverflowStats();
-        }
+        // blocking until the background peak scan is finished
+        data->waitForGain();
 
         const VSFrame* inFrm = vsapi->getFrameFilter(outFrmNum, data->getAudio(), frameCtx);
 
+        std::vector<const VSFrame*> outChannelSources = data->getOutChannelSources(inFrm, vsapi);
+
+        if (std::all_of(outChannelSources.begin(), outChannelSources.end(), [](const VSFrame* src) { return src; }))
+        {
+            // all channels unchanged
+            data->submitOverflowStats(outFrmNum, common::OverflowStats(), core, vsapi);
+            return common::passFrameStatsProps(inFrm, data->isStatsEnabled(), core, vsapi);
+        }
+
         int inFrmLen = vsapi->getFrameLength(inFrm);
 
-        VSFrame* outFrm = vsapi->newAudioFrame(&data->getOutInfo().format, inFrmLen, inFrm, core);
+        VSFrame* outFrm = vsutils::newAudioFrameFromChannelSources(&data->getOutInfo().format, inFrmLen, outChannelSources, inFrm, core, vsapi);
+
+        common::OverflowStats overflowStats;
 
-        bool success = data->writeFrame(outFrm, outFrmNum, inFrm, frameCtx, core, vsapi);
+        bool success = data->writeFrame(outFrm, outFrmNum, inFrm, outChannelSources, overflowStats, frameCtx, core, vsapi);
 
         vsapi->freeFrame(inFrm);
 
-        if (outFrmNum == data->getOutInfo().numFrames - 1)
+        if (success)
         {
-            // last frame
-            data->logOverflowStats(core, vsapi);
+            common::updateFrameStatsProps(outFrm, data->isStatsEnabled(), overflowStats, vsapi);
         }
 
+        data->submitOverflowStats(outFrmNum, std::move(overflowStats), core, vsapi);
+
         if (success)
         {
             return outFrm;
@@ -275,6 +444,9 @@ static void VS_CC normalizeCreate(const VSMap* in, VSMap* out, void* userData, V
     // lower_only:int:opt
     bool lowerOnly = vsmap::getOptBool("lower_only", in, vsapi, false);
 
+    // true_peak:int:opt
+    bool truePeak = vsmap::getOptBool("true_peak", in, vsapi, DefaultTruePeak);
+
     // channels:int[]:opt
     std::vector<int> defaultChannels;
     std::optional<std::vector<int>> optChannels = vsmap::getOptChannels("channels", FuncName, in, out, vsapi, defaultChannels, audioInfo->format.numChannels);
@@ -308,12 +480,71 @@ static void VS_CC normalizeCreate(const VSMap* in, VSMap* out, void* userData, V
         return;
     }
 
-    Normalize* data = new Normalize(audio, audioInfo, outNormPeak, lowerOnly, optChannels.value(), optOverflowMode.value(), optOverflowLog.value(), vsapi);
+    // requests:int:opt
+    int requests = vsmap::getOptInt("requests", in, vsapi, DefaultRequests);
+    if (requests < 0)
+    {
+        std::string errMsg = std::format("{}: negative requests", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // cache_path:data:opt
+    std::string cacheDir = vsmap::getOptString("cache_path", in, vsapi, "");
+
+    // stats:int:opt
+    bool stats = vsmap::getOptBool("stats", in, vsapi, DefaultStats);
+
+    // use_stats:int:opt
+    bool useStats = vsmap::getOptBool("use_stats", in, vsapi, DefaultUseStats);
+
+    // background_scan:int:opt
+    bool backgroundScan = vsmap::getOptBool("background_scan", in, vsapi, DefaultBackgroundScan);
+
+    // fixed_point:data:opt
+    std::optional<NormalizeFixedPoint> optFixedPoint = vsmap::getOptValueFromString<NormalizeFixedPoint>("fixed_point", FuncName, in, out, vsapi,
+        { { "off", NormalizeFixedPoint::Off }, { "fast", NormalizeFixedPoint::Fast }, { "exact", NormalizeFixedPoint::Exact } }, DefaultFixedPoint);
+    if (!optFixedPoint.has_value())
+    {
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // precision:data:opt
+    std::optional<common::Precision> optPrecision = vsmap::getOptPrecisionFromString("precision", FuncName, in, out, vsapi, DefaultPrecision);
+    if (!optPrecision.has_value())
+    {
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    VSCoreInfo coreInfo;
+    vsapi->getCoreInfo(core, &coreInfo);
+
+    // the slot is released by the scan thread once the peak is found (or the scan is cancelled)
+    if (backgroundScan && !tryAcquireBackgroundScan(core, coreInfo.numThreads))
+    {
+        // the threads waiting for the scans would block all threads that can read the frames of the scans
+        std::string warnMsg = std::format("{}: background_scan allows at most {} running scans with {} threads, scanning the peak now",
+                                          FuncName, std::max(coreInfo.numThreads - 1, 0), coreInfo.numThreads);
+        vsapi->logMessage(VSMessageType::mtWarning, warnMsg.c_str(), core);
+        backgroundScan = false;
+    }
+
+    Normalize* data = new Normalize(audio, audioInfo, outNormPeak, lowerOnly, optChannels.value(), optFixedPoint.value(), optOverflowMode.value(), optOverflowLog.value(), stats, optPrecision.value(),
+                                    requests, truePeak, useStats, backgroundScan, cacheDir, core, vsapi);
 
     VSFilterDependency deps[] = {{ audio, rpStrictSpatial }};
 
-    // fmParallelRequests: strict sequential frame requests for overflow logging
-    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), normalizeGetFrame, normalizeFree, VSFilterMode::fmParallelRequests, deps, 1, data, core);
+    common::logOverflowCheck(FuncName, data->isOverflowPossible(), core, vsapi);
+
+    // fmParallel: overflows are collected per frame and logged in frame order by common::OverflowTracker
+    // fmParallelRequests with a background scan: only one thread at a time waits for the scan in arAllFramesReady,
+    // the other threads keep reading the frames of the scan
+    VSFilterMode filterMode = data->hasBackgroundScan() ? VSFilterMode::fmParallelRequests : VSFilterMode::fmParallel;
+
+    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), normalizeGetFrame, normalizeFree, filterMode, deps, 1, data, core);
 }
 
 
@@ -323,9 +554,17 @@ void normalizeInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi)
                              "clip:anode;"
                              "peak:float:opt;"
                              "lower_only:int:opt;"
+                             "true_peak:int:opt;"
                              "channels:int[]:opt;"
                              "overflow:data:opt;"
-                             "overflow_log:data:opt;",
+                             "overflow_log:data:opt;"
+                             "requests:int:opt;"
+                             "cache_path:data:opt;"
+                             "stats:int:opt;"
+                             "use_stats:int:opt;"
+                             "background_scan:int:opt;"
+                             "fixed_point:data:opt;"
+                             "precision:data:opt;",
                              "return:anode;",
                              normalizeCreate, nullptr, plugin);
 }
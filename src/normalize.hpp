@@ -2,32 +2,71 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
 #include <vector>
 
 #include "VapourSynth4.h"
 
 #include "common/overflow.hpp"
 #include "common/sampletype.hpp"
+#include "simd/fixedgain.hpp"
+
+// integer sample path of the edit channels
+enum class NormalizeFixedPoint
+{
+    // convert to double, scale and convert back
+    Off,
+    // fixed point gain, can differ by 1 from the double path for samples close to a rounding tie
+    Fast,
+    // fixed point gain, samples close to a rounding tie use the double path (same result as Off)
+    Exact,
+};
+
 
 class Normalize
 {
 public:
-    Normalize(VSNode* audio, const VSAudioInfo* audioInfo, double outNormPeak, bool lowerOnly, std::vector<int> editChannels,
-              common::OverflowMode overflowMode, common::OverflowLog overflowLog, const VSAPI* vsapi);
+    Normalize(VSNode* audio, const VSAudioInfo* audioInfo, double outNormPeak, bool lowerOnly, std::vector<int> editChannels, NormalizeFixedPoint fixedPoint,
+              common::OverflowMode overflowMode, common::OverflowLog overflowLog, bool stats, common::Precision precision,
+              int requests, bool truePeak, bool useStats, bool backgroundScan, const std::string& cacheDir, VSCore* core, const VSAPI* vsapi);
 
     VSNode* getAudio();
 
     const VSAudioInfo& getOutInfo();
 
-    void resetOverflowStats();
+    // false if no output sample can overflow, see common::isOverflowPossible
+    bool isOverflowPossible();
+
+    // true if the stats props are written to every output frame, see common/stats.hpp
+    bool isStatsEnabled();
+
+    // true if the peak is scanned in the background, see waitForGain
+    bool hasBackgroundScan();
+
+    // blocks until the background peak scan is finished and the gain is set, returns immediately afterwards or without background scan
+    void waitForGain();
+
+    /**
+     * returns the source frame of each output channel that is taken over unchanged (for newAudioFrame2)
+     * copy channels are taken from inFrm, edit channels too if the gain is 1 and no sample would change
+     * nullptr: the channel has to be written by writeFrame
+     */
+    std::vector<const VSFrame*> getOutChannelSources(const VSFrame* inFrm, const VSAPI* vsapi);
+
+    void submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi);
 
-    void logOverflowStats(VSCore* core, const VSAPI* vsapi);
+    void flushOverflowStats(VSCore* core, const VSAPI* vsapi);
 
     void free(const VSAPI* vsapi);
 
-    bool writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm,
-                    VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
+    // writes all channels without an out channel source
+    bool writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, const std::vector<const VSFrame*>& outChannelSources,
+                    common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
 
 private:
     VSNode* audio;
@@ -37,21 +76,48 @@ private:
 
     double outNormPeak;
 
+    bool lowerOnly;
+
+    // set by initGain
     double gain;
 
+    // gain is 1 and the clamping to outNormPeak has no effect
+    bool unityGain;
+
+    NormalizeFixedPoint fixedPoint;
+
+    // set by initGain, std::nullopt: double path (float sample type, fixed point off or not applicable, see simd::makeFixedGain)
+    std::optional<simd::FixedGain> fixedGain;
+
     std::vector<int> editChannels;
     std::vector<int> copyChannels;
 
     common::OverflowMode overflowMode;
     common::OverflowLog overflowLog;
 
-    common::OverflowStats overflowStats = { .count = 0, .peak = 0.0 };
+    common::OverflowTracker overflowTracker;
+
+    // selects the writeFrameImpl specialization with or without overflow checks
+    bool overflowPossible;
+
+    bool stats;
+
+    // compute type of float samples, see common::Precision
+    common::Precision precision;
+
+    // normalized input peak of the background scan, invalid after waitForGain or without background scan
+    std::future<double> inNormPeakScan;
+    std::atomic<bool> cancelPeakScan = false;
+    std::once_flag gainInitFlag;
+
+    void initGain(double inNormPeak);
 
-    template <typename sample_t, size_t IntSampleBits>
+    template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t = double>
     bool writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStart, int outFrmLen, const VSFrame* inFrm, const common::OverflowContext& ofCtx);
 
-    template <typename sample_t, size_t IntSampleBits>
-    bool writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, const common::OverflowContext& ofCtx);
+    template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t = double>
+    bool writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, const std::vector<const VSFrame*>& outChannelSources,
+                        const common::OverflowContext& ofCtx);
 };
 
 
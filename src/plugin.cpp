@@ -2,22 +2,42 @@
 
 #include "VapourSynth4.h"
 
+#include "chain.hpp"
 #include "config.hpp"
 #include "convert.hpp"
 #include "crossfade.hpp"
 #include "delay.hpp"
 #include "fadein.hpp"
 #include "fadeout.hpp"
+#include "findloudness.hpp"
 #include "findpeak.hpp"
+#include "loudnorm.hpp"
 #include "mix.hpp"
+#include "mixn.hpp"
 #include "normalize.hpp"
+#include "resample.hpp"
 #include "sinetone.hpp"
+#include "splice.hpp"
 #include "setsamples.hpp"
+#include "stats.hpp"
+#include "simd/fixedgain.hpp"
+#include "simd/minmax.hpp"
+#include "simd/resample.hpp"
+#include "simd/sampleconv.hpp"
+#include "simd/truepeak.hpp"
 
 VS_EXTERNAL_API(void) VapourSynthPluginInit2(VSPlugin* plugin, const VSPLUGINAPI* vspapi)
 {
     vspapi->configPlugin("com.ropagr.atools", "atools", "basic audio functions", VS_MAKE_VERSION(0, 1), VAPOURSYNTH_API_VERSION, 0, plugin);
 
+    simd::initSampleConvKernels();
+    simd::initFixedGainKernels();
+    simd::initMinMaxKernels();
+    simd::initTruePeakKernels();
+    simd::initResampleKernels();
+
+    chainInit(plugin, vspapi);
+
     convertInit(plugin, vspapi);
 
     crossfadeInit(plugin, vspapi);
@@ -26,16 +46,28 @@ VS_EXTERNAL_API(void) VapourSynthPluginInit2(VSPlugin* plugin, const VSPLUGINAPI
 
     fadeoutInit(plugin, vspapi);
 
+    findloudnessInit(plugin, vspapi);
+
     findpeakInit(plugin, vspapi);
 
     delayInit(plugin, vspapi);
 
+    loudnormInit(plugin, vspapi);
+
     mixInit(plugin, vspapi);
 
+    mixnInit(plugin, vspapi);
+
     normalizeInit(plugin, vspapi);
 
+    resampleInit(plugin, vspapi);
+
     sinetoneInit(plugin, vspapi);
 
+    spliceInit(plugin, vspapi);
+
+    statsInit(plugin, vspapi);
+
     // undocumented function, only for debugging
     setsamplesInit(plugin, vspapi);
 }
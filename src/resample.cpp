@@ -0,0 +1,446 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "VapourSynth4.h"
+#include "VSHelper4.h"
+
+#include "resample.hpp"
+#include "common/framewindow.hpp"
+#include "common/offset.hpp"
+#include "common/overflow.hpp"
+#include "common/resampler.hpp"
+#include "common/sampletype.hpp"
+#include "common/stats.hpp"
+#include "simd/sampleconv.hpp"
+#include "vsmap/vsmap.hpp"
+#include "vsmap/vsmap_common.hpp"
+#include "vsutils/audio.hpp"
+
+constexpr const char* FuncName = "Resample";
+
+constexpr int DefaultTaps = 64;
+constexpr common::OverflowMode DefaultOverflowMode = common::OverflowMode::Error;
+constexpr common::OverflowLog DefaultOverflowLog = common::OverflowLog::Once;
+constexpr bool DefaultStats = false;
+
+
+Resample::Resample(VSNode* _audio, const VSAudioInfo* _audioInfo, int outSampleRate, int taps,
+                   common::OverflowMode _overflowMode, common::OverflowLog _overflowLog, bool _stats) :
+    audio(_audio), inInfo(*_audioInfo), overflowMode(_overflowMode), overflowLog(_overflowLog), stats(_stats)
+{
+    outSampleType = common::getSampleTypeFromAudioFormat(inInfo.format).value();
+
+    common::ResampleRatio ratio = common::getResampleRatio(inInfo.sampleRate, outSampleRate);
+
+    outInfo = inInfo;
+    outInfo.sampleRate = outSampleRate;
+    outInfo.numSamples = common::getResampledLength(inInfo.numSamples, ratio);
+    outInfo.numFrames = vsutils::samplesToFrames(outInfo.numSamples);
+
+    if (outSampleRate != inInfo.sampleRate)
+    {
+        resampler.emplace(ratio, taps);
+    }
+
+    // an input frame is read by every output frame that overlaps with it or with the filter length around it
+    audioWindow.init(resampler.has_value() ? common::FrameWindow::DefaultCapacity : 0);
+
+    overflowTracker.init(FuncName, overflowMode, overflowLog, common::isFloatSampleType(outSampleType), outInfo.numFrames);
+}
+
+
+VSNode* Resample::getAudio()
+{
+    return audio;
+}
+
+
+common::FrameWindow& Resample::getAudioWindow()
+{
+    return audioWindow;
+}
+
+
+const VSAudioInfo& Resample::getOutInfo()
+{
+    return outInfo;
+}
+
+
+bool Resample::isStatsEnabled()
+{
+    return stats;
+}
+
+
+bool Resample::isPassthrough()
+{
+    return !resampler.has_value();
+}
+
+
+common::SampleRange Resample::getInSampleRange(int outFrmNum)
+{
+    int64_t outPosFrmStart = vsutils::frameToFirstSample(outFrmNum);
+    int outFrmLen = vsutils::getFrameSampleCount(outFrmNum, outInfo.numSamples);
+
+    common::SampleRange inRange = resampler->getInputRange(outPosFrmStart, outPosFrmStart + outFrmLen);
+
+    return { .begin = std::max<int64_t>(inRange.begin, 0), .end = std::min(inRange.end, inInfo.numSamples) };
+}
+
+
+std::vector<common::OffsetFramePos> Resample::outFrameToInFrames(int outFrmNum)
+{
+    std::vector<common::OffsetFramePos> inFrmNums;
+
+    common::SampleRange inRange = getInSampleRange(outFrmNum);
+    if (inRange.end <= inRange.begin)
+    {
+        return inFrmNums;
+    }
+
+    int firstInFrm = vsutils::sampleToFrame(inRange.begin);
+    int lastInFrm = vsutils::sampleToFrame(inRange.end - 1);
+
+    for (int frm = firstInFrm; frm <= lastInFrm; frm += 2)
+    {
+        inFrmNums.push_back({ .left = frm, .right = frm < lastInFrm ? frm + 1 : -1 });
+    }
+
+    return inFrmNums;
+}
+
+
+void Resample::submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi)
+{
+    overflowTracker.submitFrame(outFrmNum, std::move(frameOverflowStats), core, vsapi);
+}
+
+
+void Resample::flushOverflowStats(VSCore* core, const VSAPI* vsapi)
+{
+    overflowTracker.flush(core, vsapi);
+}
+
+
+void Resample::free(const VSAPI* vsapi)
+{
+    audioWindow.clear(vsapi);
+
+    vsapi->freeNode(audio);
+}
+
+
+template <typename sample_t, size_t IntSampleBits>
+bool Resample::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const std::vector<common::OffsetFrames>& inFrms,
+                              const common::OverflowContext& ofCtx)
+{
+    int64_t outPosFrmStart = vsutils::frameToFirstSample(outFrmNum);
+    int outFrmLen = ofCtx.vsapi->getFrameLength(outFrm);
+
+    // unclamped: the filter reads zeros before and after the input clip
+    common::SampleRange inRange = resampler->getInputRange(outPosFrmStart, outPosFrmStart + outFrmLen);
+
+    // input frames in sample order
+    std::vector<const VSFrame*> inFrmList;
+
+    for (const common::OffsetFrames& frms : inFrms)
+    {
+        inFrmList.push_back(frms.left);
+
+        if (frms.right)
+        {
+            inFrmList.push_back(frms.right);
+        }
+    }
+
+    int firstInFrm = vsutils::sampleToFrame(std::max<int64_t>(inRange.begin, 0));
+
+    // the samples outside of the input clip are never overwritten
+    std::vector<double> inSamples(static_cast<size_t>(inRange.end - inRange.begin), 0.0);
+
+    std::array<double, VS_AUDIO_FRAME_SAMPLES> samples;
+
+    for (int ch = 0; ch < outInfo.format.numChannels; ++ch)
+    {
+        for (size_t f = 0; f < inFrmList.size(); ++f)
+        {
+            int64_t inPosFrmStart = vsutils::frameToFirstSample(firstInFrm + static_cast<int>(f));
+            int inFrmLen = ofCtx.vsapi->getFrameLength(inFrmList[f]);
+
+            int64_t begin = std::max(inPosFrmStart, inRange.begin);
+            int64_t end = std::min(inPosFrmStart + inFrmLen, inRange.end);
+
+            if (end <= begin)
+            {
+                continue;
+            }
+
+            const sample_t* inFrmPtr = reinterpret_cast<const sample_t*>(ofCtx.vsapi->getReadPtr(inFrmList[f], ch));
+
+            simd::convSamplesToDouble<sample_t, IntSampleBits>(inFrmPtr + (begin - inPosFrmStart), inSamples.data() + (begin - inRange.begin),
+                                                               static_cast<int>(end - begin));
+        }
+
+        resampler->process(inSamples.data(), outPosFrmStart, samples.data(), outFrmLen);
+
+        sample_t* outFrmPtr = reinterpret_cast<sample_t*>(ofCtx.vsapi->getWritePtr(outFrm, ch));
+
+        // the filter overshoots at steep transients, even if no input sample overflows
+        if (!common::safeWriteSamples<sample_t, IntSampleBits>(std::span(samples.data(), outFrmLen), outFrmPtr, outPosFrmStart, ch, ofCtx))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool Resample::writeFrame(VSFrame* outFrm, int outFrmNum, const std::vector<common::OffsetFrames>& inFrms,
+                          common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+{
+    common::OverflowContext ofCtx =
+        { .mode = overflowMode, .log = overflowLog, .funcName = FuncName,
+          .frameCtx = frameCtx, .core = core, .vsapi = vsapi,
+          .stats = overflowStats };
+
+    switch (outSampleType)
+    {
+        case common::SampleType::Int8:
+            return writeFrameImpl<int8_t, 8>(outFrm, outFrmNum, inFrms, ofCtx);
+        case common::SampleType::Int16:
+            return writeFrameImpl<int16_t, 16>(outFrm, outFrmNum, inFrms, ofCtx);
+        case common::SampleType::Int24:
+            return writeFrameImpl<int32_t, 24>(outFrm, outFrmNum, inFrms, ofCtx);
+        case common::SampleType::Int32:
+            return writeFrameImpl<int32_t, 32>(outFrm, outFrmNum, inFrms, ofCtx);
+        case common::SampleType::Float32:
+            return writeFrameImpl<float, 0>(outFrm, outFrmNum, inFrms, ofCtx);
+        case common::SampleType::Float64:
+            return writeFrameImpl<double, 0>(outFrm, outFrmNum, inFrms, ofCtx);
+        default:
+            return false;
+    }
+}
+
+
+static void VS_CC resampleFree(void* instanceData, VSCore* core, const VSAPI* vsapi)
+{
+    Resample* data = static_cast<Resample*>(instanceData);
+    data->flushOverflowStats(core, vsapi);
+    data->free(vsapi);
+    delete data;
+}
+
+
+static const VSFrame* VS_CC resampleGetFrame(int outFrmNum, int activationReason, void* instanceData, void** frameData, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+{
+    Resample* data = static_cast<Resample*>(instanceData);
+
+    if (activationReason == VSActivationReason::arError)
+    {
+        common::freeWindowFrames(frameData, vsapi);
+        return nullptr;
+    }
+
+    if (data->isPassthrough())
+    {
+        if (activationReason == VSActivationReason::arInitial)
+        {
+            vsapi->requestFrameFilter(outFrmNum, data->getAudio(), frameCtx);
+        }
+        else if (activationReason == VSActivationReason::arAllFramesReady)
+        {
+            // same sample rate: the input frames are passed through
+            const VSFrame* inFrm = vsapi->getFrameFilter(outFrmNum, data->getAudio(), frameCtx);
+            return common::passFrameStatsProps(inFrm, data->isStatsEnabled(), core, vsapi);
+        }
+        return nullptr;
+    }
+
+    std::vector<common::OffsetFramePos> inFrmNums = data->outFrameToInFrames(outFrmNum);
+
+    if (activationReason == VSActivationReason::arInitial)
+    {
+        bool frmRequested = false;
+
+        // input frames that are still in the frame window are not requested again
+        auto windowFrms = std::make_unique<common::WindowFrames>(inFrmNums.size());
+
+        for (size_t i = 0; i < inFrmNums.size(); ++i)
+        {
+            frmRequested = common::requestOffsetFrames(inFrmNums[i], data->getAudio(), data->getAudioWindow(), windowFrms->at(i), frameCtx, vsapi) || frmRequested;
+        }
+
+        *frameData = windowFrms.release();
+
+        if (frmRequested)
+        {
+            return nullptr;
+        }
+
+        // all input frames are in the frame window: the frame is returned right away
+    }
+
+    if (activationReason == VSActivationReason::arInitial || activationReason == VSActivationReason::arAllFramesReady)
+    {
+        std::unique_ptr<common::WindowFrames> windowFrms(common::releaseWindowFrames(frameData));
+
+        std::vector<common::OffsetFrames> inFrms;
+
+        for (size_t i = 0; i < inFrmNums.size(); ++i)
+        {
+            inFrms.push_back(common::getOffsetFrames(inFrmNums[i], windowFrms->at(i), data->getAudio(), data->getAudioWindow(), frameCtx, vsapi));
+        }
+
+        int outFrmLen = vsutils::getFrameSampleCount(outFrmNum, data->getOutInfo().numSamples);
+
+        VSFrame* outFrm = vsapi->newAudioFrame(&data->getOutInfo().format, outFrmLen, nullptr, core);
+
+        common::OverflowStats overflowStats;
+
+        bool success = data->writeFrame(outFrm, outFrmNum, inFrms, overflowStats, frameCtx, core, vsapi);
+
+        for (const common::OffsetFrames& frms : inFrms)
+        {
+            if (frms.left)
+            {
+                vsapi->freeFrame(frms.left);
+            }
+
+            if (frms.right)
+            {
+                vsapi->freeFrame(frms.right);
+            }
+        }
+
+        if (success)
+        {
+            common::updateFrameStatsProps(outFrm, data->isStatsEnabled(), overflowStats, vsapi);
+        }
+
+        data->submitOverflowStats(outFrmNum, std::move(overflowStats), core, vsapi);
+
+        if (success)
+        {
+            return outFrm;
+        }
+
+        vsapi->freeFrame(outFrm);
+    }
+
+    return nullptr;
+}
+
+
+static void VS_CC resampleCreate(const VSMap* in, VSMap* out, void* userData, VSCore* core, const VSAPI* vsapi)
+{
+    // clip:anode
+    int err = 0;
+    VSNode* audio = vsapi->mapGetNode(in, "clip", 0, &err);
+    if (err)
+    {
+        return;
+    }
+
+    const VSAudioInfo* audioInfo = vsapi->getAudioInfo(audio);
+
+    // check for supported audio format
+    auto optSampleType = common::getSampleTypeFromAudioFormat(audioInfo->format);
+    if (!optSampleType.has_value())
+    {
+        std::string errMsg = std::format("{}: unsupported audio format", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // sample_rate:int
+    int sampleRate = vsapi->mapGetIntSaturated(in, "sample_rate", 0, nullptr);
+    if (sampleRate <= 0)
+    {
+        std::string errMsg = std::format("{}: invalid sample_rate", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // taps:int:opt
+    int taps = vsmap::getOptInt("taps", in, vsapi, DefaultTaps);
+    if (taps < common::Resampler::MinTaps || common::Resampler::MaxTaps < taps)
+    {
+        std::string errMsg = std::format("{}: taps must be between {} and {}", FuncName, common::Resampler::MinTaps, common::Resampler::MaxTaps);
+        vsapi->mapSetError(out, errMsg.c_str());
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    common::ResampleRatio ratio = common::getResampleRatio(audioInfo->sampleRate, sampleRate);
+    if (sampleRate != audioInfo->sampleRate && !common::Resampler::isSupported(ratio, taps))
+    {
+        std::string errMsg = std::format("{}: unsupported sample rate ratio {}:{}, the filter would need more than {} coefficients (try fewer taps)",
+                                         FuncName, audioInfo->sampleRate, sampleRate, common::Resampler::MaxCoeffs);
+        vsapi->mapSetError(out, errMsg.c_str());
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // overflow:data:opt
+    std::optional<common::OverflowMode> optOverflowMode = vsmap::getOptOverflowModeFromString("overflow", FuncName, in, out, vsapi, DefaultOverflowMode);
+    if (!optOverflowMode.has_value())
+    {
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    if (optOverflowMode.value() == common::OverflowMode::KeepFloat && !common::isFloatSampleType(optSampleType.value()))
+    {
+        std::string errMsg = std::format("{}: cannot use 'keep_float' overflow mode with an integer sample type", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // overflow_log:data:opt
+    std::optional<common::OverflowLog> optOverflowLog = vsmap::getOptOverflowLogFromString("overflow_log", FuncName, in, out, vsapi, DefaultOverflowLog);
+    if (!optOverflowLog.has_value())
+    {
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    // stats:int:opt
+    bool stats = vsmap::getOptBool("stats", in, vsapi, DefaultStats);
+
+    Resample* data = new Resample(audio, audioInfo, sampleRate, taps, optOverflowMode.value(), optOverflowLog.value(), stats);
+
+    VSFilterDependency deps[] = {{ audio, data->isPassthrough() ? rpStrictSpatial : rpGeneral }};
+
+    // fmParallel: overflows are collected per frame and logged in frame order by common::OverflowTracker
+    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), resampleGetFrame, resampleFree, VSFilterMode::fmParallel, deps, 1, data, core);
+}
+
+
+void resampleInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi)
+{
+    vspapi->registerFunction(FuncName,
+                             "clip:anode;"
+                             "sample_rate:int;"
+                             "taps:int:opt;"
+                             "overflow:data:opt;"
+                             "overflow_log:data:opt;"
+                             "stats:int:opt;",
+                             "return:anode;",
+                             resampleCreate, nullptr, plugin);
+}
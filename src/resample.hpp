@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+#include "common/framewindow.hpp"
+#include "common/offset.hpp"
+#include "common/overflow.hpp"
+#include "common/resampler.hpp"
+#include "common/sampletype.hpp"
+
+class Resample
+{
+public:
+    // taps: see common::Resampler
+    Resample(VSNode* audio, const VSAudioInfo* audioInfo, int outSampleRate, int taps,
+             common::OverflowMode overflowMode, common::OverflowLog overflowLog, bool stats);
+
+    VSNode* getAudio();
+
+    // recently fetched input frames, see common::FrameWindow
+    common::FrameWindow& getAudioWindow();
+
+    const VSAudioInfo& getOutInfo();
+
+    // true if the stats props are written to every output frame, see common/stats.hpp
+    bool isStatsEnabled();
+
+    // true if the output sample rate equals the input sample rate
+    bool isPassthrough();
+
+    /**
+     * returns the input frames read by an output frame as pairs of consecutive left and right frames (see common::requestOffsetFrames)
+     * downsampling and long filters can read more than two input frames per output frame
+     */
+    std::vector<common::OffsetFramePos> outFrameToInFrames(int outFrmNum);
+
+    void submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi);
+
+    void flushOverflowStats(VSCore* core, const VSAPI* vsapi);
+
+    void free(const VSAPI* vsapi);
+
+    // inFrms: the frames of outFrameToInFrames in the same order
+    bool writeFrame(VSFrame* outFrm, int outFrmNum, const std::vector<common::OffsetFrames>& inFrms,
+                    common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
+
+private:
+    VSNode* audio;
+    const VSAudioInfo inInfo;
+    VSAudioInfo outInfo;
+
+    common::SampleType outSampleType;
+
+    common::OverflowMode overflowMode;
+    common::OverflowLog overflowLog;
+
+    common::OverflowTracker overflowTracker;
+
+    bool stats;
+
+    // only set if the rates differ
+    std::optional<common::Resampler> resampler;
+
+    common::FrameWindow audioWindow;
+
+    // input samples read by an output frame, clamped to the input clip
+    common::SampleRange getInSampleRange(int outFrmNum);
+
+    template <typename sample_t, size_t IntSampleBits>
+    bool writeFrameImpl(VSFrame* outFrm, int outFrmNum, const std::vector<common::OffsetFrames>& inFrms,
+                        const common::OverflowContext& ofCtx);
+};
+
+
+void resampleInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi);
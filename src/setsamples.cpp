@@ -1,12 +1,15 @@
 // SPDX-License-Identifier: MIT
 
+#include <array>
 #include <climits>
 #include <cstdint>
 #include <cstring>
 #include <format>
 #include <optional>
+#include <span>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "VapourSynth4.h"
@@ -14,6 +17,7 @@
 #include "setsamples.hpp"
 #include "common/overflow.hpp"
 #include "common/sampletype.hpp"
+#include "common/stats.hpp"
 #include "utils/sample.hpp"
 #include "utils/vector.hpp"
 #include "vsmap/vsmap.hpp"
@@ -36,6 +40,8 @@ SetSamples::SetSamples(VSNode* _audio, const VSAudioInfo* _audioInfo, double _sa
     outSampleType = common::getSampleTypeFromAudioFormat(audioInfo.format).value();
 
     copyChannels = utils::vectorInvert(editChannels, 0, audioInfo.format.numChannels);
+
+    overflowTracker.init(FuncName, overflowMode, overflowLog, common::isFloatSampleType(outSampleType), audioInfo.numFrames);
 }
 
 
@@ -51,18 +57,15 @@ const VSAudioInfo& SetSamples::getOutInfo()
 }
 
 
-void SetSamples::resetOverflowStats()
+void SetSamples::submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi)
 {
-    overflowStats = { .count = 0, .peak = 0.0 };
+    overflowTracker.submitFrame(outFrmNum, std::move(frameOverflowStats), core, vsapi);
 }
 
 
-void SetSamples::logOverflowStats(VSCore* core, const VSAPI* vsapi)
+void SetSamples::flushOverflowStats(VSCore* core, const VSAPI* vsapi)
 {
-    if (0 < overflowStats.count)
-    {
-        overflowStats.logVS(FuncName, overflowMode, isFloatSampleType(outSampleType), core, vsapi);
-    }
+    overflowTracker.flush(core, vsapi);
 }
 
 
@@ -84,17 +87,15 @@ bool SetSamples::writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmSta
 
     double dSample = utils::convSampleToDouble<sample_t, IntSampleBits>(utils::castSample<sample_t, IntSampleBits>(sample));
 
+    std::array<double, VS_AUDIO_FRAME_SAMPLES> samples;
+
     for (int s = 0; s < outFrmLen; ++s)
     {
         int64_t outPos = outPosFrmStart + s;
 
         if (outPosStart <= outPos && outPos < outPosEnd)
         {
-            if (!common::safeWriteSample<sample_t, IntSampleBits>(dSample, outFrmPtr, s, outPos, ch, ofCtx, overflowStats))
-            {
-                // overflow and error
-                return false;
-            }
+            samples[s] = dSample;
         }
         else
         {
@@ -106,14 +107,10 @@ bool SetSamples::writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmSta
                 inSample >>= bitShift.count;
             }
 
-            if (!common::safeWriteSample<sample_t, IntSampleBits>(utils::convSampleToDouble<sample_t, IntSampleBits>(inSample), outFrmPtr, s, outPos, ch, ofCtx, overflowStats))
-            {
-                // overflow and error
-                return false;
-            }
+            samples[s] = utils::convSampleToDouble<sample_t, IntSampleBits>(inSample);
         }
     }
-    return true;
+    return common::safeWriteSamples<sample_t, IntSampleBits>(std::span(samples.data(), outFrmLen), outFrmPtr, outPosFrmStart, ch, ofCtx);
 }
 
 
@@ -143,11 +140,12 @@ bool SetSamples::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const VSFrame* i
 }
 
 
-bool SetSamples::writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+bool SetSamples::writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm, common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
 {
     common::OverflowContext ofCtx =
         { .mode = overflowMode, .log = overflowLog, .funcName = FuncName,
-          .frameCtx = frameCtx, .core = core, .vsapi = vsapi };
+          .frameCtx = frameCtx, .core = core, .vsapi = vsapi,
+          .stats = overflowStats };
 
     switch (outSampleType)
     {
@@ -172,8 +170,7 @@ bool SetSamples::writeFrame(VSFrame* outFrm, int outFrmNum, const VSFrame* inFrm
 void VS_CC setsamplesFree(void* instanceData, VSCore* core, const VSAPI* vsapi)
 {
     SetSamples* data = static_cast<SetSamples*>(instanceData);
-    // skip logging since the total number of overflows is unreliable
-    // data->logNumOverflows(core, vsapi);
+    data->flushOverflowStats(core, vsapi);
     data->free(vsapi);
     delete data;
 }
@@ -191,27 +188,26 @@ const VSFrame* VS_CC setsamplesGetFrame(int outFrmNum, int activationReason, voi
 
     if (activationReason == VSActivationReason::arAllFramesReady)
     {
-        if (outFrmNum == 0)
-        {
-            data->resetOverflowStats();
-        }
-
         const VSFrame* inFrm = vsapi->getFrameFilter(outFrmNum, data->getAudio(), frameCtx);
 
         int inFrmLen = vsapi->getFrameLength(inFrm);
 
         VSFrame *outFrm = vsapi->newAudioFrame(&data->getOutInfo().format, inFrmLen, inFrm, core);
 
-        bool success = data->writeFrame(outFrm, outFrmNum, inFrm, frameCtx, core, vsapi);
+        common::OverflowStats overflowStats;
+
+        bool success = data->writeFrame(outFrm, outFrmNum, inFrm, overflowStats, frameCtx, core, vsapi);
 
         vsapi->freeFrame(inFrm);
 
-        if (outFrmNum == data->getOutInfo().numFrames - 1)
+        if (success)
         {
-            // last frame
-            data->logOverflowStats(core, vsapi);
+            // the stats props copied from inFrm do not match the set samples (SetSamples has no 'stats' parameter)
+            common::updateFrameStatsProps(outFrm, false, overflowStats, vsapi);
         }
 
+        data->submitOverflowStats(outFrmNum, std::move(overflowStats), core, vsapi);
+
         if (success)
         {
             return outFrm;
@@ -298,8 +294,8 @@ static void VS_CC setsamplesCreate(const VSMap* in, VSMap* out, void* userData,
 
     VSFilterDependency deps[] = {{ audio, VSRequestPattern::rpStrictSpatial }};
 
-    // fmParallelRequests: strict sequential frame requests for overflow logging
-    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), setsamplesGetFrame, setsamplesFree, VSFilterMode::fmParallelRequests, deps, 1, data, core);
+    // fmParallel: overflows are collected per frame and logged in frame order by common::OverflowTracker
+    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), setsamplesGetFrame, setsamplesFree, VSFilterMode::fmParallel, deps, 1, data, core);
 }
 
 
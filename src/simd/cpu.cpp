@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: MIT
+
+#include "simd/cpu.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace simd
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    static bool cpuHasSSE2()
+    {
+        int info[4];
+        __cpuid(info, 1);
+        return (info[3] & (1 << 26)) != 0;
+    }
+
+
+    static bool cpuHasAVX2()
+    {
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+        {
+            return false;
+        }
+
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx)
+        {
+            return false;
+        }
+
+        // the OS has to save the YMM registers
+        if ((_xgetbv(0) & 0x6) != 0x6)
+        {
+            return false;
+        }
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }
+#else
+    static bool cpuHasSSE2()
+    {
+        return __builtin_cpu_supports("sse2");
+    }
+
+
+    static bool cpuHasAVX2()
+    {
+        // also checks OS support for the YMM registers
+        return __builtin_cpu_supports("avx2");
+    }
+#endif
+
+    Isa detectIsa()
+    {
+        if (cpuHasAVX2())
+        {
+            return Isa::AVX2;
+        }
+
+        if (cpuHasSSE2())
+        {
+            return Isa::SSE2;
+        }
+
+        return Isa::Scalar;
+    }
+
+#elif defined(__aarch64__) || defined(_M_ARM64)
+
+    Isa detectIsa()
+    {
+        // NEON is mandatory on ARM64
+        return Isa::NEON;
+    }
+
+#else
+
+    Isa detectIsa()
+    {
+        return Isa::Scalar;
+    }
+
+#endif
+
+
+    const char* getIsaName(Isa isa)
+    {
+        switch (isa)
+        {
+            case Isa::SSE2:
+                return "sse2";
+            case Isa::AVX2:
+                return "avx2";
+            case Isa::NEON:
+                return "neon";
+            case Isa::Scalar:
+            default:
+                return "scalar";
+        }
+    }
+}
@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+namespace simd
+{
+    enum class Isa
+    {
+        // plain C++, no SIMD kernels
+        Scalar,
+        // x86 SSE2
+        SSE2,
+        // x86 AVX2
+        AVX2,
+        // ARM64 NEON
+        NEON,
+    };
+
+    // returns the best instruction set supported by the running CPU (and the compiler)
+    Isa detectIsa();
+
+    const char* getIsaName(Isa isa);
+}
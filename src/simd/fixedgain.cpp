@@ -0,0 +1,236 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "common/sampletype.hpp"
+#include "simd/cpu.hpp"
+#include "simd/fixedgain.hpp"
+#include "simd/fixedgain_impl.hpp"
+#include "utils/sample.hpp"
+#include "vsutils/bitshift.hpp"
+
+namespace simd
+{
+    static std::optional<int32_t> getIntSampleMax(common::SampleType st)
+    {
+        switch (st)
+        {
+            case common::SampleType::Int8:
+                return utils::maxInt<int8_t, 8>;
+            case common::SampleType::Int16:
+                return utils::maxInt<int16_t, 16>;
+            case common::SampleType::Int24:
+                return utils::maxInt<int32_t, 24>;
+            case common::SampleType::Int32:
+                return utils::maxInt<int32_t, 32>;
+            default:
+                return std::nullopt;
+        }
+    }
+
+
+    std::optional<FixedGain> makeFixedGain(common::SampleType st, double gain, double normPeak, bool exact)
+    {
+        std::optional<int32_t> optMaxInt = getIntSampleMax(st);
+        if (!optMaxInt.has_value())
+        {
+            return std::nullopt;
+        }
+
+        uint32_t maxInt = static_cast<uint32_t>(optMaxInt.value());
+
+        if (!(0 <= gain) || !(0 <= normPeak && normPeak <= 1))
+        {
+            return std::nullopt;
+        }
+
+        // every result has to fit into the positive range of int32_t
+        if (2147483646.0 <= gain * static_cast<double>(maxInt))
+        {
+            return std::nullopt;
+        }
+
+        // as many fractional bits as possible with mult < 2^32
+        int shift = 32;
+        while (std::ldexp(1.0, 32 - shift) <= gain)
+        {
+            --shift;
+        }
+
+        uint64_t mult = static_cast<uint64_t>(std::llround(std::ldexp(gain, shift)));
+        if (UINT32_MAX < mult)
+        {
+            --shift;
+            mult = static_cast<uint64_t>(std::llround(std::ldexp(gain, shift)));
+        }
+
+        // quantization error of mult: |x| * 0.5 (|x| <= maxInt)
+        // rounding error of the double path (3 roundings): less than |x| * gain * 2^-50 (< 2^31 * 2^-50)
+        uint64_t tieBand = (maxInt >> 1) + (maxInt >> (50 - shift)) + 2;
+
+        if (exact && (uint64_t(1) << shift) < (tieBand << 8))
+        {
+            // more than 1/128 of all samples would need the double path
+            return std::nullopt;
+        }
+
+        return FixedGain
+        {
+            .mult = static_cast<uint32_t>(mult),
+            .shift = shift,
+            .maxOut = static_cast<uint32_t>(std::round(normPeak * static_cast<double>(maxInt))),
+            .tieBand = static_cast<uint32_t>(tieBand),
+            .exact = exact,
+            .gain = gain,
+            .normPeak = normPeak,
+        };
+    }
+
+
+    template <typename sample_t, size_t IntSampleBits>
+    static void scalarApplyFixedGain(const void* in, void* out, int numSamples, const FixedGain& gain)
+    {
+        const sample_t* inPtr = static_cast<const sample_t*>(in);
+        sample_t* outPtr = static_cast<sample_t*>(out);
+
+        constexpr vsutils::BitShift bitShift = vsutils::getSampleBitShift<sample_t, IntSampleBits>();
+
+        constexpr int32_t maxInt = utils::maxInt<sample_t, IntSampleBits>;
+
+        const uint64_t half = uint64_t(1) << (gain.shift - 1);
+        const uint32_t fracMask = static_cast<uint32_t>((uint64_t(1) << gain.shift) - 1);
+
+        for (int s = 0; s < numSamples; ++s)
+        {
+            sample_t sample = inPtr[s];
+
+            if constexpr (bitShift.required)
+            {
+                sample >>= bitShift.count;
+            }
+
+            int32_t x = std::max<int32_t>(sample, -maxInt);
+
+            uint64_t product = static_cast<uint64_t>(x < 0 ? -x : x) * gain.mult;
+
+            if (gain.exact)
+            {
+                // |frac - 0.5| <= tieBand
+                uint32_t frac = static_cast<uint32_t>(product) & fracMask;
+                if (frac - static_cast<uint32_t>(half) + gain.tieBand <= 2 * gain.tieBand)
+                {
+                    // too close to a rounding tie -> double path
+                    double scaled = std::clamp(gain.gain * utils::convSampleToDouble<sample_t, IntSampleBits>(sample), -gain.normPeak, gain.normPeak);
+                    sample = utils::convSampleFromDouble<sample_t, IntSampleBits>(scaled);
+
+                    if constexpr (bitShift.required)
+                    {
+                        sample <<= bitShift.count;
+                    }
+
+                    outPtr[s] = sample;
+                    continue;
+                }
+            }
+
+            int32_t result = static_cast<int32_t>(std::min<uint64_t>((product + half) >> gain.shift, gain.maxOut));
+
+            sample = static_cast<sample_t>(x < 0 ? -result : result);
+
+            if constexpr (bitShift.required)
+            {
+                sample <<= bitShift.count;
+            }
+
+            outPtr[s] = sample;
+        }
+    }
+
+
+    static constexpr FixedGainKernels scalarKernels =
+    {
+        .apply =
+        {
+            scalarApplyFixedGain<int8_t, 8>,
+            scalarApplyFixedGain<int16_t, 16>,
+            scalarApplyFixedGain<int32_t, 24>,
+            scalarApplyFixedGain<int32_t, 32>,
+            nullptr,
+            nullptr,
+        },
+    };
+
+    static FixedGainKernels activeKernels = scalarKernels;
+
+    static Isa activeIsa = Isa::Scalar;
+
+
+    void initFixedGainKernels(Isa isa)
+    {
+        FixedGainKernels kernels = scalarKernels;
+        bool available = false;
+
+        switch (isa)
+        {
+            case Isa::SSE2:
+                available = fillFixedGainKernelsSSE2(kernels);
+                break;
+            case Isa::AVX2:
+                available = fillFixedGainKernelsAVX2(kernels);
+                break;
+            case Isa::NEON:
+                available = fillFixedGainKernelsNEON(kernels);
+                break;
+            case Isa::Scalar:
+            default:
+                break;
+        }
+
+        if (available)
+        {
+            activeKernels = kernels;
+            activeIsa = isa;
+        }
+        else
+        {
+            activeKernels = scalarKernels;
+            activeIsa = Isa::Scalar;
+        }
+    }
+
+
+    void initFixedGainKernels()
+    {
+        Isa isa = detectIsa();
+
+        initFixedGainKernels(isa);
+
+        if (activeIsa == Isa::Scalar && isa == Isa::AVX2)
+        {
+            // AVX2 kernels not built
+            initFixedGainKernels(Isa::SSE2);
+        }
+    }
+
+
+    Isa getFixedGainIsa()
+    {
+        return activeIsa;
+    }
+
+
+    const FixedGainKernels& getFixedGainKernels()
+    {
+        return activeKernels;
+    }
+
+
+    const FixedGainKernels& getScalarFixedGainKernels()
+    {
+        return scalarKernels;
+    }
+}
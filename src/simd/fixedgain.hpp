@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include "common/sampletype.hpp"
+#include "simd/cpu.hpp"
+
+namespace simd
+{
+    /**
+     * constant gain for integer samples in Q format (shift fractional bits)
+     * out = sign(x) * min((|x| * mult + 2^(shift - 1)) >> shift, maxOut) with x = max(sample, -maxInt)
+     *
+     * this is the same as convSampleFromDouble(clamp(gain * convSampleToDouble(sample), -normPeak, normPeak))
+     * except for samples close to a rounding tie (.5) which can differ by 1 (see tieBand)
+     */
+    struct FixedGain
+    {
+        uint32_t mult;
+        int shift;
+
+        // round(normPeak * maxInt)
+        uint32_t maxOut;
+
+        // error of the fixed point product in 2^-shift units (quantized gain + rounding of the double path)
+        // exact: samples with a fractional part within tieBand of 0.5 are computed with the double path
+        uint32_t tieBand;
+        bool exact;
+
+        // for the double path
+        double gain;
+        double normPeak;
+    };
+
+
+    /**
+     * returns the fixed point gain for an integer sample type
+     * std::nullopt if the sample type is not an integer type, normPeak is greater than 1 (overflow handling needed),
+     * gain * maxInt does not fit into 31 bits or exact is requested but more than ~1/128 of all samples
+     * would need the double path (Int32)
+     */
+    std::optional<FixedGain> makeFixedGain(common::SampleType st, double gain, double normPeak, bool exact);
+
+
+    // applies a fixed point gain to numSamples samples of one integer sample type (including the bit shift of the sample type)
+    using FixedGainKernel = void (*)(const void* in, void* out, int numSamples, const FixedGain& gain);
+
+
+    struct FixedGainKernels
+    {
+        // indexed by common::SampleType, nullptr for float sample types
+        FixedGainKernel apply[common::NumSampleTypes];
+    };
+
+
+    // selects the fixed point gain kernels for the running CPU
+    // call once at plugin initialization; the scalar kernels are used until then
+    void initFixedGainKernels();
+
+    // force a specific instruction set (falls back to scalar if not supported by the build)
+    void initFixedGainKernels(Isa isa);
+
+    Isa getFixedGainIsa();
+
+    const FixedGainKernels& getFixedGainKernels();
+
+    // reference kernels, also used for the samples close to a rounding tie
+    const FixedGainKernels& getScalarFixedGainKernels();
+
+
+    template <typename sample_t, size_t IntSampleBits>
+    requires std::integral<sample_t>
+    void applyFixedGain(const sample_t* in, sample_t* out, int numSamples, const FixedGain& gain)
+    {
+        constexpr size_t index = static_cast<size_t>(common::toSampleType<sample_t, IntSampleBits>());
+        getFixedGainKernels().apply[index](in, out, numSamples, gain);
+    }
+}
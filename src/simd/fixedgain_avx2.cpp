@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: MIT
+
+// this file is compiled with AVX2 enabled
+// only call these kernels if the CPU supports AVX2 (see simd::detectIsa)
+
+#include <cstdint>
+#include <cstring>
+
+#include "common/sampletype.hpp"
+#include "simd/fixedgain.hpp"
+#include "simd/fixedgain_impl.hpp"
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+namespace simd
+{
+    namespace
+    {
+        constexpr size_t idx(common::SampleType st)
+        {
+            return static_cast<size_t>(st);
+        }
+
+
+        template <common::SampleType st>
+        inline __m256i loadInt32x8(const void* in, int s)
+        {
+            if constexpr (st == common::SampleType::Int8)
+            {
+                return _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(static_cast<const int8_t*>(in) + s)));
+            }
+            else if constexpr (st == common::SampleType::Int16)
+            {
+                return _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(static_cast<const int16_t*>(in) + s)));
+            }
+            else if constexpr (st == common::SampleType::Int24)
+            {
+                return _mm256_srai_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(static_cast<const int32_t*>(in) + s)), 8);
+            }
+            else
+            {
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(static_cast<const int32_t*>(in) + s));
+            }
+        }
+
+
+        template <common::SampleType st>
+        inline void storeInt32x8(__m256i v, void* out, int s)
+        {
+            __m128i i0 = _mm256_castsi256_si128(v);
+            __m128i i1 = _mm256_extracti128_si256(v, 1);
+
+            if constexpr (st == common::SampleType::Int8)
+            {
+                __m128i i16 = _mm_packs_epi32(i0, i1);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(static_cast<int8_t*>(out) + s), _mm_packs_epi16(i16, i16));
+            }
+            else if constexpr (st == common::SampleType::Int16)
+            {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(static_cast<int16_t*>(out) + s), _mm_packs_epi32(i0, i1));
+            }
+            else
+            {
+                if constexpr (st == common::SampleType::Int24)
+                {
+                    v = _mm256_slli_epi32(v, 8);
+                }
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(static_cast<int32_t*>(out) + s), v);
+            }
+        }
+
+
+        template <common::SampleType st, int32_t MaxInt>
+        void applyGain(const void* in, void* out, int numSamples, const FixedGain& gain)
+        {
+            const __m256i negMaxInt = _mm256_set1_epi32(-MaxInt);
+            const __m256i mult = _mm256_set1_epi64x(gain.mult);
+            const __m256i half = _mm256_set1_epi64x(int64_t(1) << (gain.shift - 1));
+            const __m128i shift = _mm_cvtsi32_si128(gain.shift);
+            const __m256i maxOut = _mm256_set1_epi32(static_cast<int32_t>(gain.maxOut));
+
+            // |frac - 0.5| <= tieBand <=> (frac - 0.5 + tieBand) <= 2 * tieBand (unsigned, flipped sign bit for the signed compare)
+            const __m256i fracMask = _mm256_set1_epi32(static_cast<int32_t>(static_cast<uint32_t>((uint64_t(1) << gain.shift) - 1)));
+            const __m256i tieOffset = _mm256_set1_epi32(static_cast<int32_t>(gain.tieBand - static_cast<uint32_t>(uint64_t(1) << (gain.shift - 1))));
+            const __m256i tieLimit = _mm256_set1_epi32(static_cast<int32_t>((2 * gain.tieBand) ^ 0x80000000u));
+            const __m256i signBit = _mm256_set1_epi32(INT32_MIN);
+
+            const FixedGainKernels& scalar = getScalarFixedGainKernels();
+            size_t bytesPerSample = st == common::SampleType::Int8 ? 1 : (st == common::SampleType::Int16 ? 2 : 4);
+            const uint8_t* inBytes = static_cast<const uint8_t*>(in);
+            uint8_t* outBytes = static_cast<uint8_t*>(out);
+
+            int s = 0;
+            for (; s + 8 <= numSamples; s += 8)
+            {
+                __m256i x = _mm256_max_epi32(loadInt32x8<st>(in, s), negMaxInt);
+                __m256i absX = _mm256_abs_epi32(x);
+
+                // 32 x 32 -> 64 bit products of the even and odd lanes
+                __m256i productEven = _mm256_mul_epu32(absX, mult);
+                __m256i productOdd = _mm256_mul_epu32(_mm256_srli_epi64(absX, 32), mult);
+
+                if (gain.exact)
+                {
+                    // lower 32 bits of the products
+                    __m256i frac = _mm256_and_si256(_mm256_blend_epi32(productEven, _mm256_slli_epi64(productOdd, 32), 0xAA), fracMask);
+                    __m256i dist = _mm256_xor_si256(_mm256_add_epi32(frac, tieOffset), signBit);
+
+                    if (_mm256_movemask_epi8(_mm256_cmpgt_epi32(dist, tieLimit)) != -1)
+                    {
+                        // too close to a rounding tie -> let the scalar kernel use the double path
+                        scalar.apply[idx(st)](inBytes + s * bytesPerSample, outBytes + s * bytesPerSample, 8, gain);
+                        continue;
+                    }
+                }
+
+                // results fit into 31 bits (see makeFixedGain)
+                __m256i resultEven = _mm256_srl_epi64(_mm256_add_epi64(productEven, half), shift);
+                __m256i resultOdd = _mm256_srl_epi64(_mm256_add_epi64(productOdd, half), shift);
+                __m256i result = _mm256_or_si256(resultEven, _mm256_slli_epi64(resultOdd, 32));
+
+                result = _mm256_sign_epi32(_mm256_min_epi32(result, maxOut), x);
+
+                storeInt32x8<st>(result, out, s);
+            }
+
+            if (s < numSamples)
+            {
+                scalar.apply[idx(st)](inBytes + s * bytesPerSample, outBytes + s * bytesPerSample, numSamples - s, gain);
+            }
+        }
+    }
+
+
+    bool fillFixedGainKernelsAVX2(FixedGainKernels& kernels)
+    {
+        kernels.apply[idx(common::SampleType::Int8)] = applyGain<common::SampleType::Int8, 127>;
+        kernels.apply[idx(common::SampleType::Int16)] = applyGain<common::SampleType::Int16, 32767>;
+        kernels.apply[idx(common::SampleType::Int24)] = applyGain<common::SampleType::Int24, 8388607>;
+        kernels.apply[idx(common::SampleType::Int32)] = applyGain<common::SampleType::Int32, 2147483647>;
+
+        return true;
+    }
+}
+
+#else
+
+namespace simd
+{
+    bool fillFixedGainKernelsAVX2(FixedGainKernels& kernels)
+    {
+        return false;
+    }
+}
+
+#endif
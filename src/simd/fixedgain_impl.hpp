@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "simd/fixedgain.hpp"
+
+// internal: instruction set specific kernel tables
+// every function returns false if the instruction set is not available in this build
+// the kernels fall back to the scalar kernels for the remaining samples and for samples close to a rounding tie (exact)
+namespace simd
+{
+    bool fillFixedGainKernelsSSE2(FixedGainKernels& kernels);
+
+    bool fillFixedGainKernelsAVX2(FixedGainKernels& kernels);
+
+    bool fillFixedGainKernelsNEON(FixedGainKernels& kernels);
+}
@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: MIT
+
+// NEON is part of every ARM64 CPU
+
+#include <cstdint>
+#include <cstring>
+
+#include "common/sampletype.hpp"
+#include "simd/fixedgain.hpp"
+#include "simd/fixedgain_impl.hpp"
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+
+#include <arm_neon.h>
+
+namespace simd
+{
+    namespace
+    {
+        constexpr size_t idx(common::SampleType st)
+        {
+            return static_cast<size_t>(st);
+        }
+
+
+        template <common::SampleType st>
+        inline int32x4_t loadInt32x4(const void* in, int s)
+        {
+            if constexpr (st == common::SampleType::Int8)
+            {
+                int32_t bytes;
+                std::memcpy(&bytes, static_cast<const int8_t*>(in) + s, sizeof(bytes));
+                int8x8_t v = vreinterpret_s8_s32(vdup_n_s32(bytes));
+                return vmovl_s16(vget_low_s16(vmovl_s8(v)));
+            }
+            else if constexpr (st == common::SampleType::Int16)
+            {
+                return vmovl_s16(vld1_s16(static_cast<const int16_t*>(in) + s));
+            }
+            else if constexpr (st == common::SampleType::Int24)
+            {
+                return vshrq_n_s32(vld1q_s32(static_cast<const int32_t*>(in) + s), 8);
+            }
+            else
+            {
+                return vld1q_s32(static_cast<const int32_t*>(in) + s);
+            }
+        }
+
+
+        template <common::SampleType st>
+        inline void storeInt32x4(int32x4_t v, void* out, int s)
+        {
+            if constexpr (st == common::SampleType::Int8)
+            {
+                int8x8_t i8 = vqmovn_s16(vcombine_s16(vqmovn_s32(v), vdup_n_s16(0)));
+                int32_t bytes = vget_lane_s32(vreinterpret_s32_s8(i8), 0);
+                std::memcpy(static_cast<int8_t*>(out) + s, &bytes, sizeof(bytes));
+            }
+            else if constexpr (st == common::SampleType::Int16)
+            {
+                vst1_s16(static_cast<int16_t*>(out) + s, vqmovn_s32(v));
+            }
+            else
+            {
+                if constexpr (st == common::SampleType::Int24)
+                {
+                    v = vshlq_n_s32(v, 8);
+                }
+
+                vst1q_s32(static_cast<int32_t*>(out) + s, v);
+            }
+        }
+
+
+        template <common::SampleType st, int32_t MaxInt>
+        void applyGain(const void* in, void* out, int numSamples, const FixedGain& gain)
+        {
+            const int32x4_t negMaxInt = vdupq_n_s32(-MaxInt);
+            const uint32x2_t mult = vdup_n_u32(gain.mult);
+            const uint64x2_t half = vdupq_n_u64(uint64_t(1) << (gain.shift - 1));
+            const int64x2_t shift = vdupq_n_s64(-gain.shift);
+            const uint32x4_t maxOut = vdupq_n_u32(gain.maxOut);
+
+            // |frac - 0.5| <= tieBand <=> (frac - 0.5 + tieBand) <= 2 * tieBand (unsigned)
+            const uint32x4_t fracMask = vdupq_n_u32(static_cast<uint32_t>((uint64_t(1) << gain.shift) - 1));
+            const uint32x4_t tieOffset = vdupq_n_u32(gain.tieBand - static_cast<uint32_t>(uint64_t(1) << (gain.shift - 1)));
+            const uint32x4_t tieLimit = vdupq_n_u32(2 * gain.tieBand);
+
+            const FixedGainKernels& scalar = getScalarFixedGainKernels();
+            size_t bytesPerSample = st == common::SampleType::Int8 ? 1 : (st == common::SampleType::Int16 ? 2 : 4);
+            const uint8_t* inBytes = static_cast<const uint8_t*>(in);
+            uint8_t* outBytes = static_cast<uint8_t*>(out);
+
+            int s = 0;
+            for (; s + 4 <= numSamples; s += 4)
+            {
+                int32x4_t x = vmaxq_s32(loadInt32x4<st>(in, s), negMaxInt);
+                uint32x4_t absX = vreinterpretq_u32_s32(vabsq_s32(x));
+
+                // 32 x 32 -> 64 bit products
+                uint64x2_t productLo = vmull_u32(vget_low_u32(absX), mult);
+                uint64x2_t productHi = vmull_u32(vget_high_u32(absX), mult);
+
+                if (gain.exact)
+                {
+                    // lower 32 bits of the products
+                    uint32x4_t frac = vandq_u32(vcombine_u32(vmovn_u64(productLo), vmovn_u64(productHi)), fracMask);
+
+                    if (vmaxvq_u32(vcleq_u32(vaddq_u32(frac, tieOffset), tieLimit)) != 0)
+                    {
+                        // too close to a rounding tie -> let the scalar kernel use the double path
+                        scalar.apply[idx(st)](inBytes + s * bytesPerSample, outBytes + s * bytesPerSample, 4, gain);
+                        continue;
+                    }
+                }
+
+                // results fit into 31 bits (see makeFixedGain)
+                uint64x2_t resultLo = vshlq_u64(vaddq_u64(productLo, half), shift);
+                uint64x2_t resultHi = vshlq_u64(vaddq_u64(productHi, half), shift);
+                uint32x4_t result = vminq_u32(vcombine_u32(vmovn_u64(resultLo), vmovn_u64(resultHi)), maxOut);
+
+                // restore the sign
+                int32x4_t signedResult = vreinterpretq_s32_u32(result);
+                signedResult = vbslq_s32(vcltzq_s32(x), vnegq_s32(signedResult), signedResult);
+
+                storeInt32x4<st>(signedResult, out, s);
+            }
+
+            if (s < numSamples)
+            {
+                scalar.apply[idx(st)](inBytes + s * bytesPerSample, outBytes + s * bytesPerSample, numSamples - s, gain);
+            }
+        }
+    }
+
+
+    bool fillFixedGainKernelsNEON(FixedGainKernels& kernels)
+    {
+        kernels.apply[idx(common::SampleType::Int8)] = applyGain<common::SampleType::Int8, 127>;
+        kernels.apply[idx(common::SampleType::Int16)] = applyGain<common::SampleType::Int16, 32767>;
+        kernels.apply[idx(common::SampleType::Int24)] = applyGain<common::SampleType::Int24, 8388607>;
+        kernels.apply[idx(common::SampleType::Int32)] = applyGain<common::SampleType::Int32, 2147483647>;
+
+        return true;
+    }
+}
+
+#else
+
+namespace simd
+{
+    bool fillFixedGainKernelsNEON(FixedGainKernels& kernels)
+    {
+        return false;
+    }
+}
+
+#endif
@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: MIT
+
+// SSE2 is part of every x86-64 CPU, on 32-bit x86 the CPU support is checked at runtime (see simd::detectIsa)
+
+#include <cstdint>
+#include <cstring>
+
+#include "common/sampletype.hpp"
+#include "simd/fixedgain.hpp"
+#include "simd/fixedgain_impl.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+
+namespace simd
+{
+    namespace
+    {
+        constexpr size_t idx(common::SampleType st)
+        {
+            return static_cast<size_t>(st);
+        }
+
+
+        template <common::SampleType st>
+        inline __m128i loadInt32x4(const void* in, int s)
+        {
+            if constexpr (st == common::SampleType::Int8)
+            {
+                int32_t bytes;
+                std::memcpy(&bytes, static_cast<const int8_t*>(in) + s, sizeof(bytes));
+                __m128i v = _mm_cvtsi32_si128(bytes);
+                v = _mm_unpacklo_epi8(v, v);
+                v = _mm_unpacklo_epi16(v, v);
+                return _mm_srai_epi32(v, 24);
+            }
+            else if constexpr (st == common::SampleType::Int16)
+            {
+                __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(static_cast<const int16_t*>(in) + s));
+                return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+            }
+            else if constexpr (st == common::SampleType::Int24)
+            {
+                return _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(static_cast<const int32_t*>(in) + s)), 8);
+            }
+            else
+            {
+                return _mm_loadu_si128(reinterpret_cast<const __m128i*>(static_cast<const int32_t*>(in) + s));
+            }
+        }
+
+
+        template <common::SampleType st>
+        inline void storeInt32x4(__m128i v, void* out, int s)
+        {
+            if constexpr (st == common::SampleType::Int8)
+            {
+                __m128i i16 = _mm_packs_epi32(v, v);
+                int32_t bytes = _mm_cvtsi128_si32(_mm_packs_epi16(i16, i16));
+                std::memcpy(static_cast<int8_t*>(out) + s, &bytes, sizeof(bytes));
+            }
+            else if constexpr (st == common::SampleType::Int16)
+            {
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(static_cast<int16_t*>(out) + s), _mm_packs_epi32(v, v));
+            }
+            else
+            {
+                if constexpr (st == common::SampleType::Int24)
+                {
+                    v = _mm_slli_epi32(v, 8);
+                }
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(static_cast<int32_t*>(out) + s), v);
+            }
+        }
+
+
+        template <common::SampleType st, int32_t MaxInt>
+        void applyGain(const void* in, void* out, int numSamples, const FixedGain& gain)
+        {
+            const __m128i minInt = _mm_set1_epi32(-MaxInt - 1);
+            const __m128i mult = _mm_set1_epi64x(gain.mult);
+            const __m128i half = _mm_set1_epi64x(int64_t(1) << (gain.shift - 1));
+            const __m128i shift = _mm_cvtsi32_si128(gain.shift);
+            const __m128i maxOut = _mm_set1_epi32(static_cast<int32_t>(gain.maxOut));
+            const __m128i lowMask = _mm_set1_epi64x(0xFFFFFFFF);
+
+            // |frac - 0.5| <= tieBand <=> (frac - 0.5 + tieBand) <= 2 * tieBand (unsigned, flipped sign bit for the signed compare)
+            const __m128i fracMask = _mm_set1_epi32(static_cast<int32_t>(static_cast<uint32_t>((uint64_t(1) << gain.shift) - 1)));
+            const __m128i tieOffset = _mm_set1_epi32(static_cast<int32_t>(gain.tieBand - static_cast<uint32_t>(uint64_t(1) << (gain.shift - 1))));
+            const __m128i tieLimit = _mm_set1_epi32(static_cast<int32_t>((2 * gain.tieBand) ^ 0x80000000u));
+            const __m128i signBit = _mm_set1_epi32(INT32_MIN);
+
+            const FixedGainKernels& scalar = getScalarFixedGainKernels();
+            size_t bytesPerSample = st == common::SampleType::Int8 ? 1 : (st == common::SampleType::Int16 ? 2 : 4);
+            const uint8_t* inBytes = static_cast<const uint8_t*>(in);
+            uint8_t* outBytes = static_cast<uint8_t*>(out);
+
+            int s = 0;
+            for (; s + 4 <= numSamples; s += 4)
+            {
+                __m128i x = loadInt32x4<st>(in, s);
+
+                // minInt -> -maxInt
+                x = _mm_sub_epi32(x, _mm_cmpeq_epi32(x, minInt));
+
+                __m128i sign = _mm_srai_epi32(x, 31);
+                __m128i absX = _mm_sub_epi32(_mm_xor_si128(x, sign), sign);
+
+                // 32 x 32 -> 64 bit products of the even and odd lanes
+                __m128i productEven = _mm_mul_epu32(absX, mult);
+                __m128i productOdd = _mm_mul_epu32(_mm_srli_epi64(absX, 32), mult);
+
+                if (gain.exact)
+                {
+                    // lower 32 bits of the products
+                    __m128i frac = _mm_or_si128(_mm_and_si128(productEven, lowMask), _mm_slli_epi64(productOdd, 32));
+                    __m128i dist = _mm_xor_si128(_mm_add_epi32(_mm_and_si128(frac, fracMask), tieOffset), signBit);
+
+                    if (_mm_movemask_epi8(_mm_cmpgt_epi32(dist, tieLimit)) != 0xFFFF)
+                    {
+                        // too close to a rounding tie -> let the scalar kernel use the double path
+                        scalar.apply[idx(st)](inBytes + s * bytesPerSample, outBytes + s * bytesPerSample, 4, gain);
+                        continue;
+                    }
+                }
+
+                // results fit into 31 bits (see makeFixedGain)
+                __m128i resultEven = _mm_srl_epi64(_mm_add_epi64(productEven, half), shift);
+                __m128i resultOdd = _mm_srl_epi64(_mm_add_epi64(productOdd, half), shift);
+                __m128i result = _mm_or_si128(resultEven, _mm_slli_epi64(resultOdd, 32));
+
+                // min(result, maxOut)
+                __m128i greater = _mm_cmpgt_epi32(result, maxOut);
+                result = _mm_or_si128(_mm_and_si128(greater, maxOut), _mm_andnot_si128(greater, result));
+
+                // restore the sign
+                result = _mm_sub_epi32(_mm_xor_si128(result, sign), sign);
+
+                storeInt32x4<st>(result, out, s);
+            }
+
+            if (s < numSamples)
+            {
+                scalar.apply[idx(st)](inBytes + s * bytesPerSample, outBytes + s * bytesPerSample, numSamples - s, gain);
+            }
+        }
+    }
+
+
+    bool fillFixedGainKernelsSSE2(FixedGainKernels& kernels)
+    {
+        kernels.apply[idx(common::SampleType::Int8)] = applyGain<common::SampleType::Int8, 127>;
+        kernels.apply[idx(common::SampleType::Int16)] = applyGain<common::SampleType::Int16, 32767>;
+        kernels.apply[idx(common::SampleType::Int24)] = applyGain<common::SampleType::Int24, 8388607>;
+        kernels.apply[idx(common::SampleType::Int32)] = applyGain<common::SampleType::Int32, 2147483647>;
+
+        return true;
+    }
+}
+
+#else
+
+namespace simd
+{
+    bool fillFixedGainKernelsSSE2(FixedGainKernels& kernels)
+    {
+        return false;
+    }
+}
+
+#endif
@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "common/sampletype.hpp"
+#include "simd/cpu.hpp"
+#include "simd/minmax.hpp"
+#include "simd/minmax_impl.hpp"
+#include "vsutils/bitshift.hpp"
+
+namespace simd
+{
+    template <typename sample_t, size_t IntSampleBits>
+    static void scalarMinMax(const void* in, int numSamples, MinMax& range)
+    {
+        const sample_t* inPtr = static_cast<const sample_t*>(in);
+
+        if constexpr (std::is_integral_v<sample_t>)
+        {
+            if (numSamples <= 0)
+            {
+                return;
+            }
+
+            // the bit shift is monotonic: it is applied once to the result
+            sample_t minSample = inPtr[0];
+            sample_t maxSample = inPtr[0];
+
+            for (int s = 1; s < numSamples; ++s)
+            {
+                minSample = std::min(minSample, inPtr[s]);
+                maxSample = std::max(maxSample, inPtr[s]);
+            }
+
+            constexpr vsutils::BitShift bitShift = vsutils::getSampleBitShift<sample_t, IntSampleBits>();
+
+            if constexpr (bitShift.required)
+            {
+                minSample >>= bitShift.count;
+                maxSample >>= bitShift.count;
+            }
+
+            range.min = std::min(range.min, static_cast<double>(minSample));
+            range.max = std::max(range.max, static_cast<double>(maxSample));
+        }
+        else
+        {
+            sample_t minSample = std::numeric_limits<sample_t>::infinity();
+            sample_t maxSample = -std::numeric_limits<sample_t>::infinity();
+
+            for (int s = 0; s < numSamples; ++s)
+            {
+                // the accumulator is the first argument: a NaN sample keeps it
+                minSample = std::min(minSample, inPtr[s]);
+                maxSample = std::max(maxSample, inPtr[s]);
+            }
+
+            range.min = std::min(range.min, static_cast<double>(minSample));
+            range.max = std::max(range.max, static_cast<double>(maxSample));
+        }
+    }
+
+
+    static constexpr MinMaxKernels scalarKernels =
+    {
+        .minMax =
+        {
+            scalarMinMax<int8_t, 8>,
+            scalarMinMax<int16_t, 16>,
+            scalarMinMax<int32_t, 24>,
+            scalarMinMax<int32_t, 32>,
+            scalarMinMax<float, 0>,
+            scalarMinMax<double, 0>,
+        },
+    };
+
+    static MinMaxKernels activeKernels = scalarKernels;
+
+    static Isa activeIsa = Isa::Scalar;
+
+
+    void initMinMaxKernels(Isa isa)
+    {
+        MinMaxKernels kernels = scalarKernels;
+        bool available = false;
+
+        switch (isa)
+        {
+            case Isa::SSE2:
+                available = fillMinMaxKernelsSSE2(kernels);
+                break;
+            case Isa::AVX2:
+                available = fillMinMaxKernelsAVX2(kernels);
+                break;
+            case Isa::NEON:
+                available = fillMinMaxKernelsNEON(kernels);
+                break;
+            case Isa::Scalar:
+            default:
+                break;
+        }
+
+        if (available)
+        {
+            activeKernels = kernels;
+            activeIsa = isa;
+        }
+        else
+        {
+            activeKernels = scalarKernels;
+            activeIsa = Isa::Scalar;
+        }
+    }
+
+
+    void initMinMaxKernels()
+    {
+        Isa isa = detectIsa();
+
+        initMinMaxKernels(isa);
+
+        if (activeIsa == Isa::Scalar && isa == Isa::AVX2)
+        {
+            // AVX2 kernels not built
+            initMinMaxKernels(Isa::SSE2);
+        }
+    }
+
+
+    Isa getMinMaxIsa()
+    {
+        return activeIsa;
+    }
+
+
+    const MinMaxKernels& getMinMaxKernels()
+    {
+        return activeKernels;
+    }
+
+
+    const MinMaxKernels& getScalarMinMaxKernels()
+    {
+        return scalarKernels;
+    }
+}
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+
+#include "common/sampletype.hpp"
+#include "simd/cpu.hpp"
+
+namespace simd
+{
+    // smallest and largest sample value (integer samples as integer value after the bit shift of the sample type)
+    struct MinMax
+    {
+        double min;
+        double max;
+    };
+
+
+    /**
+     * extends range by the smallest and largest of numSamples samples of one sample type
+     * NaN samples are ignored
+     */
+    using MinMaxKernel = void (*)(const void* in, int numSamples, MinMax& range);
+
+
+    struct MinMaxKernels
+    {
+        // indexed by common::SampleType
+        MinMaxKernel minMax[common::NumSampleTypes];
+    };
+
+
+    // selects the min/max kernels for the running CPU
+    // call once at plugin initialization; the scalar kernels are used until then
+    void initMinMaxKernels();
+
+    // force a specific instruction set (falls back to scalar if not supported by the build)
+    void initMinMaxKernels(Isa isa);
+
+    Isa getMinMaxIsa();
+
+    const MinMaxKernels& getMinMaxKernels();
+
+    // reference kernels, also used for the remaining samples of the SIMD kernels
+    const MinMaxKernels& getScalarMinMaxKernels();
+
+
+    template <typename sample_t, size_t IntSampleBits>
+    requires std::integral<sample_t> || std::floating_point<sample_t>
+    void findMinMax(const sample_t* in, int numSamples, MinMax& range)
+    {
+        constexpr size_t index = static_cast<size_t>(common::toSampleType<sample_t, IntSampleBits>());
+        getMinMaxKernels().minMax[index](in, numSamples, range);
+    }
+}
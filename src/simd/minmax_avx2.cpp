@@ -0,0 +1,231 @@
+// SPDX-License-Identifier: MIT
+
+// this file is compiled with AVX2 enabled
+// only call these kernels if the CPU supports AVX2 (see simd::detectIsa)
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "common/sampletype.hpp"
+#include "simd/minmax.hpp"
+#include "simd/minmax_impl.hpp"
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+namespace simd
+{
+    namespace
+    {
+        constexpr size_t idx(common::SampleType st)
+        {
+            return static_cast<size_t>(st);
+        }
+
+
+        void minMaxInt8(const void* in, int numSamples, MinMax& range)
+        {
+            const int8_t* inPtr = static_cast<const int8_t*>(in);
+            const MinMaxKernel scalar = getScalarMinMaxKernels().minMax[idx(common::SampleType::Int8)];
+
+            constexpr int lanes = 32;
+
+            if (numSamples < lanes)
+            {
+                scalar(in, numSamples, range);
+                return;
+            }
+
+            __m256i minV = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inPtr));
+            __m256i maxV = minV;
+
+            int s = lanes;
+            for (; s + lanes <= numSamples; s += lanes)
+            {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inPtr + s));
+                minV = _mm256_min_epi8(minV, x);
+                maxV = _mm256_max_epi8(maxV, x);
+            }
+
+            alignas(32) int8_t minLanes[lanes];
+            alignas(32) int8_t maxLanes[lanes];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(minLanes), minV);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(maxLanes), maxV);
+
+            scalar(minLanes, lanes, range);
+            scalar(maxLanes, lanes, range);
+            scalar(inPtr + s, numSamples - s, range);
+        }
+
+
+        void minMaxInt16(const void* in, int numSamples, MinMax& range)
+        {
+            const int16_t* inPtr = static_cast<const int16_t*>(in);
+            const MinMaxKernel scalar = getScalarMinMaxKernels().minMax[idx(common::SampleType::Int16)];
+
+            constexpr int lanes = 16;
+
+            if (numSamples < lanes)
+            {
+                scalar(in, numSamples, range);
+                return;
+            }
+
+            __m256i minV = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inPtr));
+            __m256i maxV = minV;
+
+            int s = lanes;
+            for (; s + lanes <= numSamples; s += lanes)
+            {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inPtr + s));
+                minV = _mm256_min_epi16(minV, x);
+                maxV = _mm256_max_epi16(maxV, x);
+            }
+
+            alignas(32) int16_t minLanes[lanes];
+            alignas(32) int16_t maxLanes[lanes];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(minLanes), minV);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(maxLanes), maxV);
+
+            scalar(minLanes, lanes, range);
+            scalar(maxLanes, lanes, range);
+            scalar(inPtr + s, numSamples - s, range);
+        }
+
+
+        // Int24 and Int32: the bit shift of Int24 is applied by the scalar kernel
+        template <common::SampleType st>
+        void minMaxInt32(const void* in, int numSamples, MinMax& range)
+        {
+            const int32_t* inPtr = static_cast<const int32_t*>(in);
+            const MinMaxKernel scalar = getScalarMinMaxKernels().minMax[idx(st)];
+
+            constexpr int lanes = 8;
+
+            if (numSamples < lanes)
+            {
+                scalar(in, numSamples, range);
+                return;
+            }
+
+            __m256i minV = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inPtr));
+            __m256i maxV = minV;
+
+            int s = lanes;
+            for (; s + lanes <= numSamples; s += lanes)
+            {
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inPtr + s));
+                minV = _mm256_min_epi32(minV, x);
+                maxV = _mm256_max_epi32(maxV, x);
+            }
+
+            alignas(32) int32_t minLanes[lanes];
+            alignas(32) int32_t maxLanes[lanes];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(minLanes), minV);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(maxLanes), maxV);
+
+            scalar(minLanes, lanes, range);
+            scalar(maxLanes, lanes, range);
+            scalar(inPtr + s, numSamples - s, range);
+        }
+
+
+        void minMaxFloat(const void* in, int numSamples, MinMax& range)
+        {
+            const float* inPtr = static_cast<const float*>(in);
+            const MinMaxKernel scalar = getScalarMinMaxKernels().minMax[idx(common::SampleType::Float32)];
+
+            constexpr int lanes = 8;
+
+            __m256 minV = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+            __m256 maxV = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+
+            int s = 0;
+            for (; s + lanes <= numSamples; s += lanes)
+            {
+                __m256 x = _mm256_loadu_ps(inPtr + s);
+
+                // vminps/vmaxps return the second operand if one is NaN: NaN samples are ignored
+                minV = _mm256_min_ps(x, minV);
+                maxV = _mm256_max_ps(x, maxV);
+            }
+
+            alignas(32) float minLanes[lanes];
+            alignas(32) float maxLanes[lanes];
+            _mm256_store_ps(minLanes, minV);
+            _mm256_store_ps(maxLanes, maxV);
+
+            // lanes without any sample (or only NaN samples) are still infinity: only the min lanes for the min, only the max lanes for the max
+            for (int l = 0; l < lanes; ++l)
+            {
+                range.min = std::min(range.min, static_cast<double>(minLanes[l]));
+                range.max = std::max(range.max, static_cast<double>(maxLanes[l]));
+            }
+
+            scalar(inPtr + s, numSamples - s, range);
+        }
+
+
+        void minMaxDouble(const void* in, int numSamples, MinMax& range)
+        {
+            const double* inPtr = static_cast<const double*>(in);
+            const MinMaxKernel scalar = getScalarMinMaxKernels().minMax[idx(common::SampleType::Float64)];
+
+            constexpr int lanes = 4;
+
+            __m256d minV = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+            __m256d maxV = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+
+            int s = 0;
+            for (; s + lanes <= numSamples; s += lanes)
+            {
+                __m256d x = _mm256_loadu_pd(inPtr + s);
+
+                // vminpd/vmaxpd return the second operand if one is NaN: NaN samples are ignored
+                minV = _mm256_min_pd(x, minV);
+                maxV = _mm256_max_pd(x, maxV);
+            }
+
+            alignas(32) double minLanes[lanes];
+            alignas(32) double maxLanes[lanes];
+            _mm256_store_pd(minLanes, minV);
+            _mm256_store_pd(maxLanes, maxV);
+
+            // lanes without any sample (or only NaN samples) are still infinity: only the min lanes for the min, only the max lanes for the max
+            for (int l = 0; l < lanes; ++l)
+            {
+                range.min = std::min(range.min, static_cast<double>(minLanes[l]));
+                range.max = std::max(range.max, static_cast<double>(maxLanes[l]));
+            }
+
+            scalar(inPtr + s, numSamples - s, range);
+        }
+    }
+
+
+    bool fillMinMaxKernelsAVX2(MinMaxKernels& kernels)
+    {
+        kernels.minMax[idx(common::SampleType::Int8)] = minMaxInt8;
+        kernels.minMax[idx(common::SampleType::Int16)] = minMaxInt16;
+        kernels.minMax[idx(common::SampleType::Int24)] = minMaxInt32<common::SampleType::Int24>;
+        kernels.minMax[idx(common::SampleType::Int32)] = minMaxInt32<common::SampleType::Int32>;
+        kernels.minMax[idx(common::SampleType::Float32)] = minMaxFloat;
+        kernels.minMax[idx(common::SampleType::Float64)] = minMaxDouble;
+
+        return true;
+    }
+}
+
+#else
+
+namespace simd
+{
+    bool fillMinMaxKernelsAVX2(MinMaxKernels& kernels)
+    {
+        return false;
+    }
+}
+
+#endif
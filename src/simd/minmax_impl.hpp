@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "simd/minmax.hpp"
+
+// internal: instruction set specific kernel tables
+// every function returns false if the instruction set is not available in this build
+// the kernels fall back to the scalar kernels for the remaining samples
+namespace simd
+{
+    bool fillMinMaxKernelsSSE2(MinMaxKernels& kernels);
+
+    bool fillMinMaxKernelsAVX2(MinMaxKernels& kernels);
+
+    bool fillMinMaxKernelsNEON(MinMaxKernels& kernels);
+}
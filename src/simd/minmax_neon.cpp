@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: MIT
+
+// NEON is part of every ARM64 CPU
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "common/sampletype.hpp"
+#include "simd/minmax.hpp"
+#include "simd/minmax_impl.hpp"
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+
+#include <arm_neon.h>
+
+namespace simd
+{
+    namespace
+    {
+        constexpr size_t idx(common::SampleType st)
+        {
+            return static_cast<size_t>(st);
+        }
+
+
+        void minMaxInt8(const void* in, int numSamples, MinMax& range)
+        {
+            const int8_t* inPtr = static_cast<const int8_t*>(in);
+            const MinMaxKernel scalar = getScalarMinMaxKernels().minMax[idx(common::SampleType::Int8)];
+
+            constexpr int lanes = 16;
+
+            if (numSamples < lanes)
+            {
+                scalar(in, numSamples, range);
+                return;
+            }
+
+            int8x16_t minV = vld1q_s8(inPtr);
+            int8x16_t maxV = minV;
+
+            int s = lanes;
+            for (; s + lanes <= numSamples; s += lanes)
+            {
+                int8x16_t x = vld1q_s8(inPtr + s);
+                minV = vminq_s8(minV, x);
+                maxV = vmaxq_s8(maxV, x);
+            }
+
+            int8_t minMax[2] = { vminvq_s8(minV), vmaxvq_s8(maxV) };
+
+            scalar(minMax, 2, range);
+            scalar(inPtr + s, numSamples - s, range);
+        }
+
+
+        void minMaxInt16(const void* in, int numSamples, MinMax& range)
+        {
+            const int16_t* inPtr = static_cast<const int16_t*>(in);
+            const MinMaxKernel scalar = getScalarMinMaxKernels().minMax[idx(common::SampleType::Int16)];
+
+            constexpr int lanes = 8;
+
+            if (numSamples < lanes)
+            {
+                scalar(in, numSamples, range);
+                return;
+            }
+
+            int16x8_t minV = vld1q_s16(inPtr);
+            int16x8_t maxV = minV;
+
+            int s = lanes;
+            for (; s + lanes <= numSamples; s += lanes)
+            {
+                int16x8_t x = vld1q_s16(inPtr + s);
+                minV = vminq_s16(minV, x);
+                maxV = vmaxq_s16(maxV, x);
+            }
+
+            int16_t minMax[2] = { vminvq_s16(minV), vmaxvq_s16(maxV) };
+
+            scalar(minMax, 2, range);
+            scalar(inPtr + s, numSamples - s, range);
+        }
+
+
+        // Int24 and Int32: the bit shift of Int24 is applied by the scalar kernel
+        template <common::SampleType st>
+        void minMaxInt32(const void* in, int numSamples, MinMax& range)
+        {
+            const int32_t* inPtr = static_cast<const int32_t*>(in);
+            const MinMaxKernel scalar = getScalarMinMaxKernels().minMax[idx(st)];
+
+            constexpr int lanes = 4;
+
+            if (numSamples < lanes)
+            {
+                scalar(in, numSamples, range);
+                return;
+            }
+
+            int32x4_t minV = vld1q_s32(inPtr);
+            int32x4_t maxV = minV;
+
+            int s = lanes;
+            for (; s + lanes <= numSamples; s += lanes)
+            {
+                int32x4_t x = vld1q_s32(inPtr + s);
+                minV = vminq_s32(minV, x);
+                maxV = vmaxq_s32(maxV, x);
+            }
+
+            int32_t minMax[2] = { vminvq_s32(minV), vmaxvq_s32(maxV) };
+
+            scalar(minMax, 2, range);
+            scalar(inPtr + s, numSamples - s, range);
+        }
+
+
+        void minMaxFloat(const void* in, int numSamples, MinMax& range)
+        {
+            const float* inPtr = static_cast<const float*>(in);
+            const MinMaxKernel scalar = getScalarMinMaxKernels().minMax[idx(common::SampleType::Float32)];
+
+            constexpr int lanes = 4;
+
+            float32x4_t minV = vdupq_n_f32(std::numeric_limits<float>::infinity());
+            float32x4_t maxV = vdupq_n_f32(-std::numeric_limits<float>::infinity());
+
+            int s = 0;
+            for (; s + lanes <= numSamples; s += lanes)
+            {
+                float32x4_t x = vld1q_f32(inPtr + s);
+
+                // fminnm/fmaxnm return the number if one operand is NaN: NaN samples are ignored
+                minV = vminnmq_f32(minV, x);
+                maxV = vmaxnmq_f32(maxV, x);
+            }
+
+            // lanes without any sample (or only NaN samples) are still infinity: only the min lanes for the min, only the max lanes for the max
+            range.min = std::min(range.min, static_cast<double>(vminnmvq_f32(minV)));
+            range.max = std::max(range.max, static_cast<double>(vmaxnmvq_f32(maxV)));
+
+            scalar(inPtr + s, numSamples - s, range);
+        }
+
+
+        void minMaxDouble(const void* in, int numSamples, MinMax& range)
+        {
+            const double* inPtr = static_cast<const double*>(in);
+            const MinMaxKernel scalar = getScalarMinMaxKernels().minMax[idx(common::SampleType::Float64)];
+
+            constexpr int lanes = 2;
+
+            float64x2_t minV = vdupq_n_f64(std::numeric_limits<double>::infinity());
+            float64x2_t maxV = vdupq_n_f64(-std::numeric_limits<double>::infinity());
+
+            int s = 0;
+            for (; s + lanes <= numSamples; s += lanes)
+            {
+                float64x2_t x = vld1q_f64(inPtr + s);
+
+                // fminnm/fmaxnm return the number if one operand is NaN: NaN samples are ignored
+                minV = vminnmq_f64(minV, x);
+                maxV = vmaxnmq_f64(maxV, x);
+            }
+
+            // lanes without any sample (or only NaN samples) are still infinity: only the min lanes for the min, only the max lanes for the max
+            range.min = std::min(range.min, vminnmvq_f64(minV));
+            range.max = std::max(range.max, vmaxnmvq_f64(maxV));
+
+            scalar(inPtr + s, numSamples - s, range);
+        }
+    }
+
+
+    bool fillMinMaxKernelsNEON(MinMaxKernels& kernels)
+    {
+        kernels.minMax[idx(common::SampleType::Int8)] = minMaxInt8;
+        kernels.minMax[idx(common::SampleType::Int16)] = minMaxInt16;
+        kernels.minMax[idx(common::SampleType::Int24)] = minMaxInt32<common::SampleType::Int24>;
+        kernels.minMax[idx(common::SampleType::Int32)] = minMaxInt32<common::SampleType::Int32>;
+        kernels.minMax[idx(common::SampleType::Float32)] = minMaxFloat;
+        kernels.minMax[idx(common::SampleType::Float64)] = minMaxDouble;
+
+        return true;
+    }
+}
+
+#else
+
+namespace simd
+{
+    bool fillMinMaxKernelsNEON(MinMaxKernels& kernels)
+    {
+        return false;
+    }
+}
+
+#endif
@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: MIT
+
+// SSE2 is part of every x86-64 CPU, on 32-bit x86 the CPU support is checked at runtime (see simd::detectIsa)
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "common/sampletype.hpp"
+#include "simd/minmax.hpp"
+#include "simd/minmax_impl.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+
+namespace simd
+{
+    namespace
+    {
+        constexpr size_t idx(common::SampleType st)
+        {
+            return static_cast<size_t>(st);
+        }
+
+
+        // 16 int8 samples per vector, signed compare via unsigned min/max with flipped sign bits
+        void minMaxInt8(const void* in, int numSamples, MinMax& range)
+        {
+            const int8_t* inPtr = static_cast<const int8_t*>(in);
+            const MinMaxKernel scalar = getScalarMinMaxKernels().minMax[idx(common::SampleType::Int8)];
+
+            constexpr int lanes = 16;
+
+            if (numSamples < lanes)
+            {
+                scalar(in, numSamples, range);
+                return;
+            }
+
+            const __m128i signBits = _mm_set1_epi8(INT8_MIN);
+
+            __m128i minV = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(inPtr)), signBits);
+            __m128i maxV = minV;
+
+            int s = lanes;
+            for (; s + lanes <= numSamples; s += lanes)
+            {
+                __m128i x = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(inPtr + s)), signBits);
+                minV = _mm_min_epu8(minV, x);
+                maxV = _mm_max_epu8(maxV, x);
+            }
+
+            alignas(16) int8_t minLanes[lanes];
+            alignas(16) int8_t maxLanes[lanes];
+            _mm_store_si128(reinterpret_cast<__m128i*>(minLanes), _mm_xor_si128(minV, signBits));
+            _mm_store_si128(reinterpret_cast<__m128i*>(maxLanes), _mm_xor_si128(maxV, signBits));
+
+            scalar(minLanes, lanes, range);
+            scalar(maxLanes, lanes, range);
+            scalar(inPtr + s, numSamples - s, range);
+        }
+
+
+        void minMaxInt16(const void* in, int numSamples, MinMax& range)
+        {
+            const int16_t* inPtr = static_cast<const int16_t*>(in);
+            const MinMaxKernel scalar = getScalarMinMaxKernels().minMax[idx(common::SampleType::Int16)];
+
+            constexpr int lanes = 8;
+
+            if (numSamples < lanes)
+            {
+                scalar(in, numSamples, range);
+                return;
+            }
+
+            __m128i minV = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inPtr));
+            __m128i maxV = minV;
+
+            int s = lanes;
+            for (; s + lanes <= numSamples; s += lanes)
+            {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inPtr + s));
+                minV = _mm_min_epi16(minV, x);
+                maxV = _mm_max_epi16(maxV, x);
+            }
+
+            alignas(16) int16_t minLanes[lanes];
+            alignas(16) int16_t maxLanes[lanes];
+            _mm_store_si128(reinterpret_cast<__m128i*>(minLanes), minV);
+            _mm_store_si128(reinterpret_cast<__m128i*>(maxLanes), maxV);
+
+            scalar(minLanes, lanes, range);
+            scalar(maxLanes, lanes, range);
+            scalar(inPtr + s, numSamples - s, range);
+        }
+
+
+        // Int24 and Int32: the bit shift of Int24 is applied by the scalar kernel
+        template <common::SampleType st>
+        void minMaxInt32(const void* in, int numSamples, MinMax& range)
+        {
+            const int32_t* inPtr = static_cast<const int32_t*>(in);
+            const MinMaxKernel scalar = getScalarMinMaxKernels().minMax[idx(st)];
+
+            constexpr int lanes = 4;
+
+            if (numSamples < lanes)
+            {
+                scalar(in, numSamples, range);
+                return;
+            }
+
+            __m128i minV = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inPtr));
+            __m128i maxV = minV;
+
+            int s = lanes;
+            for (; s + lanes <= numSamples; s += lanes)
+            {
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inPtr + s));
+
+                // no 32 bit min/max before SSE4.1
+                __m128i less = _mm_cmplt_epi32(x, minV);
+                minV = _mm_or_si128(_mm_and_si128(less, x), _mm_andnot_si128(less, minV));
+
+                __m128i greater = _mm_cmpgt_epi32(x, maxV);
+                maxV = _mm_or_si128(_mm_and_si128(greater, x), _mm_andnot_si128(greater, maxV));
+            }
+
+            alignas(16) int32_t minLanes[lanes];
+            alignas(16) int32_t maxLanes[lanes];
+            _mm_store_si128(reinterpret_cast<__m128i*>(minLanes), minV);
+            _mm_store_si128(reinterpret_cast<__m128i*>(maxLanes), maxV);
+
+            scalar(minLanes, lanes, range);
+            scalar(maxLanes, lanes, range);
+            scalar(inPtr + s, numSamples - s, range);
+        }
+
+
+        void minMaxFloat(const void* in, int numSamples, MinMax& range)
+        {
+            const float* inPtr = static_cast<const float*>(in);
+            const MinMaxKernel scalar = getScalarMinMaxKernels().minMax[idx(common::SampleType::Float32)];
+
+            constexpr int lanes = 4;
+
+            __m128 minV = _mm_set1_ps(std::numeric_limits<float>::infinity());
+            __m128 maxV = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+
+            int s = 0;
+            for (; s + lanes <= numSamples; s += lanes)
+            {
+                __m128 x = _mm_loadu_ps(inPtr + s);
+
+                // minps/maxps return the second operand if one is NaN: NaN samples are ignored
+                minV = _mm_min_ps(x, minV);
+                maxV = _mm_max_ps(x, maxV);
+            }
+
+            alignas(16) float minLanes[lanes];
+            alignas(16) float maxLanes[lanes];
+            _mm_store_ps(minLanes, minV);
+            _mm_store_ps(maxLanes, maxV);
+
+            // lanes without any sample (or only NaN samples) are still infinity: only the min lanes for the min, only the max lanes for the max
+            for (int l = 0; l < lanes; ++l)
+            {
+                range.min = std::min(range.min, static_cast<double>(minLanes[l]));
+                range.max = std::max(range.max, static_cast<double>(maxLanes[l]));
+            }
+
+            scalar(inPtr + s, numSamples - s, range);
+        }
+
+
+        void minMaxDouble(const void* in, int numSamples, MinMax& range)
+        {
+            const double* inPtr = static_cast<const double*>(in);
+            const MinMaxKernel scalar = getScalarMinMaxKernels().minMax[idx(common::SampleType::Float64)];
+
+            constexpr int lanes = 2;
+
+            __m128d minV = _mm_set1_pd(std::numeric_limits<double>::infinity());
+            __m128d maxV = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+
+            int s = 0;
+            for (; s + lanes <= numSamples; s += lanes)
+            {
+                __m128d x = _mm_loadu_pd(inPtr + s);
+
+                // minpd/maxpd return the second operand if one is NaN: NaN samples are ignored
+                minV = _mm_min_pd(x, minV);
+                maxV = _mm_max_pd(x, maxV);
+            }
+
+            alignas(16) double minLanes[lanes];
+            alignas(16) double maxLanes[lanes];
+            _mm_store_pd(minLanes, minV);
+            _mm_store_pd(maxLanes, maxV);
+
+            // lanes without any sample (or only NaN samples) are still infinity: only the min lanes for the min, only the max lanes for the max
+            for (int l = 0; l < lanes; ++l)
+            {
+                range.min = std::min(range.min, static_cast<double>(minLanes[l]));
+                range.max = std::max(range.max, static_cast<double>(maxLanes[l]));
+            }
+
+            scalar(inPtr + s, numSamples - s, range);
+        }
+    }
+
+
+    bool fillMinMaxKernelsSSE2(MinMaxKernels& kernels)
+    {
+        kernels.minMax[idx(common::SampleType::Int8)] = minMaxInt8;
+        kernels.minMax[idx(common::SampleType::Int16)] = minMaxInt16;
+        kernels.minMax[idx(common::SampleType::Int24)] = minMaxInt32<common::SampleType::Int24>;
+        kernels.minMax[idx(common::SampleType::Int32)] = minMaxInt32<common::SampleType::Int32>;
+        kernels.minMax[idx(common::SampleType::Float32)] = minMaxFloat;
+        kernels.minMax[idx(common::SampleType::Float64)] = minMaxDouble;
+
+        return true;
+    }
+}
+
+#else
+
+namespace simd
+{
+    bool fillMinMaxKernelsSSE2(MinMaxKernels& kernels)
+    {
+        return false;
+    }
+}
+
+#endif
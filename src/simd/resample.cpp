@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: MIT
+
+#include <cstddef>
+
+#include "simd/cpu.hpp"
+#include "simd/resample.hpp"
+#include "simd/resample_impl.hpp"
+
+namespace simd
+{
+    static void scalarPolyphase(const double* in, const double* coeffs, int numTaps, int numPhases, int step, int phase,
+                                double* out, int numSamples)
+    {
+        for (int j = 0; j < numSamples; ++j)
+        {
+            const double* c = coeffs + static_cast<ptrdiff_t>(phase) * numTaps;
+
+            double acc0 = 0;
+            double acc1 = 0;
+            double acc2 = 0;
+            double acc3 = 0;
+
+            for (int k = 0; k < numTaps; k += ResampleTapAlign)
+            {
+                acc0 += c[k] * in[k];
+                acc1 += c[k + 1] * in[k + 1];
+                acc2 += c[k + 2] * in[k + 2];
+                acc3 += c[k + 3] * in[k + 3];
+            }
+
+            out[j] = (acc0 + acc2) + (acc1 + acc3);
+
+            phase += step;
+            in += phase / numPhases;
+            phase %= numPhases;
+        }
+    }
+
+
+    static constexpr ResampleKernels scalarKernels =
+    {
+        .polyphase = scalarPolyphase,
+    };
+
+    static ResampleKernels activeKernels = scalarKernels;
+
+    static Isa activeIsa = Isa::Scalar;
+
+
+    void initResampleKernels(Isa isa)
+    {
+        ResampleKernels kernels = scalarKernels;
+        bool available = false;
+
+        switch (isa)
+        {
+            case Isa::SSE2:
+                available = fillResampleKernelsSSE2(kernels);
+                break;
+            case Isa::AVX2:
+                available = fillResampleKernelsAVX2(kernels);
+                break;
+            case Isa::NEON:
+                available = fillResampleKernelsNEON(kernels);
+                break;
+            case Isa::Scalar:
+            default:
+                break;
+        }
+
+        if (available)
+        {
+            activeKernels = kernels;
+            activeIsa = isa;
+        }
+        else
+        {
+            activeKernels = scalarKernels;
+            activeIsa = Isa::Scalar;
+        }
+    }
+
+
+    void initResampleKernels()
+    {
+        Isa isa = detectIsa();
+
+        initResampleKernels(isa);
+
+        if (activeIsa == Isa::Scalar && isa == Isa::AVX2)
+        {
+            // AVX2 kernels not built
+            initResampleKernels(Isa::SSE2);
+        }
+    }
+
+
+    Isa getResampleIsa()
+    {
+        return activeIsa;
+    }
+
+
+    const ResampleKernels& getResampleKernels()
+    {
+        return activeKernels;
+    }
+
+
+    const ResampleKernels& getScalarResampleKernels()
+    {
+        return scalarKernels;
+    }
+}
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "simd/cpu.hpp"
+
+namespace simd
+{
+    // the number of filter taps has to be a multiple of this (one AVX2 vector)
+    constexpr int ResampleTapAlign = 4;
+
+
+    /**
+     * polyphase FIR of a rational rate ratio, writes numSamples output samples
+     * output sample j: out[j] = sum of coeffs[phase_j * numTaps + k] * in[index_j + k] for k in [0, numTaps)
+     * index_0 = 0 and phase_0 = phase, every output sample advances the input position by step / numPhases samples:
+     * phase_j + step = (index_j+1 - index_j) * numPhases + phase_j+1
+     * numTaps has to be a multiple of ResampleTapAlign
+     */
+    using ResampleKernel = void (*)(const double* in, const double* coeffs, int numTaps, int numPhases, int step, int phase,
+                                    double* out, int numSamples);
+
+
+    struct ResampleKernels
+    {
+        ResampleKernel polyphase;
+    };
+
+
+    // selects the resample kernels for the running CPU
+    // call once at plugin initialization; the scalar kernels are used until then
+    void initResampleKernels();
+
+    // force a specific instruction set (falls back to scalar if not supported by the build)
+    void initResampleKernels(Isa isa);
+
+    Isa getResampleIsa();
+
+    const ResampleKernels& getResampleKernels();
+
+    // reference kernels, the SIMD kernels sum the taps in the same order
+    const ResampleKernels& getScalarResampleKernels();
+
+
+    inline void resamplePolyphase(const double* in, const double* coeffs, int numTaps, int numPhases, int step, int phase,
+                                  double* out, int numSamples)
+    {
+        getResampleKernels().polyphase(in, coeffs, numTaps, numPhases, step, phase, out, numSamples);
+    }
+}
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: MIT
+
+// this file is compiled with AVX2 enabled
+// only call these kernels if the CPU supports AVX2 (see simd::detectIsa)
+
+#include <cstddef>
+
+#include "simd/resample.hpp"
+#include "simd/resample_impl.hpp"
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+namespace simd
+{
+    namespace
+    {
+        // all four partial sums in one vector
+        void polyphase(const double* in, const double* coeffs, int numTaps, int numPhases, int step, int phase,
+                       double* out, int numSamples)
+        {
+            for (int j = 0; j < numSamples; ++j)
+            {
+                const double* c = coeffs + static_cast<ptrdiff_t>(phase) * numTaps;
+
+                __m256d acc = _mm256_setzero_pd();
+
+                for (int k = 0; k < numTaps; k += ResampleTapAlign)
+                {
+                    // no fused multiply-add: same result as the scalar kernel
+                    acc = _mm256_add_pd(acc, _mm256_mul_pd(_mm256_loadu_pd(c + k), _mm256_loadu_pd(in + k)));
+                }
+
+                // (s0 + s2, s1 + s3)
+                __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+                out[j] = _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+
+                phase += step;
+                in += phase / numPhases;
+                phase %= numPhases;
+            }
+        }
+    }
+
+
+    bool fillResampleKernelsAVX2(ResampleKernels& kernels)
+    {
+        kernels.polyphase = polyphase;
+
+        return true;
+    }
+}
+
+#else
+
+namespace simd
+{
+    bool fillResampleKernelsAVX2(ResampleKernels& kernels)
+    {
+        return false;
+    }
+}
+
+#endif
@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "simd/resample.hpp"
+
+// internal: instruction set specific kernel tables
+// every function returns false if the instruction set is not available in this build
+// all kernels keep 4 partial sums (tap k goes to sum k % 4) and add them as (s0 + s2) + (s1 + s3) without fused multiply-add
+namespace simd
+{
+    bool fillResampleKernelsSSE2(ResampleKernels& kernels);
+
+    bool fillResampleKernelsAVX2(ResampleKernels& kernels);
+
+    bool fillResampleKernelsNEON(ResampleKernels& kernels);
+}
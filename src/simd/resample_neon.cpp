@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: MIT
+
+// NEON is part of every ARM64 CPU
+
+#include <cstddef>
+
+#include "simd/resample.hpp"
+#include "simd/resample_impl.hpp"
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+
+#include <arm_neon.h>
+
+namespace simd
+{
+    namespace
+    {
+        // partial sums 0, 1 and 2, 3 in two vectors
+        void polyphase(const double* in, const double* coeffs, int numTaps, int numPhases, int step, int phase,
+                       double* out, int numSamples)
+        {
+            for (int j = 0; j < numSamples; ++j)
+            {
+                const double* c = coeffs + static_cast<ptrdiff_t>(phase) * numTaps;
+
+                float64x2_t acc01 = vdupq_n_f64(0.0);
+                float64x2_t acc23 = vdupq_n_f64(0.0);
+
+                for (int k = 0; k < numTaps; k += ResampleTapAlign)
+                {
+                    // no fused multiply-add: same result as the scalar kernel
+                    acc01 = vaddq_f64(acc01, vmulq_f64(vld1q_f64(c + k), vld1q_f64(in + k)));
+                    acc23 = vaddq_f64(acc23, vmulq_f64(vld1q_f64(c + k + 2), vld1q_f64(in + k + 2)));
+                }
+
+                // (s0 + s2, s1 + s3)
+                out[j] = vaddvq_f64(vaddq_f64(acc01, acc23));
+
+                phase += step;
+                in += phase / numPhases;
+                phase %= numPhases;
+            }
+        }
+    }
+
+
+    bool fillResampleKernelsNEON(ResampleKernels& kernels)
+    {
+        kernels.polyphase = polyphase;
+
+        return true;
+    }
+}
+
+#else
+
+namespace simd
+{
+    bool fillResampleKernelsNEON(ResampleKernels& kernels)
+    {
+        return false;
+    }
+}
+
+#endif
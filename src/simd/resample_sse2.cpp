@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: MIT
+
+// SSE2 is part of every x86-64 CPU, on 32-bit x86 the CPU support is checked at runtime (see simd::detectIsa)
+
+#include <cstddef>
+
+#include "simd/resample.hpp"
+#include "simd/resample_impl.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+
+namespace simd
+{
+    namespace
+    {
+        // partial sums 0, 1 and 2, 3 in two vectors
+        void polyphase(const double* in, const double* coeffs, int numTaps, int numPhases, int step, int phase,
+                       double* out, int numSamples)
+        {
+            for (int j = 0; j < numSamples; ++j)
+            {
+                const double* c = coeffs + static_cast<ptrdiff_t>(phase) * numTaps;
+
+                __m128d acc01 = _mm_setzero_pd();
+                __m128d acc23 = _mm_setzero_pd();
+
+                for (int k = 0; k < numTaps; k += ResampleTapAlign)
+                {
+                    // no fused multiply-add: same result as the scalar kernel
+                    acc01 = _mm_add_pd(acc01, _mm_mul_pd(_mm_loadu_pd(c + k), _mm_loadu_pd(in + k)));
+                    acc23 = _mm_add_pd(acc23, _mm_mul_pd(_mm_loadu_pd(c + k + 2), _mm_loadu_pd(in + k + 2)));
+                }
+
+                // (s0 + s2, s1 + s3)
+                __m128d sum = _mm_add_pd(acc01, acc23);
+                out[j] = _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+
+                phase += step;
+                in += phase / numPhases;
+                phase %= numPhases;
+            }
+        }
+    }
+
+
+    bool fillResampleKernelsSSE2(ResampleKernels& kernels)
+    {
+        kernels.polyphase = polyphase;
+
+        return true;
+    }
+}
+
+#else
+
+namespace simd
+{
+    bool fillResampleKernelsSSE2(ResampleKernels& kernels)
+    {
+        return false;
+    }
+}
+
+#endif
@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: MIT
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/sampletype.hpp"
+#include "simd/cpu.hpp"
+#include "simd/sampleconv.hpp"
+#include "simd/sampleconv_impl.hpp"
+#include "utils/sample.hpp"
+#include "vsutils/bitshift.hpp"
+
+namespace simd
+{
+    template <typename sample_t, size_t IntSampleBits>
+    static void scalarToDouble(const void* in, double* out, int numSamples)
+    {
+        const sample_t* inPtr = static_cast<const sample_t*>(in);
+
+        constexpr vsutils::BitShift bitShift = vsutils::getSampleBitShift<sample_t, IntSampleBits>();
+
+        for (int s = 0; s < numSamples; ++s)
+        {
+            sample_t sample = inPtr[s];
+
+            if constexpr (bitShift.required)
+            {
+                sample >>= bitShift.count;
+            }
+
+            out[s] = utils::convSampleToDouble<sample_t, IntSampleBits>(sample);
+        }
+    }
+
+
+    template <typename sample_t, size_t IntSampleBits>
+    static void scalarFromDouble(const double* in, void* out, int numSamples)
+    {
+        sample_t* outPtr = static_cast<sample_t*>(out);
+
+        constexpr vsutils::BitShift bitShift = vsutils::getSampleBitShift<sample_t, IntSampleBits>();
+
+        for (int s = 0; s < numSamples; ++s)
+        {
+            sample_t sample = utils::convSampleFromDouble<sample_t, IntSampleBits>(in[s]);
+
+            if constexpr (bitShift.required)
+            {
+                sample <<= bitShift.count;
+            }
+
+            outPtr[s] = sample;
+        }
+    }
+
+
+    static constexpr SampleConvKernels scalarKernels =
+    {
+        .toDouble =
+        {
+            scalarToDouble<int8_t, 8>,
+            scalarToDouble<int16_t, 16>,
+            scalarToDouble<int32_t, 24>,
+            scalarToDouble<int32_t, 32>,
+            scalarToDouble<float, 0>,
+            scalarToDouble<double, 0>,
+        },
+        .fromDouble =
+        {
+            scalarFromDouble<int8_t, 8>,
+            scalarFromDouble<int16_t, 16>,
+            scalarFromDouble<int32_t, 24>,
+            scalarFromDouble<int32_t, 32>,
+            scalarFromDouble<float, 0>,
+            scalarFromDouble<double, 0>,
+        },
+    };
+
+    static SampleConvKernels activeKernels = scalarKernels;
+
+    static Isa activeIsa = Isa::Scalar;
+
+
+    void initSampleConvKernels(Isa isa)
+    {
+        SampleConvKernels kernels = scalarKernels;
+        bool available = false;
+
+        switch (isa)
+        {
+            case Isa::SSE2:
+                available = fillSampleConvKernelsSSE2(kernels);
+                break;
+            case Isa::AVX2:
+                available = fillSampleConvKernelsAVX2(kernels);
+                break;
+            case Isa::NEON:
+                available = fillSampleConvKernelsNEON(kernels);
+                break;
+            case Isa::Scalar:
+            default:
+                break;
+        }
+
+        if (available)
+        {
+            activeKernels = kernels;
+            activeIsa = isa;
+        }
+        else
+        {
+            activeKernels = scalarKernels;
+            activeIsa = Isa::Scalar;
+        }
+    }
+
+
+    void initSampleConvKernels()
+    {
+        Isa isa = detectIsa();
+
+        initSampleConvKernels(isa);
+
+        if (activeIsa == Isa::Scalar && isa == Isa::AVX2)
+        {
+            // AVX2 kernels not built
+            initSampleConvKernels(Isa::SSE2);
+        }
+    }
+
+
+    Isa getSampleConvIsa()
+    {
+        return activeIsa;
+    }
+
+
+    const SampleConvKernels& getSampleConvKernels()
+    {
+        return activeKernels;
+    }
+
+
+    const SampleConvKernels& getScalarSampleConvKernels()
+    {
+        return scalarKernels;
+    }
+}
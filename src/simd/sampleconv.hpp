@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+
+#include "common/sampletype.hpp"
+#include "simd/cpu.hpp"
+
+namespace simd
+{
+    /**
+     * converts numSamples samples of one sample type to double
+     * same result as utils::convSampleToDouble (including the bit shift of the sample type)
+     */
+    using ToDoubleKernel = void (*)(const void* in, double* out, int numSamples);
+
+    /**
+     * converts numSamples non-overflowing double samples to one sample type
+     * same result as utils::convSampleFromDouble without float clamping (including the bit shift of the sample type)
+     */
+    using FromDoubleKernel = void (*)(const double* in, void* out, int numSamples);
+
+
+    struct SampleConvKernels
+    {
+        // indexed by common::SampleType
+        ToDoubleKernel toDouble[common::NumSampleTypes];
+        FromDoubleKernel fromDouble[common::NumSampleTypes];
+    };
+
+
+    // selects the sample conversion kernels for the running CPU
+    // call once at plugin initialization; the scalar kernels are used until then
+    void initSampleConvKernels();
+
+    // force a specific instruction set (falls back to scalar if not supported by the build)
+    void initSampleConvKernels(Isa isa);
+
+    Isa getSampleConvIsa();
+
+    const SampleConvKernels& getSampleConvKernels();
+
+    // bit-exact reference kernels
+    const SampleConvKernels& getScalarSampleConvKernels();
+
+
+    template <typename sample_t, size_t IntSampleBits>
+    requires std::integral<sample_t> || std::floating_point<sample_t>
+    void convSamplesToDouble(const sample_t* in, double* out, int numSamples)
+    {
+        constexpr size_t index = static_cast<size_t>(common::toSampleType<sample_t, IntSampleBits>());
+        getSampleConvKernels().toDouble[index](in, out, numSamples);
+    }
+
+
+    // same as convSamplesToDouble, but the sample type is selected at runtime
+    inline void convSamplesToDouble(common::SampleType st, const void* in, double* out, int numSamples)
+    {
+        getSampleConvKernels().toDouble[static_cast<size_t>(st)](in, out, numSamples);
+    }
+
+
+    template <typename sample_t, size_t IntSampleBits>
+    requires std::integral<sample_t> || std::floating_point<sample_t>
+    void convSamplesFromDouble(const double* in, sample_t* out, int numSamples)
+    {
+        constexpr size_t index = static_cast<size_t>(common::toSampleType<sample_t, IntSampleBits>());
+        getSampleConvKernels().fromDouble[index](in, out, numSamples);
+    }
+}
@@ -0,0 +1,277 @@
+// SPDX-License-Identifier: MIT
+
+// this file is compiled with AVX2 enabled
+// only call these kernels if the CPU supports AVX2 (see simd::detectIsa)
+
+#include <cstdint>
+#include <cstring>
+
+#include "common/sampletype.hpp"
+#include "simd/sampleconv.hpp"
+#include "simd/sampleconv_impl.hpp"
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+namespace simd
+{
+    namespace
+    {
+        constexpr size_t idx(common::SampleType st)
+        {
+            return static_cast<size_t>(st);
+        }
+
+
+        // 4 int32 -> 4 normalized doubles (minInt is clamped to -maxInt)
+        inline __m256d intToNormDouble(__m128i v, __m256d negMaxInt, __m256d maxInt)
+        {
+            return _mm256_div_pd(_mm256_max_pd(_mm256_cvtepi32_pd(v), negMaxInt), maxInt);
+        }
+
+
+        // 8 int32 -> 8 normalized doubles
+        inline void storeNormDouble8(__m256i v, double* out, __m256d negMaxInt, __m256d maxInt)
+        {
+            _mm256_storeu_pd(out,     intToNormDouble(_mm256_castsi256_si128(v), negMaxInt, maxInt));
+            _mm256_storeu_pd(out + 4, intToNormDouble(_mm256_extracti128_si256(v, 1), negMaxInt, maxInt));
+        }
+
+
+        template <common::SampleType st>
+        inline __m256i loadInt32x8(const void* in, int s)
+        {
+            if constexpr (st == common::SampleType::Int8)
+            {
+                return _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(static_cast<const int8_t*>(in) + s)));
+            }
+            else if constexpr (st == common::SampleType::Int16)
+            {
+                return _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(static_cast<const int16_t*>(in) + s)));
+            }
+            else if constexpr (st == common::SampleType::Int24)
+            {
+                return _mm256_srai_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(static_cast<const int32_t*>(in) + s)), 8);
+            }
+            else
+            {
+                return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(static_cast<const int32_t*>(in) + s));
+            }
+        }
+
+
+        template <common::SampleType st, int32_t MaxInt>
+        void intToDouble(const void* in, double* out, int numSamples)
+        {
+            const __m256d maxInt = _mm256_set1_pd(static_cast<double>(MaxInt));
+            const __m256d negMaxInt = _mm256_set1_pd(-static_cast<double>(MaxInt));
+
+            int s = 0;
+            for (; s + 8 <= numSamples; s += 8)
+            {
+                storeNormDouble8(loadInt32x8<st>(in, s), out + s, negMaxInt, maxInt);
+            }
+
+            if (s < numSamples)
+            {
+                const SampleConvKernels& scalar = getScalarSampleConvKernels();
+                const uint8_t* inBytes = static_cast<const uint8_t*>(in);
+                size_t bytesPerSample = st == common::SampleType::Int8 ? 1 : (st == common::SampleType::Int16 ? 2 : 4);
+
+                scalar.toDouble[idx(st)](inBytes + s * bytesPerSample, out + s, numSamples - s);
+            }
+        }
+
+
+        void floatToDouble(const void* in, double* out, int numSamples)
+        {
+            const float* inPtr = static_cast<const float*>(in);
+
+            int s = 0;
+            for (; s + 4 <= numSamples; s += 4)
+            {
+                _mm256_storeu_pd(out + s, _mm256_cvtps_pd(_mm_loadu_ps(inPtr + s)));
+            }
+
+            for (; s < numSamples; ++s)
+            {
+                out[s] = static_cast<double>(inPtr[s]);
+            }
+        }
+
+
+        void doubleToDouble(const void* in, double* out, int numSamples)
+        {
+            std::memcpy(out, in, static_cast<size_t>(numSamples) * sizeof(double));
+        }
+
+
+        // same as std::round (round half away from zero) for |x| < 2^52
+        inline __m256d roundHalfAway(__m256d x)
+        {
+            const __m256d signMask = _mm256_set1_pd(-0.0);
+            const __m256d half = _mm256_set1_pd(0.5);
+            const __m256d one = _mm256_set1_pd(1.0);
+
+            __m256d trunc = _mm256_round_pd(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+
+            // exact
+            __m256d absFrac = _mm256_andnot_pd(signMask, _mm256_sub_pd(x, trunc));
+
+            __m256d roundAway = _mm256_cmp_pd(absFrac, half, _CMP_GE_OQ);
+
+            // copysign(1, x)
+            __m256d signedOne = _mm256_or_pd(_mm256_and_pd(x, signMask), one);
+
+            return _mm256_add_pd(trunc, _mm256_and_pd(roundAway, signedOne));
+        }
+
+
+        // 4 doubles -> 4 int32: clamp to [-1, 1], scale to maxInt and round
+        inline __m128i normDoubleToInt(__m256d x, __m256d maxInt)
+        {
+            const __m256d negOne = _mm256_set1_pd(-1.0);
+            const __m256d one = _mm256_set1_pd(1.0);
+
+            x = _mm256_min_pd(_mm256_max_pd(x, negOne), one);
+
+            return _mm256_cvttpd_epi32(roundHalfAway(_mm256_mul_pd(x, maxInt)));
+        }
+
+
+        inline bool hasNaN(__m256d a, __m256d b)
+        {
+            return (_mm256_movemask_pd(_mm256_cmp_pd(a, a, _CMP_UNORD_Q)) | _mm256_movemask_pd(_mm256_cmp_pd(b, b, _CMP_UNORD_Q))) != 0;
+        }
+
+
+        template <common::SampleType st, int32_t MaxInt>
+        void doubleToInt(const double* in, void* out, int numSamples)
+        {
+            const __m256d maxInt = _mm256_set1_pd(static_cast<double>(MaxInt));
+
+            const SampleConvKernels& scalar = getScalarSampleConvKernels();
+            size_t bytesPerSample = st == common::SampleType::Int8 ? 1 : (st == common::SampleType::Int16 ? 2 : 4);
+            uint8_t* outBytes = static_cast<uint8_t*>(out);
+
+            int s = 0;
+            for (; s + 8 <= numSamples; s += 8)
+            {
+                __m256d x0 = _mm256_loadu_pd(in + s);
+                __m256d x1 = _mm256_loadu_pd(in + s + 4);
+
+                if (hasNaN(x0, x1))
+                {
+                    // conversion of NaN is implementation defined -> let the scalar kernel decide
+                    scalar.fromDouble[idx(st)](in + s, outBytes + s * bytesPerSample, 8);
+                    continue;
+                }
+
+                __m128i i0 = normDoubleToInt(x0, maxInt);
+                __m128i i1 = normDoubleToInt(x1, maxInt);
+
+                if constexpr (st == common::SampleType::Int8)
+                {
+                    __m128i i16 = _mm_packs_epi32(i0, i1);
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(static_cast<int8_t*>(out) + s), _mm_packs_epi16(i16, i16));
+                }
+                else if constexpr (st == common::SampleType::Int16)
+                {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(static_cast<int16_t*>(out) + s), _mm_packs_epi32(i0, i1));
+                }
+                else
+                {
+                    __m256i i32 = _mm256_set_m128i(i1, i0);
+
+                    if constexpr (st == common::SampleType::Int24)
+                    {
+                        i32 = _mm256_slli_epi32(i32, 8);
+                    }
+
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(static_cast<int32_t*>(out) + s), i32);
+                }
+            }
+
+            if (s < numSamples)
+            {
+                scalar.fromDouble[idx(st)](in + s, outBytes + s * bytesPerSample, numSamples - s);
+            }
+        }
+
+
+        // same as utils::castToFloatTowardsZero<float>
+        void doubleToFloat(const double* in, void* out, int numSamples)
+        {
+            float* outPtr = static_cast<float*>(out);
+
+            const __m256d zero = _mm256_setzero_pd();
+            const __m256i evenLanes = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+            int s = 0;
+            for (; s + 4 <= numSamples; s += 4)
+            {
+                __m256d x = _mm256_loadu_pd(in + s);
+
+                __m128 f = _mm256_cvtpd_ps(x);
+                __m256d back = _mm256_cvtps_pd(f);
+
+                // float is further away from zero than the double value
+                __m256d awayPos = _mm256_and_pd(_mm256_cmp_pd(zero, x, _CMP_LT_OQ), _mm256_cmp_pd(x, back, _CMP_LT_OQ));
+                __m256d awayNeg = _mm256_and_pd(_mm256_cmp_pd(x, zero, _CMP_LT_OQ), _mm256_cmp_pd(back, x, _CMP_LT_OQ));
+                __m256i away64 = _mm256_castpd_si256(_mm256_or_pd(awayPos, awayNeg));
+
+                // 64 bit lane masks -> 32 bit lane masks (all bits set: -1)
+                __m128i away32 = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(away64, evenLanes));
+
+                // next float towards zero: decrement the magnitude bits
+                __m128i bits = _mm_add_epi32(_mm_castps_si128(f), away32);
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(outPtr + s), bits);
+            }
+
+            if (s < numSamples)
+            {
+                getScalarSampleConvKernels().fromDouble[idx(common::SampleType::Float32)](in + s, outPtr + s, numSamples - s);
+            }
+        }
+
+
+        void doubleToDouble(const double* in, void* out, int numSamples)
+        {
+            std::memcpy(out, in, static_cast<size_t>(numSamples) * sizeof(double));
+        }
+    }
+
+
+    bool fillSampleConvKernelsAVX2(SampleConvKernels& kernels)
+    {
+        kernels.toDouble[idx(common::SampleType::Int8)] = intToDouble<common::SampleType::Int8, 127>;
+        kernels.toDouble[idx(common::SampleType::Int16)] = intToDouble<common::SampleType::Int16, 32767>;
+        kernels.toDouble[idx(common::SampleType::Int24)] = intToDouble<common::SampleType::Int24, 8388607>;
+        kernels.toDouble[idx(common::SampleType::Int32)] = intToDouble<common::SampleType::Int32, 2147483647>;
+        kernels.toDouble[idx(common::SampleType::Float32)] = floatToDouble;
+        kernels.toDouble[idx(common::SampleType::Float64)] = doubleToDouble;
+
+        kernels.fromDouble[idx(common::SampleType::Int8)] = doubleToInt<common::SampleType::Int8, 127>;
+        kernels.fromDouble[idx(common::SampleType::Int16)] = doubleToInt<common::SampleType::Int16, 32767>;
+        kernels.fromDouble[idx(common::SampleType::Int24)] = doubleToInt<common::SampleType::Int24, 8388607>;
+        kernels.fromDouble[idx(common::SampleType::Int32)] = doubleToInt<common::SampleType::Int32, 2147483647>;
+        kernels.fromDouble[idx(common::SampleType::Float32)] = doubleToFloat;
+        kernels.fromDouble[idx(common::SampleType::Float64)] = doubleToDouble;
+
+        return true;
+    }
+}
+
+#else
+
+namespace simd
+{
+    bool fillSampleConvKernelsAVX2(SampleConvKernels& kernels)
+    {
+        return false;
+    }
+}
+
+#endif
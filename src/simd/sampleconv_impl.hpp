@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "simd/sampleconv.hpp"
+
+// internal: instruction set specific kernel tables
+// every function returns false if the instruction set is not available in this build
+// the kernels fall back to the scalar kernels for the remaining samples and for NaN samples
+namespace simd
+{
+    bool fillSampleConvKernelsSSE2(SampleConvKernels& kernels);
+
+    bool fillSampleConvKernelsAVX2(SampleConvKernels& kernels);
+
+    bool fillSampleConvKernelsNEON(SampleConvKernels& kernels);
+}
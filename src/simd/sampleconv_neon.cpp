@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: MIT
+
+// NEON is part of every ARM64 CPU
+
+#include <cstdint>
+#include <cstring>
+
+#include "common/sampletype.hpp"
+#include "simd/sampleconv.hpp"
+#include "simd/sampleconv_impl.hpp"
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+
+#include <arm_neon.h>
+
+namespace simd
+{
+    namespace
+    {
+        constexpr size_t idx(common::SampleType st)
+        {
+            return static_cast<size_t>(st);
+        }
+
+
+        // 4 int32 -> 4 normalized doubles (minInt is clamped to -maxInt)
+        inline void storeNormDouble4(int32x4_t v, double* out, float64x2_t negMaxInt, float64x2_t maxInt)
+        {
+            float64x2_t lo = vcvtq_f64_s64(vmovl_s32(vget_low_s32(v)));
+            float64x2_t hi = vcvtq_f64_s64(vmovl_s32(vget_high_s32(v)));
+
+            vst1q_f64(out,     vdivq_f64(vmaxq_f64(lo, negMaxInt), maxInt));
+            vst1q_f64(out + 2, vdivq_f64(vmaxq_f64(hi, negMaxInt), maxInt));
+        }
+
+
+        template <common::SampleType st>
+        inline int32x4_t loadInt32x4(const void* in, int s)
+        {
+            if constexpr (st == common::SampleType::Int8)
+            {
+                int32_t bytes;
+                std::memcpy(&bytes, static_cast<const int8_t*>(in) + s, sizeof(bytes));
+                int8x8_t v = vreinterpret_s8_s32(vdup_n_s32(bytes));
+                return vmovl_s16(vget_low_s16(vmovl_s8(v)));
+            }
+            else if constexpr (st == common::SampleType::Int16)
+            {
+                return vmovl_s16(vld1_s16(static_cast<const int16_t*>(in) + s));
+            }
+            else if constexpr (st == common::SampleType::Int24)
+            {
+                return vshrq_n_s32(vld1q_s32(static_cast<const int32_t*>(in) + s), 8);
+            }
+            else
+            {
+                return vld1q_s32(static_cast<const int32_t*>(in) + s);
+            }
+        }
+
+
+        template <common::SampleType st, int32_t MaxInt>
+        void intToDouble(const void* in, double* out, int numSamples)
+        {
+            const float64x2_t maxInt = vdupq_n_f64(static_cast<double>(MaxInt));
+            const float64x2_t negMaxInt = vdupq_n_f64(-static_cast<double>(MaxInt));
+
+            int s = 0;
+            for (; s + 4 <= numSamples; s += 4)
+            {
+                storeNormDouble4(loadInt32x4<st>(in, s), out + s, negMaxInt, maxInt);
+            }
+
+            if (s < numSamples)
+            {
+                const uint8_t* inBytes = static_cast<const uint8_t*>(in);
+                size_t bytesPerSample = st == common::SampleType::Int8 ? 1 : (st == common::SampleType::Int16 ? 2 : 4);
+
+                getScalarSampleConvKernels().toDouble[idx(st)](inBytes + s * bytesPerSample, out + s, numSamples - s);
+            }
+        }
+
+
+        void floatToDouble(const void* in, double* out, int numSamples)
+        {
+            const float* inPtr = static_cast<const float*>(in);
+
+            int s = 0;
+            for (; s + 4 <= numSamples; s += 4)
+            {
+                float32x4_t f = vld1q_f32(inPtr + s);
+                vst1q_f64(out + s,     vcvt_f64_f32(vget_low_f32(f)));
+                vst1q_f64(out + s + 2, vcvt_high_f64_f32(f));
+            }
+
+            for (; s < numSamples; ++s)
+            {
+                out[s] = static_cast<double>(inPtr[s]);
+            }
+        }
+
+
+        void doubleToDouble(const void* in, double* out, int numSamples)
+        {
+            std::memcpy(out, in, static_cast<size_t>(numSamples) * sizeof(double));
+        }
+
+
+        // 2 doubles -> 2 int64: clamp to [-1, 1], scale to maxInt and round half away from zero (same as std::round)
+        inline int64x2_t normDoubleToInt(float64x2_t x, float64x2_t maxInt)
+        {
+            const float64x2_t negOne = vdupq_n_f64(-1.0);
+            const float64x2_t one = vdupq_n_f64(1.0);
+
+            x = vminq_f64(vmaxq_f64(x, negOne), one);
+
+            return vcvtq_s64_f64(vrndaq_f64(vmulq_f64(x, maxInt)));
+        }
+
+
+        inline bool hasNaN(float64x2_t a, float64x2_t b)
+        {
+            uint64x2_t ordered = vandq_u64(vceqq_f64(a, a), vceqq_f64(b, b));
+            return vminvq_u32(vreinterpretq_u32_u64(ordered)) == 0;
+        }
+
+
+        template <common::SampleType st, int32_t MaxInt>
+        void doubleToInt(const double* in, void* out, int numSamples)
+        {
+            const float64x2_t maxInt = vdupq_n_f64(static_cast<double>(MaxInt));
+
+            const SampleConvKernels& scalar = getScalarSampleConvKernels();
+            size_t bytesPerSample = st == common::SampleType::Int8 ? 1 : (st == common::SampleType::Int16 ? 2 : 4);
+            uint8_t* outBytes = static_cast<uint8_t*>(out);
+
+            int s = 0;
+            for (; s + 4 <= numSamples; s += 4)
+            {
+                float64x2_t x0 = vld1q_f64(in + s);
+                float64x2_t x1 = vld1q_f64(in + s + 2);
+
+                if (hasNaN(x0, x1))
+                {
+                    // conversion of NaN is implementation defined -> let the scalar kernel decide
+                    scalar.fromDouble[idx(st)](in + s, outBytes + s * bytesPerSample, 4);
+                    continue;
+                }
+
+                // values are in range of the sample type -> narrowing is exact
+                int32x4_t i32 = vcombine_s32(vmovn_s64(normDoubleToInt(x0, maxInt)), vmovn_s64(normDoubleToInt(x1, maxInt)));
+
+                if constexpr (st == common::SampleType::Int8)
+                {
+                    int8x8_t i8 = vmovn_s16(vcombine_s16(vmovn_s32(i32), vdup_n_s16(0)));
+                    int32_t bytes = vget_lane_s32(vreinterpret_s32_s8(i8), 0);
+                    std::memcpy(static_cast<int8_t*>(out) + s, &bytes, sizeof(bytes));
+                }
+                else if constexpr (st == common::SampleType::Int16)
+                {
+                    vst1_s16(static_cast<int16_t*>(out) + s, vmovn_s32(i32));
+                }
+                else
+                {
+                    if constexpr (st == common::SampleType::Int24)
+                    {
+                        i32 = vshlq_n_s32(i32, 8);
+                    }
+
+                    vst1q_s32(static_cast<int32_t*>(out) + s, i32);
+                }
+            }
+
+            if (s < numSamples)
+            {
+                scalar.fromDouble[idx(st)](in + s, outBytes + s * bytesPerSample, numSamples - s);
+            }
+        }
+
+
+        // same as utils::castToFloatTowardsZero<float>
+        void doubleToFloat(const double* in, void* out, int numSamples)
+        {
+            float* outPtr = static_cast<float*>(out);
+
+            const float64x2_t zero = vdupq_n_f64(0.0);
+
+            int s = 0;
+            for (; s + 2 <= numSamples; s += 2)
+            {
+                float64x2_t x = vld1q_f64(in + s);
+
+                float32x2_t f = vcvt_f32_f64(x);
+                float64x2_t back = vcvt_f64_f32(f);
+
+                // float is further away from zero than the double value
+                uint64x2_t awayPos = vandq_u64(vcltq_f64(zero, x), vcltq_f64(x, back));
+                uint64x2_t awayNeg = vandq_u64(vcltq_f64(x, zero), vcltq_f64(back, x));
+                uint64x2_t away64 = vorrq_u64(awayPos, awayNeg);
+
+                // 64 bit lane masks -> 32 bit lane masks (all bits set: -1)
+                int32x2_t away32 = vreinterpret_s32_u32(vmovn_u64(away64));
+
+                // next float towards zero: decrement the magnitude bits
+                int32x2_t bits = vadd_s32(vreinterpret_s32_f32(f), away32);
+
+                vst1_f32(outPtr + s, vreinterpret_f32_s32(bits));
+            }
+
+            if (s < numSamples)
+            {
+                getScalarSampleConvKernels().fromDouble[idx(common::SampleType::Float32)](in + s, outPtr + s, numSamples - s);
+            }
+        }
+
+
+        void doubleToDouble(const double* in, void* out, int numSamples)
+        {
+            std::memcpy(out, in, static_cast<size_t>(numSamples) * sizeof(double));
+        }
+    }
+
+
+    bool fillSampleConvKernelsNEON(SampleConvKernels& kernels)
+    {
+        kernels.toDouble[idx(common::SampleType::Int8)] = intToDouble<common::SampleType::Int8, 127>;
+        kernels.toDouble[idx(common::SampleType::Int16)] = intToDouble<common::SampleType::Int16, 32767>;
+        kernels.toDouble[idx(common::SampleType::Int24)] = intToDouble<common::SampleType::Int24, 8388607>;
+        kernels.toDouble[idx(common::SampleType::Int32)] = intToDouble<common::SampleType::Int32, 2147483647>;
+        kernels.toDouble[idx(common::SampleType::Float32)] = floatToDouble;
+        kernels.toDouble[idx(common::SampleType::Float64)] = doubleToDouble;
+
+        kernels.fromDouble[idx(common::SampleType::Int8)] = doubleToInt<common::SampleType::Int8, 127>;
+        kernels.fromDouble[idx(common::SampleType::Int16)] = doubleToInt<common::SampleType::Int16, 32767>;
+        kernels.fromDouble[idx(common::SampleType::Int24)] = doubleToInt<common::SampleType::Int24, 8388607>;
+        kernels.fromDouble[idx(common::SampleType::Int32)] = doubleToInt<common::SampleType::Int32, 2147483647>;
+        kernels.fromDouble[idx(common::SampleType::Float32)] = doubleToFloat;
+        kernels.fromDouble[idx(common::SampleType::Float64)] = doubleToDouble;
+
+        return true;
+    }
+}
+
+#else
+
+namespace simd
+{
+    bool fillSampleConvKernelsNEON(SampleConvKernels& kernels)
+    {
+        return false;
+    }
+}
+
+#endif
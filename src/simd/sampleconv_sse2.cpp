@@ -0,0 +1,276 @@
+// SPDX-License-Identifier: MIT
+
+// SSE2 is part of every x86-64 CPU, on 32-bit x86 the CPU support is checked at runtime (see simd::detectIsa)
+
+#include <cstdint>
+#include <cstring>
+
+#include "common/sampletype.hpp"
+#include "simd/sampleconv.hpp"
+#include "simd/sampleconv_impl.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+
+namespace simd
+{
+    namespace
+    {
+        constexpr size_t idx(common::SampleType st)
+        {
+            return static_cast<size_t>(st);
+        }
+
+
+        // 2 int32 (lower half) -> 2 normalized doubles (minInt is clamped to -maxInt)
+        inline __m128d intToNormDouble(__m128i v, __m128d negMaxInt, __m128d maxInt)
+        {
+            return _mm_div_pd(_mm_max_pd(_mm_cvtepi32_pd(v), negMaxInt), maxInt);
+        }
+
+
+        template <common::SampleType st>
+        inline __m128i loadInt32x4(const void* in, int s)
+        {
+            if constexpr (st == common::SampleType::Int8)
+            {
+                int32_t bytes;
+                std::memcpy(&bytes, static_cast<const int8_t*>(in) + s, sizeof(bytes));
+                __m128i v = _mm_cvtsi32_si128(bytes);
+                v = _mm_unpacklo_epi8(v, v);
+                v = _mm_unpacklo_epi16(v, v);
+                return _mm_srai_epi32(v, 24);
+            }
+            else if constexpr (st == common::SampleType::Int16)
+            {
+                __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(static_cast<const int16_t*>(in) + s));
+                return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+            }
+            else if constexpr (st == common::SampleType::Int24)
+            {
+                return _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(static_cast<const int32_t*>(in) + s)), 8);
+            }
+            else
+            {
+                return _mm_loadu_si128(reinterpret_cast<const __m128i*>(static_cast<const int32_t*>(in) + s));
+            }
+        }
+
+
+        template <common::SampleType st, int32_t MaxInt>
+        void intToDouble(const void* in, double* out, int numSamples)
+        {
+            const __m128d maxInt = _mm_set1_pd(static_cast<double>(MaxInt));
+            const __m128d negMaxInt = _mm_set1_pd(-static_cast<double>(MaxInt));
+
+            int s = 0;
+            for (; s + 4 <= numSamples; s += 4)
+            {
+                __m128i v = loadInt32x4<st>(in, s);
+
+                _mm_storeu_pd(out + s,     intToNormDouble(v, negMaxInt, maxInt));
+                _mm_storeu_pd(out + s + 2, intToNormDouble(_mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)), negMaxInt, maxInt));
+            }
+
+            if (s < numSamples)
+            {
+                const uint8_t* inBytes = static_cast<const uint8_t*>(in);
+                size_t bytesPerSample = st == common::SampleType::Int8 ? 1 : (st == common::SampleType::Int16 ? 2 : 4);
+
+                getScalarSampleConvKernels().toDouble[idx(st)](inBytes + s * bytesPerSample, out + s, numSamples - s);
+            }
+        }
+
+
+        void floatToDouble(const void* in, double* out, int numSamples)
+        {
+            const float* inPtr = static_cast<const float*>(in);
+
+            int s = 0;
+            for (; s + 4 <= numSamples; s += 4)
+            {
+                __m128 f = _mm_loadu_ps(inPtr + s);
+                _mm_storeu_pd(out + s,     _mm_cvtps_pd(f));
+                _mm_storeu_pd(out + s + 2, _mm_cvtps_pd(_mm_movehl_ps(f, f)));
+            }
+
+            for (; s < numSamples; ++s)
+            {
+                out[s] = static_cast<double>(inPtr[s]);
+            }
+        }
+
+
+        void doubleToDouble(const void* in, double* out, int numSamples)
+        {
+            std::memcpy(out, in, static_cast<size_t>(numSamples) * sizeof(double));
+        }
+
+
+        // same as std::round (round half away from zero) for |x| < 2^31
+        inline __m128d roundHalfAway(__m128d x)
+        {
+            const __m128d signMask = _mm_set1_pd(-0.0);
+            const __m128d half = _mm_set1_pd(0.5);
+            const __m128d one = _mm_set1_pd(1.0);
+
+            // no SSE4.1 round instruction: truncate through int32 (exact in this range)
+            __m128d trunc = _mm_cvtepi32_pd(_mm_cvttpd_epi32(x));
+
+            // exact
+            __m128d absFrac = _mm_andnot_pd(signMask, _mm_sub_pd(x, trunc));
+
+            __m128d roundAway = _mm_cmpge_pd(absFrac, half);
+
+            // copysign(1, x)
+            __m128d signedOne = _mm_or_pd(_mm_and_pd(x, signMask), one);
+
+            return _mm_add_pd(trunc, _mm_and_pd(roundAway, signedOne));
+        }
+
+
+        // 2 doubles -> 2 int32 (lower half): clamp to [-1, 1], scale to maxInt and round
+        inline __m128i normDoubleToInt(__m128d x, __m128d maxInt)
+        {
+            const __m128d negOne = _mm_set1_pd(-1.0);
+            const __m128d one = _mm_set1_pd(1.0);
+
+            x = _mm_min_pd(_mm_max_pd(x, negOne), one);
+
+            return _mm_cvttpd_epi32(roundHalfAway(_mm_mul_pd(x, maxInt)));
+        }
+
+
+        inline bool hasNaN(__m128d a, __m128d b)
+        {
+            return (_mm_movemask_pd(_mm_cmpunord_pd(a, a)) | _mm_movemask_pd(_mm_cmpunord_pd(b, b))) != 0;
+        }
+
+
+        template <common::SampleType st, int32_t MaxInt>
+        void doubleToInt(const double* in, void* out, int numSamples)
+        {
+            const __m128d maxInt = _mm_set1_pd(static_cast<double>(MaxInt));
+
+            const SampleConvKernels& scalar = getScalarSampleConvKernels();
+            size_t bytesPerSample = st == common::SampleType::Int8 ? 1 : (st == common::SampleType::Int16 ? 2 : 4);
+            uint8_t* outBytes = static_cast<uint8_t*>(out);
+
+            int s = 0;
+            for (; s + 4 <= numSamples; s += 4)
+            {
+                __m128d x0 = _mm_loadu_pd(in + s);
+                __m128d x1 = _mm_loadu_pd(in + s + 2);
+
+                if (hasNaN(x0, x1))
+                {
+                    // conversion of NaN is implementation defined -> let the scalar kernel decide
+                    scalar.fromDouble[idx(st)](in + s, outBytes + s * bytesPerSample, 4);
+                    continue;
+                }
+
+                __m128i i32 = _mm_unpacklo_epi64(normDoubleToInt(x0, maxInt), normDoubleToInt(x1, maxInt));
+
+                if constexpr (st == common::SampleType::Int8)
+                {
+                    __m128i i16 = _mm_packs_epi32(i32, i32);
+                    int32_t bytes = _mm_cvtsi128_si32(_mm_packs_epi16(i16, i16));
+                    std::memcpy(static_cast<int8_t*>(out) + s, &bytes, sizeof(bytes));
+                }
+                else if constexpr (st == common::SampleType::Int16)
+                {
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(static_cast<int16_t*>(out) + s), _mm_packs_epi32(i32, i32));
+                }
+                else
+                {
+                    if constexpr (st == common::SampleType::Int24)
+                    {
+                        i32 = _mm_slli_epi32(i32, 8);
+                    }
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(static_cast<int32_t*>(out) + s), i32);
+                }
+            }
+
+            if (s < numSamples)
+            {
+                scalar.fromDouble[idx(st)](in + s, outBytes + s * bytesPerSample, numSamples - s);
+            }
+        }
+
+
+        // same as utils::castToFloatTowardsZero<float>
+        void doubleToFloat(const double* in, void* out, int numSamples)
+        {
+            float* outPtr = static_cast<float*>(out);
+
+            const __m128d zero = _mm_setzero_pd();
+
+            int s = 0;
+            for (; s + 2 <= numSamples; s += 2)
+            {
+                __m128d x = _mm_loadu_pd(in + s);
+
+                __m128 f = _mm_cvtpd_ps(x);
+                __m128d back = _mm_cvtps_pd(f);
+
+                // float is further away from zero than the double value
+                __m128d awayPos = _mm_and_pd(_mm_cmplt_pd(zero, x), _mm_cmplt_pd(x, back));
+                __m128d awayNeg = _mm_and_pd(_mm_cmplt_pd(x, zero), _mm_cmplt_pd(back, x));
+                __m128i away64 = _mm_castpd_si128(_mm_or_pd(awayPos, awayNeg));
+
+                // 64 bit lane masks -> 32 bit lane masks (all bits set: -1)
+                __m128i away32 = _mm_shuffle_epi32(away64, _MM_SHUFFLE(3, 3, 2, 0));
+
+                // next float towards zero: decrement the magnitude bits
+                __m128i bits = _mm_add_epi32(_mm_castps_si128(f), away32);
+
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(outPtr + s), bits);
+            }
+
+            if (s < numSamples)
+            {
+                getScalarSampleConvKernels().fromDouble[idx(common::SampleType::Float32)](in + s, outPtr + s, numSamples - s);
+            }
+        }
+
+
+        void doubleToDouble(const double* in, void* out, int numSamples)
+        {
+            std::memcpy(out, in, static_cast<size_t>(numSamples) * sizeof(double));
+        }
+    }
+
+
+    bool fillSampleConvKernelsSSE2(SampleConvKernels& kernels)
+    {
+        kernels.toDouble[idx(common::SampleType::Int8)] = intToDouble<common::SampleType::Int8, 127>;
+        kernels.toDouble[idx(common::SampleType::Int16)] = intToDouble<common::SampleType::Int16, 32767>;
+        kernels.toDouble[idx(common::SampleType::Int24)] = intToDouble<common::SampleType::Int24, 8388607>;
+        kernels.toDouble[idx(common::SampleType::Int32)] = intToDouble<common::SampleType::Int32, 2147483647>;
+        kernels.toDouble[idx(common::SampleType::Float32)] = floatToDouble;
+        kernels.toDouble[idx(common::SampleType::Float64)] = doubleToDouble;
+
+        kernels.fromDouble[idx(common::SampleType::Int8)] = doubleToInt<common::SampleType::Int8, 127>;
+        kernels.fromDouble[idx(common::SampleType::Int16)] = doubleToInt<common::SampleType::Int16, 32767>;
+        kernels.fromDouble[idx(common::SampleType::Int24)] = doubleToInt<common::SampleType::Int24, 8388607>;
+        kernels.fromDouble[idx(common::SampleType::Int32)] = doubleToInt<common::SampleType::Int32, 2147483647>;
+        kernels.fromDouble[idx(common::SampleType::Float32)] = doubleToFloat;
+        kernels.fromDouble[idx(common::SampleType::Float64)] = doubleToDouble;
+
+        return true;
+    }
+}
+
+#else
+
+namespace simd
+{
+    bool fillSampleConvKernelsSSE2(SampleConvKernels& kernels)
+    {
+        return false;
+    }
+}
+
+#endif
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <cmath>
+
+#include "simd/cpu.hpp"
+#include "simd/truepeak.hpp"
+#include "simd/truepeak_impl.hpp"
+
+namespace simd
+{
+    // ITU-R BS.1770-4 Annex 2: the phases interpolate the input at quarter sample steps, delayed by about 5.5 samples
+    alignas(32) const double truePeakCoeffs[TruePeakTaps][TruePeakPhases] =
+    {
+        {  0.0017089843750, -0.0291748046875, -0.0189208984375, -0.0083007812500 },
+        {  0.0109863281250,  0.0292968750000,  0.0330810546875,  0.0148925781250 },
+        { -0.0196533203125, -0.0517578125000, -0.0582275390625, -0.0266113281250 },
+        {  0.0332031250000,  0.0891113281250,  0.1015625000000,  0.0476074218750 },
+        { -0.0594482421875, -0.1665039062500, -0.2003173828125, -0.1022949218750 },
+        {  0.1373291015625,  0.4650878906250,  0.7797851562500,  0.9721679687500 },
+        {  0.9721679687500,  0.7797851562500,  0.4650878906250,  0.1373291015625 },
+        { -0.1022949218750, -0.2003173828125, -0.1665039062500, -0.0594482421875 },
+        {  0.0476074218750,  0.1015625000000,  0.0891113281250,  0.0332031250000 },
+        { -0.0266113281250, -0.0582275390625, -0.0517578125000, -0.0196533203125 },
+        {  0.0148925781250,  0.0330810546875,  0.0292968750000,  0.0109863281250 },
+        { -0.0083007812500, -0.0189208984375, -0.0291748046875,  0.0017089843750 },
+    };
+
+
+    static double scalarTruePeak(const double* in, int numSamples)
+    {
+        double peak = 0;
+
+        for (int s = 0; s < numSamples; ++s)
+        {
+            for (int p = 0; p < TruePeakPhases; ++p)
+            {
+                double acc = truePeakCoeffs[0][p] * in[s];
+
+                for (int k = 1; k < TruePeakTaps; ++k)
+                {
+                    acc += truePeakCoeffs[k][p] * in[s - k];
+                }
+
+                // the accumulator is the first argument: a NaN value keeps it
+                peak = std::max(peak, std::abs(acc));
+            }
+        }
+        return peak;
+    }
+
+
+    static constexpr TruePeakKernels scalarKernels =
+    {
+        .maxAbs = scalarTruePeak,
+    };
+
+    static TruePeakKernels activeKernels = scalarKernels;
+
+    static Isa activeIsa = Isa::Scalar;
+
+
+    void initTruePeakKernels(Isa isa)
+    {
+        TruePeakKernels kernels = scalarKernels;
+        bool available = false;
+
+        switch (isa)
+        {
+            case Isa::SSE2:
+                available = fillTruePeakKernelsSSE2(kernels);
+                break;
+            case Isa::AVX2:
+                available = fillTruePeakKernelsAVX2(kernels);
+                break;
+            case Isa::NEON:
+                available = fillTruePeakKernelsNEON(kernels);
+                break;
+            case Isa::Scalar:
+            default:
+                break;
+        }
+
+        if (available)
+        {
+            activeKernels = kernels;
+            activeIsa = isa;
+        }
+        else
+        {
+            activeKernels = scalarKernels;
+            activeIsa = Isa::Scalar;
+        }
+    }
+
+
+    void initTruePeakKernels()
+    {
+        Isa isa = detectIsa();
+
+        initTruePeakKernels(isa);
+
+        if (activeIsa == Isa::Scalar && isa == Isa::AVX2)
+        {
+            // AVX2 kernels not built
+            initTruePeakKernels(Isa::SSE2);
+        }
+    }
+
+
+    Isa getTruePeakIsa()
+    {
+        return activeIsa;
+    }
+
+
+    const TruePeakKernels& getTruePeakKernels()
+    {
+        return activeKernels;
+    }
+
+
+    const TruePeakKernels& getScalarTruePeakKernels()
+    {
+        return scalarKernels;
+    }
+}
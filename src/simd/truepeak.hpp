@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "simd/cpu.hpp"
+
+namespace simd
+{
+    // 4x oversampling FIR of ITU-R BS.1770-4 Annex 2: 4 phases of 12 taps
+    constexpr int TruePeakPhases = 4;
+    constexpr int TruePeakTaps = 12;
+
+    // number of previous input samples the filter reads for the first output position
+    constexpr int TruePeakHistory = TruePeakTaps - 1;
+
+
+    /**
+     * returns the largest absolute value of the 4x oversampled signal at the input positions [0, numSamples)
+     * in[-TruePeakHistory] to in[-1] are the previous input samples and have to be readable
+     * NaN values are ignored, returns 0 if numSamples <= 0
+     */
+    using TruePeakKernel = double (*)(const double* in, int numSamples);
+
+
+    struct TruePeakKernels
+    {
+        TruePeakKernel maxAbs;
+    };
+
+
+    // selects the true peak kernels for the running CPU
+    // call once at plugin initialization; the scalar kernels are used until then
+    void initTruePeakKernels();
+
+    // force a specific instruction set (falls back to scalar if not supported by the build)
+    void initTruePeakKernels(Isa isa);
+
+    Isa getTruePeakIsa();
+
+    const TruePeakKernels& getTruePeakKernels();
+
+    // reference kernels, the SIMD kernels return the same result
+    const TruePeakKernels& getScalarTruePeakKernels();
+
+
+    inline double findTruePeak(const double* in, int numSamples)
+    {
+        return getTruePeakKernels().maxAbs(in, numSamples);
+    }
+}
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: MIT
+
+// this file is compiled with AVX2 enabled
+// only call these kernels if the CPU supports AVX2 (see simd::detectIsa)
+
+#include <algorithm>
+
+#include "simd/truepeak.hpp"
+#include "simd/truepeak_impl.hpp"
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+namespace simd
+{
+    namespace
+    {
+        // all four phases of one output position per iteration
+        double truePeak(const double* in, int numSamples)
+        {
+            __m256d coeffs[TruePeakTaps];
+            for (int k = 0; k < TruePeakTaps; ++k)
+            {
+                coeffs[k] = _mm256_load_pd(truePeakCoeffs[k]);
+            }
+
+            const __m256d signBit = _mm256_set1_pd(-0.0);
+
+            __m256d peakV = _mm256_setzero_pd();
+
+            for (int s = 0; s < numSamples; ++s)
+            {
+                // no fused multiply-add: same result as the scalar kernel
+                __m256d acc = _mm256_mul_pd(coeffs[0], _mm256_set1_pd(in[s]));
+
+                for (int k = 1; k < TruePeakTaps; ++k)
+                {
+                    acc = _mm256_add_pd(acc, _mm256_mul_pd(coeffs[k], _mm256_set1_pd(in[s - k])));
+                }
+
+                // maxpd returns the second operand if one is NaN: NaN values are ignored
+                peakV = _mm256_max_pd(_mm256_andnot_pd(signBit, acc), peakV);
+            }
+
+            alignas(32) double peakLanes[4];
+            _mm256_store_pd(peakLanes, peakV);
+
+            return std::max(std::max(peakLanes[0], peakLanes[1]), std::max(peakLanes[2], peakLanes[3]));
+        }
+    }
+
+
+    bool fillTruePeakKernelsAVX2(TruePeakKernels& kernels)
+    {
+        kernels.maxAbs = truePeak;
+
+        return true;
+    }
+}
+
+#else
+
+namespace simd
+{
+    bool fillTruePeakKernelsAVX2(TruePeakKernels& kernels)
+    {
+        return false;
+    }
+}
+
+#endif
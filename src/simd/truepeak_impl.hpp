@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "simd/truepeak.hpp"
+
+// internal: instruction set specific kernel tables
+// every function returns false if the instruction set is not available in this build
+// all kernels sum the taps in the same order without fused multiply-add, so the results are identical
+namespace simd
+{
+    // filter coefficients [tap][phase], the phases of one tap are adjacent for the SIMD kernels
+    alignas(32) extern const double truePeakCoeffs[TruePeakTaps][TruePeakPhases];
+
+    bool fillTruePeakKernelsSSE2(TruePeakKernels& kernels);
+
+    bool fillTruePeakKernelsAVX2(TruePeakKernels& kernels);
+
+    bool fillTruePeakKernelsNEON(TruePeakKernels& kernels);
+}
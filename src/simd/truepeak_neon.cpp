@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: MIT
+
+// NEON is part of every ARM64 CPU
+
+#include "simd/truepeak.hpp"
+#include "simd/truepeak_impl.hpp"
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+
+#include <arm_neon.h>
+
+namespace simd
+{
+    namespace
+    {
+        // phases 0, 1 and phases 2, 3 of one output position per iteration
+        double truePeak(const double* in, int numSamples)
+        {
+            float64x2_t coeffs01[TruePeakTaps];
+            float64x2_t coeffs23[TruePeakTaps];
+            for (int k = 0; k < TruePeakTaps; ++k)
+            {
+                coeffs01[k] = vld1q_f64(&truePeakCoeffs[k][0]);
+                coeffs23[k] = vld1q_f64(&truePeakCoeffs[k][2]);
+            }
+
+            float64x2_t peakV = vdupq_n_f64(0.0);
+
+            for (int s = 0; s < numSamples; ++s)
+            {
+                // no fused multiply-add: same result as the scalar kernel
+                float64x2_t x = vdupq_n_f64(in[s]);
+                float64x2_t acc01 = vmulq_f64(coeffs01[0], x);
+                float64x2_t acc23 = vmulq_f64(coeffs23[0], x);
+
+                for (int k = 1; k < TruePeakTaps; ++k)
+                {
+                    x = vdupq_n_f64(in[s - k]);
+                    acc01 = vaddq_f64(acc01, vmulq_f64(coeffs01[k], x));
+                    acc23 = vaddq_f64(acc23, vmulq_f64(coeffs23[k], x));
+                }
+
+                // maxnm returns the number if one operand is NaN: NaN values are ignored
+                peakV = vmaxnmq_f64(peakV, vabsq_f64(acc01));
+                peakV = vmaxnmq_f64(peakV, vabsq_f64(acc23));
+            }
+
+            return vmaxnmvq_f64(peakV);
+        }
+    }
+
+
+    bool fillTruePeakKernelsNEON(TruePeakKernels& kernels)
+    {
+        kernels.maxAbs = truePeak;
+
+        return true;
+    }
+}
+
+#else
+
+namespace simd
+{
+    bool fillTruePeakKernelsNEON(TruePeakKernels& kernels)
+    {
+        return false;
+    }
+}
+
+#endif
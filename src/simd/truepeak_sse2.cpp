@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: MIT
+
+// SSE2 is part of every x86-64 CPU, on 32-bit x86 the CPU support is checked at runtime (see simd::detectIsa)
+
+#include <algorithm>
+
+#include "simd/truepeak.hpp"
+#include "simd/truepeak_impl.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+
+namespace simd
+{
+    namespace
+    {
+        // phases 0, 1 and phases 2, 3 of one output position per iteration
+        double truePeak(const double* in, int numSamples)
+        {
+            __m128d coeffs01[TruePeakTaps];
+            __m128d coeffs23[TruePeakTaps];
+            for (int k = 0; k < TruePeakTaps; ++k)
+            {
+                coeffs01[k] = _mm_load_pd(&truePeakCoeffs[k][0]);
+                coeffs23[k] = _mm_load_pd(&truePeakCoeffs[k][2]);
+            }
+
+            const __m128d signBit = _mm_set1_pd(-0.0);
+
+            __m128d peakV = _mm_setzero_pd();
+
+            for (int s = 0; s < numSamples; ++s)
+            {
+                __m128d x = _mm_set1_pd(in[s]);
+                __m128d acc01 = _mm_mul_pd(coeffs01[0], x);
+                __m128d acc23 = _mm_mul_pd(coeffs23[0], x);
+
+                for (int k = 1; k < TruePeakTaps; ++k)
+                {
+                    x = _mm_set1_pd(in[s - k]);
+                    acc01 = _mm_add_pd(acc01, _mm_mul_pd(coeffs01[k], x));
+                    acc23 = _mm_add_pd(acc23, _mm_mul_pd(coeffs23[k], x));
+                }
+
+                // maxpd returns the second operand if one is NaN: NaN values are ignored
+                peakV = _mm_max_pd(_mm_andnot_pd(signBit, acc01), peakV);
+                peakV = _mm_max_pd(_mm_andnot_pd(signBit, acc23), peakV);
+            }
+
+            alignas(16) double peakLanes[2];
+            _mm_store_pd(peakLanes, peakV);
+
+            return std::max(peakLanes[0], peakLanes[1]);
+        }
+    }
+
+
+    bool fillTruePeakKernelsSSE2(TruePeakKernels& kernels)
+    {
+        kernels.maxAbs = truePeak;
+
+        return true;
+    }
+}
+
+#else
+
+namespace simd
+{
+    bool fillTruePeakKernelsSSE2(TruePeakKernels& kernels)
+    {
+        return false;
+    }
+}
+
+#endif
@@ -1,12 +1,16 @@
 // SPDX-License-Identifier: MIT
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <format>
 #include <numbers>
 #include <optional>
+#include <span>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "VapourSynth4.h"
@@ -15,6 +19,7 @@
 #include "common/overflow.hpp"
 #include "common/peak.hpp"
 #include "common/sampletype.hpp"
+#include "common/stats.hpp"
 #include "vsmap/vsmap.hpp"
 #include "vsmap/vsmap_common.hpp"
 #include "vsutils/audio.hpp"
@@ -29,11 +34,16 @@ constexpr double DefaultFrequency = 500;
 constexpr double DefaultAmplitude = 1;
 constexpr common::OverflowMode DefaultOverflowMode = common::OverflowMode::Error;
 constexpr common::OverflowLog DefaultOverflowLog = common::OverflowLog::Once;
+constexpr bool DefaultStats = false;
+
+// the oscillator is restarted from the exact phase every OscillatorAnchorInterval samples
+// to keep the accumulated rounding error of the rotation far below the resolution of 32 bit samples
+constexpr int OscillatorAnchorInterval = 256;
 
 
 SineTone::SineTone(int64_t numSamples, uint64_t channelLayout, int sampleRate, common::SampleType _sampleType, double _freq, double _amplitude,
-                   common::OverflowMode _overflowMode, common::OverflowLog _overflowLog) :
-    outSampleType(_sampleType), freq(_freq), overflowMode(_overflowMode), overflowLog(_overflowLog)
+                   common::OverflowMode _overflowMode, common::OverflowLog _overflowLog, bool _stats, VSCore* core, const VSAPI* vsapi) :
+    outSampleType(_sampleType), freq(_freq), overflowMode(_overflowMode), overflowLog(_overflowLog), stats(_stats)
 {
     outInfo = VSAudioInfo();
     outInfo.numSamples = numSamples;
@@ -47,6 +57,45 @@ SineTone::SineTone(int64_t numSamples, uint64_t channelLayout, int sampleRate, c
 
     amplitude = common::adjustNormPeak(_amplitude, outSampleType);
     absAmplitude = std::abs(amplitude);
+
+    double phaseStep = 2 * std::numbers::pi * freq / static_cast<double>(outInfo.sampleRate);
+    cosPhaseStep = std::cos(phaseStep);
+    sinPhaseStep = std::sin(phaseStep);
+
+    // all samples are clamped to the amplitude
+    overflowPossible = common::isOverflowPossible(absAmplitude, outSampleType);
+
+    overflowTracker.init(FuncName, overflowMode, overflowLog, common::isFloatSampleType(outSampleType), outInfo.numFrames);
+
+    initPeriodicFrame(core, vsapi);
+}
+
+
+void SineTone::initPeriodicFrame(VSCore* core, const VSAPI* vsapi)
+{
+    // all full frames are equal if a frame contains a whole number of periods
+    // the cached frame is only used if no sample can overflow, no overflows have to be logged then
+    if (outInfo.numFrames < 2 || 1 < absAmplitude || std::fmod(freq * VS_AUDIO_FRAME_SAMPLES, static_cast<double>(outInfo.sampleRate)) != 0)
+    {
+        return;
+    }
+
+    VSFrame* frm = vsapi->newAudioFrame(&outInfo.format, VS_AUDIO_FRAME_SAMPLES, nullptr, core);
+
+    common::OverflowStats frameOverflowStats;
+
+    if (!writeFrame(frm, 0, frameOverflowStats, nullptr, core, vsapi) || 0 < frameOverflowStats.count)
+    {
+        vsapi->freeFrame(frm);
+        return;
+    }
+
+    if (stats)
+    {
+        common::setFrameStatsProps(frm, frameOverflowStats, vsapi);
+    }
+
+    periodicFrame = frm;
 }
 
 
@@ -56,61 +105,132 @@ const VSAudioInfo& SineTone::getOutInfo()
 }
 
 
-void SineTone::resetOverflowStats()
+bool SineTone::isOverflowPossible()
 {
-    overflowStats = { .count = 0, .peak = 0.0 };
+    return overflowPossible;
 }
 
 
-void SineTone::logOverflowStats(VSCore* core, const VSAPI* vsapi)
+bool SineTone::isStatsEnabled()
 {
-    if (0 < overflowStats.count)
+    return stats;
+}
+
+
+const VSFrame* SineTone::getPeriodicFrame(int outFrmNum, const VSAPI* vsapi)
+{
+    if (!periodicFrame || vsutils::getFrameSampleCount(outFrmNum, outInfo.numSamples) != VS_AUDIO_FRAME_SAMPLES)
     {
-        overflowStats.logVS(FuncName, overflowMode, isFloatSampleType(outSampleType), core, vsapi);
+        return nullptr;
     }
+
+    return vsapi->addFrameRef(periodicFrame);
 }
 
 
-void SineTone::free(const VSAPI* vsapi)
+void SineTone::submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi)
 {
+    overflowTracker.submitFrame(outFrmNum, std::move(frameOverflowStats), core, vsapi);
 }
 
 
-template <typename sample_t, size_t IntSampleBits>
-bool SineTone::writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStart, int outFrmLen,
-                                 const common::OverflowContext& ofCtx)
+void SineTone::flushOverflowStats(VSCore* core, const VSAPI* vsapi)
 {
-    sample_t* outFrmPtr = reinterpret_cast<sample_t*>(ofCtx.vsapi->getWritePtr(outFrm, ch));
+    overflowTracker.flush(core, vsapi);
+}
+
 
-    for (int s = 0; s < outFrmLen; ++s)
+void SineTone::free(const VSAPI* vsapi)
+{
+    if (periodicFrame)
     {
-        int64_t outPos = outPosFrmStart + s;
+        vsapi->freeFrame(periodicFrame);
+    }
+}
 
-        double seconds = vsutils::samplesToSeconds(outPos, outInfo.sampleRate);
 
-        // clamp the result to the amplitude in case of precision inaccuracies
-        double sample = std::clamp(amplitude * std::sin(2 * std::numbers::pi * seconds * freq), -absAmplitude, absAmplitude);
+// returns the exact phase of a sample position
+double SineTone::getPhase(int64_t outPos)
+{
+    double seconds = vsutils::samplesToSeconds(outPos, outInfo.sampleRate);
+
+    return 2 * std::numbers::pi * seconds * freq;
+}
+
+
+void SineTone::fillFrameSamples(int64_t outPosFrmStart, std::span<double> samples)
+{
+    int numSamples = static_cast<int>(samples.size());
+
+    for (int anchor = 0; anchor < numSamples; anchor += OscillatorAnchorInterval)
+    {
+        int end = std::min(anchor + OscillatorAnchorInterval, numSamples);
+
+        double phase = getPhase(outPosFrmStart + anchor);
+        double sinPhase = std::sin(phase);
+        double cosPhase = std::cos(phase);
 
-        if (!common::safeWriteSample<sample_t, IntSampleBits>(sample, outFrmPtr, s, outPos, ch, ofCtx, overflowStats))
+        for (int s = anchor; s < end; ++s)
         {
-            // overflow and error
-            return false;
+            // clamp the result to the amplitude in case of precision inaccuracies
+            samples[s] = std::clamp(amplitude * sinPhase, -absAmplitude, absAmplitude);
+
+            // rotate the phase by one sample step
+            double nextSinPhase = sinPhase * cosPhaseStep + cosPhase * sinPhaseStep;
+            cosPhase = cosPhase * cosPhaseStep - sinPhase * sinPhaseStep;
+            sinPhase = nextSinPhase;
         }
     }
+}
 
-    return true;
+
+template <typename sample_t, size_t IntSampleBits, bool CheckOverflow>
+bool SineTone::writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStart, std::span<const double> samples,
+                                 const common::OverflowContext& ofCtx)
+{
+    sample_t* outFrmPtr = reinterpret_cast<sample_t*>(ofCtx.vsapi->getWritePtr(outFrm, ch));
+
+    return common::safeWriteSamples<sample_t, IntSampleBits, CheckOverflow>(samples, outFrmPtr, outPosFrmStart, ch, ofCtx);
 }
 
 
-template <typename sample_t, size_t IntSampleBits>
+template <typename sample_t, size_t IntSampleBits, bool CheckOverflow>
 bool SineTone::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const common::OverflowContext& ofCtx)
 {
     int64_t outPosFrmStart = vsutils::frameToFirstSample(outFrmNum);
     int outFrmLen = ofCtx.vsapi->getFrameLength(outFrm);
 
-    for (int ch = 0; ch < outInfo.format.numChannels; ++ch)
+    // all channels are equal
+    std::array<double, VS_AUDIO_FRAME_SAMPLES> samples;
+    std::span<const double> frameSamples(samples.data(), outFrmLen);
+
+    fillFrameSamples(outPosFrmStart, std::span(samples.data(), outFrmLen));
+
+    if (outInfo.format.numChannels == 0)
+    {
+        return true;
+    }
+
+    int64_t overflowCount = ofCtx.stats.count;
+
+    if (!writeFrameChannel<sample_t, IntSampleBits, CheckOverflow>(0, outFrm, outPosFrmStart, frameSamples, ofCtx))
+    {
+        return false;
+    }
+
+    const uint8_t* firstChannelPtr = ofCtx.vsapi->getReadPtr(outFrm, 0);
+
+    for (int ch = 1; ch < outInfo.format.numChannels; ++ch)
     {
-        if (!writeFrameChannel<sample_t, IntSampleBits>(ch, outFrm, outPosFrmStart, outFrmLen, ofCtx))
+        if (ofCtx.stats.count == overflowCount)
+        {
+            // no overflow in the first channel, all other channels are the same
+            std::memcpy(ofCtx.vsapi->getWritePtr(outFrm, ch), firstChannelPtr, static_cast<size_t>(outFrmLen) * sizeof(sample_t));
+            continue;
+        }
+
+        // overflows are handled and logged for each channel
+        if (!writeFrameChannel<sample_t, IntSampleBits, CheckOverflow>(ch, outFrm, outPosFrmStart, frameSamples, ofCtx))
         {
             return false;
         }
@@ -119,27 +239,33 @@ bool SineTone::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const common::Over
 }
 
 
-
-bool SineTone::writeFrame(VSFrame* outFrm, int outFrmNum, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+bool SineTone::writeFrame(VSFrame* outFrm, int outFrmNum, common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
 {
     common::OverflowContext ofCtx =
         { .mode = overflowMode, .log = overflowLog, .funcName = FuncName,
-          .frameCtx = frameCtx, .core = core, .vsapi = vsapi };
+          .frameCtx = frameCtx, .core = core, .vsapi = vsapi,
+          .stats = overflowStats };
 
     switch (outSampleType)
     {
         case common::SampleType::Int8:
-            return writeFrameImpl<int8_t, 8>(outFrm, outFrmNum, ofCtx);
+            return overflowPossible ? writeFrameImpl<int8_t, 8, true>(outFrm, outFrmNum, ofCtx)
+                                    : writeFrameImpl<int8_t, 8, false>(outFrm, outFrmNum, ofCtx);
         case common::SampleType::Int16:
-            return writeFrameImpl<int16_t, 16>(outFrm, outFrmNum, ofCtx);
+            return overflowPossible ? writeFrameImpl<int16_t, 16, true>(outFrm, outFrmNum, ofCtx)
+                                    : writeFrameImpl<int16_t, 16, false>(outFrm, outFrmNum, ofCtx);
         case common::SampleType::Int24:
-            return writeFrameImpl<int32_t, 24>(outFrm, outFrmNum, ofCtx);
+            return overflowPossible ? writeFrameImpl<int32_t, 24, true>(outFrm, outFrmNum, ofCtx)
+                                    : writeFrameImpl<int32_t, 24, false>(outFrm, outFrmNum, ofCtx);
         case common::SampleType::Int32:
-            return writeFrameImpl<int32_t, 32>(outFrm, outFrmNum, ofCtx);
+            return overflowPossible ? writeFrameImpl<int32_t, 32, true>(outFrm, outFrmNum, ofCtx)
+                                    : writeFrameImpl<int32_t, 32, false>(outFrm, outFrmNum, ofCtx);
         case common::SampleType::Float32:
-            return writeFrameImpl<float, 0>(outFrm, outFrmNum, ofCtx);
+            return overflowPossible ? writeFrameImpl<float, 0, true>(outFrm, outFrmNum, ofCtx)
+                                    : writeFrameImpl<float, 0, false>(outFrm, outFrmNum, ofCtx);
         case common::SampleType::Float64:
-            return writeFrameImpl<double, 0>(outFrm, outFrmNum, ofCtx);
+            return overflowPossible ? writeFrameImpl<double, 0, true>(outFrm, outFrmNum, ofCtx)
+                                    : writeFrameImpl<double, 0, false>(outFrm, outFrmNum, ofCtx);
         default:
             return false;
     }
@@ -149,8 +275,7 @@ bool SineTone::writeFrame(VSFrame* outFrm, int outFrmNum, VSFrameContext* frameC
 void VS_CC sinetoneFree(void* instanceData, VSCore* core, const VSAPI* vsapi)
 {
     SineTone* data = static_cast<SineTone*>(instanceData);
-    // skip logging since the total number of overflows is unreliable
-    // data->logNumOverflows(core, vsapi);
+    data->flushOverflowStats(core, vsapi);
     data->free(vsapi);
     delete data;
 }
@@ -162,23 +287,27 @@ const VSFrame* VS_CC sinetoneGetFrame(int outFrmNum, int activationReason, void*
 
     if (activationReason == VSActivationReason::arInitial)
     {
-        if (outFrmNum == 0)
+        if (const VSFrame* periodicFrm = data->getPeriodicFrame(outFrmNum, vsapi))
         {
-            data->resetOverflowStats();
+            data->submitOverflowStats(outFrmNum, common::OverflowStats(), core, vsapi);
+            return periodicFrm;
         }
 
         int outFrmLen = vsutils::getFrameSampleCount(outFrmNum, data->getOutInfo().numSamples);
 
         VSFrame* outFrm = vsapi->newAudioFrame(&data->getOutInfo().format, outFrmLen, nullptr, core);
 
-        bool success = data->writeFrame(outFrm, outFrmNum, frameCtx, core, vsapi);
+        common::OverflowStats overflowStats;
 
-        if (outFrmNum == data->getOutInfo().numFrames - 1)
+        bool success = data->writeFrame(outFrm, outFrmNum, overflowStats, frameCtx, core, vsapi);
+
+        if (success && data->isStatsEnabled())
         {
-            // last frame
-            data->logOverflowStats(core, vsapi);
+            common::setFrameStatsProps(outFrm, overflowStats, vsapi);
         }
 
+        data->submitOverflowStats(outFrmNum, std::move(overflowStats), core, vsapi);
+
         if (success)
         {
             return outFrm;
@@ -297,13 +426,19 @@ static void VS_CC sinetoneCreate(const VSMap* in, VSMap* out, void* userData, VS
         return;
     }
 
+    // stats:int:opt
+    bool stats = vsmap::getOptBool("stats", in, vsapi, DefaultStats);
+
     // free template clip, might be null
     vsapi->freeNode(audio);
 
-    SineTone* data = new SineTone(samples, channelLayout, sampleRate, optSampleType.value(), freq, amp, optOverflowMode.value(), optOverflowLog.value());
+    SineTone* data = new SineTone(samples, channelLayout, sampleRate, optSampleType.value(), freq, amp, optOverflowMode.value(), optOverflowLog.value(),
+                                  stats, core, vsapi);
+
+    common::logOverflowCheck(FuncName, data->isOverflowPossible(), core, vsapi);
 
-    // fmParallelRequests: strict sequential frame requests for overflow logging
-    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), sinetoneGetFrame, sinetoneFree, VSFilterMode::fmParallelRequests, nullptr, 0, data, core);
+    // fmParallel: overflows are collected per frame and logged in frame order by common::OverflowTracker
+    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), sinetoneGetFrame, sinetoneFree, VSFilterMode::fmParallel, nullptr, 0, data, core);
 }
 
 
@@ -319,7 +454,8 @@ void sinetoneInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi)
                              "amp:float:opt;"
                              "channels:int[]:opt;"
                              "overflow:data:opt;"
-                             "overflow_log:data:opt;",
+                             "overflow_log:data:opt;"
+                             "stats:int:opt;",
                              "return:anode;",
                              sinetoneCreate, nullptr, plugin);
 }
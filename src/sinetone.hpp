@@ -3,6 +3,7 @@
 #pragma once
 
 #include <cstdint>
+#include <span>
 
 #include "VapourSynth4.h"
 
@@ -13,17 +14,27 @@ class SineTone
 {
 public:
     SineTone(int64_t numSamples, uint64_t channelLayout, int sampleRate, common::SampleType sampleType,
-             double freq, double amplitude, common::OverflowMode overflowMode, common::OverflowLog overflowLog);
+             double freq, double amplitude, common::OverflowMode overflowMode, common::OverflowLog overflowLog,
+             bool stats, VSCore* core, const VSAPI* vsapi);
 
     const VSAudioInfo& getOutInfo();
 
-    void resetOverflowStats();
+    // false if no output sample can overflow, see common::isOverflowPossible
+    bool isOverflowPossible();
 
-    void logOverflowStats(VSCore* core, const VSAPI* vsapi);
+    // true if the stats props are written to every output frame, see common/stats.hpp
+    bool isStatsEnabled();
+
+    // returns a new reference to the cached frame if the output is periodic per frame, nullptr otherwise
+    const VSFrame* getPeriodicFrame(int outFrmNum, const VSAPI* vsapi);
+
+    void submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi);
+
+    void flushOverflowStats(VSCore* core, const VSAPI* vsapi);
 
     void free(const VSAPI* vsapi);
 
-    bool writeFrame(VSFrame* outFrm, int outFrmNum, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
+    bool writeFrame(VSFrame* outFrm, int outFrmNum, common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
 
 private:
     VSAudioInfo outInfo;
@@ -34,16 +45,34 @@ private:
     double amplitude;
     double absAmplitude;
 
+    // one sample step of the oscillator phase
+    double cosPhaseStep;
+    double sinPhaseStep;
+
+    // content of every full frame if a frame contains a whole number of periods and no sample can overflow
+    const VSFrame* periodicFrame = nullptr;
+
     common::OverflowMode overflowMode;
     common::OverflowLog overflowLog;
 
-    common::OverflowStats overflowStats = { .count = 0, .peak = 0.0 };
+    common::OverflowTracker overflowTracker;
+
+    // selects the writeFrameImpl specialization with or without overflow checks
+    bool overflowPossible;
+
+    bool stats;
+
+    void initPeriodicFrame(VSCore* core, const VSAPI* vsapi);
+
+    double getPhase(int64_t outPos);
+
+    void fillFrameSamples(int64_t outPosFrmStart, std::span<double> samples);
 
-    template <typename sample_t, size_t IntSampleBits>
-    bool writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStart, int outFrmLen,
+    template <typename sample_t, size_t IntSampleBits, bool CheckOverflow>
+    bool writeFrameChannel(int ch, VSFrame* outFrm, int64_t outPosFrmStart, std::span<const double> samples,
                            const common::OverflowContext& ofCtx);
 
-    template <typename sample_t, size_t IntSampleBits>
+    template <typename sample_t, size_t IntSampleBits, bool CheckOverflow>
     bool writeFrameImpl(VSFrame* outFrm, int outFrmNum, const common::OverflowContext& ofCtx);
 };
 
@@ -0,0 +1,696 @@
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "VapourSynth4.h"
+#include "VSHelper4.h"
+
+#include "splice.hpp"
+#include "common/framewindow.hpp"
+#include "common/offset.hpp"
+#include "common/overflow.hpp"
+#include "common/precision.hpp"
+#include "common/sampletype.hpp"
+#include "common/stats.hpp"
+#include "common/transition.hpp"
+#include "vsmap/vsmap.hpp"
+#include "vsmap/vsmap_common.hpp"
+#include "vsutils/audio.hpp"
+
+constexpr const char* FuncName = "Splice";
+
+constexpr int64_t DefaultFadeSamples = 0;
+constexpr common::TransitionType DefaultFadeType = common::TransitionType::Cubic;
+constexpr common::OverflowMode DefaultOverflowMode = common::OverflowMode::Error;
+constexpr common::OverflowLog DefaultOverflowLog = common::OverflowLog::Once;
+constexpr bool DefaultStats = false;
+constexpr common::Precision DefaultPrecision = common::Precision::Double;
+
+
+Splice::Splice(std::vector<VSNode*> audios, std::vector<int64_t> fadeSamples, std::vector<common::TransitionType> fadeTypes,
+               common::OverflowMode _overflowMode, common::OverflowLog _overflowLog, bool _stats, common::Precision _precision,
+               const VSAPI* vsapi) :
+    overflowMode(_overflowMode), overflowLog(_overflowLog), stats(_stats), precision(_precision)
+{
+    outInfo = *vsapi->getAudioInfo(audios[0]);
+
+    int64_t outPosStart = 0;
+
+    for (size_t i = 0; i < audios.size(); ++i)
+    {
+        SpliceClip clip = {};
+
+        clip.audio = audios[i];
+        clip.info = *vsapi->getAudioInfo(audios[i]);
+
+        // the clip starts with the crossfade of the previous junction
+        int64_t fadein = 0 < i ? fadeSamples[i - 1] : 0;
+        int64_t fadeout = i + 1 < audios.size() ? fadeSamples[i] : 0;
+
+        clip.outPosStart = outPosStart;
+        clip.outPosEnd = outPosStart + clip.info.numSamples;
+
+        clip.frameSampleOffsets = common::getFrameSampleOffsets(clip.outPosStart);
+
+        clip.outPosFadeinEnd = clip.outPosStart + fadein;
+        clip.outPosFadeoutStart = clip.outPosEnd - fadeout;
+
+        clip.fadeinTrans = 0 < i ? clips[i - 1].fadeoutTrans : nullptr;
+        clip.fadeoutTrans = 0 < fadeout ? common::newTransition(fadeTypes[i], 0, 1, static_cast<double>(fadeout - 1), 0) : nullptr;
+
+        outPosClipStarts.push_back(clip.outPosStart);
+        outPosClipEnds.push_back(clip.outPosEnd);
+
+        outPosStart = clip.outPosFadeoutStart;
+
+        clips.push_back(clip);
+    }
+
+    // create destination audio information
+    outInfo.numSamples = clips.back().outPosEnd;
+    outInfo.numFrames = vsutils::samplesToFrames(outInfo.numSamples);
+
+    outSampleType = common::getSampleTypeFromAudioFormat(outInfo.format).value();
+
+    // only needed if every clip frame is used by two output frames
+    clipWindows = std::vector<common::FrameWindow>(clips.size());
+
+    for (size_t i = 0; i < clips.size(); ++i)
+    {
+        clipWindows[i].init(clips[i].frameSampleOffsets.left == 0 ? 0 : common::FrameWindow::DefaultCapacity);
+    }
+
+    // the scales of the two clips of a crossfade are inside [0, 1] and add up to 1
+    overflowPossible = common::isOverflowPossible(common::getMaxAbsSample(outSampleType), outSampleType, precision);
+
+    overflowTracker.init(FuncName, overflowMode, overflowLog, common::isFloatSampleType(outSampleType), outInfo.numFrames);
+}
+
+
+const VSAudioInfo& Splice::getOutInfo()
+{
+    return outInfo;
+}
+
+
+bool Splice::isOverflowPossible()
+{
+    return overflowPossible;
+}
+
+
+bool Splice::isStatsEnabled()
+{
+    return stats;
+}
+
+
+VSNode* Splice::getAudio(size_t clip)
+{
+    return clips[clip].audio;
+}
+
+
+common::FrameWindow& Splice::getClipWindow(size_t clip)
+{
+    return clipWindows[clip];
+}
+
+
+SpliceClipRange Splice::getActiveClips(int outFrmNum)
+{
+    int64_t outPosFrmStart = vsutils::frameToFirstSample(outFrmNum);
+    int64_t outPosFrmEnd = outPosFrmStart + vsutils::getFrameSampleCount(outFrmNum, outInfo.numSamples);
+
+    // the clip starts and ends are both sorted: first clip that ends after the frame start, first clip that starts at or after the frame end
+    auto begin = std::upper_bound(outPosClipEnds.begin(), outPosClipEnds.end(), outPosFrmStart);
+    auto end = std::lower_bound(outPosClipStarts.begin(), outPosClipStarts.end(), outPosFrmEnd);
+
+    return { .begin = static_cast<size_t>(begin - outPosClipEnds.begin()),
+             .end = static_cast<size_t>(end - outPosClipStarts.begin()) };
+}
+
+
+common::OffsetFramePos Splice::outFrameToClipFrames(int outFrmNum, size_t clip)
+{
+    const SpliceClip& c = clips[clip];
+
+    return common::baseFrameToOffsetFrames(outFrmNum, c.outPosStart, c.info.numSamples, outInfo.numSamples);
+}
+
+
+bool Splice::isFading(const SpliceClip& clip, int64_t outPosFrmStart, int64_t outPosFrmEnd)
+{
+    bool inFadein = clip.fadeinTrans && clip.outPosStart < outPosFrmEnd && outPosFrmStart < clip.outPosFadeinEnd;
+    bool inFadeout = clip.fadeoutTrans && clip.outPosFadeoutStart < outPosFrmEnd && outPosFrmStart < clip.outPosEnd;
+
+    return inFadein || inFadeout;
+}
+
+
+std::vector<const VSFrame*> Splice::getOutChannelSources(int outFrmNum, int outFrmLen, const std::vector<SpliceClipFrames>& clipFrames, const VSAPI* vsapi)
+{
+    std::vector<const VSFrame*> outChannelSources(static_cast<size_t>(outInfo.format.numChannels), nullptr);
+
+    if (clipFrames.size() != 1)
+    {
+        return outChannelSources;
+    }
+
+    const SpliceClipFrames& frames = clipFrames[0];
+    const SpliceClip& clip = clips[frames.clip];
+
+    int64_t outPosFrmStart = vsutils::frameToFirstSample(outFrmNum);
+    int64_t outPosFrmEnd = outPosFrmStart + outFrmLen;
+
+    // the clip has to cover the whole frame unchanged
+    if (clip.frameSampleOffsets.left != 0 || !frames.frmL || vsapi->getFrameLength(frames.frmL) != outFrmLen ||
+        outPosFrmStart < clip.outPosStart || clip.outPosEnd < outPosFrmEnd || isFading(clip, outPosFrmStart, outPosFrmEnd))
+    {
+        return outChannelSources;
+    }
+
+    for (int ch = 0; ch < outInfo.format.numChannels; ++ch)
+    {
+        // overflowing input samples are handled by writeFrame
+        if (!common::isFrameChannelOverflowing(frames.frmL, ch, outSampleType, vsapi))
+        {
+            outChannelSources[ch] = frames.frmL;
+        }
+    }
+
+    return outChannelSources;
+}
+
+
+void Splice::submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi)
+{
+    overflowTracker.submitFrame(outFrmNum, std::move(frameOverflowStats), core, vsapi);
+}
+
+
+void Splice::flushOverflowStats(VSCore* core, const VSAPI* vsapi)
+{
+    overflowTracker.flush(core, vsapi);
+}
+
+
+void Splice::free(const VSAPI* vsapi)
+{
+    for (common::FrameWindow& window : clipWindows)
+    {
+        window.clear(vsapi);
+    }
+
+    for (SpliceClip& clip : clips)
+    {
+        // fadeinTrans is the fadeoutTrans of the previous clip
+        delete clip.fadeoutTrans;
+
+        vsapi->freeNode(clip.audio);
+    }
+}
+
+
+template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t>
+bool Splice::writeFrameImpl(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
+                            const std::vector<SpliceClipFrames>& clipFrames, const common::OverflowContext& ofCtx)
+{
+    int64_t outPosFrmStart = vsutils::frameToFirstSample(outFrmNum);
+    int outFrmLen = ofCtx.vsapi->getFrameLength(outFrm);
+
+    int numChannels = outInfo.format.numChannels;
+
+    // sum of the crossfaded clips, one frame per channel
+    std::vector<compute_t> spliceSamples(static_cast<size_t>(numChannels) * VS_AUDIO_FRAME_SAMPLES, compute_t(0));
+
+    std::array<compute_t, VS_AUDIO_FRAME_SAMPLES> samples;
+
+    // per sample gains of a crossfaded clip, the same for all channels
+    std::array<compute_t, VS_AUDIO_FRAME_SAMPLES> gains;
+    FrameScales fadeScales;
+
+    for (const SpliceClipFrames& frames : clipFrames)
+    {
+        const SpliceClip& clip = clips[frames.clip];
+
+        int begin = static_cast<int>(std::clamp<int64_t>(clip.outPosStart - outPosFrmStart, 0, outFrmLen));
+        int end = static_cast<int>(std::clamp<int64_t>(clip.outPosEnd - outPosFrmStart, 0, outFrmLen));
+
+        if (end <= begin)
+        {
+            continue;
+        }
+
+        bool fading = isFading(clip, outPosFrmStart + begin, outPosFrmStart + end);
+
+        if (fading)
+        {
+            std::fill(gains.begin() + begin, gains.begin() + end, compute_t(1));
+
+            int fadeinEnd = static_cast<int>(std::clamp<int64_t>(clip.outPosFadeinEnd - outPosFrmStart, begin, end));
+
+            if (clip.fadeinTrans && begin < fadeinEnd)
+            {
+                // the previous clip fades out: this clip gets the rest
+                int64_t fadeinPosBegin = outPosFrmStart + begin - clip.outPosStart;
+                clip.fadeinTrans->fill(static_cast<double>(fadeinPosBegin), std::span(fadeScales.data() + begin, fadeinEnd - begin));
+
+                for (int s = begin; s < fadeinEnd; ++s)
+                {
+                    gains[s] = 1 - static_cast<compute_t>(fadeScales[s]);
+                }
+            }
+
+            int fadeoutBegin = static_cast<int>(std::clamp<int64_t>(clip.outPosFadeoutStart - outPosFrmStart, begin, end));
+
+            if (clip.fadeoutTrans && fadeoutBegin < end)
+            {
+                int64_t fadeoutPosBegin = outPosFrmStart + fadeoutBegin - clip.outPosFadeoutStart;
+                clip.fadeoutTrans->fill(static_cast<double>(fadeoutPosBegin), std::span(fadeScales.data() + fadeoutBegin, end - fadeoutBegin));
+
+                for (int s = fadeoutBegin; s < end; ++s)
+                {
+                    gains[s] *= static_cast<compute_t>(fadeScales[s]);
+                }
+            }
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            if (outChannelSources[ch])
+            {
+                continue;
+            }
+
+            const sample_t* frmLPtr = reinterpret_cast<const sample_t*>(frames.frmL ? ofCtx.vsapi->getReadPtr(frames.frmL, ch) : nullptr);
+            const sample_t* frmRPtr = reinterpret_cast<const sample_t*>(frames.frmR ? ofCtx.vsapi->getReadPtr(frames.frmR, ch) : nullptr);
+
+            compute_t* splicePtr = spliceSamples.data() + static_cast<size_t>(ch) * VS_AUDIO_FRAME_SAMPLES;
+
+            if (fading)
+            {
+                common::convOffsetSamplesToCompute<sample_t, IntSampleBits, compute_t>(begin, end, clip.frameSampleOffsets, frmLPtr, frmRPtr, samples.data());
+
+                for (int s = begin; s < end; ++s)
+                {
+                    splicePtr[s] += gains[s] * samples[s];
+                }
+            }
+            else
+            {
+                // clips only overlap inside a crossfade: the samples are converted in place
+                common::convOffsetSamplesToCompute<sample_t, IntSampleBits, compute_t>(begin, end, clip.frameSampleOffsets, frmLPtr, frmRPtr, splicePtr);
+            }
+        }
+    }
+
+    // one overflow check and conversion per channel for all clips
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        if (outChannelSources[ch])
+        {
+            continue;
+        }
+
+        sample_t* outFrmPtr = reinterpret_cast<sample_t*>(ofCtx.vsapi->getWritePtr(outFrm, ch));
+
+        compute_t* splicePtr = spliceSamples.data() + static_cast<size_t>(ch) * VS_AUDIO_FRAME_SAMPLES;
+
+        if (!common::safeWriteSamples<sample_t, IntSampleBits, CheckOverflow>(std::span(splicePtr, outFrmLen), outFrmPtr, outPosFrmStart, ch, ofCtx))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool Splice::writeFrame(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
+                        const std::vector<SpliceClipFrames>& clipFrames,
+                        common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+{
+    common::OverflowContext ofCtx =
+        { .mode = overflowMode, .log = overflowLog, .funcName = FuncName,
+          .frameCtx = frameCtx, .core = core, .vsapi = vsapi,
+          .stats = overflowStats };
+
+    switch (outSampleType)
+    {
+        case common::SampleType::Int8:
+            return overflowPossible ? writeFrameImpl<int8_t, 8, true>(outFrm, outFrmNum, outChannelSources, clipFrames, ofCtx)
+                                    : writeFrameImpl<int8_t, 8, false>(outFrm, outFrmNum, outChannelSources, clipFrames, ofCtx);
+        case common::SampleType::Int16:
+            return overflowPossible ? writeFrameImpl<int16_t, 16, true>(outFrm, outFrmNum, outChannelSources, clipFrames, ofCtx)
+                                    : writeFrameImpl<int16_t, 16, false>(outFrm, outFrmNum, outChannelSources, clipFrames, ofCtx);
+        case common::SampleType::Int24:
+            return overflowPossible ? writeFrameImpl<int32_t, 24, true>(outFrm, outFrmNum, outChannelSources, clipFrames, ofCtx)
+                                    : writeFrameImpl<int32_t, 24, false>(outFrm, outFrmNum, outChannelSources, clipFrames, ofCtx);
+        case common::SampleType::Int32:
+            return overflowPossible ? writeFrameImpl<int32_t, 32, true>(outFrm, outFrmNum, outChannelSources, clipFrames, ofCtx)
+                                    : writeFrameImpl<int32_t, 32, false>(outFrm, outFrmNum, outChannelSources, clipFrames, ofCtx);
+        case common::SampleType::Float32:
+            if (common::isFloatCompute(precision, outSampleType))
+            {
+                // float rounding errors can overflow, see common::isOverflowPossible
+                return writeFrameImpl<float, 0, true, float>(outFrm, outFrmNum, outChannelSources, clipFrames, ofCtx);
+            }
+            return overflowPossible ? writeFrameImpl<float, 0, true>(outFrm, outFrmNum, outChannelSources, clipFrames, ofCtx)
+                                    : writeFrameImpl<float, 0, false>(outFrm, outFrmNum, outChannelSources, clipFrames, ofCtx);
+        case common::SampleType::Float64:
+            return overflowPossible ? writeFrameImpl<double, 0, true>(outFrm, outFrmNum, outChannelSources, clipFrames, ofCtx)
+                                    : writeFrameImpl<double, 0, false>(outFrm, outFrmNum, outChannelSources, clipFrames, ofCtx);
+        default:
+            return false;
+    }
+}
+
+
+static void VS_CC spliceFree(void* instanceData, VSCore* core, const VSAPI* vsapi)
+{
+    Splice* data = static_cast<Splice*>(instanceData);
+    data->flushOverflowStats(core, vsapi);
+    data->free(vsapi);
+    delete data;
+}
+
+
+static const VSFrame* VS_CC spliceGetFrame(int outFrmNum, int activationReason, void* instanceData, void** frameData, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+{
+    Splice* data = static_cast<Splice*>(instanceData);
+
+    // only the clips that overlap the output frame are requested
+    SpliceClipRange activeClips = data->getActiveClips(outFrmNum);
+
+    if (activationReason == VSActivationReason::arError)
+    {
+        common::freeWindowFrames(frameData, vsapi);
+        return nullptr;
+    }
+
+    if (activationReason == VSActivationReason::arInitial)
+    {
+        bool frmRequested = false;
+
+        // clip frames that are still in the frame windows are not requested again
+        auto windowFrms = std::make_unique<common::WindowFrames>(activeClips.end - activeClips.begin);
+
+        for (size_t clip = activeClips.begin; clip < activeClips.end; ++clip)
+        {
+            common::OffsetFramePos frmNums = data->outFrameToClipFrames(outFrmNum, clip);
+
+            if (common::requestOffsetFrames(frmNums, data->getAudio(clip), data->getClipWindow(clip), windowFrms->at(clip - activeClips.begin), frameCtx, vsapi))
+            {
+                frmRequested = true;
+            }
+        }
+
+        *frameData = windowFrms.release();
+
+        if (frmRequested)
+        {
+            return nullptr;
+        }
+
+        // all frames are in the frame windows: the frame is returned right away
+    }
+
+    if (activationReason == VSActivationReason::arInitial || activationReason == VSActivationReason::arAllFramesReady)
+    {
+        std::unique_ptr<common::WindowFrames> windowFrms(common::releaseWindowFrames(frameData));
+
+        std::vector<SpliceClipFrames> clipFrames;
+        clipFrames.reserve(activeClips.end - activeClips.begin);
+
+        const VSFrame* propFrm = nullptr;
+
+        for (size_t clip = activeClips.begin; clip < activeClips.end; ++clip)
+        {
+            common::OffsetFramePos frmNums = data->outFrameToClipFrames(outFrmNum, clip);
+
+            common::OffsetFrames frms = common::getOffsetFrames(frmNums, windowFrms->at(clip - activeClips.begin), data->getAudio(clip), data->getClipWindow(clip), frameCtx, vsapi);
+
+            SpliceClipFrames frames = { .clip = clip, .frmL = frms.left, .frmR = frms.right };
+
+            if (!propFrm)
+            {
+                propFrm = frames.frmL ? frames.frmL : frames.frmR;
+            }
+
+            clipFrames.push_back(frames);
+        }
+
+        int outFrmLen = vsutils::getFrameSampleCount(outFrmNum, data->getOutInfo().numSamples);
+
+        std::vector<const VSFrame*> outChannelSources = data->getOutChannelSources(outFrmNum, outFrmLen, clipFrames, vsapi);
+
+        VSFrame* outFrm = vsutils::newAudioFrameFromChannelSources(&data->getOutInfo().format, outFrmLen, outChannelSources, propFrm, core, vsapi);
+
+        common::OverflowStats overflowStats;
+
+        bool success = data->writeFrame(outFrm, outFrmNum, outChannelSources, clipFrames, overflowStats, frameCtx, core, vsapi);
+
+        for (const SpliceClipFrames& frames : clipFrames)
+        {
+            if (frames.frmL)
+            {
+                vsapi->freeFrame(frames.frmL);
+            }
+
+            if (frames.frmR)
+            {
+                vsapi->freeFrame(frames.frmR);
+            }
+        }
+
+        if (success)
+        {
+            common::updateFrameStatsProps(outFrm, data->isStatsEnabled(), overflowStats, vsapi);
+        }
+
+        data->submitOverflowStats(outFrmNum, std::move(overflowStats), core, vsapi);
+
+        if (success)
+        {
+            return outFrm;
+        }
+
+        vsapi->freeFrame(outFrm);
+    }
+
+    return nullptr;
+}
+
+
+static void freeNodes(const std::vector<VSNode*>& nodes, const VSAPI* vsapi)
+{
+    for (VSNode* node : nodes)
+    {
+        vsapi->freeNode(node);
+    }
+}
+
+
+/**
+ * returns one value per junction (number of clips - 1)
+ * values can be empty (defaultValue for all junctions), have one value (for all junctions) or one value per junction
+ */
+template <typename T>
+static std::optional<std::vector<T>> toPerJunctionValues(const char* varName, const std::vector<T>& values, size_t numJunctions, T defaultValue, VSMap* out, const VSAPI* vsapi)
+{
+    if (values.empty())
+    {
+        return std::vector<T>(numJunctions, defaultValue);
+    }
+
+    if (values.size() == 1)
+    {
+        return std::vector<T>(numJunctions, values[0]);
+    }
+
+    if (values.size() != numJunctions)
+    {
+        std::string errMsg = std::format("{}: {} must have one value or one value per junction ({})", FuncName, varName, numJunctions);
+        vsapi->mapSetError(out, errMsg.c_str());
+        return std::nullopt;
+    }
+
+    return values;
+}
+
+
+static void VS_CC spliceCreate(const VSMap* in, VSMap* out, void* userData, VSCore* core, const VSAPI* vsapi)
+{
+    // clips:anode[]
+    int numClips = vsapi->mapNumElements(in, "clips");
+    if (numClips < 1)
+    {
+        std::string errMsg = std::format("{}: no clips", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        return;
+    }
+
+    std::vector<VSNode*> audios;
+    audios.reserve(static_cast<size_t>(numClips));
+
+    for (int i = 0; i < numClips; ++i)
+    {
+        audios.push_back(vsapi->mapGetNode(in, "clips", i, nullptr));
+    }
+
+    const VSAudioInfo* audioInfo = vsapi->getAudioInfo(audios[0]);
+
+    for (int i = 1; i < numClips; ++i)
+    {
+        if (!vsh::isSameAudioInfo(audioInfo, vsapi->getAudioInfo(audios[i])))
+        {
+            std::string errMsg = std::format("{}: clips have different audio format", FuncName);
+            vsapi->mapSetError(out, errMsg.c_str());
+            freeNodes(audios, vsapi);
+            return;
+        }
+    }
+
+    // check for supported audio format
+    auto optSampleType = common::getSampleTypeFromAudioFormat(audioInfo->format);
+    if (!optSampleType.has_value())
+    {
+        std::string errMsg = std::format("{}: unsupported audio format", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    size_t junctions = audios.size() - 1;
+
+    // fade_samples:int[]:opt
+    // fade_seconds:float[]:opt
+    // fade_samples has a higher priority than fade_seconds
+    std::optional<std::vector<int64_t>> optFadeSamples = toPerJunctionValues("fade",
+        vsmap::getOptSamplesArray("fade_samples", "fade_seconds", in, vsapi, {}, audioInfo->sampleRate), junctions, DefaultFadeSamples, out, vsapi);
+    if (!optFadeSamples.has_value())
+    {
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    const std::vector<int64_t>& fadeSamples = optFadeSamples.value();
+
+    for (size_t j = 0; j < junctions; ++j)
+    {
+        if (fadeSamples[j] < 0)
+        {
+            std::string errMsg = std::format("{}: negative crossfade length", FuncName);
+            vsapi->mapSetError(out, errMsg.c_str());
+            freeNodes(audios, vsapi);
+            return;
+        }
+    }
+
+    // at most two clips may overlap: the crossfades at the start and at the end of a clip must not overlap
+    for (size_t i = 0; i < audios.size(); ++i)
+    {
+        int64_t fadein = 0 < i ? fadeSamples[i - 1] : 0;
+        int64_t fadeout = i < junctions ? fadeSamples[i] : 0;
+
+        if (vsapi->getAudioInfo(audios[i])->numSamples < fadein + fadeout)
+        {
+            std::string errMsg = std::format("{}: clip {} is shorter than its crossfades", FuncName, i);
+            vsapi->mapSetError(out, errMsg.c_str());
+            freeNodes(audios, vsapi);
+            return;
+        }
+    }
+
+    // types:data[]:opt
+    std::optional<std::vector<common::TransitionType>> optTypes = vsmap::getOptTransitionTypesFromStrings("types", FuncName, in, out, vsapi, {});
+    if (!optTypes.has_value())
+    {
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    std::optional<std::vector<common::TransitionType>> optFadeTypes = toPerJunctionValues("types", optTypes.value(), junctions, DefaultFadeType, out, vsapi);
+    if (!optFadeTypes.has_value())
+    {
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    // overflow:data:opt
+    std::optional<common::OverflowMode> optOverflowMode = vsmap::getOptOverflowModeFromString("overflow", FuncName, in, out, vsapi, DefaultOverflowMode);
+    if (!optOverflowMode.has_value())
+    {
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    if (optOverflowMode.value() == common::OverflowMode::KeepFloat && !common::isFloatSampleType(optSampleType.value()))
+    {
+        std::string errMsg = std::format("{}: cannot use 'keep_float' overflow mode with an integer sample type", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    // overflow_log:data:opt
+    std::optional<common::OverflowLog> optOverflowLog = vsmap::getOptOverflowLogFromString("overflow_log", FuncName, in, out, vsapi, DefaultOverflowLog);
+    if (!optOverflowLog.has_value())
+    {
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    // stats:int:opt
+    bool stats = vsmap::getOptBool("stats", in, vsapi, DefaultStats);
+
+    // precision:data:opt
+    std::optional<common::Precision> optPrecision = vsmap::getOptPrecisionFromString("precision", FuncName, in, out, vsapi, DefaultPrecision);
+    if (!optPrecision.has_value())
+    {
+        freeNodes(audios, vsapi);
+        return;
+    }
+
+    std::vector<VSFilterDependency> deps;
+    deps.reserve(audios.size());
+
+    for (VSNode* audio : audios)
+    {
+        deps.push_back({ audio, VSRequestPattern::rpGeneral });
+    }
+
+    Splice* data = new Splice(audios, fadeSamples, optFadeTypes.value(),
+                              optOverflowMode.value(), optOverflowLog.value(), stats, optPrecision.value(), vsapi);
+
+    common::logOverflowCheck(FuncName, data->isOverflowPossible(), core, vsapi);
+
+    // fmParallel: overflows are collected per frame and logged in frame order by common::OverflowTracker
+    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), spliceGetFrame, spliceFree, VSFilterMode::fmParallel, deps.data(), static_cast<int>(deps.size()), data, core);
+}
+
+
+void spliceInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi)
+{
+    vspapi->registerFunction(FuncName,
+                             "clips:anode[];"
+                             "fade_samples:int[]:opt;"
+                             "fade_seconds:float[]:opt;"
+                             "types:data[]:opt;"
+                             "overflow:data:opt;"
+                             "overflow_log:data:opt;"
+                             "stats:int:opt;"
+                             "precision:data:opt;",
+                             "return:anode;",
+                             spliceCreate, nullptr, plugin);
+}
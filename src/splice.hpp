@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "VapourSynth4.h"
+
+#include "common/framewindow.hpp"
+#include "common/offset.hpp"
+#include "common/overflow.hpp"
+#include "common/precision.hpp"
+#include "common/sampletype.hpp"
+#include "common/transition.hpp"
+
+// input clip of Splice
+struct SpliceClip
+{
+    VSNode* audio;
+    VSAudioInfo info;
+
+    // output range of the clip: [outPosStart, outPosEnd)
+    int64_t outPosStart;
+    int64_t outPosEnd;
+
+    common::FrameSampleOffsets frameSampleOffsets;
+
+    // crossfade with the previous clip: [outPosStart, outPosFadeinEnd)
+    int64_t outPosFadeinEnd;
+
+    // crossfade with the next clip: [outPosFadeoutStart, outPosEnd)
+    int64_t outPosFadeoutStart;
+
+    // fade out transition of the previous clip (not owned), the clip scale is 1 - y
+    common::Transition* fadeinTrans;
+
+    // fade out transition is going from (0, 1) to (fadeSamples - 1, 0)
+    common::Transition* fadeoutTrans;
+};
+
+
+// frames of a clip that overlap an output frame, nullptr if not needed
+struct SpliceClipFrames
+{
+    size_t clip;
+
+    const VSFrame* frmL;
+    const VSFrame* frmR;
+};
+
+
+// clips that overlap an output frame: [begin, end)
+struct SpliceClipRange
+{
+    size_t begin;
+    size_t end;
+};
+
+
+class Splice
+{
+public:
+    /**
+     * the clips are joined in order, fadeSamples and fadeTypes have one value per junction (number of clips - 1)
+     * at most two clips overlap at any output position
+     */
+    Splice(std::vector<VSNode*> audios, std::vector<int64_t> fadeSamples, std::vector<common::TransitionType> fadeTypes,
+           common::OverflowMode overflowMode, common::OverflowLog overflowLog, bool stats, common::Precision precision,
+           const VSAPI* vsapi);
+
+    const VSAudioInfo& getOutInfo();
+
+    // false if no output sample can overflow, see common::isOverflowPossible
+    bool isOverflowPossible();
+
+    // true if the stats props are written to every output frame, see common/stats.hpp
+    bool isStatsEnabled();
+
+    VSNode* getAudio(size_t clip);
+
+    // recently fetched frames of a clip, see common::FrameWindow
+    common::FrameWindow& getClipWindow(size_t clip);
+
+    // binary search in the segment table, O(log n) in the number of clips
+    SpliceClipRange getActiveClips(int outFrmNum);
+
+    common::OffsetFramePos outFrameToClipFrames(int outFrmNum, size_t clip);
+
+    /**
+     * returns the source frame of each output channel that is taken over unchanged (for newAudioFrame2)
+     * a channel is taken from a clip frame if that clip is the only active clip of the frame, frame aligned and not faded
+     * nullptr: the channel has to be written by writeFrame
+     */
+    std::vector<const VSFrame*> getOutChannelSources(int outFrmNum, int outFrmLen, const std::vector<SpliceClipFrames>& clipFrames, const VSAPI* vsapi);
+
+    void submitOverflowStats(int outFrmNum, common::OverflowStats frameOverflowStats, VSCore* core, const VSAPI* vsapi);
+
+    void flushOverflowStats(VSCore* core, const VSAPI* vsapi);
+
+    void free(const VSAPI* vsapi);
+
+    // writes all channels without an out channel source
+    bool writeFrame(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
+                    const std::vector<SpliceClipFrames>& clipFrames,
+                    common::OverflowStats& overflowStats, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi);
+
+private:
+    std::vector<SpliceClip> clips;
+
+    // segment table: output start and end position of every clip, both sorted
+    std::vector<int64_t> outPosClipStarts;
+    std::vector<int64_t> outPosClipEnds;
+
+    // one frame window per clip
+    std::vector<common::FrameWindow> clipWindows;
+
+    VSAudioInfo outInfo;
+    common::SampleType outSampleType;
+
+    common::OverflowMode overflowMode;
+    common::OverflowLog overflowLog;
+
+    common::OverflowTracker overflowTracker;
+
+    // selects the writeFrameImpl specialization with or without overflow checks
+    bool overflowPossible;
+
+    bool stats;
+
+    // compute type of float samples, see common::Precision
+    common::Precision precision;
+
+    using FrameScales = std::array<double, VS_AUDIO_FRAME_SAMPLES>;
+
+    // true if the clip is crossfaded inside the output frame range [outPosFrmStart, outPosFrmEnd)
+    bool isFading(const SpliceClip& clip, int64_t outPosFrmStart, int64_t outPosFrmEnd);
+
+    template <typename sample_t, size_t IntSampleBits, bool CheckOverflow, typename compute_t = double>
+    bool writeFrameImpl(VSFrame* outFrm, int outFrmNum, const std::vector<const VSFrame*>& outChannelSources,
+                        const std::vector<SpliceClipFrames>& clipFrames, const common::OverflowContext& ofCtx);
+};
+
+void spliceInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi);
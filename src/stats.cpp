@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: MIT
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <string>
+
+#include "VapourSynth4.h"
+
+#include "stats.hpp"
+#include "common/overflow.hpp"
+#include "common/sampletype.hpp"
+#include "common/stats.hpp"
+
+constexpr const char* FuncName = "Stats";
+
+
+Stats::Stats(VSNode* _audio, const VSAudioInfo* _audioInfo) :
+    audio(_audio), audioInfo(*_audioInfo)
+{
+    sampleType = common::getSampleTypeFromAudioFormat(audioInfo.format).value();
+}
+
+
+VSNode* Stats::getAudio()
+{
+    return audio;
+}
+
+
+const VSAudioInfo& Stats::getOutInfo()
+{
+    return audioInfo;
+}
+
+
+common::OverflowStats Stats::countOverflows(const VSFrame* frm, const VSAPI* vsapi)
+{
+    common::OverflowStats overflowStats;
+    overflowStats.channelCounts.resize(static_cast<size_t>(audioInfo.format.numChannels), 0);
+
+    for (int ch = 0; ch < audioInfo.format.numChannels; ++ch)
+    {
+        int64_t count = common::countFrameChannelOverflows(frm, ch, sampleType, vsapi);
+        overflowStats.channelCounts[ch] = count;
+        overflowStats.count += count;
+    }
+    return overflowStats;
+}
+
+
+void Stats::free(const VSAPI* vsapi)
+{
+    vsapi->freeNode(audio);
+}
+
+
+static void VS_CC statsFree(void* instanceData, VSCore* core, const VSAPI* vsapi)
+{
+    Stats* data = static_cast<Stats*>(instanceData);
+    data->free(vsapi);
+    delete data;
+}
+
+
+static const VSFrame* VS_CC statsGetFrame(int outFrmNum, int activationReason, void* instanceData, void** frameData, VSFrameContext* frameCtx, VSCore* core, const VSAPI* vsapi)
+{
+    Stats* data = static_cast<Stats*>(instanceData);
+
+    if (activationReason == VSActivationReason::arInitial)
+    {
+        vsapi->requestFrameFilter(outFrmNum, data->getAudio(), frameCtx);
+        return nullptr;
+    }
+
+    if (activationReason == VSActivationReason::arAllFramesReady)
+    {
+        const VSFrame* inFrm = vsapi->getFrameFilter(outFrmNum, data->getAudio(), frameCtx);
+
+        // the samples are shared with inFrm, only the props are written
+        VSFrame* outFrm = vsapi->copyFrame(inFrm, core);
+
+        common::setFrameStatsProps(outFrm, data->countOverflows(inFrm, vsapi), vsapi);
+
+        vsapi->freeFrame(inFrm);
+
+        return outFrm;
+    }
+
+    return nullptr;
+}
+
+
+static void VS_CC statsCreate(const VSMap* in, VSMap* out, void* userData, VSCore* core, const VSAPI* vsapi)
+{
+    // clip:anode
+    int err = 0;
+    VSNode* audio = vsapi->mapGetNode(in, "clip", 0, &err);
+    if (err)
+    {
+        return;
+    }
+
+    const VSAudioInfo* audioInfo = vsapi->getAudioInfo(audio);
+
+    // check for supported audio format
+    std::optional<common::SampleType> optSampleType = common::getSampleTypeFromAudioFormat(audioInfo->format);
+    if (!optSampleType.has_value())
+    {
+        std::string errMsg = std::format("{}: unsupported audio format", FuncName);
+        vsapi->mapSetError(out, errMsg.c_str());
+        vsapi->freeNode(audio);
+        return;
+    }
+
+    Stats* data = new Stats(audio, audioInfo);
+
+    VSFilterDependency deps[] = {{ audio, rpStrictSpatial }};
+
+    vsapi->createAudioFilter(out, FuncName, &data->getOutInfo(), statsGetFrame, statsFree, VSFilterMode::fmParallel, deps, 1, data, core);
+}
+
+
+void statsInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi)
+{
+    vspapi->registerFunction(FuncName,
+                             "clip:anode;",
+                             "return:anode;",
+                             statsCreate, nullptr, plugin);
+}
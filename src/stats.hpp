@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include "VapourSynth4.h"
+
+#include "common/overflow.hpp"
+#include "common/sampletype.hpp"
+
+// passes the audio through unchanged and writes the stats props (see common/stats.hpp) to every frame
+class Stats
+{
+public:
+    Stats(VSNode* audio, const VSAudioInfo* audioInfo);
+
+    VSNode* getAudio();
+
+    const VSAudioInfo& getOutInfo();
+
+    // overflowing samples of every channel of frm (e.g. float samples outside [-1, 1])
+    common::OverflowStats countOverflows(const VSFrame* frm, const VSAPI* vsapi);
+
+    void free(const VSAPI* vsapi);
+
+private:
+    VSNode* audio;
+    const VSAudioInfo audioInfo;
+
+    common::SampleType sampleType;
+};
+
+
+void statsInit(VSPlugin* plugin, const VSPLUGINAPI* vspapi);
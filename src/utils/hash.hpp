@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace utils
+{
+    /**
+     * 64 bit FNV-1a hash
+     * not cryptographic, only used for fingerprints
+     */
+    class Fnv1aHash
+    {
+    public:
+        void update(const void* data, size_t size)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+            for (size_t i = 0; i < size; ++i)
+            {
+                state ^= bytes[i];
+                state *= Prime;
+            }
+        }
+
+        template <typename T>
+        requires std::is_trivially_copyable_v<T>
+        void updateValue(const T& value)
+        {
+            update(&value, sizeof(T));
+        }
+
+        uint64_t digest() const
+        {
+            return state;
+        }
+
+    private:
+        static constexpr uint64_t OffsetBasis = 14695981039346656037ULL;
+        static constexpr uint64_t Prime = 1099511628211ULL;
+
+        uint64_t state = OffsetBasis;
+    };
+}
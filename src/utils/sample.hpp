@@ -7,6 +7,7 @@
 #include <cmath>
 #include <concepts>
 #include <cstddef>
+#include <span>
 #include <type_traits>
 
 #include "utils/number.hpp"
@@ -29,6 +30,57 @@ namespace utils
     }
 
 
+    /**
+     * returns true if any sample of a block of double samples is overflowing
+     * NaN samples are not considered overflowing (same as isSampleOverflowing)
+     * the min/max reduction has no early exit so the compiler can vectorize it
+     */
+    inline bool isAnySampleOverflowing(std::span<const double> samples)
+    {
+        double minSample = 0;
+        double maxSample = 0;
+
+        for (double sample : samples)
+        {
+            minSample = sample < minSample ? sample : minSample;
+            maxSample = maxSample < sample ? sample : maxSample;
+        }
+
+        return minSample < -1.0 || 1.0 < maxSample;
+    }
+
+
+    /**
+     * returns true if any sample of a block of (unconverted) samples is overflowing
+     * same as calling isSampleOverflowing for each sample, 24 bit samples are expected in the upper bits of int32_t
+     * the min/max reduction has no early exit so the compiler can vectorize it
+     */
+    template <typename sample_t, size_t IntSampleBits>
+    requires std::integral<sample_t> || std::floating_point<sample_t>
+    bool isAnySampleOverflowing(std::span<const sample_t> samples)
+    {
+        sample_t minSample = 0;
+        sample_t maxSample = 0;
+
+        for (sample_t sample : samples)
+        {
+            minSample = sample < minSample ? sample : minSample;
+            maxSample = maxSample < sample ? sample : maxSample;
+        }
+
+        if constexpr (std::is_integral_v<sample_t>)
+        {
+            constexpr size_t shiftCount = sizeof(sample_t) * CHAR_BIT - IntSampleBits;
+            return static_cast<sample_t>(minSample >> shiftCount) == utils::minInt<sample_t, IntSampleBits>;
+        }
+
+        if constexpr (std::is_floating_point_v<sample_t>)
+        {
+            return minSample < static_cast<sample_t>(-1) || static_cast<sample_t>(1) < maxSample;
+        }
+    }
+
+
     // minInt gets clamped to -maxInt
     template <typename sample_t, size_t IntSampleBits>
     requires std::integral<sample_t>
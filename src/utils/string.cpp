@@ -18,4 +18,27 @@ namespace utils
         }
         return result;
     }
+
+
+    std::vector<std::string> stringSplit(const std::string& str, char delim)
+    {
+        std::vector<std::string> result;
+
+        size_t itemStart = 0;
+        while (itemStart <= str.length())
+        {
+            size_t itemEnd = str.find(delim, itemStart);
+            if (itemEnd == std::string::npos)
+            {
+                itemEnd = str.length();
+            }
+
+            if (itemStart < itemEnd)
+            {
+                result.push_back(str.substr(itemStart, itemEnd - itemStart));
+            }
+            itemStart = itemEnd + 1;
+        }
+        return result;
+    }
 }
@@ -8,4 +8,7 @@
 namespace utils
 {
     std::string stringJoin(const std::vector<std::string>& items, const std::string& delim);
+
+    // splits str at every delim, empty items are skipped
+    std::vector<std::string> stringSplit(const std::string& str, char delim);
 }
@@ -94,6 +94,21 @@ namespace vsmap
     }
 
 
+    std::string getOptString(const char* varName, const VSMap* in, const VSAPI* vsapi, const std::string& defaultValue)
+    {
+        int err = 0;
+        const char* result = vsapi->mapGetData(in, varName, 0, &err);
+        if (err)
+        {
+            return defaultValue;
+        }
+
+        int size = vsapi->mapGetDataSize(in, varName, 0, &err);
+
+        return std::string(result, static_cast<size_t>(size));
+    }
+
+
     std::optional<std::vector<int>> getIntArray(const char* varName, const char* logFuncName, const VSMap* in, VSMap* out, const VSAPI* vsapi)
     {
         int err = 0;
@@ -4,6 +4,7 @@
 
 #include <cstdint>
 #include <optional>
+#include <string>
 #include <vector>
 
 #include "VapourSynth4.h"
@@ -22,6 +23,8 @@ namespace vsmap
 
     int64_t getOptInt64(const char* varName, const VSMap* in, const VSAPI* vsapi, int64_t defaultValue);
 
+    std::string getOptString(const char* varName, const VSMap* in, const VSAPI* vsapi, const std::string& defaultValue);
+
     std::optional<std::vector<int>> getIntArray(const char* varName, const char* logFuncName, const VSMap* in, VSMap* out, const VSAPI* vsapi);
 
     std::vector<int> getOptIntArray(const char* varName, const VSMap* in, const VSAPI* vsapi, const std::vector<int>& defaultValue);
@@ -2,6 +2,7 @@
 
 #include <bitset>
 #include <format>
+#include <map>
 #include <optional>
 #include <set>
 #include <string>
@@ -11,6 +12,7 @@
 #include "VapourSynth4.h"
 
 #include "common/overflow.hpp"
+#include "common/precision.hpp"
 #include "common/sampletype.hpp"
 #include "common/transition.hpp"
 #include "utils/string.hpp"
@@ -42,6 +44,35 @@ namespace vsmap
     }
 
 
+    std::vector<int64_t> getOptSamplesArray(const char* sampleVarName, const char* secondsVarName, const VSMap* in, const VSAPI* vsapi, const std::vector<int64_t>& defaultValue, int sampleRate)
+    {
+        int err = 0;
+        vsapi->mapGetIntArray(in, sampleVarName, &err);
+        if (!err)
+        {
+            return getOptInt64Array(sampleVarName, in, vsapi, defaultValue);
+        }
+
+        // samples not defined -> try seconds
+        std::vector<double> seconds = getOptDoubleArray(secondsVarName, in, vsapi, {});
+        if (seconds.empty())
+        {
+            // seconds not defined
+            return defaultValue;
+        }
+
+        std::vector<int64_t> result;
+        result.reserve(seconds.size());
+
+        for (const double& s : seconds)
+        {
+            result.push_back(static_cast<int64_t>(sampleRate * s));
+        }
+
+        return result;
+    }
+
+
     uint64_t getOptChannelLayout(const char* varName, const VSMap* in, const VSAPI* vsapi, uint64_t defaultValue)
     {
         std::vector<int> defaultChannels = vsutils::getChannelsFromChannelLayout(defaultValue);
@@ -138,6 +169,12 @@ namespace vsmap
     }
 
 
+    std::optional<common::Precision> getOptPrecisionFromString(const char* varName, const char* logFuncName, const VSMap* in, VSMap* out, const VSAPI* vsapi, common::Precision defaultValue)
+    {
+        return getOptValueFromString(varName, logFuncName, in, out, vsapi, common::getStringPrecisionMap(), defaultValue);
+    }
+
+
     std::optional<common::TransitionType> getTransitionTypeFromString(const char* varName, const char* logFuncName, const VSMap* in, VSMap* out, const VSAPI* vsapi)
     {
         return getValueFromString(varName, logFuncName, in, out, vsapi, common::getStringTransitionTypeMap());
@@ -148,4 +185,40 @@ namespace vsmap
     {
         return getOptValueFromString(varName, logFuncName, in, out, vsapi, common::getStringTransitionTypeMap(), defaultValue);
     }
+
+
+    std::optional<std::vector<common::TransitionType>> getOptTransitionTypesFromStrings(const char* varName, const char* logFuncName, const VSMap* in, VSMap* out, const VSAPI* vsapi,
+                                                                                        const std::vector<common::TransitionType>& defaultValue)
+    {
+        int numElements = vsapi->mapNumElements(in, varName);
+        if (numElements <= 0)
+        {
+            // string array not defined
+            return defaultValue;
+        }
+
+        std::map<std::string, common::TransitionType> strValueMap = common::getStringTransitionTypeMap();
+
+        std::vector<common::TransitionType> result;
+        result.reserve(static_cast<size_t>(numElements));
+
+        for (int i = 0; i < numElements; ++i)
+        {
+            std::string strVar(vsapi->mapGetData(in, varName, i, nullptr));
+
+            std::optional<common::TransitionType> optType = utils::mapGet(strValueMap, strVar);
+            if (!optType.has_value())
+            {
+                std::string allowedValues = utils::stringJoin(utils::mapGetKeys(strValueMap), ", ");
+
+                std::string errMsg = std::format("{}: invalid {} value: {}, must be one of: {}", logFuncName, varName, strVar, allowedValues);
+                vsapi->mapSetError(out, errMsg.c_str());
+                return std::nullopt;
+            }
+
+            result.push_back(optType.value());
+        }
+
+        return result;
+    }
 }
@@ -11,6 +11,7 @@
 #include "VapourSynth4.h"
 
 #include "common/overflow.hpp"
+#include "common/precision.hpp"
 #include "common/sampletype.hpp"
 #include "common/transition.hpp"
 #include "utils/map.hpp"
@@ -20,6 +21,9 @@ namespace vsmap
 {
     int64_t getOptSamples(const char* varNameSamples, const char* varNameSeconds, const VSMap* in, VSMap* out, const VSAPI* vsapi, int64_t defaultValue, int sampleRate);
 
+    // array version of getOptSamples
+    std::vector<int64_t> getOptSamplesArray(const char* varNameSamples, const char* varNameSeconds, const VSMap* in, const VSAPI* vsapi, const std::vector<int64_t>& defaultValue, int sampleRate);
+
     uint64_t getOptChannelLayout(const char* varName, const VSMap* in, const VSAPI* vsapi, uint64_t defaultValue);
 
     std::optional<std::vector<int>> getOptChannels(const char* varName, const char* logFuncName, const VSMap* in, VSMap* out, const VSAPI* vsapi, const std::vector<int>& defaultValue, int numChannels);
@@ -101,6 +105,16 @@ namespace vsmap
     /** no error handling needed **/
     std::optional<common::TransitionType> getTransitionTypeFromString(const char* varName, const char* logFuncName, const VSMap* in, VSMap* out, const VSAPI* vsapi);
 
+    /** no error handling needed **/
+    std::optional<common::Precision> getOptPrecisionFromString(const char* varName, const char* logFuncName, const VSMap* in, VSMap* out, const VSAPI* vsapi, common::Precision defaultValue);
+
     /** no error handling needed **/
     std::optional<common::TransitionType> getOptTransitionTypeFromString(const char* varName, const char* logFuncName, const VSMap* in, VSMap* out, const VSAPI* vsapi, common::TransitionType defaultValue);
+
+    /**
+     * array version of getOptTransitionTypeFromString
+     * no error handling needed
+     */
+    std::optional<std::vector<common::TransitionType>> getOptTransitionTypesFromStrings(const char* varName, const char* logFuncName, const VSMap* in, VSMap* out, const VSAPI* vsapi,
+                                                                                        const std::vector<common::TransitionType>& defaultValue);
 }
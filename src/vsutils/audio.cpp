@@ -1,13 +1,16 @@
 // SPDX-License-Identifier: MIT
 
 #include <algorithm>
+#include <array>
 #include <bitset>
 #include <cassert>
 #include <cmath>
 #include <cstring>
 #include <cstdint>
 #include <limits>
+#include <numeric>
 #include <optional>
+#include <span>
 #include <vector>
 
 #include "VapourSynth4.h"
@@ -130,6 +133,24 @@ namespace vsutils
     }
 
 
+    // channel numbers for newAudioFrame2: 0, 1, ..., 63 (the channel layout has 64 bits)
+    static constexpr std::array<int, 64> identityChannels = []
+    {
+        std::array<int, 64> channels;
+        std::iota(channels.begin(), channels.end(), 0);
+        return channels;
+    }();
+
+
+    VSFrame* newAudioFrameFromChannelSources(const VSAudioFormat* format, int numSamples, std::span<const VSFrame* const> channelSources,
+                                             const VSFrame* propSrc, VSCore* core, const VSAPI* vsapi)
+    {
+        assertm(channelSources.size() == static_cast<size_t>(format->numChannels), "one channel source per channel required");
+
+        return vsapi->newAudioFrame2(format, numSamples, const_cast<const VSFrame**>(channelSources.data()), identityChannels.data(), propSrc, core);
+    }
+
+
     std::vector<int> getChannelsFromChannelLayout(uint64_t channelLayout)
     {
         std::vector<int> result;
@@ -4,6 +4,7 @@
 
 #include <cstdint>
 #include <optional>
+#include <span>
 #include <vector>
 
 #include "VapourSynth4.h"
@@ -32,6 +33,13 @@ namespace vsutils
 
     void copyFrameChannel(VSFrame* outFrame, int outChannel, const VSFrame* inFrame, int inChannel, int bytesPerSample, const VSAPI* vsapi);
 
+    /**
+     * creates a new frame with newAudioFrame2, channel ch references channel ch of channelSources[ch] (no copy)
+     * channels with a nullptr source are uninitialized and have to be written by the caller
+     */
+    VSFrame* newAudioFrameFromChannelSources(const VSAudioFormat* format, int numSamples, std::span<const VSFrame* const> channelSources,
+                                             const VSFrame* propSrc, VSCore* core, const VSAPI* vsapi);
+
     std::vector<int> getChannelsFromChannelLayout(uint64_t channelLayout);
 
     uint64_t toChannelLayout(const std::vector<int>& channels);